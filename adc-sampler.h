@@ -0,0 +1,193 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// Timer-Paced ADC Sampler
+// ─────────────────────────────────────
+// timer1 fires at a fixed rate and its ISR only counts the tick; the
+// conversion is taken in loop() context, by the first poll() or popRaw()
+// after the tick, and run through a decimating filter chain:
+//
+//   raw ──► average of N (oversampling) ──► median of W ──► IIR ──► value()
+//
+// The ISR does not convert because analogRead() is not interrupt-safe:
+// the SDK's system_adc_read() runs from flash, so a tick that lands while
+// LittleFS is writing (journal, trace, history) would crash the board.
+// Pacing still comes from the timer, which matters with WiFi up: reads
+// taken back to back return the same cached conversion, so oversampling
+// them gains nothing. A loop that was busy for several ticks therefore
+// gets one conversion, and the ticks it missed are counted as dropped
+// rather than made up in a burst.
+//
+// Reading the filtered value is O(1) and never waits for a conversion.
+
+struct AdcFilterConfig {
+  uint8_t oversampling = 4;   // Raw conversions averaged into one decimated sample
+  uint8_t medianWindow = 5;   // Decimated samples in the median window (odd, <= MAX_MEDIAN_WINDOW)
+  uint8_t iirShift = 3;       // IIR smoothing factor alpha = 1 / 2^iirShift
+};
+
+// Decimation + median + first-order IIR on integer ADC counts. The IIR
+// state is kept in Q8 fixed point so the filter never touches floats.
+class AdcFilter {
+public:
+  static const uint8_t MAX_MEDIAN_WINDOW = 9;
+
+  void configure(const AdcFilterConfig &filterConfig) {
+    config = filterConfig;
+    if (config.oversampling == 0) config.oversampling = 1;
+    if (config.medianWindow > MAX_MEDIAN_WINDOW) config.medianWindow = MAX_MEDIAN_WINDOW;
+    if ((config.medianWindow & 1) == 0) config.medianWindow++;
+    reset();
+  }
+
+  void reset() {
+    accumulator = 0;
+    accumulated = 0;
+    windowFill = 0;
+    windowHead = 0;
+    primed = false;
+  }
+
+  // Feed one raw conversion; returns true when a new filtered value was produced.
+  bool push(uint16_t raw) {
+    accumulator += raw;
+    if (++accumulated < config.oversampling) {
+      return false;
+    }
+    uint16_t decimated = (accumulator + config.oversampling / 2) / config.oversampling;
+    accumulator = 0;
+    accumulated = 0;
+
+    window[windowHead] = decimated;
+    windowHead = (windowHead + 1) % config.medianWindow;
+    if (windowFill < config.medianWindow) windowFill++;
+
+    int32_t median = (int32_t)medianOfWindow() << 8;
+    if (!primed) {
+      state = median;  // Seed the IIR so the first value is not dragged up from zero
+      primed = true;
+    } else {
+      state += (median - state) >> config.iirShift;
+    }
+    return true;
+  }
+
+  bool ready() const { return primed; }
+  int value() const { return (state + 128) >> 8; }
+
+private:
+  AdcFilterConfig config;
+  uint32_t accumulator = 0;
+  uint8_t accumulated = 0;
+  uint16_t window[MAX_MEDIAN_WINDOW] = {};
+  uint8_t windowFill = 0;
+  uint8_t windowHead = 0;
+  int32_t state = 0;
+  bool primed = false;
+
+  uint16_t medianOfWindow() const {
+    // Insertion sort of at most nine values - cheaper than anything clever
+    uint16_t sorted[MAX_MEDIAN_WINDOW];
+    for (uint8_t i = 0; i < windowFill; i++) {
+      uint16_t sample = window[i];
+      int8_t j = i - 1;
+      while (j >= 0 && sorted[j] > sample) {
+        sorted[j + 1] = sorted[j];
+        j--;
+      }
+      sorted[j + 1] = sample;
+    }
+    return sorted[windowFill / 2];
+  }
+};
+
+struct AdcSamplerConfig {
+  uint16_t sampleRateHz = 200;  // timer1 conversion rate
+  AdcFilterConfig filter;
+};
+
+// Owns timer1, so there is one sampler per board.
+class AdcSampler {
+public:
+  void begin(uint8_t analogPin, const AdcSamplerConfig &samplerConfig = AdcSamplerConfig()) {
+    pin = analogPin;
+    config = samplerConfig;
+    filter.configure(config.filter);
+    ticks = 0;
+    taken = 0;
+    instance = this;
+
+    timer1_isr_init();
+    timer1_attachInterrupt(onSampleTimer);
+    timer1_enable(TIM_DIV16, TIM_EDGE, TIM_LOOP);
+    timer1_write(TIMER1_TICKS_PER_SECOND / config.sampleRateHz);
+  }
+
+  void end() {
+    timer1_disable();
+    timer1_detachInterrupt();
+    instance = nullptr;
+  }
+
+  // Filter the conversion timer1 has called for since the last call, if
+  // any. Call every loop pass; a pass costs at most one conversion.
+  void poll() {
+    uint16_t raw;
+    if (convert(raw)) {
+      filter.push(raw);
+    }
+  }
+
+  // delay() for loops that wait between passes: the conversions timer1
+  // calls for during the wait are still taken, each as it falls due.
+  void delaySampling(unsigned long ms) {
+    const unsigned long period = config.sampleRateHz ? max(1000UL / config.sampleRateHz, 1UL) : ms;
+    const unsigned long started = millis();
+    for (unsigned long elapsed = 0; elapsed < ms; elapsed = millis() - started) {
+      delay(min(period, ms - elapsed));
+      poll();
+    }
+  }
+
+  // Drop filter history and a tick still pending, e.g. after an input switch.
+  void restart() {
+    taken = ticks;
+    filter.reset();
+  }
+
+  bool ready() const { return filter.ready(); }
+  int value() const { return filter.value(); }
+  uint32_t droppedSamples() const { return dropped; }
+
+  // The due conversion for consumers with their own filters; false when
+  // timer1 has not ticked since the last one was taken
+  bool popRaw(uint16_t &raw) { return convert(raw); }
+
+private:
+  static const uint32_t TIMER1_TICKS_PER_SECOND = 5000000UL;  // 80 MHz / TIM_DIV16
+
+  static inline AdcSampler *instance = nullptr;
+
+  uint8_t pin = A0;
+  AdcSamplerConfig config;
+  AdcFilter filter;
+  volatile uint32_t ticks = 0;   // Written by the ISR only; an aligned word, read whole
+  uint32_t taken = 0;            // Ticks answered by a conversion or counted as dropped
+  uint32_t dropped = 0;
+
+  bool convert(uint16_t &raw) {
+    uint32_t due = ticks - taken;
+    if (due == 0) return false;
+    dropped += due - 1;  // Loop was busy for several ticks - one conversion, not a burst
+    taken += due;
+    raw = (uint16_t)analogRead(pin);
+    return true;
+  }
+
+  static void IRAM_ATTR onSampleTimer() {
+    AdcSampler *sampler = instance;
+    if (sampler != nullptr) sampler->ticks = sampler->ticks + 1;
+  }
+};
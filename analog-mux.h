@@ -0,0 +1,166 @@
+#pragma once
+
+#include <Arduino.h>
+#include "adc-sampler.h"
+#include "input-trace.h"
+
+// ─────────────────────────────────────
+// Analog Multiplexer Channel Scheduler
+// ─────────────────────────────────────
+// Shares the single ESP8266 ADC between several sensors behind an analog
+// mux (one select line for a 2:1 switch, up to four for a CD4051 or
+// CD74HC4067). The scheduler owns the select lines and runs a small state
+// machine from loop():
+//
+//   IDLE ──► pick the most overdue channel ──► drive select lines
+//        ──► SETTLING (only if the address changed) ──► COLLECTING
+//        ──► one decimated sample into that channel's filter ──► IDLE
+//
+// Raw conversions come from the AdcSampler, one per timer1 tick, and are
+// only taken once the mux output has settled. Each channel has its own period and
+// its own median + IIR filter, so value() is always that channel's latest
+// conditioned reading.
+
+template <uint8_t MAX_CHANNELS = 16>
+class AnalogMux {
+public:
+  static const uint8_t MAX_SELECT_PINS = 4;
+
+  void begin(AdcSampler &adcSampler, const uint8_t *selectPins, uint8_t selectPinCount, unsigned long settleTimeMs) {
+    sampler = &adcSampler;
+    settleTime = settleTimeMs;
+    selectCount = selectPinCount > MAX_SELECT_PINS ? MAX_SELECT_PINS : selectPinCount;
+    for (uint8_t i = 0; i < selectCount; i++) {
+      select[i] = selectPins[i];
+      pinMode(select[i], OUTPUT);
+    }
+    currentAddress = NO_ADDRESS;
+    state = IDLE;
+  }
+
+  // Register a mux input; returns the channel index or -1 when full.
+  int8_t addChannel(uint8_t muxAddress, unsigned long periodMs, const AdcFilterConfig &filterConfig = AdcFilterConfig()) {
+    if (channelCount >= MAX_CHANNELS) return -1;
+    Channel &channel = channels[channelCount];
+    channel.address = muxAddress;
+    channel.period = periodMs;
+    channel.burst = filterConfig.oversampling ? filterConfig.oversampling : 1;
+    channel.nextDue = millis();
+    channel.filter.configure(filterConfig);
+    channel.lastUpdate = 0;
+    return channelCount++;
+  }
+
+  void poll() {
+    if (sampler == nullptr || channelCount == 0) return;
+
+    switch (state) {
+      case IDLE: {
+        int8_t next = mostOverdueChannel();
+        if (next < 0) return;
+        active = next;
+        if (channels[active].address != currentAddress) {
+          driveAddress(channels[active].address);
+          switches++;
+          settleStarted = millis();
+          state = SETTLING;
+        } else {
+          beginCollecting();
+        }
+        break;
+      }
+
+      case SETTLING:
+        if (millis() - settleStarted >= settleTime) {
+          beginCollecting();
+        }
+        break;
+
+      case COLLECTING: {
+        Channel &channel = channels[active];
+        uint16_t raw;
+        while (collected < channel.burst && sampler->popRaw(raw)) {
+          if (trace) trace->analog(channel.address, raw);
+          channel.filter.push(raw);
+          collected++;
+        }
+        if (collected >= channel.burst) {
+          channel.lastUpdate = millis();
+          channel.nextDue += channel.period;
+          if ((long)(channel.lastUpdate - channel.nextDue) > 0) {
+            channel.nextDue = channel.lastUpdate + channel.period;  // Fell behind - do not burst to catch up
+          }
+          state = IDLE;
+        }
+        break;
+      }
+    }
+  }
+
+  bool ready(uint8_t channel) const { return channel < channelCount && channels[channel].filter.ready(); }
+  int value(uint8_t channel) const { return channel < channelCount ? channels[channel].filter.value() : 0; }
+  unsigned long lastUpdate(uint8_t channel) const { return channel < channelCount ? channels[channel].lastUpdate : 0; }
+  uint32_t addressSwitches() const { return switches; }
+
+  // Record every conversion a channel keeps (and take traced ones in a replay)
+  void traceInputs(InputTrace &inputTrace) { trace = &inputTrace; }
+
+private:
+  static const uint8_t NO_ADDRESS = 0xFF;
+  enum State : uint8_t { IDLE, SETTLING, COLLECTING };
+
+  struct Channel {
+    AdcFilter filter;
+    unsigned long period;
+    unsigned long nextDue;
+    unsigned long lastUpdate;
+    uint8_t address;
+    uint8_t burst;   // Raw conversions per visit (one decimated sample)
+  };
+
+  AdcSampler *sampler = nullptr;
+  Channel channels[MAX_CHANNELS];
+  uint8_t channelCount = 0;
+  uint8_t select[MAX_SELECT_PINS];
+  uint8_t selectCount = 0;
+  uint8_t currentAddress = NO_ADDRESS;
+  unsigned long settleTime = 0;
+  unsigned long settleStarted = 0;
+  State state = IDLE;
+  uint8_t active = 0;
+  uint8_t collected = 0;
+  uint32_t switches = 0;
+  InputTrace *trace = nullptr;
+
+  // Earliest deadline first; channels on the current address win ties so
+  // consecutive reads of one input do not pay an extra settle.
+  int8_t mostOverdueChannel() const {
+    unsigned long now = millis();
+    int8_t best = -1;
+    long bestLateness = -1;
+    for (uint8_t i = 0; i < channelCount; i++) {
+      long lateness = (long)(now - channels[i].nextDue);
+      if (lateness < 0) continue;
+      bool better = lateness > bestLateness ||
+                    (lateness == bestLateness && channels[i].address == currentAddress);
+      if (better) {
+        best = i;
+        bestLateness = lateness;
+      }
+    }
+    return best;
+  }
+
+  void driveAddress(uint8_t address) {
+    for (uint8_t bit = 0; bit < selectCount; bit++) {
+      digitalWrite(select[bit], (address >> bit) & 1 ? HIGH : LOW);
+    }
+    currentAddress = address;
+  }
+
+  void beginCollecting() {
+    sampler->restart();  // A tick still pending predates the settled mux output
+    collected = 0;
+    state = COLLECTING;
+  }
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// Fixed-Point Sensor Calibration Tables
+// ─────────────────────────────────────
+// Turns a 10-bit ADC reading into engineering units (% volumetric water,
+// µmol/m²/s) through a lookup table with linear interpolation, instead of
+// map()/constrain() (a multiply and a 32-bit division per sample - the
+// LX106 has no divider) or float curve fitting:
+//
+//   constexpr CalibrationTable<> MOISTURE = CalibrationTable<>::twoPoint({ 1023, 0 }, { 0, 100 }, 0, 100);
+//   int moisture = MOISTURE.convert(raw);   // shift, mask, one multiply-add, clamp
+//
+// Tables are generated at compile time from two reference readings (e.g.
+// probe in dry air and in water), a list of points, or polynomial
+// coefficients evaluated in double precision by the compiler - no floating
+// point is left in the firmware. twoPoint() also runs on the device, so a
+// field recalibration regenerates a table in RAM.
+//
+// Knots sit every 2^SEGMENT_BITS counts (33 knots, 132 bytes by default) in
+// Q16 fixed point. Conversion rounds the interpolation to the nearest Q16
+// step and floors the result to whole units, like map() truncates, so a
+// linear table reproduces map() + constrain() exactly. Curves must change
+// by less than 1000 units per segment to keep the interpolation in 32 bits.
+
+struct CalibrationPoint {
+  uint16_t raw;      // ADC counts
+  int16_t value;     // Engineering units
+};
+
+template <uint8_t SEGMENT_BITS = 5>
+class CalibrationTable {
+public:
+  static const uint8_t ADC_BITS = 10;
+  static const uint16_t RAW_MAX = (1 << ADC_BITS) - 1;
+  static const uint8_t FRACTION_BITS = 16;
+  static const uint16_t KNOTS = (1 << (ADC_BITS - SEGMENT_BITS)) + 1;
+
+  constexpr CalibrationTable() {}
+
+  // Straight line through two readings, extended across the whole ADC
+  // range and clamped to [minimum, maximum] units.
+  static constexpr CalibrationTable twoPoint(CalibrationPoint a, CalibrationPoint b, int16_t minimum, int16_t maximum) {
+    CalibrationTable table;
+    table.setBounds(minimum, maximum);
+    for (uint16_t knot = 0; knot < KNOTS; knot++) {
+      int64_t raw = (int64_t)knot << SEGMENT_BITS;
+      table.knots[knot] = a.value * ONE + roundedDivide((raw - a.raw) * (b.value - a.value) * ONE, (int64_t)b.raw - a.raw);
+    }
+    return table;
+  }
+
+  // Piecewise-linear through points sorted by raw count; the end segments
+  // extend past the first and last point.
+  template <size_t COUNT>
+  static constexpr CalibrationTable piecewise(const CalibrationPoint (&points)[COUNT], int16_t minimum, int16_t maximum) {
+    static_assert(COUNT >= 2, "A calibration needs at least two points");
+    CalibrationTable table;
+    table.setBounds(minimum, maximum);
+    size_t segment = 0;
+    for (uint16_t knot = 0; knot < KNOTS; knot++) {
+      int64_t raw = (int64_t)knot << SEGMENT_BITS;
+      while (segment + 2 < COUNT && raw > points[segment + 1].raw) segment++;
+      const CalibrationPoint &a = points[segment];
+      const CalibrationPoint &b = points[segment + 1];
+      table.knots[knot] = a.value * ONE + roundedDivide((raw - a.raw) * (b.value - a.value) * ONE, (int64_t)b.raw - a.raw);
+    }
+    return table;
+  }
+
+  // value = c[0] + c[1] raw + c[2] raw² + ...  Only for constexpr tables:
+  // the double arithmetic must not reach the device.
+  template <size_t COUNT>
+  static constexpr CalibrationTable polynomial(const double (&coefficients)[COUNT], int16_t minimum, int16_t maximum) {
+    CalibrationTable table;
+    table.setBounds(minimum, maximum);
+    for (uint16_t knot = 0; knot < KNOTS; knot++) {
+      double raw = knot << SEGMENT_BITS;
+      double value = 0;
+      for (size_t i = COUNT; i-- > 0;) value = value * raw + coefficients[i];  // Horner
+      double scaled = value * ONE;
+      table.knots[knot] = (int32_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    }
+    return table;
+  }
+
+  // Q16 units, clamped
+  int32_t fixed(uint16_t raw) const {
+    if (raw > RAW_MAX) raw = RAW_MAX;
+    uint16_t segment = raw >> SEGMENT_BITS;
+    int32_t offset = raw & ((1 << SEGMENT_BITS) - 1);
+    int32_t low = knots[segment];
+    int32_t value = low + (((knots[segment + 1] - low) * offset + (1 << (SEGMENT_BITS - 1))) >> SEGMENT_BITS);
+    if (value < lower) return lower;
+    if (value > upper) return upper;
+    return value;
+  }
+
+  // Whole units, rounded down
+  int16_t convert(uint16_t raw) const { return fixed(raw) >> FRACTION_BITS; }
+
+  int32_t knot(uint16_t index) const { return knots[index]; }
+
+private:
+  static constexpr int64_t ONE = (int64_t)1 << FRACTION_BITS;
+
+  int32_t knots[KNOTS] = {};
+  int32_t lower = 0;
+  int32_t upper = 0;
+
+  constexpr void setBounds(int16_t minimum, int16_t maximum) {
+    lower = minimum * (int32_t)ONE;
+    upper = maximum * (int32_t)ONE;
+  }
+
+  static constexpr int64_t roundedDivide(int64_t numerator, int64_t denominator) {
+    if (denominator < 0) {
+      numerator = -numerator;
+      denominator = -denominator;
+    }
+    return (numerator >= 0 ? numerator + denominator / 2 : numerator - denominator / 2) / denominator;
+  }
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include "rtc-memory.h"
+
+// ─────────────────────────────────────
+// Deep-Sleep Duty Cycle
+// ─────────────────────────────────────
+// millis() restarts from zero on every wake, so timing that has to span
+// deep sleeps and resets (offline failsafe intervals, next-due times) runs
+// on now() instead: the elapsed time carried over in RTC memory plus
+// millis() of the current boot. The clock is checkpointed whenever the
+// caller persists its own state and credited with the programmed sleep
+// time on a deep-sleep wake. Deep sleep needs GPIO16 (D0) wired to RST.
+//
+// Each wake-to-sleep interval is measured and kept with the clock, so the
+// awake share of the duty cycle can be reported after the next wake.
+
+struct DutyCycleState {
+  unsigned long clockMs;        // now() at the last checkpoint
+  unsigned long plannedSleepMs; // Sleep programmed before the last deep sleep
+  uint32_t wakes;               // Deep-sleep wakes since the record was created
+  uint32_t lastAwakeMs;         // Wake-to-sleep time of the previous cycle
+  uint32_t maxAwakeMs;
+  uint32_t totalAwakeMs;
+  uint32_t totalSleepMs;
+};
+
+class DutyCycle {
+public:
+  // Restore the clock from RTC memory. Call first thing in setup().
+  void begin() {
+    wokeFromDeepSleep = ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE;
+    restored = record.load(state);
+    if (!restored) {
+      state = DutyCycleState();
+      wokeFromDeepSleep = false;  // Nothing to resume - treat as a cold start
+    }
+    clockOffset = state.clockMs;
+    if (wokeFromDeepSleep) {
+      clockOffset += state.plannedSleepMs;
+      state.wakes++;
+    }
+    state.plannedSleepMs = 0;
+  }
+
+  // Milliseconds since the first cold boot; wraps like millis().
+  unsigned long now() const { return clockOffset + millis(); }
+
+  bool wokeFromSleep() const { return wokeFromDeepSleep; }
+  bool stateRestored() const { return restored; }
+  unsigned long awakeMs() const { return millis(); }
+  const DutyCycleState &stats() const { return state; }
+
+  uint8_t awakePercent() const {
+    uint32_t total = state.totalAwakeMs + state.totalSleepMs;
+    return total ? (uint8_t)((uint64_t)state.totalAwakeMs * 100 / total) : 100;
+  }
+
+  // Persist the clock so a reset does not rewind now().
+  void checkpoint() {
+    state.clockMs = now();
+    record.save(state);
+  }
+
+  // Record this wake's duration and power down for `durationMs`
+  // (clamped to the hardware maximum). Does not return.
+  void sleep(unsigned long durationMs) {
+    uint64_t maxMs = ESP.deepSleepMax() / 1000;
+    if (durationMs > maxMs) durationMs = (unsigned long)maxMs;
+
+    uint32_t awake = millis();
+    state.lastAwakeMs = awake;
+    if (awake > state.maxAwakeMs) state.maxAwakeMs = awake;
+    state.totalAwakeMs += awake;
+    state.totalSleepMs += durationMs;
+    state.plannedSleepMs = durationMs;
+    state.clockMs = now();
+    record.save(state);
+
+    ESP.deepSleep((uint64_t)durationMs * 1000ULL, WAKE_RF_DEFAULT);
+  }
+
+private:
+  RtcRecord<DutyCycleState, RTC_BLOCK_DUTY_CYCLE> record;
+  DutyCycleState state = DutyCycleState();
+  unsigned long clockOffset = 0;
+  bool wokeFromDeepSleep = false;
+  bool restored = false;
+};
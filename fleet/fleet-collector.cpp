@@ -0,0 +1,270 @@
+// ─────────────────────────────────────
+// EcoPulse Fleet Collector
+// ─────────────────────────────────────
+// Standalone Linux service that receives the LAN telemetry frames of a
+// site's boards (ECOPULSE_LAN_TELEMETRY), keeps every device's time series
+// in memory and answers queries about the fleet. Needs no network beyond
+// the LAN and no cloud account.
+//
+// Frames arrive on UDP and TCP port 47800 (fleet-ingest.h). Queries are
+// text lines on standard input or on a TCP console bound to loopback
+// (port 47801); each answer ends with its execution time and an empty
+// line. See README.md for build commands and fleet/fleet-loadgen.cpp for
+// the load benchmark.
+
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fleet-ingest.h"
+#include "fleet-query.h"
+
+namespace {
+
+const uint16_t QUERY_PORT = TELEMETRY_FRAME_PORT + 1;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) { stopRequested = 1; }
+
+void printUsage(const char *program) {
+  printf("usage: %s [options]\n"
+         "  --port N            frame port, UDP and TCP (default %u)\n"
+         "  --query-port N      query console on 127.0.0.1, 0 = stdin only (default %u)\n"
+         "  --threads N         ingest threads (default: one per CPU)\n"
+         "  --no-tcp            UDP only\n"
+         "  --retention-days N  keep N days per device (default 30)\n"
+         "  --max-gap S         longest interval one sample stands for (default 300)\n"
+         "  --device-clock      device timestamps are UNIX time (replays, load tests)\n"
+         "  --status S          print an ingest status line every S seconds (default 10, 0 = off)\n"
+         "queries: stats, devices, below PCT, pump-hours [DAYS], range DEVICE FROM TO, series DEVICE FROM TO\n",
+         program, TELEMETRY_FRAME_PORT, QUERY_PORT);
+}
+
+size_t storeFootprint(const FleetStore &store, size_t &devices, size_t &samples) {
+  size_t chunks = 0;
+  devices = samples = 0;
+  store.forEachDevice([&](const DeviceSeries &series) {
+    devices++;
+    samples += series.samples;
+    chunks += series.chunks.size();
+  });
+  return chunks * sizeof(SeriesChunk) + devices * sizeof(DeviceSeries);
+}
+
+void queryStats(const FleetStore &store, const FleetIngest &ingest, std::string &out) {
+  const FleetIngestStats &stats = ingest.stats();
+  size_t devices, samples;
+  size_t bytes = storeFootprint(store, devices, samples);
+  uint64_t lost = 0, late = 0, restarts = 0;
+  store.forEachDevice([&](const DeviceSeries &series) {
+    lost += series.lost;
+    late += series.late;
+    restarts += series.restarts;
+  });
+  appendf(out, "frames %llu\n", (unsigned long long)stats.frames.load());
+  appendf(out, "datagrams %llu\n", (unsigned long long)stats.datagrams.load());
+  for (size_t status = 1; status <= TELEMETRY_FRAME_BAD_CRC; status++) {
+    appendf(out, "rejected %s %llu\n", telemetryFrameStatusName((TelemetryFrameStatus)status),
+            (unsigned long long)stats.rejected[status].load());
+  }
+  appendf(out, "connections %llu\n", (unsigned long long)stats.connections.load());
+  appendf(out, "stream-bytes %llu\n", (unsigned long long)stats.streamBytes.load());
+  appendf(out, "skipped-bytes %llu\n", (unsigned long long)stats.skippedBytes.load());
+  appendf(out, "broadcast-copies %llu\n", (unsigned long long)stats.broadcastCopies.load());
+  appendf(out, "devices %zu\n", devices);
+  appendf(out, "samples %zu\n", samples);
+  appendf(out, "lost %llu\n", (unsigned long long)lost);
+  appendf(out, "late %llu\n", (unsigned long long)late);
+  appendf(out, "restarts %llu\n", (unsigned long long)restarts);
+  appendf(out, "memory-kb %zu\n", bytes / 1024);
+  appendf(out, "threads %u\n", ingest.threadCount());
+}
+
+void runQuery(const FleetStore &store, const FleetIngest &ingest, char *line, std::string &out) {
+  auto started = std::chrono::steady_clock::now();
+  char *words[5] = {};
+  int count = 0;
+  char *cursor;
+  for (char *word = strtok_r(line, " \t\r\n", &cursor); word && count < 5; word = strtok_r(nullptr, " \t\r\n", &cursor)) {
+    words[count++] = word;
+  }
+  if (!count) return;
+
+  const char *command = words[0];
+  uint32_t from = 0, to = 0;
+  bool window = count == 4;
+  if (window) {
+    uint32_t now = store.newestTime();
+    window = parseQueryTime(words[2], now, from) && parseQueryTime(words[3], now, to);
+  }
+  if (!strcmp(command, "stats") && count == 1) {
+    queryStats(store, ingest, out);
+  } else if (!strcmp(command, "devices") && count == 1) {
+    queryDevices(store, out);
+  } else if (!strcmp(command, "below") && count == 2) {
+    queryBelow(store, atoi(words[1]), out);
+  } else if (!strcmp(command, "pump-hours") && count <= 2) {
+    queryPumpHours(store, count == 2 ? atoi(words[1]) : 7, out);
+  } else if (!strcmp(command, "range") && window) {
+    queryRange(store, strtoul(words[1], nullptr, 16), from, to, out);
+  } else if (!strcmp(command, "series") && window) {
+    querySeries(store, strtoul(words[1], nullptr, 16), from, to, out);
+  } else {
+    appendf(out, "queries: stats, devices, below PCT, pump-hours [DAYS], range DEVICE FROM TO, series DEVICE FROM TO\n"
+                 "times: UNIX seconds, now, or -90s/-30m/-6h/-2d before the newest sample\n");
+  }
+  appendf(out, "# %.2f ms\n\n",
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count());
+}
+
+// Serves one console client at a time; queries are short and the console
+// is for operators and scripts, not for many concurrent users.
+void serveQueries(int listener, const FleetStore &store, const FleetIngest &ingest) {
+  while (!stopRequested) {
+    pollfd waiting = { listener, POLLIN, 0 };
+    if (poll(&waiting, 1, 200) <= 0) continue;
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0) continue;
+    int enable = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));   // Answers span several writes
+    FILE *requests = fdopen(client, "r");
+    char line[256];
+    std::string answer;
+    bool connected = true;
+    while (connected && !stopRequested && fgets(line, sizeof(line), requests)) {
+      answer.clear();
+      runQuery(store, ingest, line, answer);
+      for (size_t sent = 0; connected && sent < answer.size();) {
+        ssize_t written = send(client, answer.data() + sent, answer.size() - sent, MSG_NOSIGNAL);
+        connected = written > 0;
+        sent += connected ? written : 0;
+      }
+    }
+    fclose(requests);
+  }
+}
+
+int openQueryListener(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  int enable = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  local.sin_port = htons(port);
+  if (bind(fd, (sockaddr *)&local, sizeof(local)) < 0 || listen(fd, 8) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void printStatus(const FleetStore &store, const FleetIngest &ingest, uint64_t &lastFrames, double seconds) {
+  size_t devices, samples;
+  size_t bytes = storeFootprint(store, devices, samples);
+  uint64_t frames = ingest.stats().frames.load();
+  fprintf(stderr, "fleet: %zu devices, %.0f frames/s, %llu frames, %zu samples, %.1f MB\n", devices,
+          (frames - lastFrames) / seconds, (unsigned long long)frames, samples, bytes / 1048576.0);
+  lastFrames = frames;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  FleetStoreConfig storeConfig;
+  FleetIngestConfig ingestConfig;
+  uint16_t queryPort = QUERY_PORT;
+  double statusSeconds = 10;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--port") && value) {
+      ingestConfig.port = (uint16_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--query-port") && value) {
+      queryPort = (uint16_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--threads") && value) {
+      ingestConfig.threads = (unsigned)atoi(value); i++;
+    } else if (!strcmp(arg, "--no-tcp")) {
+      ingestConfig.tcp = false;
+    } else if (!strcmp(arg, "--retention-days") && value) {
+      storeConfig.retentionSeconds = (uint32_t)(atof(value) * 86400); i++;
+    } else if (!strcmp(arg, "--max-gap") && value) {
+      storeConfig.maxSampleGap = (uint32_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--device-clock")) {
+      storeConfig.deviceClock = true;
+    } else if (!strcmp(arg, "--status") && value) {
+      statusSeconds = atof(value); i++;
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  struct sigaction stop = {};
+  stop.sa_handler = requestStop;   // No SA_RESTART: a blocked fgets() returns
+  sigaction(SIGINT, &stop, nullptr);
+  sigaction(SIGTERM, &stop, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  FleetStore *store = new FleetStore(storeConfig);   // Shards are large; keep them off the stack
+  FleetIngest ingest(*store, ingestConfig);
+  std::string error;
+  if (!ingest.start(error)) {
+    fprintf(stderr, "fleet: %s\n", error.c_str());
+    return 1;
+  }
+  std::thread console;
+  if (queryPort) {
+    int listener = openQueryListener(queryPort);
+    if (listener < 0) {
+      fprintf(stderr, "fleet: query port %u: %s\n", queryPort, strerror(errno));
+      return 1;
+    }
+    console = std::thread([listener, store, &ingest]() {
+      serveQueries(listener, *store, ingest);
+      close(listener);
+    });
+  }
+  fprintf(stderr, "fleet: listening on port %u (UDP%s), %u ingest threads\n", ingestConfig.port,
+          ingestConfig.tcp ? " and TCP" : "", ingest.threadCount());
+  if (queryPort) fprintf(stderr, "fleet: queries on 127.0.0.1:%u\n", queryPort);
+
+  // Standard input is a query console too; after it closes, run until signalled
+  bool interactive = true;
+  uint64_t lastFrames = 0;
+  auto lastStatus = std::chrono::steady_clock::now();
+  char line[256];
+  std::string answer;
+  while (!stopRequested) {
+    pollfd input = { STDIN_FILENO, POLLIN, 0 };
+    if (interactive && poll(&input, 1, 200) > 0) {
+      if (fgets(line, sizeof(line), stdin)) {
+        answer.clear();
+        runQuery(*store, ingest, line, answer);
+        fwrite(answer.data(), 1, answer.size(), stdout);
+        fflush(stdout);
+      } else {
+        interactive = false;
+      }
+    } else if (!interactive) {
+      usleep(200000);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastStatus).count();
+    if (statusSeconds > 0 && elapsed >= statusSeconds) {
+      printStatus(*store, ingest, lastFrames, elapsed);
+      lastStatus = std::chrono::steady_clock::now();
+    }
+  }
+
+  ingest.stop();
+  if (console.joinable()) console.join();
+  delete store;
+  return 0;
+}
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fleet-store.h"
+
+// ─────────────────────────────────────
+// Fleet Frame Ingest
+// ─────────────────────────────────────
+// Receives telemetry frames on one port over UDP (what the boards send)
+// and TCP (gateways, forwarders and replays: frames back to back on a
+// stream), decodes them on a pool of threads and appends them to the
+// store:
+//
+//   FleetIngest ingest(store, config);
+//   if (!ingest.start(error)) ...;   // binds UDP and TCP, spawns the threads
+//
+// Every thread binds its own UDP socket and TCP listener to the port
+// (SO_REUSEPORT), so the kernel spreads unicast senders and connections
+// over the threads by address, and all frames of one board reach one
+// thread in order. A broadcast datagram, which is what the boards send,
+// is delivered to every socket in the group instead. Only the first thread
+// keeps it and the others drop their copy, so each frame is stored once
+// and a broadcasting fleet is ingested by that one thread, still in order
+// per board. The destination address comes from IP_PKTINFO; directed
+// broadcast addresses are read from the interfaces at start().
+//
+// A thread drains its socket with recvmmsg() in batches, decodes and
+// CRC-checks the batch and appends it to the store with one lock per shard
+// touched. There is no hand-off queue between receiving and decoding, and
+// nothing is allocated per frame.
+//
+// A TCP stream that loses frame alignment (bad magic or CRC) skips ahead
+// a byte at a time until a valid frame decodes again.
+
+struct FleetIngestConfig {
+  uint16_t port = TELEMETRY_FRAME_PORT;
+  unsigned threads = 0;                 // 0 = one per CPU
+  bool tcp = true;
+  int receiveBuffer = 8 << 20;          // UDP socket buffer, bytes
+};
+
+struct FleetIngestStats {
+  std::atomic<uint64_t> datagrams{ 0 };
+  std::atomic<uint64_t> frames{ 0 };          // Decoded and stored
+  std::atomic<uint64_t> rejected[TELEMETRY_FRAME_BAD_CRC + 1] = {};   // By TelemetryFrameStatus
+  std::atomic<uint64_t> connections{ 0 };
+  std::atomic<uint64_t> streamBytes{ 0 };
+  std::atomic<uint64_t> skippedBytes{ 0 };    // Stream bytes dropped while realigning
+  std::atomic<uint64_t> broadcastCopies{ 0 }; // Broadcast datagrams dropped by the threads that do not keep them
+};
+
+class FleetIngest {
+public:
+  static const size_t BATCH = 64;             // Datagrams per recvmmsg()
+  static const size_t STREAM_BUFFER = 4096;
+
+  FleetIngest(FleetStore &fleetStore, const FleetIngestConfig &ingestConfig) : store(fleetStore), config(ingestConfig) {}
+  ~FleetIngest() { stop(); }
+
+  bool start(std::string &error) {
+    unsigned count = config.threads ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    readBroadcastAddresses();
+    running = true;
+    for (unsigned i = 0; i < count; i++) {
+      workers.emplace_back(new Worker());
+      workers.back()->keepsBroadcasts = i == 0;
+      if (!open(*workers.back(), error)) {
+        stop();
+        return false;
+      }
+    }
+    for (std::unique_ptr<Worker> &worker : workers) {
+      Worker *self = worker.get();
+      worker->thread = std::thread([this, self]() { run(*self); });
+    }
+    return true;
+  }
+
+  void stop() {
+    running = false;
+    for (std::unique_ptr<Worker> &worker : workers) {
+      if (worker->thread.joinable()) worker->thread.join();
+      for (Connection *connection : worker->connections) {
+        close(connection->fd);
+        delete connection;
+      }
+      if (worker->udp >= 0) close(worker->udp);
+      if (worker->listener >= 0) close(worker->listener);
+      if (worker->events >= 0) close(worker->events);
+    }
+    workers.clear();
+  }
+
+  unsigned threadCount() const { return workers.size(); }
+  const FleetIngestStats &stats() const { return statistics; }
+
+private:
+  struct Connection {
+    int fd = -1;
+    uint8_t buffer[STREAM_BUFFER];
+    size_t used = 0;
+    bool realigning = false;
+  };
+
+  struct Worker {
+    int udp = -1;
+    int listener = -1;
+    int events = -1;
+    bool keepsBroadcasts = false;     // Every socket receives each broadcast; one thread stores it
+    std::vector<Connection *> connections;
+    std::thread thread;
+  };
+
+  FleetStore &store;
+  FleetIngestConfig config;
+  FleetIngestStats statistics;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<in_addr_t> broadcastAddresses;   // Directed broadcast of each IPv4 interface
+  std::atomic<bool> running{ false };
+
+  static uint32_t collectorSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return (uint32_t)now.tv_sec;
+  }
+
+  static int boundSocket(int type, uint16_t port) {
+    int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(fd, (sockaddr *)&local, sizeof(local)) < 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  bool open(Worker &worker, std::string &error) {
+    worker.events = epoll_create1(EPOLL_CLOEXEC);
+    worker.udp = boundSocket(SOCK_DGRAM, config.port);
+    if (worker.events < 0 || worker.udp < 0) {
+      error = std::string("UDP port ") + std::to_string(config.port) + ": " + strerror(errno);
+      return false;
+    }
+    // Raising past net.core.rmem_max needs CAP_NET_ADMIN; fall back to the capped size
+    if (setsockopt(worker.udp, SOL_SOCKET, SO_RCVBUFFORCE, &config.receiveBuffer, sizeof(config.receiveBuffer)) < 0) {
+      setsockopt(worker.udp, SOL_SOCKET, SO_RCVBUF, &config.receiveBuffer, sizeof(config.receiveBuffer));
+    }
+    int enable = 1;
+    setsockopt(worker.udp, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable));
+    epoll_event udpEvent = {};
+    udpEvent.events = EPOLLIN;
+    udpEvent.data.ptr = nullptr;
+    epoll_ctl(worker.events, EPOLL_CTL_ADD, worker.udp, &udpEvent);
+
+    if (config.tcp) {
+      worker.listener = boundSocket(SOCK_STREAM, config.port);
+      if (worker.listener < 0 || listen(worker.listener, 128) < 0) {
+        error = std::string("TCP port ") + std::to_string(config.port) + ": " + strerror(errno);
+        return false;
+      }
+      epoll_event listenEvent = {};
+      listenEvent.events = EPOLLIN;
+      listenEvent.data.ptr = &worker.listener;
+      epoll_ctl(worker.events, EPOLL_CTL_ADD, worker.listener, &listenEvent);
+    }
+    return true;
+  }
+
+  void run(Worker &worker) {
+    epoll_event ready[16];
+    while (running) {
+      int count = epoll_wait(worker.events, ready, 16, 100);
+      for (int i = 0; i < count; i++) {
+        void *source = ready[i].data.ptr;
+        if (!source) {
+          drainDatagrams(worker);
+        } else if (source == &worker.listener) {
+          accept(worker);
+        } else {
+          Connection *connection = (Connection *)source;
+          if (!drainStream(*connection)) disconnect(worker, connection);
+        }
+      }
+    }
+  }
+
+  void readBroadcastAddresses() {
+    broadcastAddresses.clear();
+    ifaddrs *interfaces;
+    if (getifaddrs(&interfaces) < 0) return;
+    for (ifaddrs *entry = interfaces; entry; entry = entry->ifa_next) {
+      if (!entry->ifa_addr || entry->ifa_addr->sa_family != AF_INET) continue;
+      if (!(entry->ifa_flags & IFF_BROADCAST) || !entry->ifa_broadaddr) continue;
+      broadcastAddresses.push_back(((const sockaddr_in *)entry->ifa_broadaddr)->sin_addr.s_addr);
+    }
+    freeifaddrs(interfaces);
+  }
+
+  // Addressed to every host (limited or directed broadcast, or multicast)
+  // rather than to this one
+  bool broadcastDatagram(msghdr &header) const {
+    for (cmsghdr *message = CMSG_FIRSTHDR(&header); message; message = CMSG_NXTHDR(&header, message)) {
+      if (message->cmsg_level != IPPROTO_IP || message->cmsg_type != IP_PKTINFO) continue;
+      const in_addr_t destination = ((const in_pktinfo *)CMSG_DATA(message))->ipi_addr.s_addr;
+      if (destination == htonl(INADDR_BROADCAST) || IN_MULTICAST(ntohl(destination))) return true;
+      return std::find(broadcastAddresses.begin(), broadcastAddresses.end(), destination) != broadcastAddresses.end();
+    }
+    return false;
+  }
+
+  void drainDatagrams(Worker &worker) {
+    uint8_t payload[BATCH][TELEMETRY_FRAME_SIZE];
+    alignas(cmsghdr) uint8_t control[BATCH][CMSG_SPACE(sizeof(in_pktinfo))];
+    iovec vectors[BATCH];
+    mmsghdr messages[BATCH];
+    for (size_t i = 0; i < BATCH; i++) {
+      vectors[i] = { payload[i], TELEMETRY_FRAME_SIZE };
+      messages[i] = {};
+      messages[i].msg_hdr.msg_iov = &vectors[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_control = control[i];
+    }
+    TelemetryFrame frames[BATCH];
+    uint32_t arrival[BATCH];
+    uint64_t rejected[TELEMETRY_FRAME_BAD_CRC + 1] = {};
+    uint64_t copies = 0;
+
+    int received;
+    for (;;) {
+      for (size_t i = 0; i < BATCH; i++) messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+      if ((received = recvmmsg(worker.udp, messages, BATCH, MSG_DONTWAIT, nullptr)) <= 0) break;
+      const uint32_t now = collectorSeconds();
+      size_t decoded = 0;
+      int kept = 0;
+      for (int i = 0; i < received; i++) {
+        if (!worker.keepsBroadcasts && broadcastDatagram(messages[i].msg_hdr)) {
+          copies++;
+          continue;
+        }
+        kept++;
+        // Longer datagrams are cut to the frame size; a frame is never longer
+        size_t length = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) ? TELEMETRY_FRAME_SIZE : messages[i].msg_len;
+        TelemetryFrameStatus status = decodeTelemetryFrame(payload[i], length, frames[decoded]);
+        if (status == TELEMETRY_FRAME_OK) {
+          arrival[decoded++] = now;
+        } else {
+          rejected[status]++;
+        }
+      }
+      store.append(frames, arrival, decoded);
+      statistics.datagrams += kept;
+      statistics.frames += decoded;
+    }
+    if (copies) statistics.broadcastCopies += copies;
+    for (size_t status = 1; status <= TELEMETRY_FRAME_BAD_CRC; status++) {
+      if (rejected[status]) statistics.rejected[status] += rejected[status];
+    }
+  }
+
+  void accept(Worker &worker) {
+    int fd;
+    while ((fd = accept4(worker.listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+      Connection *connection = new Connection();
+      connection->fd = fd;
+      epoll_event event = {};
+      event.events = EPOLLIN | EPOLLRDHUP;
+      event.data.ptr = connection;
+      epoll_ctl(worker.events, EPOLL_CTL_ADD, fd, &event);
+      worker.connections.push_back(connection);
+      statistics.connections++;
+    }
+  }
+
+  void disconnect(Worker &worker, Connection *connection) {
+    epoll_ctl(worker.events, EPOLL_CTL_DEL, connection->fd, nullptr);
+    close(connection->fd);
+    worker.connections.erase(std::find(worker.connections.begin(), worker.connections.end(), connection));
+    delete connection;
+  }
+
+  // False once the peer has closed or the connection failed
+  bool drainStream(Connection &connection) {
+    TelemetryFrame frames[STREAM_BUFFER / TELEMETRY_FRAME_SIZE];
+    uint32_t arrival[STREAM_BUFFER / TELEMETRY_FRAME_SIZE];
+    for (;;) {
+      ssize_t length = read(connection.fd, connection.buffer + connection.used, STREAM_BUFFER - connection.used);
+      if (length == 0) return false;
+      if (length < 0) return errno == EAGAIN || errno == EINTR;
+      statistics.streamBytes += length;
+      connection.used += length;
+
+      const uint32_t now = collectorSeconds();
+      size_t decoded = 0;
+      size_t offset = 0;
+      uint64_t skipped = 0;
+      while (connection.used - offset >= TELEMETRY_FRAME_SIZE) {
+        TelemetryFrameStatus status = decodeTelemetryFrame(connection.buffer + offset, TELEMETRY_FRAME_SIZE, frames[decoded]);
+        if (status == TELEMETRY_FRAME_OK) {
+          arrival[decoded++] = now;
+          offset += TELEMETRY_FRAME_SIZE;
+          connection.realigning = false;
+        } else {
+          if (!connection.realigning) statistics.rejected[status]++;
+          connection.realigning = true;
+          offset++;
+          skipped++;
+        }
+      }
+      memmove(connection.buffer, connection.buffer + offset, connection.used - offset);
+      connection.used -= offset;
+      store.append(frames, arrival, decoded);
+      statistics.frames += decoded;
+      if (skipped) statistics.skippedBytes += skipped;
+    }
+  }
+};
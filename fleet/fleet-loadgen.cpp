@@ -0,0 +1,336 @@
+// ─────────────────────────────────────
+// EcoPulse Fleet Load Generator
+// ─────────────────────────────────────
+// Benchmarks a running fleet-collector: plays back the history of a
+// simulated fleet as telemetry frames, as fast as the collector takes
+// them or at a fixed rate, then reads the collector's counters and times
+// the example queries over its console:
+//
+//   ./fleet-collector --device-clock < /dev/null &
+//   ./fleet-loadgen --devices 500 --days 2
+//
+// Each device reports every 10 s: soil that dries and is watered by a
+// pump between a per-device threshold and threshold + 10 %, a daily
+// temperature swing and a day/night photosensor. Timestamps are UNIX time
+// ending now, so the collector must trust device clocks (--device-clock).
+// Sender threads own disjoint sets of devices and send in time order over
+// their own socket, 64 frames per sendmmsg() or one TCP write. --broadcast
+// sends the datagrams to 255.255.255.255 as the boards do; the run fails
+// unless every frame was stored exactly once and none arrived late.
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../telemetry-frame.h"
+
+namespace {
+
+typedef std::chrono::steady_clock LoadClock;
+
+struct LoadConfig {
+  unsigned devices = 500;
+  double days = 1;
+  uint32_t interval = 10;
+  unsigned senders = 4;
+  double rate = 0;              // Frames/s over all senders, 0 = unpaced
+  bool tcp = false;
+  bool broadcast = false;       // UDP to 255.255.255.255, as the boards send
+  bool queries = true;
+  const char *host = "127.0.0.1";
+  uint16_t port = TELEMETRY_FRAME_PORT;
+  uint16_t queryPort = TELEMETRY_FRAME_PORT + 1;
+};
+
+struct SimulatedDevice {
+  uint32_t deviceId;
+  uint16_t sequence;
+  float moisture;
+  float threshold;
+  float dryingPerStep;
+  float temperatureOffset;
+  bool pump;
+
+  TelemetrySample step(uint32_t time, uint32_t interval) {
+    moisture += pump ? 0.4f * interval / 10 : -dryingPerStep;
+    if (moisture < threshold) pump = true;
+    if (moisture > threshold + 10) pump = false;
+    double hour = (time % 86400) / 3600.0;
+    double sun = sin((hour - 6) * M_PI / 12);
+    TelemetrySample sample;
+    sample.timestamp = time;
+    sample.temperatureDeci = telemetryTemperature(16 + temperatureOffset + 6 * sin((hour - 9) * M_PI / 12));
+    sample.light = sun > 0 ? (uint16_t)(900 * sun) : 0;
+    sample.moisture = (uint8_t)std::max(0.0f, std::min(100.0f, moisture));
+    sample.flags = (pump ? TELEMETRY_FLAG_PUMP : 0) | (sample.light < 150 && hour > 17 && hour < 22 ? TELEMETRY_FLAG_LIGHTS : 0);
+    return sample;
+  }
+};
+
+void printUsage(const char *program) {
+  printf("usage: %s [options]\n"
+         "  --devices N      simulated boards (default 500)\n"
+         "  --days N         history per board (default 1)\n"
+         "  --interval S     seconds between frames of a board (default 10)\n"
+         "  --senders N      sender threads, one socket each (default 4)\n"
+         "  --rate FPS       total frames per second, 0 = as fast as possible (default 0)\n"
+         "  --tcp            stream over TCP instead of UDP datagrams\n"
+         "  --broadcast      send the datagrams to 255.255.255.255, as the boards do\n"
+         "  --host ADDR      collector address (default 127.0.0.1)\n"
+         "  --port N         collector frame port (default %u)\n"
+         "  --query-port N   collector console port (default %u)\n"
+         "  --no-queries     only send\n",
+         program, TELEMETRY_FRAME_PORT, TELEMETRY_FRAME_PORT + 1);
+}
+
+sockaddr_in collectorAddress(const LoadConfig &config, uint16_t port) {
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  inet_pton(AF_INET, config.host, &address.sin_addr);
+  return address;
+}
+
+// Sends every `senders`-th device's history; returns frames sent
+uint64_t runSender(const LoadConfig &config, unsigned index, uint32_t start, uint32_t steps) {
+  const size_t BATCH = 64;
+  sockaddr_in collector = collectorAddress(config, config.port);
+  if (config.broadcast) collector.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+  int fd = socket(AF_INET, config.tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+  int enable = 1;
+  if (config.broadcast) setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+  if (fd < 0 || connect(fd, (sockaddr *)&collector, sizeof(collector)) < 0) {
+    perror("fleet-loadgen: connect");
+    exit(1);
+  }
+  int sendBuffer = 4 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+  std::vector<SimulatedDevice> devices;
+  for (unsigned device = index; device < config.devices; device += config.senders) {
+    uint32_t seed = device * 2654435761u;
+    devices.push_back({ 0xEC000000u | device, 0, 30.0f + seed % 40, 20.0f + (seed >> 8) % 20,
+                        (0.6f + (seed >> 16) % 20 * 0.05f) * config.interval / 3600, ((seed >> 24) % 40) / 10.0f - 2, false });
+  }
+
+  uint8_t payload[BATCH][TELEMETRY_FRAME_SIZE];
+  iovec vectors[BATCH];
+  mmsghdr messages[BATCH];
+  for (size_t i = 0; i < BATCH; i++) {
+    vectors[i] = { payload[i], TELEMETRY_FRAME_SIZE };
+    messages[i] = {};
+    messages[i].msg_hdr.msg_iov = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  const double perSecond = config.rate / config.senders;
+  const LoadClock::time_point began = LoadClock::now();
+  uint64_t sent = 0;
+  size_t pending = 0;
+  auto flush = [&]() {
+    if (config.tcp) {
+      const uint8_t *bytes = payload[0];
+      size_t length = pending * TELEMETRY_FRAME_SIZE;
+      while (length) {
+        ssize_t written = send(fd, bytes, length, 0);
+        if (written <= 0) {
+          perror("fleet-loadgen: send");
+          exit(1);
+        }
+        bytes += written;
+        length -= written;
+      }
+    } else {
+      for (size_t done = 0; done < pending;) {
+        int count = sendmmsg(fd, messages + done, pending - done, 0);
+        if (count <= 0) {
+          if (errno == ECONNREFUSED) continue;   // ICMP from a moment with no listener; the datagram is gone
+          perror("fleet-loadgen: sendmmsg");
+          exit(1);
+        }
+        done += count;
+      }
+    }
+    sent += pending;
+    pending = 0;
+    if (perSecond > 0) std::this_thread::sleep_until(began + std::chrono::duration<double>(sent / perSecond));
+  };
+
+  for (uint32_t step = 0; step < steps; step++) {
+    uint32_t time = start + step * config.interval;
+    for (SimulatedDevice &device : devices) {
+      encodeTelemetryFrame(payload[pending++], device.sequence++, device.deviceId, device.step(time, config.interval));
+      if (pending == BATCH) flush();
+    }
+  }
+  if (pending) flush();
+  close(fd);
+  return sent;
+}
+
+class QueryConsole {
+public:
+  bool open(const LoadConfig &config) {
+    sockaddr_in address = collectorAddress(config, config.queryPort);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0) return false;
+    replies = fdopen(fd, "r");
+    requests = fdopen(dup(fd), "w");
+    return replies && requests;
+  }
+
+  ~QueryConsole() {
+    if (replies) fclose(replies);
+    if (requests) fclose(requests);
+  }
+
+  // Answer without the trailing "# ms" and empty lines
+  std::string ask(const char *query) {
+    fprintf(requests, "%s\n", query);
+    fflush(requests);
+    std::string answer;
+    char line[512];
+    while (fgets(line, sizeof(line), replies) && line[0] != '\n') {
+      if (line[0] != '#') answer += line;
+    }
+    return answer;
+  }
+
+  uint64_t counter(const char *name) {
+    std::string stats = ask("stats");
+    size_t at = stats.find(std::string(name) + " ");
+    return at == std::string::npos ? 0 : strtoull(stats.c_str() + at + strlen(name) + 1, nullptr, 10);
+  }
+
+private:
+  FILE *replies = nullptr;
+  FILE *requests = nullptr;
+};
+
+void timeQuery(QueryConsole &console, const char *query, const char *label) {
+  const int RUNS = 5;
+  double best = 1e9;
+  std::string answer;
+  for (int run = 0; run < RUNS; run++) {
+    auto started = LoadClock::now();
+    answer = console.ask(query);
+    best = std::min(best, std::chrono::duration<double, std::milli>(LoadClock::now() - started).count());
+  }
+  std::string first = answer.substr(0, answer.find('\n'));
+  printf("  %-26s %8.2f ms   %s\n", label, best, first.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  LoadConfig config;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--devices") && value) {
+      config.devices = (unsigned)atoi(value); i++;
+    } else if (!strcmp(arg, "--days") && value) {
+      config.days = atof(value); i++;
+    } else if (!strcmp(arg, "--interval") && value) {
+      config.interval = (uint32_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--senders") && value) {
+      config.senders = (unsigned)atoi(value); i++;
+    } else if (!strcmp(arg, "--rate") && value) {
+      config.rate = atof(value); i++;
+    } else if (!strcmp(arg, "--tcp")) {
+      config.tcp = true;
+    } else if (!strcmp(arg, "--broadcast")) {
+      config.broadcast = true;
+    } else if (!strcmp(arg, "--host") && value) {
+      config.host = value; i++;
+    } else if (!strcmp(arg, "--port") && value) {
+      config.port = (uint16_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--query-port") && value) {
+      config.queryPort = (uint16_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--no-queries")) {
+      config.queries = false;
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (!config.devices || !config.senders || !config.interval || config.days <= 0 || (config.tcp && config.broadcast)) {
+    printUsage(argv[0]);
+    return 2;
+  }
+  config.senders = std::min(config.senders, config.devices);
+
+  QueryConsole console;
+  if (!console.open(config)) {
+    fprintf(stderr, "fleet-loadgen: no collector console on %s:%u\n", config.host, config.queryPort);
+    return 1;
+  }
+  const uint64_t storedBefore = console.counter("frames");
+  const uint64_t lateBefore = console.counter("late");
+
+  const uint32_t steps = (uint32_t)(config.days * 86400 / config.interval);
+  const uint32_t start = (uint32_t)time(nullptr) - steps * config.interval;
+  const uint64_t total = (uint64_t)steps * config.devices;
+  printf("fleet load: %u devices x %u frames (%.1f days at %u s) = %llu frames over %s, %u senders\n", config.devices, steps,
+         config.days, config.interval, (unsigned long long)total,
+         config.tcp ? "TCP" : config.broadcast ? "UDP broadcast" : "UDP", config.senders);
+
+  std::atomic<uint64_t> sent{ 0 };
+  std::vector<std::thread> senders;
+  const LoadClock::time_point began = LoadClock::now();
+  for (unsigned index = 0; index < config.senders; index++) {
+    senders.emplace_back([&, index]() { sent += runSender(config, index, start, steps); });
+  }
+  for (std::thread &sender : senders) sender.join();
+  const double sendSeconds = std::chrono::duration<double>(LoadClock::now() - began).count();
+
+  // Wait for the collector to drain its sockets
+  uint64_t stored = console.counter("frames") - storedBefore;
+  double storeSeconds = std::chrono::duration<double>(LoadClock::now() - began).count();
+  for (int idle = 0; stored < sent && idle < 20;) {
+    usleep(50000);
+    uint64_t now = console.counter("frames") - storedBefore;
+    if (now == stored) {
+      idle++;
+    } else {
+      idle = 0;
+      stored = now;
+      storeSeconds = std::chrono::duration<double>(LoadClock::now() - began).count();
+    }
+  }
+
+  printf("  %-10s %10llu frames in %6.2f s  %9.0f frames/s\n", "sent", (unsigned long long)sent.load(), sendSeconds,
+         sent / sendSeconds);
+  if (stored <= sent) {
+    printf("  %-10s %10llu frames in %6.2f s  %9.0f frames/s  (%llu lost, %.3f %%)\n", "stored", (unsigned long long)stored,
+           storeSeconds, stored / storeSeconds, (unsigned long long)(sent - stored), 100.0 * (sent - stored) / sent);
+  } else {
+    printf("  %-10s %10llu frames in %6.2f s  %9.0f frames/s  (%llu stored twice)\n", "stored", (unsigned long long)stored,
+           storeSeconds, stored / storeSeconds, (unsigned long long)(stored - sent));
+  }
+  const uint64_t late = console.counter("late") - lateBefore;
+  printf("  %-10s %10llu frames behind a later frame of their device\n", "late", (unsigned long long)late);
+
+  if (config.queries) {
+    char range[64];
+    snprintf(range, sizeof(range), "range %08x -24h now", 0xEC000000u);
+    printf("queries (round trip on the console, best of 5)\n");
+    timeQuery(console, "below 30", "below 30");
+    timeQuery(console, "pump-hours 7", "pump-hours 7");
+    timeQuery(console, range, "range (one device, 24 h)");
+    timeQuery(console, "devices", "devices");
+  }
+  return stored == sent && !late ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string>
+
+#include "fleet-store.h"
+
+// ─────────────────────────────────────
+// Fleet Queries
+// ─────────────────────────────────────
+// Range and aggregate queries over the store, answered as text tables
+// for the query console:
+//
+//   below 30                   devices whose latest moisture is under 30 %
+//   pump-hours 7               pump run time per device per UTC day
+//   range ec000001 -24h now    moisture/temperature/light/pump summary
+//   series ec000001 -1h now    raw samples as CSV
+//   devices                    every device with its link statistics
+//
+// Times are UNIX seconds, "now", or relative to the newest sample in the
+// store ("-90s", "-30m", "-6h", "-2d"), so replayed or simulated data
+// queries the same way as live data.
+//
+// A sample stands for the interval until the next sample of its device,
+// capped at FleetStoreConfig::maxSampleGap, so lost frames and outages do
+// not count as pump time. Intervals are split at day boundaries.
+
+inline void appendf(std::string &out, const char *format, ...) {
+  char line[256];
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(line, sizeof(line), format, arguments);
+  va_end(arguments);
+  out.append(line, length < (int)sizeof(line) ? length : sizeof(line) - 1);
+}
+
+inline bool parseQueryTime(const char *text, uint32_t now, uint32_t &time) {
+  if (!strcmp(text, "now")) {
+    time = now;
+    return true;
+  }
+  char *end;
+  if (text[0] == '-') {
+    double amount = strtod(text + 1, &end);
+    double unit = *end == 's' ? 1 : *end == 'm' ? 60 : *end == 'h' ? 3600 : *end == 'd' ? 86400 : 0;
+    if (end == text + 1 || !unit || end[1]) return false;
+    double seconds = amount * unit;
+    time = seconds >= now ? 0 : now - (uint32_t)seconds;
+    return true;
+  }
+  unsigned long absolute = strtoul(text, &end, 10);
+  if (end == text || *end) return false;
+  time = (uint32_t)absolute;
+  return true;
+}
+
+inline const char *formatQueryTime(uint32_t time, char *text, size_t size) {
+  time_t seconds = time;
+  tm utc;
+  gmtime_r(&seconds, &utc);
+  strftime(text, size, "%Y-%m-%d %H:%M:%S", &utc);
+  return text;
+}
+
+// Seconds with the pump on in [from, to), per day starting at `firstDay`
+// (UTC day number); days[] holds `dayCount` entries, or pass dayCount 0
+// for the total only. Returns the total.
+inline double pumpSeconds(const DeviceSeries &series, uint32_t from, uint32_t to, uint32_t maxGap,
+                          uint32_t firstDay = 0, double *days = nullptr, size_t dayCount = 0) {
+  double total = 0;
+  bool previousPump = false;
+  uint32_t previousTime = 0;
+  for (const std::unique_ptr<SeriesChunk> &chunk : series.chunks) {
+    if (chunk->lastTime() + maxGap < from) continue;
+    if (chunk->firstTime() >= to && !previousPump) break;
+    for (size_t row = 0; row < chunk->count; row++) {
+      uint32_t time = chunk->time[row];
+      if (previousPump) {
+        uint32_t start = std::max(previousTime, from);
+        uint32_t end = std::min(std::min(time, previousTime + maxGap), to);
+        if (end > start) {
+          total += end - start;
+          if (dayCount) {
+            uint32_t boundary = (start / 86400 + 1) * 86400;
+            uint32_t day = start / 86400 - firstDay;
+            uint32_t inFirst = std::min(end, boundary) - start;
+            if (day < dayCount) days[day] += inFirst;
+            if (end > boundary && day + 1 < dayCount) days[day + 1] += end - boundary;
+          }
+        }
+      }
+      if (time >= to) return total;
+      previousPump = chunk->flags[row] & TELEMETRY_FLAG_PUMP;
+      previousTime = time;
+    }
+  }
+  return total;
+}
+
+inline void queryBelow(const FleetStore &store, int threshold, std::string &out) {
+  struct Dry {
+    uint32_t deviceId;
+    uint8_t moisture;
+    uint32_t since;
+    uint32_t last;
+    bool pump;
+  };
+  std::vector<Dry> dry;
+  size_t devices = 0;
+  store.forEachDevice([&](const DeviceSeries &series) {
+    if (series.chunks.empty()) return;
+    devices++;
+    const SeriesChunk &newest = *series.chunks.back();
+    size_t last = newest.count - 1;
+    if (newest.moisture[last] >= threshold) return;
+    // Walk back to the start of the dry run
+    uint32_t since = newest.time[last];
+    for (size_t chunk = series.chunks.size(); chunk-- > 0;) {
+      const SeriesChunk &rows = *series.chunks[chunk];
+      size_t row = rows.count;
+      while (row > 0 && rows.moisture[row - 1] < threshold) since = rows.time[--row];
+      if (row > 0) break;
+    }
+    dry.push_back({ series.deviceId, newest.moisture[last], since, newest.time[last], (newest.flags[last] & TELEMETRY_FLAG_PUMP) != 0 });
+  });
+  std::sort(dry.begin(), dry.end(), [](const Dry &a, const Dry &b) {
+    return a.moisture != b.moisture ? a.moisture < b.moisture : a.deviceId < b.deviceId;
+  });
+
+  appendf(out, "%zu of %zu devices below %d %% moisture\n", dry.size(), devices, threshold);
+  if (dry.empty()) return;
+  appendf(out, "device    moisture  below since           for       pump\n");
+  char since[24];
+  for (const Dry &device : dry) {
+    appendf(out, "%08x  %5u %%   %s  %6.1f h  %s\n", device.deviceId, device.moisture,
+            formatQueryTime(device.since, since, sizeof(since)), (device.last - device.since) / 3600.0,
+            device.pump ? "on" : "off");
+  }
+}
+
+inline void queryPumpHours(const FleetStore &store, uint32_t dayCount, std::string &out) {
+  const size_t MAX_DAYS = 31;
+  if (dayCount < 1) dayCount = 1;
+  if (dayCount > MAX_DAYS) dayCount = MAX_DAYS;
+  const uint32_t now = store.newestTime();
+  const uint32_t lastDay = now / 86400;
+  const uint32_t firstDay = lastDay + 1 >= dayCount ? lastDay + 1 - dayCount : 0;
+  const uint32_t from = firstDay * 86400;
+  const uint32_t to = (lastDay + 1) * 86400;
+
+  struct Row {
+    uint32_t deviceId;
+    double days[MAX_DAYS];
+  };
+  std::vector<Row> rows;
+  double fleet[MAX_DAYS] = {};
+  store.forEachDevice([&](const DeviceSeries &series) {
+    if (series.chunks.empty() || series.newestTime() < from) return;
+    rows.push_back(Row());
+    Row &row = rows.back();
+    row.deviceId = series.deviceId;
+    memset(row.days, 0, sizeof(row.days));
+    pumpSeconds(series, from, to, store.settings().maxSampleGap, firstDay, row.days, dayCount);
+    for (size_t day = 0; day < dayCount; day++) fleet[day] += row.days[day];
+  });
+  std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.deviceId < b.deviceId; });
+
+  appendf(out, "pump-hours per UTC day, %zu devices\ndevice  ", rows.size());
+  for (uint32_t day = firstDay; day <= lastDay; day++) {
+    time_t seconds = (time_t)day * 86400;
+    tm utc;
+    gmtime_r(&seconds, &utc);
+    appendf(out, "  %02d-%02d", utc.tm_mon + 1, utc.tm_mday);
+  }
+  appendf(out, "   total\n");
+  for (const Row &row : rows) {
+    double total = 0;
+    appendf(out, "%08x", row.deviceId);
+    for (size_t day = 0; day < dayCount; day++) {
+      appendf(out, " %6.2f", row.days[day] / 3600.0);
+      total += row.days[day];
+    }
+    appendf(out, " %7.2f\n", total / 3600.0);
+  }
+  double total = 0;
+  appendf(out, "fleet   ");
+  for (size_t day = 0; day < dayCount; day++) {
+    appendf(out, " %6.1f", fleet[day] / 3600.0);
+    total += fleet[day];
+  }
+  appendf(out, " %7.1f\n", total / 3600.0);
+}
+
+inline void queryRange(const FleetStore &store, uint32_t deviceId, uint32_t from, uint32_t to, std::string &out) {
+  bool known = store.withDevice(deviceId, [&](const DeviceSeries &series) {
+    size_t samples = 0, temperatures = 0;
+    uint64_t moistureSum = 0, lightSum = 0;
+    int64_t temperatureSum = 0;
+    int moistureMin = 255, moistureMax = -1, temperatureMin = INT16_MAX, temperatureMax = INT16_MIN;
+    for (const std::unique_ptr<SeriesChunk> &chunk : series.chunks) {
+      if (chunk->lastTime() < from) continue;
+      if (chunk->firstTime() >= to) break;
+      size_t begin = std::lower_bound(chunk->time, chunk->time + chunk->count, from) - chunk->time;
+      size_t end = std::lower_bound(chunk->time, chunk->time + chunk->count, to) - chunk->time;
+      for (size_t row = begin; row < end; row++) {
+        moistureSum += chunk->moisture[row];
+        moistureMin = std::min<int>(moistureMin, chunk->moisture[row]);
+        moistureMax = std::max<int>(moistureMax, chunk->moisture[row]);
+        lightSum += chunk->light[row];
+        int16_t temperature = chunk->temperature[row];
+        if (temperature != TELEMETRY_TEMPERATURE_UNKNOWN) {
+          temperatureSum += temperature;
+          temperatureMin = std::min<int>(temperatureMin, temperature);
+          temperatureMax = std::max<int>(temperatureMax, temperature);
+          temperatures++;
+        }
+      }
+      samples += end - begin;
+    }
+    char first[24], last[24];
+    appendf(out, "%08x  %s .. %s UTC\n", series.deviceId, formatQueryTime(from, first, sizeof(first)),
+            formatQueryTime(to, last, sizeof(last)));
+    appendf(out, "samples      %zu\n", samples);
+    if (!samples) return;
+    appendf(out, "moisture     min %d  mean %.1f  max %d %%\n", moistureMin, (double)moistureSum / samples, moistureMax);
+    if (temperatures) {
+      appendf(out, "temperature  min %.1f  mean %.1f  max %.1f C\n", temperatureMin / 10.0,
+              temperatureSum / 10.0 / temperatures, temperatureMax / 10.0);
+    }
+    appendf(out, "light        mean %.0f counts\n", (double)lightSum / samples);
+    appendf(out, "pump         %.2f h\n", pumpSeconds(series, from, to, store.settings().maxSampleGap) / 3600.0);
+  });
+  if (!known) appendf(out, "unknown device %08x\n", deviceId);
+}
+
+inline void querySeries(const FleetStore &store, uint32_t deviceId, uint32_t from, uint32_t to, std::string &out) {
+  bool known = store.withDevice(deviceId, [&](const DeviceSeries &series) {
+    appendf(out, "time,temperature,light,moisture,pump,lights,failsafe\n");
+    for (const std::unique_ptr<SeriesChunk> &chunk : series.chunks) {
+      if (chunk->lastTime() < from) continue;
+      if (chunk->firstTime() >= to) break;
+      size_t begin = std::lower_bound(chunk->time, chunk->time + chunk->count, from) - chunk->time;
+      size_t end = std::lower_bound(chunk->time, chunk->time + chunk->count, to) - chunk->time;
+      for (size_t row = begin; row < end; row++) {
+        uint8_t flags = chunk->flags[row];
+        if (chunk->temperature[row] == TELEMETRY_TEMPERATURE_UNKNOWN) {
+          appendf(out, "%u,,%u,%u", chunk->time[row], chunk->light[row], chunk->moisture[row]);
+        } else {
+          appendf(out, "%u,%.1f,%u,%u", chunk->time[row], chunk->temperature[row] / 10.0, chunk->light[row], chunk->moisture[row]);
+        }
+        appendf(out, ",%d,%d,%d\n", (flags & TELEMETRY_FLAG_PUMP) != 0, (flags & TELEMETRY_FLAG_LIGHTS) != 0,
+                (flags & TELEMETRY_FLAG_FAILSAFE) != 0);
+      }
+    }
+  });
+  if (!known) appendf(out, "unknown device %08x\n", deviceId);
+}
+
+inline void queryDevices(const FleetStore &store, std::string &out) {
+  struct Row {
+    uint32_t deviceId;
+    size_t samples;
+    uint32_t oldest, newest;
+    uint8_t moisture;
+    uint64_t frames, lost, late;
+    uint32_t restarts;
+  };
+  std::vector<Row> rows;
+  store.forEachDevice([&](const DeviceSeries &series) {
+    if (series.chunks.empty()) return;
+    const SeriesChunk &newest = *series.chunks.back();
+    rows.push_back({ series.deviceId, series.samples, series.oldestTime(), series.newestTime(), newest.moisture[newest.count - 1],
+                     series.frames, series.lost, series.late, series.restarts });
+  });
+  std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.deviceId < b.deviceId; });
+  appendf(out, "%zu devices\n", rows.size());
+  appendf(out, "device     samples  newest (UTC)          span h  moisture    frames   lost   late  restarts\n");
+  char newest[24];
+  for (const Row &row : rows) {
+    appendf(out, "%08x  %8zu  %s  %6.1f  %6u %%  %8llu  %5llu  %5llu  %8u\n", row.deviceId, row.samples,
+            formatQueryTime(row.newest, newest, sizeof(newest)), (row.newest - row.oldest) / 3600.0, row.moisture,
+            (unsigned long long)row.frames, (unsigned long long)row.lost, (unsigned long long)row.late, row.restarts);
+  }
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../telemetry-frame.h"
+
+// ─────────────────────────────────────
+// Columnar Fleet Store
+// ─────────────────────────────────────
+// In-memory time series for every board feeding the collector. Each
+// device's samples are kept in time order in fixed-size chunks, one array
+// per field (time, temperature, light, moisture, flags), so a query reads
+// only the columns it needs - "pump-hours" touches 5 bytes per sample,
+// "below threshold" only the newest rows:
+//
+//   FleetStore store(config);
+//   store.append(frames, arrivalSeconds, count);   // from the ingest threads
+//   store.forEachDevice([](const DeviceSeries &series) { ... });
+//
+// Devices are spread over SHARDS by ID, each behind its own mutex. An
+// ingest thread takes a shard's lock once per batch; a query takes the
+// locks one shard at a time, so queries and ingest interleave and a query
+// sees each shard at a consistent point.
+//
+// Device timestamps are seconds on the board's own clock (from boot, or
+// the DutyCycle origin). Unless the clock is trusted as UNIX time, each
+// device is anchored to the collector's clock when its first frame
+// arrives, and re-anchored when a live frame disagrees with the anchor by
+// more than reanchorSeconds or the device restarts (its sequence number
+// falls back). Journal backlog replayed after an outage keeps its original
+// timestamps and lands in place. Retention drops whole chunks.
+
+struct FleetStoreConfig {
+  uint32_t retentionSeconds = 30 * 86400;
+  uint32_t maxSampleGap = 300;       // Longest interval one sample is taken to stand for, seconds
+  uint32_t reanchorSeconds = 600;
+  bool deviceClock = false;          // Device timestamps are already UNIX time
+};
+
+struct SeriesChunk {
+  static const uint16_t CAPACITY = 4096;
+
+  uint16_t count = 0;
+  uint32_t time[CAPACITY];           // Collector clock, UNIX seconds
+  int16_t temperature[CAPACITY];     // Degrees C x 10, TELEMETRY_TEMPERATURE_UNKNOWN without a reading
+  uint16_t light[CAPACITY];
+  uint8_t moisture[CAPACITY];
+  uint8_t flags[CAPACITY];
+
+  uint32_t firstTime() const { return time[0]; }
+  uint32_t lastTime() const { return time[count - 1]; }
+};
+
+struct DeviceSeries {
+  uint32_t deviceId = 0;
+  std::vector<std::unique_ptr<SeriesChunk>> chunks;
+  size_t samples = 0;
+
+  // Link accounting from sequence numbers
+  uint64_t frames = 0;
+  uint64_t lost = 0;                 // Sequence numbers skipped and not seen since
+  uint64_t late = 0;                 // Arrived behind a later frame
+  uint32_t restarts = 0;
+  uint16_t nextSequence = 0;
+  uint32_t lastArrival = 0;
+
+  // Clock anchoring
+  int64_t clockOffset = 0;           // Collector time - device time
+  uint32_t lastDeviceTime = 0;
+
+  uint32_t newestTime() const { return chunks.empty() ? 0 : chunks.back()->lastTime(); }
+  uint32_t oldestTime() const { return chunks.empty() ? 0 : chunks.front()->firstTime(); }
+};
+
+class FleetStore {
+public:
+  static const size_t SHARDS = 64;
+  static const uint16_t REORDER_WINDOW = 64;   // Sequence numbers a late frame may trail by
+
+  explicit FleetStore(const FleetStoreConfig &storeConfig = FleetStoreConfig()) : config(storeConfig) {}
+
+  const FleetStoreConfig &settings() const { return config; }
+
+  // Frames decoded by one ingest thread, with the collector time each
+  // arrived at. Frames of one device must be passed in arrival order.
+  void append(const TelemetryFrame *frames, const uint32_t *arrival, size_t count) {
+    uint8_t shardOf[256];
+    while (count > 0) {
+      size_t batch = std::min(count, sizeof(shardOf));
+      uint64_t present = 0;
+      for (size_t i = 0; i < batch; i++) {
+        shardOf[i] = shardIndex(frames[i].deviceId);
+        present |= 1ull << shardOf[i];
+      }
+      for (size_t shardNumber = 0; present; shardNumber++, present >>= 1) {
+        if (!(present & 1)) continue;
+        Shard &shard = shards[shardNumber];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        for (size_t i = 0; i < batch; i++) {
+          if (shardOf[i] == shardNumber) store(shard, frames[i], arrival[i]);
+        }
+      }
+      frames += batch;
+      arrival += batch;
+      count -= batch;
+    }
+  }
+
+  // Calls visit(const DeviceSeries &) for every device, one shard locked at a time
+  template <typename Visitor>
+  void forEachDevice(Visitor visit) const {
+    for (const Shard &shard : shards) {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      for (const std::unique_ptr<DeviceSeries> &series : shard.devices) visit(*series);
+    }
+  }
+
+  // Calls visit(const DeviceSeries &) for one device; false if unknown
+  template <typename Visitor>
+  bool withDevice(uint32_t deviceId, Visitor visit) const {
+    const Shard &shard = shards[shardIndex(deviceId)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(deviceId);
+    if (found == shard.index.end()) return false;
+    visit(*shard.devices[found->second]);
+    return true;
+  }
+
+  // Newest sample time across the fleet, the "now" of relative queries
+  uint32_t newestTime() const {
+    uint32_t newest = 0;
+    forEachDevice([&](const DeviceSeries &series) { newest = std::max(newest, series.newestTime()); });
+    return newest;
+  }
+
+private:
+  struct Shard {
+    mutable std::mutex lock;
+    std::unordered_map<uint32_t, size_t> index;
+    std::vector<std::unique_ptr<DeviceSeries>> devices;
+  };
+
+  FleetStoreConfig config;
+  Shard shards[SHARDS];
+
+  static size_t shardIndex(uint32_t deviceId) {
+    return (deviceId * 2654435761u) >> 26;   // Fibonacci hash, top 6 bits
+  }
+
+  static DeviceSeries &device(Shard &shard, uint32_t deviceId) {
+    auto found = shard.index.find(deviceId);
+    if (found != shard.index.end()) return *shard.devices[found->second];
+    shard.index.emplace(deviceId, shard.devices.size());
+    shard.devices.emplace_back(new DeviceSeries());
+    shard.devices.back()->deviceId = deviceId;
+    return *shard.devices.back();
+  }
+
+  void store(Shard &shard, const TelemetryFrame &frame, uint32_t arrival) {
+    DeviceSeries &series = device(shard, frame.deviceId);
+    const uint32_t deviceTime = frame.sample.timestamp;
+    const int64_t arrivalOffset = (int64_t)arrival - deviceTime;
+    const bool first = series.frames == 0;
+    series.frames++;
+    series.lastArrival = arrival;
+
+    uint16_t ahead = frame.sequence - series.nextSequence;
+    bool forward = ahead < 0x8000;
+    if (first) {
+      forward = true;
+    } else if (forward) {
+      series.lost += ahead;
+    } else if ((uint16_t)-ahead <= REORDER_WINDOW) {
+      series.late++;
+      if (series.lost) series.lost--;
+    } else {
+      // Sequence fell back further than reordering explains: the board restarted
+      forward = true;
+      series.restarts++;
+      series.clockOffset = arrivalOffset;
+      series.lastDeviceTime = deviceTime;
+    }
+    if (forward) series.nextSequence = frame.sequence + 1;
+
+    if (first) {
+      series.clockOffset = arrivalOffset;
+      series.lastDeviceTime = deviceTime;
+    } else if (forward && deviceTime >= series.lastDeviceTime) {
+      // A live frame; backlog (older device time) keeps the anchor
+      int64_t drift = arrivalOffset - series.clockOffset;
+      if (drift > config.reanchorSeconds || drift < -(int64_t)config.reanchorSeconds) series.clockOffset = arrivalOffset;
+      series.lastDeviceTime = deviceTime;
+    }
+
+    int64_t time = config.deviceClock ? deviceTime : deviceTime + series.clockOffset;
+    insert(series, (uint32_t)std::max<int64_t>(0, std::min<int64_t>(time, UINT32_MAX)), frame.sample);
+  }
+
+  void insert(DeviceSeries &series, uint32_t time, const TelemetrySample &sample) {
+    std::vector<std::unique_ptr<SeriesChunk>> &chunks = series.chunks;
+    if (chunks.empty() || time >= chunks.back()->lastTime()) {
+      if (chunks.empty() || chunks.back()->count == SeriesChunk::CAPACITY) {
+        chunks.emplace_back(new SeriesChunk());
+        expire(series, time);
+      }
+      SeriesChunk &chunk = *chunks.back();
+      put(chunk, chunk.count++, time, sample);
+      series.samples++;
+      return;
+    }
+
+    // Out of order (backlog, or a late datagram): the chunk it falls in
+    size_t at = chunks.size() - 1;
+    while (at > 0 && chunks[at]->firstTime() > time) at--;
+    if (time + config.retentionSeconds < series.newestTime()) return;   // Already past retention
+    if (chunks[at]->count == SeriesChunk::CAPACITY) {
+      split(chunks, at);
+      if (time >= chunks[at + 1]->firstTime()) at++;
+    }
+    SeriesChunk &chunk = *chunks[at];
+    size_t position = std::upper_bound(chunk.time, chunk.time + chunk.count, time) - chunk.time;
+    size_t tail = chunk.count - position;
+    memmove(chunk.time + position + 1, chunk.time + position, tail * sizeof(chunk.time[0]));
+    memmove(chunk.temperature + position + 1, chunk.temperature + position, tail * sizeof(chunk.temperature[0]));
+    memmove(chunk.light + position + 1, chunk.light + position, tail * sizeof(chunk.light[0]));
+    memmove(chunk.moisture + position + 1, chunk.moisture + position, tail);
+    memmove(chunk.flags + position + 1, chunk.flags + position, tail);
+    put(chunk, position, time, sample);
+    chunk.count++;
+    series.samples++;
+  }
+
+  static void put(SeriesChunk &chunk, size_t row, uint32_t time, const TelemetrySample &sample) {
+    chunk.time[row] = time;
+    chunk.temperature[row] = sample.temperatureDeci;
+    chunk.light[row] = sample.light;
+    chunk.moisture[row] = sample.moisture;
+    chunk.flags[row] = sample.flags;
+  }
+
+  // Moves the upper half of a full chunk into a new chunk after it
+  static void split(std::vector<std::unique_ptr<SeriesChunk>> &chunks, size_t at) {
+    SeriesChunk &full = *chunks[at];
+    std::unique_ptr<SeriesChunk> upper(new SeriesChunk());
+    const uint16_t keep = SeriesChunk::CAPACITY / 2;
+    upper->count = full.count - keep;
+    memcpy(upper->time, full.time + keep, upper->count * sizeof(full.time[0]));
+    memcpy(upper->temperature, full.temperature + keep, upper->count * sizeof(full.temperature[0]));
+    memcpy(upper->light, full.light + keep, upper->count * sizeof(full.light[0]));
+    memcpy(upper->moisture, full.moisture + keep, upper->count);
+    memcpy(upper->flags, full.flags + keep, upper->count);
+    full.count = keep;
+    chunks.insert(chunks.begin() + at + 1, std::move(upper));
+  }
+
+  // Drops chunks that ended before the retention window
+  void expire(DeviceSeries &series, uint32_t newest) {
+    size_t expired = 0;
+    while (expired + 1 < series.chunks.size() && series.chunks[expired]->count &&
+           series.chunks[expired]->lastTime() + config.retentionSeconds < newest) {
+      series.samples -= series.chunks[expired]->count;
+      expired++;
+    }
+    series.chunks.erase(series.chunks.begin(), series.chunks.begin() + expired);
+  }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Arduino.h>
+#include "logger.h"
+
+// ─────────────────────────────────────
+// Heap and Fragmentation Monitor
+// ─────────────────────────────────────
+// Samples the heap at a fixed interval and keeps a ring of past samples, so
+// a slow leak or creeping fragmentation shows up as a trend days before an
+// allocation fails:
+//
+//   heapMonitor.begin(30 * 60 * 1000UL, 20000);  // 48 samples span 24 h; warn under a 20 KB block
+//   heapMonitor.poll();                           // from loop()
+//
+// A sample is one ESP.getHeapStats() call: free bytes, the largest block a
+// single malloc() can still get, and the core's fragmentation metric (0 %
+// when all free memory is one block). The largest block is the figure to
+// watch - the TLS client needs its receive buffer in one piece, and free
+// heap can look healthy while no block is large enough.
+//
+// Only the periodic samples enter the history, so its trend is not skewed;
+// lows and highs since boot also count samples forced with sample() at
+// known peaks (e.g. right after a TLS connect), so a dip between periodic
+// samples is not missed.
+
+struct HeapSample {
+  uint16_t freeHeap;        // Bytes; the ESP8266 heap never exceeds 64 KB
+  uint16_t largestBlock;
+  uint8_t fragmentation;    // Percent
+};
+
+struct MemoryStats {
+  uint32_t samples = 0;
+  uint16_t lowestFreeHeap = UINT16_MAX;       // Since boot
+  uint16_t lowestLargestBlock = UINT16_MAX;
+  uint8_t highestFragmentation = 0;
+  uint16_t lowBlockEpisodes = 0;              // Times the largest block fell under the warning level
+};
+
+template <uint8_t HISTORY = 48>
+class HeapMonitor {
+public:
+  // `lowBlockBytes` of 0 disables the warning.
+  void begin(unsigned long sampleIntervalMs, uint16_t lowBlockBytes = 0) {
+    interval = sampleIntervalMs;
+    lowBlock = lowBlockBytes;
+    retain(sample());
+    lastSample = millis();
+  }
+
+  void poll() {
+    if (millis() - lastSample < interval) return;
+    lastSample = millis();
+    retain(sample());
+  }
+
+  // Measure now, outside the periodic history.
+  const HeapSample &sample() {
+    uint32_t freeHeap = 0;
+    uint32_t largestBlock = 0;
+    uint8_t fragmentation = 0;
+    ESP.getHeapStats(&freeHeap, &largestBlock, &fragmentation);
+
+    HeapSample &entry = latest;
+    entry.freeHeap = freeHeap > UINT16_MAX ? UINT16_MAX : freeHeap;
+    entry.largestBlock = largestBlock > UINT16_MAX ? UINT16_MAX : largestBlock;
+    entry.fragmentation = fragmentation;
+
+    statistics.samples++;
+    if (entry.freeHeap < statistics.lowestFreeHeap) statistics.lowestFreeHeap = entry.freeHeap;
+    if (entry.largestBlock < statistics.lowestLargestBlock) statistics.lowestLargestBlock = entry.largestBlock;
+    if (entry.fragmentation > statistics.highestFragmentation) statistics.highestFragmentation = entry.fragmentation;
+
+    bool low = lowBlock && entry.largestBlock < lowBlock;
+    if (low && !belowWarning) {
+      statistics.lowBlockEpisodes++;
+      LOG_WARN(LOG_SYSTEM, "Heap: largest free block %u B under %u B (free %u B, fragmentation %u %%)",
+               entry.largestBlock, lowBlock, entry.freeHeap, entry.fragmentation);
+    } else if (!low && belowWarning) {
+      LOG_INFO(LOG_SYSTEM, "Heap: largest free block recovered to %u B", entry.largestBlock);
+    }
+    belowWarning = low;
+    return entry;
+  }
+
+  // Periodic sample `age` intervals back (0 = newest); false past the
+  // retained history.
+  bool history(uint8_t age, HeapSample &result) const {
+    if (age >= count) return false;
+    result = ring[(next + HISTORY - 1 - age) % HISTORY];
+    return true;
+  }
+
+  uint8_t retained() const { return count; }
+  unsigned long sampleIntervalMs() const { return interval; }
+
+  // Least-squares slope of free heap across the retained history, in bytes
+  // per hour (negative = shrinking).
+  int32_t freeHeapTrendPerHour() const {
+    if (count < 2 || !interval) return 0;
+    float meanX = (count - 1) / 2.0f;
+    float meanY = 0;
+    for (uint8_t i = 0; i < count; i++) meanY += oldestFirst(i).freeHeap;
+    meanY /= count;
+    float covariance = 0, variance = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      float dx = i - meanX;
+      covariance += dx * (oldestFirst(i).freeHeap - meanY);
+      variance += dx * dx;
+    }
+    return (int32_t)(covariance / variance * (3600000.0f / interval));
+  }
+
+  void report() const {
+    LOG_INFO(LOG_SYSTEM, "Heap: free %u B, largest block %u B, fragmentation %u %%", latest.freeHeap,
+             latest.largestBlock, latest.fragmentation);
+    LOG_INFO(LOG_SYSTEM, "Heap since boot: lowest free %u B, smallest largest block %u B, fragmentation up to %u %%",
+             statistics.lowestFreeHeap, statistics.lowestLargestBlock, statistics.highestFragmentation);
+    LOG_INFO(LOG_SYSTEM, "Heap trend: %ld B/h over %u samples, %u low-block episodes", (long)freeHeapTrendPerHour(),
+             count, statistics.lowBlockEpisodes);
+  }
+
+  const MemoryStats &stats() const { return statistics; }
+
+private:
+  HeapSample ring[HISTORY];
+  HeapSample latest = {};
+  uint8_t next = 0;
+  uint8_t count = 0;
+  unsigned long interval = 0;
+  unsigned long lastSample = 0;
+  uint16_t lowBlock = 0;
+  bool belowWarning = false;
+  MemoryStats statistics;
+
+  void retain(const HeapSample &entry) {
+    ring[next] = entry;
+    next = (next + 1) % HISTORY;
+    if (count < HISTORY) count++;
+  }
+
+  const HeapSample &oldestFirst(uint8_t index) const {
+    return ring[(next + HISTORY - count + index) % HISTORY];
+  }
+};
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiServer.h>
+#include <stdarg.h>
+
+// ─────────────────────────────────────
+// HTTP Status Endpoint
+// ─────────────────────────────────────
+// A small HTTP/1.1 server for the LAN, so a browser, curl or a script can
+// read the board's state and history without the cloud:
+//
+//   statusEndpoint.on("/state.json", "application/json", writeState);
+//   statusEndpoint.begin();
+//   statusEndpoint.poll();                      // every pass, never waits
+//
+// A route's writer fills the body one chunk at a time, formatting rows
+// straight from where the data lives into the endpoint's single chunk
+// buffer; that buffer is what goes to the socket. No String, no copy of
+// the body, and a response of any length costs CHUNK_BYTES of RAM. The
+// writer prints rows until print() refuses one (print() takes a row whole
+// or not at all), notes where to resume in body.cursor and body.phase, and
+// returns true; it returns false once the body is complete:
+//
+//   bool writeRows(HttpBody &body) {
+//     for (; body.cursor < ROWS; body.cursor++) {
+//       if (!body.printf("%u\n", row(body.cursor))) return true;   // Full: continue here next chunk
+//     }
+//     return false;
+//   }
+//
+// Responses are sent with chunked transfer encoding and Connection: close.
+// poll() does a bounded amount of work: it reads what the request has
+// delivered, and writes no more than availableForWrite() - the core's
+// write() would otherwise wait for the TCP window - filling at most
+// MAX_FILLS_PER_POLL chunks. A slow or stalled client therefore only slows
+// its own response; the control loop keeps its pace. One client is served
+// at a time, others wait in the listen backlog; a client that makes no
+// progress for IDLE_TIMEOUT_MS is dropped.
+
+class HttpBody;
+typedef bool (*HttpWriter)(HttpBody &body);   // True while more of the body follows
+
+class HttpBody {
+public:
+  uint32_t cursor = 0;   // Where the writer resumes, 0 on its first call
+  uint8_t phase = 0;     // Free for the writer, e.g. the section it is in
+
+  // Both append the whole text and return true, or append nothing
+  bool print(const char *text) {
+    size_t length = strlen(text);
+    if (length > capacity - used) return false;
+    memcpy(data + used, text, length);
+    used += length;
+    return true;
+  }
+
+  bool printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list arguments;
+    va_start(arguments, format);
+    // The terminating NUL may land in the chunk trailer, which is rewritten later
+    int length = vsnprintf(data + used, capacity - used + 1, format, arguments);
+    va_end(arguments);
+    if (length < 0 || (size_t)length > capacity - used) return false;
+    used += length;
+    return true;
+  }
+
+  // Binary counterpart of print(), e.g. for a file served as it is;
+  // available() is the room left in this chunk
+  bool write(const uint8_t *bytes, size_t length) {
+    if (length > capacity - used) return false;
+    memcpy(data + used, bytes, length);
+    used += length;
+    return true;
+  }
+  size_t available() const { return capacity - used; }
+
+  // Bytes printed into this chunk so far; truncate() drops what followed a
+  // length taken earlier, e.g. a group of rows that must not be split
+  size_t length() const { return used; }
+  void truncate(size_t length) {
+    if (length < used) used = length;
+  }
+
+  // Query parameter of the request, e.g. "res" of /history.csv?res=hour;
+  // values are taken as they are, without percent-decoding
+  bool parameter(const char *name, char *value, size_t size) const {
+    const size_t nameLength = strlen(name);
+    for (const char *field = query; field && *field; field = strchr(field, '&') ? strchr(field, '&') + 1 : nullptr) {
+      if (strncmp(field, name, nameLength) || field[nameLength] != '=') continue;
+      const char *start = field + nameLength + 1;
+      size_t length = strcspn(start, "&");
+      if (length >= size) length = size - 1;
+      memcpy(value, start, length);
+      value[length] = '\0';
+      return true;
+    }
+    return false;
+  }
+
+  long parameter(const char *name, long fallback) const {
+    char value[16];
+    char *end;
+    if (!parameter(name, value, sizeof(value))) return fallback;
+    long number = strtol(value, &end, 10);
+    return end != value && !*end ? number : fallback;
+  }
+
+private:
+  template <uint8_t, uint16_t> friend class HttpEndpoint;
+
+  char *data = nullptr;
+  size_t capacity = 0;
+  size_t used = 0;
+  const char *query = "";
+};
+
+struct HttpEndpointStats {
+  uint32_t requests = 0;       // Answered with a route's body
+  uint32_t rejected = 0;       // Unknown path, method other than GET, malformed request
+  uint32_t aborted = 0;        // Dropped: idle, peer gone, or a row wider than a chunk
+  uint32_t bytesSent = 0;
+};
+
+template <uint8_t MAX_ROUTES = 6, uint16_t CHUNK_BYTES = 512>
+class HttpEndpoint {
+  static_assert(CHUNK_BYTES <= 4096, "chunk headers are reserved for three hex digits");
+
+public:
+  static const uint8_t MAX_REQUEST_LINE = 96;        // Longer request lines are cut short
+  static const uint16_t MAX_REQUEST_BYTES = 2048;    // Request line and headers
+  static const uint8_t MAX_FILLS_PER_POLL = 4;
+  static const unsigned long IDLE_TIMEOUT_MS = 10000;
+
+  explicit HttpEndpoint(uint16_t port = 80) : server(port) {}
+
+  // Returns false when the route table is full. Paths and content types
+  // must outlive the endpoint (string literals).
+  bool on(const char *path, const char *contentType, HttpWriter writer) {
+    if (routeCount >= MAX_ROUTES) return false;
+    routes[routeCount++] = { path, contentType, writer };
+    return true;
+  }
+
+  void begin() {
+    server.begin();
+    server.setNoDelay(true);   // Chunks are paced by the window already
+  }
+
+  void poll() {
+    if (state == IDLE && !accept()) return;
+    if (!client.connected()) {
+      finish(state != DRAINING);   // The peer left before the response was through
+      return;
+    }
+    if (state == REQUEST) readRequest();
+    if (state == RESPONDING) respond();
+    if (state == DRAINING) {
+      const int room = client.availableForWrite();
+      if (room >= emptyWindow) {
+        finish(false);   // Everything acknowledged: stop() will not wait for a flush
+        return;
+      }
+      if (room != drainingRoom) {
+        drainingRoom = room;   // The peer is still taking the tail of the response
+        lastProgress = millis();
+      }
+    }
+    if (state != IDLE && millis() - lastProgress > IDLE_TIMEOUT_MS) finish(true);
+  }
+
+  bool busy() const { return state != IDLE; }
+  const HttpEndpointStats &stats() const { return statistics; }
+
+private:
+  enum State : uint8_t { IDLE, REQUEST, RESPONDING, DRAINING };
+
+  // Chunk layout: hex size and CRLF right-aligned in the header area, the
+  // payload, its CRLF, and room for the final zero-length chunk
+  static const uint8_t CHUNK_HEADER = 5;
+  static const uint8_t CHUNK_TRAILER = 2 + 5;
+
+  struct Route {
+    const char *path;
+    const char *contentType;
+    HttpWriter writer;
+  };
+
+  WiFiServer server;
+  WiFiClient client;
+  Route routes[MAX_ROUTES];
+  uint8_t routeCount = 0;
+  HttpEndpointStats statistics;
+
+  State state = IDLE;
+  const Route *route = nullptr;
+  char line[MAX_REQUEST_LINE];
+  uint8_t lineLength = 0;
+  bool lineDone = false;
+  uint8_t headerLength = 0;          // Of the header line being skipped
+  uint16_t requestBytes = 0;
+  const char *query = "";
+
+  char buffer[CHUNK_BYTES];
+  uint16_t sendFrom = 0;
+  uint16_t sendTo = 0;
+  uint32_t cursor = 0;
+  uint8_t phase = 0;
+  bool bodyDone = false;
+  int emptyWindow = 0;               // availableForWrite() with nothing in flight
+  int drainingRoom = 0;
+  unsigned long lastProgress = 0;
+
+  bool accept() {
+    client = server.accept();
+    if (!client) return false;
+    state = REQUEST;
+    lineLength = 0;
+    lineDone = false;
+    headerLength = 0;
+    requestBytes = 0;
+    emptyWindow = client.availableForWrite();
+    lastProgress = millis();
+    return true;
+  }
+
+  void finish(bool aborted) {
+    if (aborted) {
+      statistics.aborted++;
+      client.abort();   // Reset rather than flush what the peer will not read
+    } else {
+      client.stop();
+    }
+    state = IDLE;
+  }
+
+  void readRequest() {
+    while (client.available() > 0) {
+      int c = client.read();
+      if (c < 0) return;
+      lastProgress = millis();
+      if (++requestBytes > MAX_REQUEST_BYTES) {
+        reject(431, "Request Header Fields Too Large");
+        return;
+      }
+      if (!lineDone) {
+        if (c == '\n') {
+          line[lineLength] = '\0';
+          lineDone = true;
+        } else if (c != '\r' && lineLength < MAX_REQUEST_LINE - 1) {
+          line[lineLength++] = (char)c;
+        }
+      } else if (c == '\n') {
+        if (!headerLength) {
+          dispatch();   // Blank line: the headers are through
+          return;
+        }
+        headerLength = 0;
+      } else if (c != '\r' && headerLength < 255) {
+        headerLength++;
+      }
+    }
+  }
+
+  void dispatch() {
+    // "GET /path?query HTTP/1.1"
+    char *target = strchr(line, ' ');
+    if (!target) return reject(400, "Bad Request");
+    *target++ = '\0';
+    char *version = strchr(target, ' ');
+    if (version) *version = '\0';
+    if (strcmp(line, "GET")) return reject(405, "Method Not Allowed");
+    char *separator = strchr(target, '?');
+    query = separator ? separator + 1 : "";
+    if (separator) *separator = '\0';
+
+    route = nullptr;
+    for (uint8_t i = 0; i < routeCount && !route; i++) {
+      if (!strcmp(routes[i].path, target)) route = &routes[i];
+    }
+    if (!route) return reject(404, "Not Found");
+
+    statistics.requests++;
+    cursor = 0;
+    phase = 0;
+    bodyDone = false;
+    sendFrom = 0;
+    sendTo = snprintf(buffer, sizeof(buffer),
+                      "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n"
+                      "Cache-Control: no-store\r\nConnection: close\r\n\r\n",
+                      route->contentType);
+    state = RESPONDING;
+  }
+
+  void reject(int status, const char *reason) {
+    statistics.rejected++;
+    sendFrom = 0;
+    sendTo = snprintf(buffer, sizeof(buffer),
+                      "HTTP/1.1 %d %s\r\nContent-Type: text/plain\r\nContent-Length: %u\r\nConnection: close\r\n\r\n%s\n",
+                      status, reason, (unsigned)strlen(reason) + 1, reason);
+    bodyDone = true;
+    state = RESPONDING;
+  }
+
+  void respond() {
+    for (uint8_t fills = 0;;) {
+      if (sendFrom < sendTo) {
+        int room = client.availableForWrite();
+        if (room <= 0) return;
+        size_t written = client.write((const uint8_t *)buffer + sendFrom, min((size_t)room, (size_t)(sendTo - sendFrom)));
+        if (written) {
+          sendFrom += written;
+          statistics.bytesSent += written;
+          lastProgress = millis();
+        }
+        if (sendFrom < sendTo) return;   // The window is full; the rest goes next pass
+      }
+      if (bodyDone) {
+        state = DRAINING;
+        drainingRoom = -1;
+        return;
+      }
+      if (fills++ == MAX_FILLS_PER_POLL) return;
+      if (!fill()) return;
+    }
+  }
+
+  // Runs the writer once and frames what it printed as one chunk
+  bool fill() {
+    HttpBody body;
+    body.data = buffer + CHUNK_HEADER;
+    body.capacity = CHUNK_BYTES - CHUNK_HEADER - CHUNK_TRAILER;
+    body.cursor = cursor;
+    body.phase = phase;
+    body.query = query;
+    const bool more = route->writer(body);
+    if (more && !body.used) {
+      finish(true);   // A row that fits no chunk would never be sent
+      return false;
+    }
+    cursor = body.cursor;
+    phase = body.phase;
+
+    uint16_t end = CHUNK_HEADER + body.used;
+    sendFrom = CHUNK_HEADER;
+    if (body.used) {
+      char header[CHUNK_HEADER + 1];
+      uint8_t framing = snprintf(header, sizeof(header), "%X\r\n", (unsigned)body.used);
+      sendFrom = CHUNK_HEADER - framing;
+      memcpy(buffer + sendFrom, header, framing);
+      memcpy(buffer + end, "\r\n", 2);
+      end += 2;
+    }
+    if (!more) {
+      memcpy(buffer + end, "0\r\n\r\n", 5);
+      end += 5;
+      bodyDone = true;
+    }
+    sendTo = end;
+    return true;
+  }
+};
@@ -0,0 +1,505 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// ─────────────────────────────────────
+// Input Trace
+// ─────────────────────────────────────
+// Field incidents are hard to reproduce: what the ADC read, what the link
+// reported and what the weather service answered are gone by the time
+// anyone looks. The trace records every external input the control code
+// consumes, with its millis() time, and every actuator output it decided,
+// in a compact binary ring on LittleFS. The host simulator replays a trace
+// through the same firmware at simulation speed and lists the decisions
+// that came out differently (sim-main --replay):
+//
+//   inputTrace.begin();
+//   analogMultiplexer.traceInputs(inputTrace);   // likewise WiFiLink, WeatherServiceConnection
+//   inputTrace.watchOutput(relayPin);
+//   inputTrace.poll();                           // every pass: output changes, timed flush
+//
+// Each event is a tag byte - type in the high nibble, a small argument in
+// the low one - then the milliseconds since the previous event as a varint,
+// then its payload:
+//
+//   SYNC      0x00 "EPT" version, segment number, millis()   first in every segment, no delta
+//   BOOT      reset reason | millis() at begin()             no delta; a new time base
+//   ANALOG    mux address | count, conversions as zigzag deltas from the address's previous one
+//   LINK      WiFi status | -                                on change
+//   REQUEST   path length, path                              the query string - the API key - is left out
+//   BODY      length (2 bytes LE), the body bytes the response handler took
+//   RESPONSE  zigzag HTTP status or HTTPC_ERROR_*, latency in ms
+//   OUTPUT    level | pin
+//
+// The conversions of one mux visit share an ANALOG event, so a visit of
+// four costs about 8 bytes. Deltas and ADC predictors restart at every
+// SYNC and BOOT, and SYNC restates the link status and the output levels,
+// so decoding can start at any segment. Events are buffered in RAM and
+// written a buffer at a time or after flushIntervalMs; segment files are
+// only appended to and deleted whole, oldest first, like the telemetry
+// journal's. A reset loses what was still buffered.
+//
+// The mux's conversions are the one input replayed inside the firmware: a
+// replay tool sets InputTrace::replaySource, and analog() then hands the
+// caller the traced conversion instead of the live one. Which conversions
+// a visit keeps depends on where timer1 stands against the loop, which no
+// host model reproduces. Link and HTTP inputs are replayed by the host's
+// network model instead. The decoder at the end of this header touches
+// nothing of the board; host tools use it through the simulator's headers.
+
+enum InputTraceEventType : uint8_t {
+  INPUT_TRACE_SYNC = 0,
+  INPUT_TRACE_BOOT = 1,
+  INPUT_TRACE_ANALOG = 2,
+  INPUT_TRACE_LINK = 3,
+  INPUT_TRACE_REQUEST = 4,
+  INPUT_TRACE_BODY = 5,
+  INPUT_TRACE_RESPONSE = 6,
+  INPUT_TRACE_OUTPUT = 7,
+};
+
+const uint8_t INPUT_TRACE_VERSION = 1;
+const uint8_t INPUT_TRACE_MAX_ADDRESSES = 16;   // Mux addresses fit the tag's low nibble
+const uint8_t INPUT_TRACE_LINK_OTHER = 15;      // Status codes past 14, e.g. WL_NO_SHIELD
+
+struct InputTraceConfig {
+  uint8_t segments = 64;                   // Flash budget in segment files (512 KB)
+  uint16_t segmentBytes = 8192;            // One LittleFS block
+  unsigned long flushIntervalMs = 30000;   // Longest an event waits in RAM
+};
+
+struct InputTraceStats {
+  uint32_t events = 0;
+  uint32_t bytes = 0;             // Written to flash
+  uint32_t flashWrites = 0;
+  uint32_t segmentsDropped = 0;   // Oldest segments deleted for the budget
+  uint32_t writeFailures = 0;     // Buffers lost to a failed flash write
+};
+
+// Supplies traced inputs in place of live ones during a replay
+class InputTraceSource {
+public:
+  virtual void analog(uint8_t address, uint16_t &raw) = 0;
+};
+
+class InputTrace {
+public:
+  static const uint16_t BUFFER_BYTES = 512;
+  static const uint8_t MAX_OUTPUTS = 8;
+  static const unsigned long ANALOG_RUN_MS = 100;   // Conversions this close together are one mux visit
+
+  static inline InputTraceSource *replaySource = nullptr;
+
+  bool begin(const InputTraceConfig &traceConfig = InputTraceConfig()) {
+    config = traceConfig;
+    buffered = 0;
+    run = NO_RUN;
+    mounted = LittleFS.begin();
+    if (!mounted) return false;
+    LittleFS.mkdir(DIRECTORY);
+
+    oldestSegment = 0;
+    newestSegment = 0;
+    Dir dir = LittleFS.openDir(DIRECTORY);
+    while (dir.next()) {
+      uint32_t segment = strtoul(dir.fileName().c_str(), nullptr, 16);
+      if (segment == 0) continue;
+      if (oldestSegment == 0 || segment < oldestSegment) oldestSegment = segment;
+      if (segment > newestSegment) newestSegment = segment;
+    }
+    if (newestSegment == 0) {
+      oldestSegment = 1;   // rotate() opens segment 1
+    } else {
+      File file = LittleFS.open(segmentPath(newestSegment).text, "r");
+      segmentUsed = file ? file.size() : 0;
+    }
+    // Carry on in the newest segment when it has room; a new one starts with SYNC
+    if (newestSegment == 0 || segmentUsed == 0 || segmentUsed + BUFFER_BYTES > config.segmentBytes) rotate();
+
+    reserve(6);
+    const unsigned long now = millis();
+    if (!buffered) bufferedSince = now;
+    buffer[buffered++] = INPUT_TRACE_BOOT << 4 | (ESP.getResetInfoPtr()->reason & 0x0F);
+    putVarint(now);
+    restartBase(now);
+    statistics.events++;
+    return true;
+  }
+
+  // Record an actuator output; its level is recorded now and on every change
+  bool watchOutput(uint8_t pin) {
+    if (!mounted || outputCount >= MAX_OUTPUTS) return false;
+    outputs[outputCount].pin = pin;
+    outputs[outputCount].level = digitalRead(pin) ? 1 : 0;
+    recordOutput(outputs[outputCount]);
+    outputCount++;
+    return true;
+  }
+
+  // One ADC conversion the mux kept for `address`. During a replay the
+  // traced conversion replaces `raw`; either way, `raw` is what is recorded.
+  void analog(uint8_t address, uint16_t &raw) {
+    if (replaySource) replaySource->analog(address, raw);
+    if (!mounted) return;
+    address &= INPUT_TRACE_MAX_ADDRESSES - 1;
+    const unsigned long now = millis();
+    const bool extend = run == ANALOG_RUN && runAddress == address && buffer[runCount] < 255 &&
+                        now - runStartedAt < ANALOG_RUN_MS && fits(3);
+    if (!extend) {
+      reserve(1 + 5 + 1 + 3);
+      beginEvent(INPUT_TRACE_ANALOG, address, now);
+      runCount = buffered++;
+      buffer[runCount] = 0;
+      run = ANALOG_RUN;
+      runAddress = address;
+      runStartedAt = now;
+    }
+    putVarint(zigzag((int32_t)raw - (int32_t)predictors[address]));
+    predictors[address] = raw;
+    buffer[runCount]++;
+  }
+
+  // WiFi status as the link manager read it; recorded when it changes
+  void link(uint8_t status) {
+    if (!mounted) return;
+    if (status > INPUT_TRACE_LINK_OTHER) status = INPUT_TRACE_LINK_OTHER;
+    if (status == linkStatus) return;
+    linkStatus = status;
+    reserve(1 + 5);
+    beginEvent(INPUT_TRACE_LINK, status, millis());
+  }
+
+  void httpRequest(const char *uri) {
+    if (!mounted) return;
+    size_t length = strcspn(uri, "?");
+    if (length > 255) length = 255;
+    reserve(1 + 5 + 1 + length);
+    beginEvent(INPUT_TRACE_REQUEST, 0, millis());
+    buffer[buffered++] = length;
+    memcpy(buffer + buffered, uri, length);
+    buffered += length;
+  }
+
+  // One body byte as the response handler takes it
+  void httpBody(uint8_t c) {
+    if (!mounted) return;
+    uint16_t length = 0;
+    if (run == BODY_RUN) length = buffer[runCount] | (uint16_t)buffer[runCount + 1] << 8;
+    if (run != BODY_RUN || length == 0xFFFF || !fits(1)) {
+      reserve(1 + 5 + 2 + 1);
+      beginEvent(INPUT_TRACE_BODY, 0, millis());
+      runCount = buffered;
+      buffered += 2;
+      run = BODY_RUN;
+      length = 0;
+    }
+    buffer[buffered++] = c;
+    length++;
+    buffer[runCount] = length;
+    buffer[runCount + 1] = length >> 8;
+  }
+
+  void httpResponse(int status, unsigned long latencyMs) {
+    if (!mounted) return;
+    reserve(1 + 5 + 5 + 5);
+    beginEvent(INPUT_TRACE_RESPONSE, 0, millis());
+    putVarint(zigzag(status));
+    putVarint(latencyMs);
+  }
+
+  // Record changed outputs and write the buffer once it has waited
+  // flushIntervalMs. Call every loop pass.
+  void poll() {
+    if (!mounted) return;
+    for (uint8_t i = 0; i < outputCount; i++) {
+      uint8_t level = digitalRead(outputs[i].pin) ? 1 : 0;
+      if (level == outputs[i].level) continue;
+      outputs[i].level = level;
+      recordOutput(outputs[i]);
+    }
+    if (buffered && millis() - bufferedSince >= config.flushIntervalMs) flush();
+  }
+
+  // Write buffered events; call before deep sleep so none are lost.
+  void flush() {
+    run = NO_RUN;
+    if (!buffered) return;
+    File file = LittleFS.open(segmentPath(newestSegment).text, "a");
+    size_t written = file ? file.write(buffer, buffered) : 0;
+    if (file) file.close();
+    statistics.flashWrites++;
+    if (written == buffered) {
+      statistics.bytes += written;
+      segmentUsed += written;
+    } else {
+      // The deltas that follow would build on lost events - continue in a fresh segment
+      statistics.writeFailures++;
+      segmentUsed = config.segmentBytes;
+    }
+    buffered = 0;
+  }
+
+  // Segments on flash, oldest first, e.g. to serve them for download. A
+  // read past the end of a segment returns 0.
+  uint32_t oldest() const { return mounted ? oldestSegment : 0; }
+  uint32_t newest() const { return mounted ? newestSegment : 0; }
+  size_t readSegment(uint32_t segment, uint32_t offset, uint8_t *data, size_t size) const {
+    File file = LittleFS.open(segmentPath(segment).text, "r");
+    if (!file || !file.seek(offset)) return 0;
+    return file.read(data, size);
+  }
+
+  bool recording() const { return mounted; }
+  const InputTraceStats &stats() const { return statistics; }
+
+private:
+  static constexpr const char *DIRECTORY = "/trace";
+  enum Run : uint8_t { NO_RUN, ANALOG_RUN, BODY_RUN };
+
+  struct Output {
+    uint8_t pin;
+    uint8_t level;
+  };
+
+  InputTraceConfig config;
+  InputTraceStats statistics;
+  uint8_t buffer[BUFFER_BYTES];
+  uint16_t buffered = 0;
+  unsigned long bufferedSince = 0;   // When the oldest buffered event was recorded
+  unsigned long lastEventAt = 0;
+  uint16_t predictors[INPUT_TRACE_MAX_ADDRESSES] = {};
+  Output outputs[MAX_OUTPUTS];
+  uint8_t outputCount = 0;
+  uint8_t linkStatus = 0xFF;         // None recorded yet
+  Run run = NO_RUN;                  // Event the next sample or body byte may extend
+  uint8_t runAddress = 0;
+  uint16_t runCount = 0;             // Buffer offset of the run's count (ANALOG) or length (BODY)
+  unsigned long runStartedAt = 0;
+  uint32_t oldestSegment = 1;
+  uint32_t newestSegment = 0;
+  uint32_t segmentUsed = 0;          // Bytes of the newest segment on flash
+  bool mounted = false;
+
+  struct SegmentPath {
+    char text[24];
+  };
+
+  // Returned by value on the stack - a String here would allocate on every open
+  static SegmentPath segmentPath(uint32_t segment) {
+    SegmentPath path;
+    snprintf(path.text, sizeof(path.text), "%s/%08lx", DIRECTORY, (unsigned long)segment);
+    return path;
+  }
+
+  static uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+
+  void putVarint(uint32_t value) {
+    while (value >= 0x80) {
+      buffer[buffered++] = (uint8_t)value | 0x80;
+      value >>= 7;
+    }
+    buffer[buffered++] = value;
+  }
+
+  bool fits(size_t bytes) const {
+    return buffered + bytes <= BUFFER_BYTES && segmentUsed + buffered + bytes <= config.segmentBytes;
+  }
+
+  // Make room for an event of up to `bytes`: flush the buffer, or close the
+  // segment and open the next one
+  void reserve(size_t bytes) {
+    if (fits(bytes)) return;
+    flush();
+    if (!fits(bytes)) rotate();
+  }
+
+  void beginEvent(InputTraceEventType type, uint8_t argument, unsigned long now) {
+    if (!buffered) bufferedSince = now;
+    buffer[buffered++] = type << 4 | argument;
+    putVarint(now - lastEventAt);
+    lastEventAt = now;
+    run = NO_RUN;
+    statistics.events++;
+  }
+
+  void restartBase(unsigned long now) {
+    lastEventAt = now;
+    memset(predictors, 0, sizeof(predictors));
+    run = NO_RUN;
+  }
+
+  void recordOutput(const Output &output) {
+    reserve(1 + 5 + 1);
+    beginEvent(INPUT_TRACE_OUTPUT, output.level, millis());
+    buffer[buffered++] = output.pin;
+  }
+
+  // Open the next segment with a SYNC that restates the link and outputs
+  void rotate() {
+    flush();
+    newestSegment++;
+    segmentUsed = 0;
+    while (newestSegment - oldestSegment >= config.segments) {
+      LittleFS.remove(segmentPath(oldestSegment).text);
+      oldestSegment++;
+      statistics.segmentsDropped++;
+    }
+    const unsigned long now = millis();
+    bufferedSince = now;
+    buffer[buffered++] = INPUT_TRACE_SYNC;
+    buffer[buffered++] = 'E';
+    buffer[buffered++] = 'P';
+    buffer[buffered++] = 'T';
+    buffer[buffered++] = INPUT_TRACE_VERSION;
+    putVarint(newestSegment);
+    putVarint(now);
+    restartBase(now);
+    statistics.events++;
+    if (linkStatus != 0xFF) beginEvent(INPUT_TRACE_LINK, linkStatus, now);
+    for (uint8_t i = 0; i < outputCount; i++) {
+      beginEvent(INPUT_TRACE_OUTPUT, outputs[i].level, now);
+      buffer[buffered++] = outputs[i].pin;
+    }
+  }
+};
+
+// One decoded event. Times are millis() of the boot the event was recorded
+// in; `bytes` points into the decoder's input.
+struct InputTraceEvent {
+  InputTraceEventType type;
+  uint8_t argument;            // Mux address, WiFi status, output level or reset reason
+  uint32_t timeMs;
+  uint32_t segment;            // SYNC: its segment number
+  bool continued;              // SYNC: follows the previous segment within one boot
+  uint8_t count;               // ANALOG: conversions in `samples`
+  uint16_t samples[255];
+  uint8_t pin;                 // OUTPUT
+  int status;                  // RESPONSE
+  uint32_t latencyMs;          // RESPONSE
+  const uint8_t *bytes;        // REQUEST: the path, BODY: the body bytes
+  size_t length;
+};
+
+// Decodes a trace: its segment files in order, or their concatenation.
+// Bytes that do not decode - a segment cut short - are skipped up to the
+// next SYNC.
+class InputTraceDecoder {
+public:
+  InputTraceDecoder(const uint8_t *traceData, size_t traceSize) : data(traceData), size(traceSize) {}
+
+  bool next(InputTraceEvent &event) {
+    while (position < size) {
+      const size_t start = position;
+      if (decode(event)) return true;
+      skipped += 1;
+      position = start + 1;
+      synced = false;
+      while (position < size && !syncAt(position)) {
+        position++;
+        skipped++;
+      }
+    }
+    return false;
+  }
+
+  size_t skippedBytes() const { return skipped; }
+
+private:
+  const uint8_t *data;
+  size_t size;
+  size_t position = 0;
+  size_t skipped = 0;
+  bool synced = false;        // Inside a segment whose SYNC was decoded
+  uint32_t segment = 0;
+  uint32_t lastTime = 0;
+  uint16_t predictors[INPUT_TRACE_MAX_ADDRESSES] = {};
+
+  bool syncAt(size_t at) const {
+    return at + 5 <= size && data[at] == INPUT_TRACE_SYNC && data[at + 1] == 'E' && data[at + 2] == 'P' &&
+           data[at + 3] == 'T' && data[at + 4] == INPUT_TRACE_VERSION;
+  }
+
+  bool varint(uint32_t &value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+      if (position >= size) return false;
+      uint8_t byte = data[position++];
+      value |= (uint32_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  static int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+  void restartBase(uint32_t time) {
+    lastTime = time;
+    memset(predictors, 0, sizeof(predictors));
+  }
+
+  bool decode(InputTraceEvent &event) {
+    const uint8_t tag = data[position];
+    event.type = (InputTraceEventType)(tag >> 4);
+    event.argument = tag & 0x0F;
+    if (tag == INPUT_TRACE_SYNC) {
+      if (!syncAt(position)) return false;
+      position += 5;
+      uint32_t number, time;
+      if (!varint(number) || !varint(time)) return false;
+      event.continued = synced && number == segment + 1;
+      event.segment = segment = number;
+      event.timeMs = time;
+      restartBase(time);
+      synced = true;
+      return true;
+    }
+    if (!synced) return false;
+    position++;
+    uint32_t value;
+    if (event.type == INPUT_TRACE_BOOT) {
+      if (!varint(value)) return false;
+      event.timeMs = value;
+      restartBase(value);
+      return true;
+    }
+    if (!varint(value)) return false;
+    event.timeMs = lastTime += value;
+    switch (event.type) {
+      case INPUT_TRACE_ANALOG:
+        if (position >= size) return false;
+        event.count = data[position++];
+        for (uint8_t i = 0; i < event.count; i++) {
+          if (!varint(value)) return false;
+          uint16_t &predictor = predictors[event.argument];
+          predictor = event.samples[i] = (uint16_t)(predictor + unzigzag(value));
+        }
+        return true;
+      case INPUT_TRACE_LINK:
+        return true;
+      case INPUT_TRACE_REQUEST:
+        if (position >= size) return false;
+        event.length = data[position++];
+        break;
+      case INPUT_TRACE_BODY:
+        if (position + 2 > size) return false;
+        event.length = data[position] | (size_t)data[position + 1] << 8;
+        position += 2;
+        break;
+      case INPUT_TRACE_RESPONSE:
+        if (!varint(value)) return false;
+        event.status = unzigzag(value);
+        return varint(event.latencyMs);
+      case INPUT_TRACE_OUTPUT:
+        if (position >= size || event.argument > 1) return false;
+        event.pin = data[position++];
+        return true;
+      default:
+        return false;
+    }
+    if (position + event.length > size) return false;
+    event.bytes = data + position;
+    position += event.length;
+    return true;
+  }
+};
@@ -3,7 +3,38 @@
 #include <WiFiClient.h>
 #include <ArduinoIoTCloud.h>
 #include <Arduino_ConnectionHandler.h>
-#include <ArduinoJson.h>
+#include "weather-client.h"
+#include "weather-forecast.h"
+#include "adc-sampler.h"
+#include "rtc-memory.h"
+#include "duty-cycle.h"
+#include "telemetry-journal.h"
+#include "telemetry-publisher.h"
+#include "logger.h"
+#include "wifi-link.h"
+#include "loop-watchdog.h"
+#include "heap-monitor.h"
+#include "calibration.h"
+#include "telemetry-stream.h"
+#include "weather-share.h"
+
+// Deep sleep between offline failsafe cycles (GPIO16/D0 wired to RST).
+// Enable here or build with -DECOPULSE_DEEP_SLEEP=1
+#ifndef ECOPULSE_DEEP_SLEEP
+#define ECOPULSE_DEEP_SLEEP 0
+#endif
+
+// Binary telemetry frames broadcast on the LAN while online (telemetry-stream.h):
+// 0 = off, 1 = alongside the cloud, 2 = instead of it. Build with -DECOPULSE_LAN_TELEMETRY=1
+#ifndef ECOPULSE_LAN_TELEMETRY
+#define ECOPULSE_LAN_TELEMETRY 0
+#endif
+
+// Forecast shared between the boards of a site (weather-share.h): one board
+// fetches, the others take its table over multicast. Build with -DECOPULSE_WEATHER_SHARE=1
+#ifndef ECOPULSE_WEATHER_SHARE
+#define ECOPULSE_WEATHER_SHARE 0
+#endif
 
 // Credentials (keep outside source code in production)
 const char SSID[] = "your-ssid";
@@ -12,22 +43,89 @@ const char DEVICE_LOGIN_NAME[] = "your-device-id";
 const char DEVICE_KEY[] = "your-device-key";
 
 // API
-const String apiKey = "your-api-key";
-const String location = "Jessore,BD";
+const char apiKey[] = "your-api-key";
+const char location[] = "Jessore,BD";
+char forecastUrl[160];  // Built once in setup(); nothing is allocated per refresh
+const char *apiFingerprint = nullptr;  // SHA-1 of api.weatherapi.com's certificate; nullptr encrypts without verifying
+WeatherServiceConnection weatherService("api.weatherapi.com");
+AsyncWeatherClient weatherClient(weatherService);
+WeatherForecast forecast;  // Hourly table from forecast.json, refreshed 4x a day
+WeatherShare weatherShare;  // LAN fetcher election (ECOPULSE_WEATHER_SHARE)
 
 // Pins
 const int moisturePin = A0;
 const int relayPin = D1;
 
+// Moisture sampling - timer1 ticks at 50 Hz; each tick is converted in loop
+// context by poll() or, through the 1 s wait, by delaySampling()
+AdcSampler moistureSampler;
+
+// Moisture conversion table, generated at compile time from the probe's
+// reading in dry air (0 %) and in water (100 %)
+constexpr CalibrationTable<> moistureCalibration = CalibrationTable<>::twoPoint({ 1023, 0 }, { 0, 100 }, 0, 100);
+
+// Loop watchdog: budgets for the calls that can block, and the relay is
+// switched off if the pump logic has not run for controlDeadline
+LoopWatchdog<4> watchdog;
+const unsigned long controlDeadline = 4000;
+int8_t wifiOperation;
+int8_t weatherOperation;
+int8_t cloudOperation;
+
+// Heap history: hourly samples for a day, warning when the largest block
+// gets too small for a TLS reconnect
+HeapMonitor<24> heapMonitor;
+
+// Offline failsafe state, kept in RTC memory so cycles survive deep sleep and resets.
+// Timestamps are on the DutyCycle clock, which keeps counting through sleep.
+struct FailSafeState {
+  unsigned long lastPumpTime;
+  bool inPumpCycle;
+};
+DutyCycle dutyCycle;
+RtcRecord<FailSafeState, RTC_BLOCK_CONTROL_STATE> failSafeRecord;
+FailSafeState failSafe;
+
+// Offline readings retained in flash and replayed through telemetryBacklog once online
+TelemetryJournal telemetryJournal;
+const unsigned long journalInterval = 60000;
+const unsigned long replayInterval = 1000;
+const uint8_t replayBatch = 12;
+
+// LAN telemetry: one 20-byte frame per interval to a collector on the local network
+TelemetryStreamer lanTelemetry;
+const unsigned long lanTelemetryInterval = 10000;
+
 // Cloud Variables
 int soil_Moisture;
 bool pumpStatus;
 float temperature;
+String telemetryBacklog;
+
+// Measured values; the cloud copies above only change when the publisher lets them through
+int moisture;
+float measuredTemperature = NAN;
+TelemetryPublisher<2> publisher;
+WiFiLink wifiLink;
+int8_t moisturePublication;
+int8_t temperaturePublication;
 
 void onSoilMoistureChange() {}
 void onPumpStatusChange() {}
 void onTemperatureChange() {}
 
+void connectToWiFiWithFailSafe();
+void onWiFiConnected();
+void offlineFailSafeIrrigation();
+void updateWeather();
+void refreshForecast();
+void onForecast(const WeatherFetchResult &result, const WeatherConditions &conditions);
+unsigned long dutyClock();
+void retainOfflineTelemetry(int moisture);
+void replayTelemetryBacklog();
+void streamLanTelemetry();
+void publishProperty(uint8_t property, float value);
+
 WiFiConnectionHandler ArduinoIoTPreferredConnection(SSID, PASS);
 
 void initProperties() {
@@ -36,101 +134,317 @@ void initProperties() {
   ArduinoCloud.addProperty(soil_Moisture, READWRITE, ON_CHANGE, onSoilMoistureChange);
   ArduinoCloud.addProperty(pumpStatus, READWRITE, ON_CHANGE, onPumpStatusChange);
   ArduinoCloud.addProperty(temperature, READ, ON_CHANGE, onTemperatureChange);
+  ArduinoCloud.addProperty(telemetryBacklog, READ, ON_CHANGE, nullptr);
 }
 
 void setup() {
   Serial.begin(115200);
+  logger.begin(Serial);
+  dutyCycle.begin();
   pinMode(moisturePin, INPUT);
   pinMode(relayPin, OUTPUT);
   digitalWrite(relayPin, LOW);  // Ensure pump is off at boot
 
+  if (!failSafeRecord.load(failSafe)) {
+    failSafe = FailSafeState();
+  } else if (failSafe.inPumpCycle) {
+    digitalWrite(relayPin, HIGH);  // Resume the cycle a reset interrupted
+  }
+  telemetryJournal.begin();
+
+  watchdog.begin(100, dutyClock);
+  wifiOperation = watchdog.addOperation("wifi", 100);
+  weatherOperation = watchdog.addOperation("weather", 2500);  // Fits one full TLS handshake
+  cloudOperation = watchdog.addOperation("cloud", 250);
+  watchdog.addSafeOutput(relayPin, LOW);
+  watchdog.setControlDeadline(controlDeadline);
+  WatchdogOverrun interrupted;
+  if (watchdog.interruptedByReset(interrupted)) {
+    LOG_WARN(LOG_SYSTEM, "Reset %u ms into '%s'", interrupted.elapsedMs, watchdog.operationName(interrupted.operation));
+  }
+
+  WeatherForecastConfig forecastConfig;
+  forecastConfig.flashCache = true;  // Still answers after a wake with the radio off
+  forecast.begin(forecastConfig, dutyClock);
+  if (ECOPULSE_WEATHER_SHARE) {
+    weatherShare.begin(forecast, ESP.getChipId(), location, WeatherShareConfig(), dutyClock);
+  }
+  WeatherTlsConfig tlsConfig;
+  tlsConfig.fingerprint = apiFingerprint;
+  weatherService.useTls(tlsConfig);  // HTTPS; the session is kept in RTC memory across sleep
+  snprintf(forecastUrl, sizeof(forecastUrl), "/v1/forecast.json?key=%s&q=%s&days=2&aqi=no&alerts=no", apiKey, location);
+  heapMonitor.begin(3600000UL, 8192);
+  if (dutyCycle.wokeFromSleep()) {
+    LOG_INFO(LOG_SYSTEM, "Woke from deep sleep (previous wake %u ms, awake %u%% of cycle)",
+             dutyCycle.stats().lastAwakeMs, dutyCycle.awakePercent());
+  }
+
+  AdcSamplerConfig samplerConfig;
+  samplerConfig.sampleRateHz = 50;
+  moistureSampler.begin(moisturePin, samplerConfig);
+
+  // Deadbands keep ±1 % sensor jitter off the cloud; changes are rate limited per property
+  PublishPolicy moisturePolicy;
+  moisturePolicy.deadband = 2;
+  moisturePolicy.minIntervalMs = 10000;
+  PublishPolicy temperaturePolicy;
+  temperaturePolicy.deadband = 0.2;
+  temperaturePolicy.minIntervalMs = 60000;
+  publisher.begin(publishProperty);
+  moisturePublication = publisher.add(moisturePolicy);
+  temperaturePublication = publisher.add(temperaturePolicy);
+
   connectToWiFiWithFailSafe();
-  if (WiFi.status() == WL_CONNECTED) {
-    initProperties();
+  // Registered even when offline at boot: the connection handler keeps retrying,
+  // and the journal backlog is replayed through these properties on reconnect
+  initProperties();
+  telemetryBacklog.reserve(replayBatch * TELEMETRY_BATCH_FIELD_MAX);  // Replay assignments reuse it
+  if (ECOPULSE_LAN_TELEMETRY) {
+    lanTelemetry.begin(ESP.getChipId());
+  }
+  if (ECOPULSE_LAN_TELEMETRY != 2) {
     ArduinoCloud.begin(ArduinoIoTPreferredConnection);
   }
 }
 
 void loop() {
-  if (WiFi.status() != WL_CONNECTED) {
+  {
+    WATCHDOG_SCOPE(watchdog, wifiOperation);
+    wifiLink.poll();
+  }
+  moistureSampler.poll();
+  {
+    WATCHDOG_SCOPE(watchdog, weatherOperation);
+    weatherClient.poll();
+    if (ECOPULSE_WEATHER_SHARE && weatherShare.poll()) {
+      LOG_INFO(LOG_WEATHER, "Forecast adopted from a peer: %u hours", forecast.stats().hours);
+    } else if (ECOPULSE_WEATHER_SHARE && wifiLink.connected() && weatherShare.fetchDue()) {
+      refreshForecast();   // Every pass, not once a minute, so boards keep their election spacing
+    }
+  }
+  logger.poll();
+  heapMonitor.poll();
+
+  if (!wifiLink.connected()) {
     offlineFailSafeIrrigation();
   } else {
-    ArduinoCloud.update();
+    if (failSafe.inPumpCycle) {
+      // The moisture loop below owns the relay now; a later reset must not resume this cycle
+      failSafe.inPumpCycle = false;
+      failSafeRecord.save(failSafe);
+      LOG_INFO(LOG_ACTUATOR, "Wi-Fi back mid-cycle: moisture control takes over the pump");
+    }
+    if (ECOPULSE_LAN_TELEMETRY != 2) {
+      WATCHDOG_SCOPE(watchdog, cloudOperation);
+      ArduinoCloud.update();
+    }
 
-    int raw = analogRead(moisturePin);
-    soil_Moisture = map(raw, 1023, 0, 0, 100);
-    soil_Moisture = constrain(soil_Moisture, 0, 100);
+    moisture = moistureCalibration.convert(moistureSampler.value());
+    publisher.set(moisturePublication, moisture);
 
-    if (soil_Moisture < 30 && !pumpStatus) {
+    if (moisture < 30 && !pumpStatus) {
       pumpStatus = true;
-    } else if (soil_Moisture >= 30 && pumpStatus) {
+    } else if (moisture >= 30 && pumpStatus) {
       pumpStatus = false;
     }
+    watchdog.controlTick();  // The relay is rewritten every pass anyway
     digitalWrite(relayPin, pumpStatus ? HIGH : LOW);
+    streamLanTelemetry();
+    replayTelemetryBacklog();
 
     static unsigned long lastUpdate = 0;
     if (millis() - lastUpdate > 60000) {
-      getWeatherTemperature();
+      updateWeather();
       lastUpdate = millis();
+
+      const PublisherStats &stats = publisher.stats();
+      LOG_INFO(LOG_CLOUD, "Cloud publication: %u sent, %u suppressed (%u duplicate, %u deadband, %u coalesced)",
+               stats.sent, stats.suppressed(), stats.suppressedDuplicate, stats.suppressedDeadband,
+               stats.coalesced);
+      if (ECOPULSE_LAN_TELEMETRY) {
+        const TelemetryStreamStats &streamStats = lanTelemetry.stats();
+        LOG_INFO(LOG_CLOUD, "LAN telemetry: %u frames (%u B) sent, %u failed", streamStats.sent, streamStats.bytes,
+                 streamStats.failed);
+      }
+      if (ECOPULSE_WEATHER_SHARE) {
+        const WeatherShareStats &shareStats = weatherShare.stats();
+        LOG_INFO(LOG_WEATHER, "Forecast sharing: role %u, %u sent, %u adopted, %u requests, %u takeovers",
+                 weatherShare.currentRole(), shareStats.recordsSent, shareStats.recordsAdopted,
+                 shareStats.requestsSent, shareStats.takeovers);
+      }
     }
+    publisher.poll();  // Picked up by the next ArduinoCloud.update()
 
-    delay(1000);
+    moistureSampler.delaySampling(1000);  // Conversions keep their 50 Hz pace through the wait
   }
 }
 
+// Non-blocking: the failsafe keeps running while wifiLink.poll() associates and retries
 void connectToWiFiWithFailSafe() {
-  WiFi.begin(SSID, PASS);
-  Serial.print("Connecting to Wi-Fi");
-  unsigned long startAttempt = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - startAttempt < 30000) {
-    Serial.print(".");
-    delay(1000);
-  }
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nWi-Fi connected");
-  } else {
-    Serial.println("\nWi-Fi failed. Entering offline mode.");
-  }
+  wifiLink.onConnected(onWiFiConnected);
+  wifiLink.begin(SSID, PASS);
+  LOG_INFO(LOG_NETWORK, "Connecting to Wi-Fi");
+}
+
+void onWiFiConnected() {
+  const WiFiLinkStats &stats = wifiLink.stats();
+  LOG_INFO(LOG_NETWORK, "Wi-Fi connected in %lu ms (%s)", stats.lastConnectMs,
+           stats.lastConnectFast ? "cached AP" : "full scan");
 }
 
 void offlineFailSafeIrrigation() {
-  static unsigned long lastPumpTime = 0;
-  static bool inPumpCycle = false;
   const unsigned long pumpDuration = 10000;      // Run pump for 10 seconds
   const unsigned long offlineCycleDelay = 30UL * 60UL * 1000UL; // 30 minutes
 
-  unsigned long now = millis();
+  unsigned long now = dutyCycle.now();
+  int moisture = moistureCalibration.convert(moistureSampler.value());
+
+  if (!failSafe.inPumpCycle && now - failSafe.lastPumpTime > offlineCycleDelay && forecast.rainExpectedWithin(3)) {
+    // Cached forecast still works offline - let the rain do it and check again next cycle
+    LOG_INFO(LOG_ACTUATOR, "Offline Mode: Rain forecast, skipping emergency irrigation");
+    failSafe.lastPumpTime = now;
+    failSafeRecord.save(failSafe);
+    dutyCycle.checkpoint();
+  }
 
-  if (!inPumpCycle && now - lastPumpTime > offlineCycleDelay) {
-    Serial.println("Offline Mode: Activating emergency irrigation");
+  if (!failSafe.inPumpCycle && now - failSafe.lastPumpTime > offlineCycleDelay) {
+    LOG_INFO(LOG_ACTUATOR, "Offline Mode: Activating emergency irrigation");
     digitalWrite(relayPin, HIGH);
-    inPumpCycle = true;
-    lastPumpTime = now;
+    failSafe.inPumpCycle = true;
+    failSafe.lastPumpTime = now;
+    failSafeRecord.save(failSafe);
+    dutyCycle.checkpoint();
   }
 
-  if (inPumpCycle && now - lastPumpTime > pumpDuration) {
+  if (failSafe.inPumpCycle && now - failSafe.lastPumpTime > pumpDuration) {
     digitalWrite(relayPin, LOW);
-    inPumpCycle = false;
-    Serial.println("Offline Mode: Irrigation cycle complete");
+    failSafe.inPumpCycle = false;
+    failSafeRecord.save(failSafe);
+    dutyCycle.checkpoint();
+    LOG_INFO(LOG_ACTUATOR, "Offline Mode: Irrigation cycle complete");
+  }
+
+  if (watchdog.controlTick()) {
+    digitalWrite(relayPin, failSafe.inPumpCycle ? HIGH : LOW);  // Undo a forced-off relay if the cycle is still due
+  }
+
+  retainOfflineTelemetry(moisture);
+
+  if (ECOPULSE_DEEP_SLEEP && !failSafe.inPumpCycle && !wifiLink.connecting()) {
+    // Nothing to do until the next cycle; the wake also retries Wi-Fi from setup()
+    unsigned long untilNextCycle = offlineCycleDelay - (now - failSafe.lastPumpTime) + 1;
+    LOG_INFO(LOG_SYSTEM, "Offline Mode: sleeping %lu s until the next cycle", untilNextCycle / 1000);
+    telemetryJournal.flush();
+    logger.flush();
+    dutyCycle.sleep(untilNextCycle);
   }
 
-  delay(1000); // Minor delay to reduce CPU churn
+  moistureSampler.delaySampling(1000); // Minor delay to reduce CPU churn; sampling continues
 }
 
-void getWeatherTemperature() {
-  WiFiClient client;
-  HTTPClient http;
+// One record per minute plus every pump transition while the cloud is unreachable
+void retainOfflineTelemetry(int moisture) {
+  static unsigned long lastRecord = 0;
+  static bool recorded = false;
+  static bool lastPumpState = false;
+  unsigned long now = dutyCycle.now();
+  if (recorded && now - lastRecord < journalInterval && failSafe.inPumpCycle == lastPumpState) return;
 
-  String url = "http://api.weatherapi.com/v1/current.json?key=" + apiKey + "&q=" + location + "&aqi=no";
-  http.begin(client, url);
-  int httpCode = http.GET();
+  TelemetryRecord record = {};
+  record.timestamp = now / 1000;
+  record.temperatureDeci = telemetryTemperature(measuredTemperature);
+  record.moisture = moisture;
+  record.flags = TELEMETRY_FLAG_FAILSAFE | (failSafe.inPumpCycle ? TELEMETRY_FLAG_PUMP : 0);
+  telemetryJournal.append(record);
+  lastRecord = now;
+  lastPumpState = failSafe.inPumpCycle;
+  recorded = true;
+}
+
+// Live samples for the LAN collector; the offline backlog follows in replayTelemetryBacklog()
+void streamLanTelemetry() {
+  static unsigned long lastFrame = 0;
+  if (!ECOPULSE_LAN_TELEMETRY || millis() - lastFrame < lanTelemetryInterval) return;
+  lastFrame = millis();
+
+  TelemetrySample sample = {};
+  sample.timestamp = dutyCycle.now() / 1000;
+  sample.temperatureDeci = telemetryTemperature(measuredTemperature);
+  sample.moisture = moisture;
+  sample.flags = pumpStatus ? TELEMETRY_FLAG_PUMP : 0;
+  lanTelemetry.send(sample);
+}
 
-  if (httpCode == 200) {
-    String payload = http.getString();
-    StaticJsonDocument<1024> doc;
-    if (!deserializeJson(doc, payload)) {
-      temperature = doc["current"]["temp_c"];
+// Publish the backlog one batch per second; a batch is acknowledged once
+// the next cloud update has carried it. LAN-only builds send each record as
+// a frame instead and acknowledge once the whole batch went out.
+void replayTelemetryBacklog() {
+  static unsigned long lastReplay = 0;
+  static bool inFlight = false;
+  if (millis() - lastReplay < replayInterval || (ECOPULSE_LAN_TELEMETRY != 2 && !ArduinoCloud.connected())) return;
+  lastReplay = millis();
+
+  if (inFlight) {
+    telemetryJournal.commit();
+    inFlight = false;
+  }
+  TelemetryRecord batch[replayBatch];
+  size_t count = telemetryJournal.backlog() ? telemetryJournal.readBatch(batch, replayBatch) : 0;
+  if (count == 0) return;
+
+  if (ECOPULSE_LAN_TELEMETRY == 2) {
+    bool delivered = true;
+    for (size_t i = 0; i < count; i++) delivered &= lanTelemetry.send(telemetryRecordSample(batch[i]));
+    inFlight = delivered;
+    return;
+  }
+  char text[replayBatch * TELEMETRY_BATCH_FIELD_MAX + 1];
+  size_t fitted = formatTelemetryBatch(text, sizeof(text), batch, count, dutyCycle.now() / 1000);
+  if (fitted < count) {
+    // Re-read only the records that made it into the text, so commit() cannot acknowledge the rest
+    if (fitted == 0 || telemetryJournal.readBatch(batch, fitted) == 0) return;
+  }
+  telemetryBacklog = text;
+  inFlight = true;
+}
+
+// Temperature comes from the cached forecast; the API is only hit when the table ages out
+void updateWeather() {
+  float temperatureNow = forecast.temperatureNow();
+  if (!isnan(temperatureNow)) {
+    measuredTemperature = temperatureNow;
+    publisher.set(temperaturePublication, measuredTemperature);
+  }
+  if (!ECOPULSE_WEATHER_SHARE && forecast.refreshDue()) {
+    refreshForecast();
+  }
+}
+
+void refreshForecast() {
+  weatherClient.stream(forecastUrl, forecast.receiver(), onForecast);
+}
+
+void onForecast(const WeatherFetchResult &result, const WeatherConditions &) {
+  heapMonitor.sample();  // TLS buffers still held: the lowest point of the day
+  if (forecast.commit(result.httpCode)) {
+    LOG_INFO(LOG_WEATHER, "Forecast updated: %u hours", forecast.stats().hours);
+    if (ECOPULSE_WEATHER_SHARE) {
+      weatherShare.publish();
     }
+  } else {
+    LOG_WARN(LOG_WEATHER, "Forecast refresh failed: %d", result.httpCode);
+  }
+  heapMonitor.report();
+}
+
+unsigned long dutyClock() {
+  return dutyCycle.now();
+}
+
+void publishProperty(uint8_t property, float value) {
+  if (property == moisturePublication) {
+    soil_Moisture = (int)value;
+  } else if (property == temperaturePublication) {
+    temperature = value;
   }
-  http.end();
 }
@@ -3,51 +3,69 @@
 #include <ESP8266WiFi.h>               // ESP8266 RF transceiver interface
 #include <ESP8266HTTPClient.h>         // HTTP transaction protocol implementation
 #include <WiFiClient.h>                // TCP/IP socket abstraction
-#include <ArduinoJson.h>               // Structured data interchange format processor
 #include <time.h>                      // Chronological reference management
+#include "task-scheduler.h"            // Cooperative non-blocking task dispatch
+#include "weather-client.h"            // Streaming filtered meteorological data client
+#include "weather-forecast.h"          // Hourly meteorological forecast retained locally
+#include "adc-sampler.h"               // Timer-paced oversampled analog acquisition
+#include "analog-mux.h"                // Time-multiplexed analog channel scheduling
+#include "rtc-memory.h"                // CRC-protected state retention across resets
+#include "duty-cycle.h"                // Deep-sleep chronological continuity
+#include "telemetry-journal.h"         // Flash-backed offline telemetry retention
+#include "telemetry-publisher.h"       // Deadband and rate-limited property publication
+#include "logger.h"                    // Non-blocking levelled diagnostic output
+#include "wifi-link.h"                 // Polled association manager with cached fast reconnect
+#include "loop-profiler.h"             // Cycle-counted per-stage latency histograms
+#include "serial-console.h"            // Line-oriented diagnostic command interface
+#include "loop-watchdog.h"             // Per-operation execution budgets and actuation safety deadline
+#include "heap-monitor.h"              // Free heap, largest block and fragmentation history
+#include "irrigation-zones.h"          // Structure-of-arrays multi-zone hydraulic regulation
+#include "calibration.h"               // Compile-time fixed-point sensor conversion tables
+#include "telemetry-stream.h"          // Binary telemetry frames over LAN UDP
+#include "weather-share.h"             // Forecast table shared among co-located units over LAN multicast
+#include "telemetry-history.h"         // Compressed in-RAM readings with multi-resolution rollups
+#include "http-endpoint.h"             // Chunked LAN HTTP service for state, metrics and history
+#include "input-trace.h"               // Flash-retained external inputs and actuator decisions for host replay
 
-void acquireAtmosphericThermalParameters() {
-  // Establish telecommunications channel for meteorological data acquisition
-  WiFiClient client;
-  HTTPClient http;
-  String endpoint = "http://api.weatherapi.com/v1/current.json?key=" + apiKey + "&q=" + location + "&aqi=no";
-
-  Serial.println(F("Initiating meteorological data acquisition sequence..."));
-
-  http.begin(client, endpoint);
-  int responseCode = http.GET();
-
-  if (responseCode == 200) {
-    String payloadData = http.getString();
-    
-    // Allocate memory for JSON document parsing
-    StaticJsonDocument<1024> jsonDocument;
-    DeserializationError parsingError = deserializeJson(jsonDocument, payloadData);
-
-    if (!parsingError) {
-      // Extract thermal parameters from structured data
-      temperature = jsonDocument["current"]["temp_c"];
-      Serial.print(F("Atmospheric thermal coefficient: "));
-      Serial.print(temperature);
-      Serial.println(F("°C"));
-      
-      // Implement adaptive hydration strategies based on thermal conditions
-      if (temperature < 15) {
-        // Modify hydraulic parameters for cold-stress mitigation
-        // Implementation varies based on physiological requirements of specific cultivars
-        // Dynamic adjustment performed via constants defined in initialization block
-      }
-    } else {
-      Serial.print(F("JSON deserialization anomaly detected: "));
-      Serial.println(parsingError.c_str());
-    }
-  } else {
-    Serial.print(F("HTTP transaction failure, response anomaly: "));
-    Serial.println(responseCode);
-  }
+// Deep-sleep duty cycling for battery and solar installations: wake, sample, actuate,
+// publish when due, then power down. Requires GPIO16 (D0) wired to RST.
+// Enable here or build with -DECOPULSE_DEEP_SLEEP=1
+#ifndef ECOPULSE_DEEP_SLEEP
+#define ECOPULSE_DEEP_SLEEP 0
+#endif
+
+// Loop stage latency summary published as the diagnostic cloud property loopProfile
+// (requires a String variable in the Thing). Build with -DECOPULSE_PROFILE_PROPERTY=1
+#ifndef ECOPULSE_PROFILE_PROPERTY
+#define ECOPULSE_PROFILE_PROPERTY 0
+#endif
+
+// Binary telemetry frames broadcast on the local network for an on-site collector:
+// 0 = off, 1 = alongside Arduino IoT Cloud, 2 = instead of it (no cloud session at all).
+// Build with -DECOPULSE_LAN_TELEMETRY=1
+#ifndef ECOPULSE_LAN_TELEMETRY
+#define ECOPULSE_LAN_TELEMETRY 0
+#endif
+
+// Meteorological forecast shared among the units of one site: an elected unit performs the
+// acquisition and multicasts the hourly table to the others. Build with -DECOPULSE_WEATHER_SHARE=1
+#ifndef ECOPULSE_WEATHER_SHARE
+#define ECOPULSE_WEATHER_SHARE 0
+#endif
+
+// Local HTTP endpoint serving current state, loop metrics and the retained history as JSON or CSV
+// (always-on configuration only - a sleeping unit answers nobody). Build with -DECOPULSE_HTTP_ENDPOINT=1
+#ifndef ECOPULSE_HTTP_ENDPOINT
+#define ECOPULSE_HTTP_ENDPOINT 0
+#endif
+
+// Every analog conversion, link status and meteorological exchange the control code consumes,
+// and every actuator decision it takes, retained in a flash ring for replay by the host
+// simulator (sim-main --replay). Build with -DECOPULSE_INPUT_TRACE=1
+#ifndef ECOPULSE_INPUT_TRACE
+#define ECOPULSE_INPUT_TRACE 0
+#endif
 
-  http.end();  // Terminate HTTP session and release resources
-}
 // Endpoint authentication parameters - modify with your unique IoT provisioning credentials
 // Format: UUID for device identification + auth key for secure device attestation
 const char DEVICE_LOGIN_NAME[] = "YOUR_DEVICE_ID";  // IoT device UUID
@@ -60,29 +78,210 @@ const char PASS[] = "YOUR_WIFI_PASSWORD";
 
 // Meteorological API integration constants 
 // Atmospheric condition acquisition endpoint + geolocation parameters
-const String apiKey = "YOUR_WEATHER_API_KEY"; // API authentication token
-const String location = "Jessore,BD";         // Geographical coordinate specification
+const char apiKey[] = "YOUR_WEATHER_API_KEY"; // API authentication token
+const char location[] = "Jessore,BD";         // Geographical coordinate specification
+char meteorologicalEndpoint[160];             // Forecast request URI, composed once in setup()
+const char *WEATHER_API_FINGERPRINT = nullptr; // SHA-1 certificate fingerprint authenticating the endpoint (nullptr: encryption only)
+WeatherServiceConnection weatherService("api.weatherapi.com"); // Persistent keep-alive service channel
+AsyncWeatherClient weatherClient(weatherService);              // Non-blocking request pipeline on that channel
+WeatherForecast weatherForecast;                                // 48 h hourly table answering thermal/precipitation queries offline
 
 // Telemetric variable declarations for bidirectional cloud synchronization
 // Hydration level metrics, actuation state indicators, and environmental parameters
-int soil_Moisture;        // Substrate hydration coefficient (0-100%)
-bool pumpStatus;          // Hydraulic actuation mechanism state indicator
-float temperature;        // Ambient thermal condition metric (Celsius)
+int soil_Moisture;        // Substrate hydration coefficient (0-100%) - coalesced publication copy
+bool pumpStatus;          // Hydraulic actuation mechanism state indicator (any zone irrigating)
+float temperature;        // Ambient thermal condition metric (Celsius) - coalesced publication copy
 bool internetConnected;   // Telecommunication link status indicator
-unsigned long lastSuccessfulConnection; // Timestamp of previous successful endpoint handshake
+bool photonicSupplementationActive; // Spectral illumination matrix state
+String telemetryBacklog;  // Offline telemetry replay batch (see formatTelemetryBatch)
+String loopProfile;       // Per-stage p50/p99/max latency summary (ECOPULSE_PROFILE_PROPERTY only)
 
 // Microcontroller I/O interface mapping - hardware-specific pinout configuration
 const int moisturePin = A0;    // Dielectric permittivity sensor analog input
-const int relayPin = D1;       // High-current switching transistor control line
 const int photoSensorPin = A0; // Photonic intensity detection element (multiplexed)
+const uint8_t multiplexerSelectPins[] = { D3 }; // Analog multiplexer address lines (LSB first) - widen for more zones
 const int lightsPin = D2;      // Spectral illumination matrix control signal
 
+// Irrigation zone matrix - one column per independently sensed substrate bed.
+// Extending a row extends the installation; the zone count follows from the tables.
+const uint8_t HYDRAULIC_RELAY_PINS[] = { D1 };                    // High-current switching transistor control lines
+const uint8_t HYDRATION_MUX_ADDRESSES[] = { 0 };                  // Multiplexer inputs wired to the permittivity sensors
+const int8_t HYDRATION_THRESHOLDS[] = { 20 };                     // Reduced hydration thresholds for winter metabolic requirements (%)
+const int8_t HYDRATION_HYSTERESIS[] = { 0 };                      // Hydration surplus above threshold ending irrigation (%)
+const uint8_t IRRIGATION_ZONE_COUNT = sizeof(HYDRAULIC_RELAY_PINS);
+const uint8_t MAX_SIMULTANEOUS_PUMPS = 1;                         // Supply line and power budget admit one pump at a time
+static_assert(sizeof(HYDRATION_MUX_ADDRESSES) == IRRIGATION_ZONE_COUNT && sizeof(HYDRATION_THRESHOLDS) == IRRIGATION_ZONE_COUNT &&
+              sizeof(HYDRATION_HYSTERESIS) == IRRIGATION_ZONE_COUNT, "Irrigation zone tables differ in length");
+
+// Sensor calibration references - expanded into fixed-point conversion tables at compile time
+constexpr CalibrationPoint HYDRATION_DRY_REFERENCE = { 1023, 0 };   // Permittivity probe suspended in dry air (%)
+constexpr CalibrationPoint HYDRATION_WET_REFERENCE = { 0, 100 };    // Permittivity probe immersed in water (%)
+constexpr CalibrationPoint PHOTONIC_REFERENCE_POINTS[] = { { 0, 0 }, { 300, 50 } }; // Photosensor counts against a PAR meter (µmol/m²/s)
+const int16_t PHOTONIC_SUPPLEMENTATION_THRESHOLD = 50;            // PAR below which C3 photosynthesis is light-limited (µmol/m²/s)
+const uint16_t CALIBRATION_MINIMUM_SPAN = 100;                    // Smallest dry-to-wet reference separation accepted (counts)
+const char CALIBRATION_PATH[] = "/calibration.bin";               // Field recalibration references retained in flash
+
+constexpr CalibrationTable<> FACTORY_HYDRATION_CALIBRATION =
+    CalibrationTable<>::twoPoint(HYDRATION_DRY_REFERENCE, HYDRATION_WET_REFERENCE, 0, 100);
+constexpr CalibrationTable<> PHOTONIC_CALIBRATION = CalibrationTable<>::piecewise(PHOTONIC_REFERENCE_POINTS, 0, 2000);
+
 // Autonomous operation parameters - fault-tolerance configuration matrix
 // Calibrated for regional climatic condition resilience under connectivity interruption
 const unsigned long MAX_OFFLINE_TIME = 6 * 60 * 60 * 1000UL;      // Maximum permissible communication interruption threshold
 const unsigned long WINTER_WATERING_INTERVAL = 24 * 60 * 60 * 1000UL; // Hydration cycle periodicity during adverse conditions
 const unsigned long WINTER_WATERING_DURATION = 2 * 60 * 1000UL;   // Actuation persistence duration per hydration cycle
-const int WINTER_MOISTURE_THRESHOLD = 20;                         // Reduced hydration threshold for winter metabolic requirements
+
+// Meteorologically adaptive hydration parameters - evaluated against the locally retained forecast
+const float COLD_STRESS_TEMPERATURE = 15;                         // Below this, evapotranspiration and root uptake slow markedly (°C)
+const int COLD_STRESS_THRESHOLD_REDUCTION = 5;                    // Hydration threshold relaxation under cold stress (%)
+const float FROST_PROTECTION_TEMPERATURE = 2;                     // No failsafe irrigation near freezing - saturated substrate heaves (°C)
+const uint8_t PRECIPITATION_DEFERRAL_HORIZON = 3;                 // Forecast hours in which expected rain defers irrigation
+const uint8_t PRECIPITATION_DEFERRAL_PROBABILITY = 60;            // Chance of rain treated as expected (%)
+const int PRECIPITATION_DEFERRAL_MARGIN = 8;                      // Hydration deficit below threshold that overrides a deferral (%)
+
+// Task scheduling periodicity parameters - all timing is dispatched by the cooperative scheduler
+const unsigned long SENSOR_ACQUISITION_INTERVAL = 1000;           // Environmental acquisition and actuation tick
+const unsigned long SENSOR_SETTLE_TIME = 100;                     // Analog pathway stabilization after each multiplexer switch
+const unsigned long HYDRATION_SAMPLING_PERIOD = 1000;             // Substrate permittivity channel refresh periodicity
+const unsigned long PHOTONIC_SAMPLING_PERIOD = 2000;              // Photonic flux channel refresh periodicity
+const uint8_t PHOTONIC_MUX_ADDRESS = 1;                           // Multiplexer input wired to the photosensor
+const unsigned long INTEGRITY_VERIFICATION_INTERVAL = 60000;      // Telecommunications link probe periodicity
+const unsigned long ATMOSPHERIC_ACQUISITION_INTERVAL = 300000;    // Thermal coefficient refresh from the forecast table (5 minutes)
+const unsigned long FORECAST_REFRESH_INTERVAL = 6 * 60 * 60 * 1000UL; // forecast.json acquisition periodicity (4 requests a day)
+const unsigned long CHRONOLOGICAL_SYNC_INTERVAL = 3600000;        // NTP resynchronization periodicity (hourly)
+const unsigned long CHRONOLOGICAL_SETTLE_TIME = 2000;             // NTP exchange allowance after each association
+const unsigned long JOURNAL_RECORDING_INTERVAL = 60000;           // Offline telemetry retention periodicity
+const unsigned long JOURNAL_REPLAY_INTERVAL = 1000;               // Backlog batch publication rate limit
+const unsigned long LAN_TELEMETRY_INTERVAL = 10000;               // Telemetry frame broadcast periodicity (ECOPULSE_LAN_TELEMETRY only)
+const uint8_t JOURNAL_REPLAY_BATCH = 12;                          // Retained records per backlog publication
+
+// Duty-cycle parameters - only used when ECOPULSE_DEEP_SLEEP is enabled
+const unsigned long DUTY_CYCLE_SLEEP_INTERVAL = 5 * 60 * 1000UL;  // Deep-sleep period between wake cycles
+const unsigned long DUTY_CYCLE_SUPERVISION_INTERVAL = 50;         // Wake cycle progress evaluation periodicity
+const unsigned long CLOUD_PUBLICATION_INTERVAL = 30 * 60 * 1000UL; // Maximum telemetry silence between wake cycles
+const int MOISTURE_PUBLICATION_DELTA = 5;                         // Hydration change forcing an early publication (%)
+const unsigned long NETWORK_WINDOW_TIMEOUT = 20000;               // Abandon an unreachable network after this long
+const unsigned long CLOUD_SYNCHRONIZATION_GRACE = ECOPULSE_LAN_TELEMETRY == 2 ? 0 : 1500; // Cloud session time granted to flush telemetry (LAN frames need none)
+
+// Publication coalescing parameters - sensor jitter below the deadbands never reaches the cloud
+const unsigned long PUBLICATION_COALESCING_WINDOW = 1000;         // Property changes gathered into one cloud message
+const float HYDRATION_PUBLICATION_DEADBAND = 2;                   // Smallest hydration change worth publishing (%)
+const unsigned long HYDRATION_PUBLICATION_MIN_INTERVAL = 10000;   // Hydration publication rate limit
+const float THERMAL_PUBLICATION_DEADBAND = 0.2;                   // Smallest thermal change worth publishing (°C)
+const unsigned long THERMAL_PUBLICATION_MIN_INTERVAL = 60000;     // Thermal publication rate limit
+
+// Execution profiling parameters
+const unsigned long PROFILE_PUBLICATION_INTERVAL = 15 * 60 * 1000UL; // Diagnostic latency summary periodicity
+const size_t PROFILE_SUMMARY_CAPACITY = 256;                      // loopProfile text, stages that do not fit are dropped
+
+// Memory telemetry parameters - 48 samples retain a day of heap history
+const unsigned long HEAP_SAMPLING_INTERVAL = 30 * 60 * 1000UL;    // Free heap / largest block / fragmentation periodicity
+const uint16_t CONTIGUOUS_HEAP_WARNING = 8192;                    // Largest block below which a TLS reconnect is at risk
+
+// Environmental history parameters - raw readings for the last half hour, rollups for two days
+const unsigned long HISTORY_RETENTION_INTERVAL = 1000;            // Reading retention periodicity (1 Hz)
+const uint8_t HISTORY_REPORT_INTERVALS = 12;                      // Rollup intervals listed by the history command
+
+// LAN status endpoint parameters (ECOPULSE_HTTP_ENDPOINT only)
+const uint16_t STATUS_ENDPOINT_PORT = 80;                         // TCP port of the HTTP service
+const long HISTORY_DEFAULT_SPAN = 3600;                           // Seconds of history served when no range is requested
+
+// Input trace parameters (ECOPULSE_INPUT_TRACE only) - ~1 MB/day at the acquisition periods above
+const uint8_t INPUT_TRACE_SEGMENTS = 128;                         // 8 KB flash segments retained (~1 day, oldest deleted first)
+
+// Loop deadline parameters - per-operation execution budgets and the actuation safety deadline
+const unsigned long HYDRAULIC_CONTROL_DEADLINE = 4000;           // Relay de-energized when the control tick starves this long
+const unsigned long DEADLINE_INSPECTION_INTERVAL = 100;          // Watchdog inspection periodicity (adds to worst-case pump-off latency)
+const unsigned long ASSOCIATION_BUDGET = 100;                    // wifiLink.poll()
+const unsigned long CLOUD_SYNCHRONIZATION_BUDGET = 250;          // Publisher release and ArduinoCloud.update()
+const unsigned long METEOROLOGICAL_EXCHANGE_BUDGET = 2500;       // weatherClient.poll(), admitting one full TLS handshake (~2 s)
+const unsigned long INTEGRITY_VERIFICATION_BUDGET = 100;         // Probe dispatch and link statistics
+const unsigned long HYDRATION_ACQUISITION_BUDGET = 150;          // Sensor tick, regulation and journal flash writes
+const unsigned long CHRONOLOGICAL_SYNC_BUDGET = 250;             // getLocalTime() waits while SNTP has no answer
+const unsigned long JOURNAL_REPLAY_BUDGET = 150;                 // Backlog batch read from flash
+const unsigned long STATUS_ENDPOINT_BUDGET = 50;                 // statusEndpoint.poll(): request bytes and a window of chunks
+
+// Control state retained in RTC user memory across deep sleep and resets.
+// All timestamps are on the DutyCycle clock, which keeps counting through sleep.
+typedef IrrigationZones<IRRIGATION_ZONE_COUNT> HydraulicZoneMatrix;
+
+struct HydraulicControlState {
+  HydraulicZoneMatrix::Schedule hydrationSchedule; // Failsafe hydration cycles per zone
+  unsigned long lastSuccessfulConnection;          // Previous verified end-to-end connectivity
+  unsigned long nextChronologicalSyncDue;
+  unsigned long nextCloudPublicationDue;
+  float lastTemperature;                           // Most recent meteorological reading
+  int16_t lastPublishedMoisture;
+  uint16_t telemetryFrameSequence;                 // Next LAN telemetry frame number
+  bool lastPublishedPumpStatus;
+};
+static_assert(sizeof(HydraulicControlState) + 8 <= (RTC_BLOCK_TELEMETRY_JOURNAL - RTC_BLOCK_CONTROL_STATE) * 4,
+              "Control state overflows its RTC blocks - too many irrigation zones");
+
+// Field recalibration references, one dry/wet pair per zone, retained in flash with a CRC
+struct HydrationCalibrationRecord {
+  CalibrationPoint dryReference[IRRIGATION_ZONE_COUNT];
+  CalibrationPoint wetReference[IRRIGATION_ZONE_COUNT];
+};
+
+TaskScheduler taskScheduler;                                      // Central timer table for all deferred operations
+WiFiLink wifiLink;                                                // Association state machine - never blocks the loop
+AdcSampler analogSampler;                                         // timer1-driven A0 conversions
+AnalogMux<IRRIGATION_ZONE_COUNT + 1> analogMultiplexer;           // Per-channel scheduling and median + IIR conditioning
+HydraulicZoneMatrix hydraulicZones;                               // Per-zone thresholds, relays, readings and cycle timers
+CalibrationTable<> hydrationCalibration[IRRIGATION_ZONE_COUNT];  // Per-zone permittivity conversion, regenerated on recalibration
+HydrationCalibrationRecord hydrationReferences;                   // References the conversion tables were generated from
+int8_t photonicChannel;                                           // Multiplexer channel handle for photonic flux
+int hydrationLevel;                                               // Driest zone's substrate hydration (%), published and journaled
+TelemetryPublisher<2> telemetryPublisher;                         // Deadband/rate-limit gate in front of ON_CHANGE properties
+int8_t hydrationPublication;
+int8_t thermalPublication;
+DutyCycle dutyCycle;                                              // Sleep-spanning chronological reference
+RtcRecord<HydraulicControlState, RTC_BLOCK_CONTROL_STATE> controlStateRecord;
+HydraulicControlState controlState;                               // Working copy of the retained control state
+bool wakeCycleEvaluated;                                          // Sensors sampled and actuators decided this wake
+bool networkWindowOpen;                                           // Telemetry/meteorological exchange in progress
+bool cloudSessionStarted;                                         // ArduinoCloud.begin() issued during this wake
+unsigned long networkWindowOpenedAt;
+unsigned long cloudSessionStartedAt;
+bool windowAcquisitionsIssued;                                    // Due weather/NTP exchanges started this window
+TelemetryJournal telemetryJournal;                                // Offline telemetry retained in flash
+unsigned long lastJournalRecording;                               // DutyCycle clock of the previous retained record
+bool journalRecordingPending;                                     // Nothing retained yet during this boot
+bool lastJournaledPumpStatus;
+bool backlogBatchInFlight;                                        // telemetryBacklog awaits acknowledgement
+ZoneMask hydrationWithheldZones;                                  // Zones whose irrigation is withheld for forecast rain or frost
+ZoneMask irrigationQueueReported;                                 // Zones already reported waiting for a pump
+TelemetryStreamer lanTelemetryStreamer;                           // Sequenced binary frames to the on-site collector
+WeatherShare meteorologicalConsortium;                            // Elected forecast acquisition among co-located units
+LoopProfiler<12> executionProfiler;                               // Per-stage cycle-counted latency histograms
+int8_t loopPassStage;                                             // Profiler stage handles
+int8_t associationStage;
+int8_t cloudSynchronizationStage;
+int8_t analogAcquisitionStage;
+int8_t meteorologicalExchangeStage;
+int8_t integrityVerificationStage;
+int8_t hydrationAcquisitionStage;
+int8_t hydraulicRegulationStage;
+int8_t photonicRegulationStage;
+int8_t forecastAcquisitionStage;
+int8_t diagnosticOutputStage;
+int8_t statusEndpointStage;
+SerialConsole<6> diagnosticConsole;                               // Maintenance commands typed at the serial monitor
+LoopWatchdog<8, IRRIGATION_ZONE_COUNT> loopWatchdog;              // Execution budgets, overrun attribution, relay safety deadline
+int8_t associationOperation;                                      // Watchdog operation handles
+int8_t cloudSynchronizationOperation;
+int8_t meteorologicalExchangeOperation;
+int8_t integrityVerificationOperation;
+int8_t hydrationAcquisitionOperation;
+int8_t chronologicalSyncOperation;
+int8_t journalReplayOperation;
+int8_t statusEndpointOperation;
+HeapMonitor<48> memoryUtilizationMonitor;                         // Heap fragmentation trend across days of uptime
+TelemetryHistory<> environmentalHistory;                          // ~7 KB: Gorilla-compressed 1 Hz readings, 1 min/15 min/1 h rollups
+HttpEndpoint<6> statusEndpoint(STATUS_ENDPOINT_PORT);             // Chunked JSON/CSV responses from one 512-byte buffer
+InputTrace inputTrace;                                            // External inputs and actuator decisions, for replay on the host
+uint32_t traceDownloadSegment;                                    // Segment /trace.bin is serving
 
 // Chronological reference acquisition parameters
 // Network Time Protocol synchronization configuration
@@ -97,6 +296,60 @@ void onSoilMoistureChange();
 void onPumpStatusChange();
 void onTemperatureChange();
 void onInternetConnectedChange();
+void establishTelecommunicationsChannel();
+void onTelecommunicationsEstablished();
+void onTelecommunicationsInterrupted();
+bool synchronizeChronologicalReference();
+void verifyTelecommunicationsIntegrity();
+void onIntegrityProbeResponse(const WeatherFetchResult &result, const WeatherConditions &conditions);
+void acquireAtmosphericThermalParameters();
+void onAtmosphericForecast(const WeatherFetchResult &result, const WeatherConditions &conditions);
+void updateAtmosphericThermalParameters();
+unsigned long sleepSpanningChronologicalReference();
+bool precipitationExpected();
+void scheduledAtmosphericAcquisition();
+void scheduledChronologicalSynchronization();
+void acquireSubstrateHydrationMetrics();
+void regulatePhotosyntheticalSupplementationSystem();
+void implementPrimaryHydraulicRegulationAlgorithm();
+void implementSecondaryHydraulicRegulationAlgorithm();
+void restoreControlState();
+void persistControlState();
+void superviseDutyCycle();
+bool publicationDue();
+void openNetworkWindow();
+void closeNetworkWindow();
+void enterDutyCycleSleep();
+void retainOfflineTelemetry();
+void replayTelemetryBacklog();
+void configureTelemetryPublication();
+void publishTelemetryProperty(uint8_t property, float value);
+void configureExecutionProfiling();
+void onProfileCommand(const char *arguments);
+void publishExecutionProfile();
+void configureLoopWatchdog();
+void onWatchdogCommand(const char *arguments);
+void composeMeteorologicalEndpoint();
+void configureMemoryTelemetry();
+void onHeapCommand(const char *arguments);
+void retainEnvironmentalHistory();
+void onHistoryCommand(const char *arguments);
+void configureStatusEndpoint();
+bool writeEndpointIndex(HttpBody &body);
+bool writeOperationalState(HttpBody &body);
+bool writeExecutionMetrics(HttpBody &body);
+bool writeHistoryCsv(HttpBody &body);
+bool writeHistoryJson(HttpBody &body);
+bool writeInputTrace(HttpBody &body);
+void configureInputTrace();
+void configureIrrigationZones();
+bool hydrationChannelsReady();
+void reportIrrigationQueue();
+void onZonesCommand(const char *arguments);
+void restoreHydrationCalibration();
+void onCalibrateCommand(const char *arguments);
+TelemetrySample captureTelemetrySample();
+void broadcastTelemetryFrame();
 
 void initProperties() {
   // Establish device attestation and cryptographic identity binding
@@ -109,6 +362,10 @@ void initProperties() {
   ArduinoCloud.addProperty(pumpStatus, READWRITE, ON_CHANGE, onPumpStatusChange);
   ArduinoCloud.addProperty(temperature, READ, ON_CHANGE, onTemperatureChange);
   ArduinoCloud.addProperty(internetConnected, READ, ON_CHANGE, onInternetConnectedChange);
+  ArduinoCloud.addProperty(telemetryBacklog, READ, ON_CHANGE, nullptr);
+  if (ECOPULSE_PROFILE_PROPERTY) {
+    ArduinoCloud.addProperty(loopProfile, READ, ON_CHANGE, nullptr);
+  }
 }
 
 // Telecommunications connectivity handler instantiation
@@ -117,284 +374,1342 @@ WiFiConnectionHandler ArduinoIoTPreferredConnection(SSID, PASS);
 void setup() {
   // Initialize serial diagnostic interface at high baud rate for minimal latency
   Serial.begin(115200);
-  delay(1500);  // Transceiver stabilization period
-  Serial.println(F("\n=== EcoPulse Autonomous Agronomic Control System v2.1 ==="));
+  dutyCycle.begin();
+  if (!dutyCycle.wokeFromSleep()) {
+    delay(1500);  // Transceiver stabilization period (cold start only - every wake millisecond costs charge)
+  }
+  logger.begin(Serial);
+  LOG_INFO(LOG_SYSTEM, "=== EcoPulse Autonomous Agronomic Control System v2.1 ===");
+  configureExecutionProfiling();
+  configureLoopWatchdog();
+  configureMemoryTelemetry();
 
   // Configure I/O peripheral interfaces with appropriate electrical characteristics
   pinMode(moisturePin, INPUT);     // High-impedance configuration for capacitive sensing
-  pinMode(relayPin, OUTPUT);       // Push-pull output for inductive load switching
   pinMode(photoSensorPin, INPUT);  // Analog acquisition mode for luminance detection
   pinMode(lightsPin, OUTPUT);      // Current-sourcing mode for illumination control
   
   // Initialize actuation subsystems to safe default states
-  digitalWrite(relayPin, LOW);    // Deactivate hydraulic circulation system
   digitalWrite(lightsPin, LOW);   // Deactivate photosynthetic supplementation array
+
+  // Commence fixed-rate analog acquisition (200 Hz) and interleave all sensors on the shared ADC
+  analogSampler.begin(moisturePin);
+  analogMultiplexer.begin(analogSampler, multiplexerSelectPins, sizeof(multiplexerSelectPins), SENSOR_SETTLE_TIME);
+  configureIrrigationZones();
+  photonicChannel = analogMultiplexer.addChannel(PHOTONIC_MUX_ADDRESS, PHOTONIC_SAMPLING_PERIOD);
   
   // System state variable initialization
   internetConnected = false;
-  lastSuccessfulConnection = 0;
-  
-  // Establish wireless communications link
+  photonicSupplementationActive = false;
+  restoreControlState();
+  temperature = controlState.lastTemperature;
+  if (ECOPULSE_LAN_TELEMETRY) {
+    // Frame numbering continues across wakes, so the collector can tell lost frames from sleep
+    lanTelemetryStreamer.begin(ESP.getChipId(), controlState.telemetryFrameSequence);
+  }
+  journalRecordingPending = true;
+
+  // The forecast table is anchored to the sleep-spanning clock and retained in flash,
+  // so a wake or reset answers thermal and precipitation queries without a request
+  WeatherForecastConfig forecastConfig;
+  forecastConfig.refreshIntervalMs = FORECAST_REFRESH_INTERVAL;
+  forecastConfig.flashCache = true;
+  weatherForecast.begin(forecastConfig, sleepSpanningChronologicalReference);
+  if (ECOPULSE_WEATHER_SHARE) {
+    meteorologicalConsortium.begin(weatherForecast, ESP.getChipId(), location, WeatherShareConfig(),
+                                   sleepSpanningChronologicalReference);
+  }
+
+  // Meteorological exchanges carry the API key - encrypted, with the TLS session
+  // retained in RTC memory so each wake resumes it instead of a full handshake
+  WeatherTlsConfig transportSecurity;
+  transportSecurity.fingerprint = WEATHER_API_FINGERPRINT;
+  weatherService.useTls(transportSecurity);
+  composeMeteorologicalEndpoint();
+  updateAtmosphericThermalParameters();
+  if (!telemetryJournal.begin()) {
+    LOG_WARN(LOG_STORAGE, "Telemetry journal unavailable - offline readings will not be retained");
+  }
+  if (ECOPULSE_INPUT_TRACE) {
+    configureInputTrace();
+  }
+
+  // Initialize IoT bidirectional telemetry subsystem; text properties get their full
+  // capacity now so later assignments reuse it instead of reallocating on the heap
+  initProperties();
+  telemetryBacklog.reserve(JOURNAL_REPLAY_BATCH * TELEMETRY_BATCH_FIELD_MAX);
+  if (ECOPULSE_PROFILE_PROPERTY) {
+    loopProfile.reserve(PROFILE_SUMMARY_CAPACITY);
+  }
+  configureTelemetryPublication();
+
+  if (ECOPULSE_DEEP_SLEEP) {
+    // Duty-cycle wake: radio stays off unless the supervisor finds telemetry or acquisitions due
+    const DutyCycleState &cycle = dutyCycle.stats();
+    LOG_INFO(LOG_SYSTEM, "Duty cycle wake %u (%s), previous wake-to-sleep %u ms, max %u ms, awake %u%% of cycle",
+             cycle.wakes, ESP.getResetReason().c_str(), cycle.lastAwakeMs, cycle.maxAwakeMs,
+             dutyCycle.awakePercent());
+    wakeCycleEvaluated = false;
+    networkWindowOpen = false;
+    cloudSessionStarted = false;
+    taskScheduler.every(SENSOR_ACQUISITION_INTERVAL, acquireSubstrateHydrationMetrics, SENSOR_ACQUISITION_INTERVAL);
+    taskScheduler.every(DUTY_CYCLE_SUPERVISION_INTERVAL, superviseDutyCycle);
+    taskScheduler.every(JOURNAL_REPLAY_INTERVAL, replayTelemetryBacklog, JOURNAL_REPLAY_INTERVAL);
+    return;
+  }
+
+  // Commence wireless association in the background; control tasks run from the first loop pass
   establishTelecommunicationsChannel();
   
-  // Synchronize chronological reference with atomic time standard
+  // Chronological reference synchronizes with the atomic time standard once the link is up
   configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-  synchronizeChronologicalReference();
 
-  // Initialize IoT bidirectional telemetry subsystem
-  initProperties();
-  ArduinoCloud.begin(ArduinoIoTPreferredConnection);
+  if (ECOPULSE_LAN_TELEMETRY != 2) {
+    ArduinoCloud.begin(ArduinoIoTPreferredConnection);
+  }
+
+  // Register periodic operations with the cooperative task scheduler
+  taskScheduler.every(SENSOR_ACQUISITION_INTERVAL, acquireSubstrateHydrationMetrics);
+  taskScheduler.every(INTEGRITY_VERIFICATION_INTERVAL, verifyTelecommunicationsIntegrity, INTEGRITY_VERIFICATION_INTERVAL);
+  taskScheduler.every(ATMOSPHERIC_ACQUISITION_INTERVAL, scheduledAtmosphericAcquisition, ATMOSPHERIC_ACQUISITION_INTERVAL);
+  taskScheduler.every(CHRONOLOGICAL_SYNC_INTERVAL, scheduledChronologicalSynchronization, CHRONOLOGICAL_SYNC_INTERVAL);
+  taskScheduler.every(JOURNAL_REPLAY_INTERVAL, replayTelemetryBacklog, JOURNAL_REPLAY_INTERVAL);
+  // RAM does not survive deep sleep, so the history is kept by the always-on configuration only
+  taskScheduler.every(HISTORY_RETENTION_INTERVAL, retainEnvironmentalHistory, HISTORY_RETENTION_INTERVAL);
+  if (ECOPULSE_PROFILE_PROPERTY) {
+    taskScheduler.every(PROFILE_PUBLICATION_INTERVAL, publishExecutionProfile, PROFILE_PUBLICATION_INTERVAL);
+  }
+  if (ECOPULSE_LAN_TELEMETRY) {
+    taskScheduler.every(LAN_TELEMETRY_INTERVAL, broadcastTelemetryFrame, LAN_TELEMETRY_INTERVAL);
+  }
+  if (ECOPULSE_HTTP_ENDPOINT) {
+    configureStatusEndpoint();
+  }
   
-  Serial.println(F("Autonomous agricultural control system initialized and operational"));
+  LOG_INFO(LOG_SYSTEM, "Autonomous agricultural control system initialized and operational");
 }
 
-void setupWifi() {
-  WiFi.begin(SSID, PASS);
-  int attempts = 0;
-  Serial.print(F("Connecting to Wi-Fi"));
-  
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
+void establishTelecommunicationsChannel() {
+  // Association, retries and backoff are advanced by wifiLink.poll() from the main loop;
+  // the access point cache also lives in flash so a power cycle still rejoins without a scan
+  WiFiLinkConfig linkConfig;
+  linkConfig.flashCache = true;
+  wifiLink.onConnected(onTelecommunicationsEstablished);
+  wifiLink.onDisconnected(onTelecommunicationsInterrupted);
+  wifiLink.begin(SSID, PASS, linkConfig);
+  LOG_INFO(LOG_NETWORK, "Connecting to Wi-Fi");
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println(F("\nWi-Fi connected. IP: ") + WiFi.localIP().toString());
-    internetConnected = true;
-    lastSuccessfulConnection = millis();
-  } else {
-    Serial.println(F("\nWi-Fi connection failed! Operating in offline mode."));
-    internetConnected = false;
+void onTelecommunicationsEstablished() {
+  const WiFiLinkStats &linkStats = wifiLink.stats();
+  LOG_INFO(LOG_NETWORK, "Wi-Fi connected in %lu ms (%u of %u attempts from cached access point). IP: %s",
+           linkStats.lastConnectMs, linkStats.fastConnects, linkStats.attempts, WiFi.localIP().toString().c_str());
+  internetConnected = true;
+  controlState.lastSuccessfulConnection = dutyCycle.now();
+  persistControlState();
+  if (!ECOPULSE_DEEP_SLEEP) {
+    taskScheduler.after(CHRONOLOGICAL_SETTLE_TIME, scheduledChronologicalSynchronization);
+    taskScheduler.after(CHRONOLOGICAL_SETTLE_TIME, scheduledAtmosphericAcquisition);  // Refetches only an aged-out forecast
+  } else if (!cloudSessionStarted) {
+    // Duty-cycle wake: the cloud session, the LAN frame and NTP ride on the first association of the wake
+    if (ECOPULSE_LAN_TELEMETRY != 2) {
+      ArduinoCloud.begin(ArduinoIoTPreferredConnection);
+    }
+    if (ECOPULSE_LAN_TELEMETRY) {
+      broadcastTelemetryFrame();
+    }
+    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+    cloudSessionStarted = true;
+    cloudSessionStartedAt = dutyCycle.now();
   }
 }
 
+void onTelecommunicationsInterrupted() {
+  LOG_WARN(LOG_NETWORK, "Telecommunications disruption detected. Reassociating in the background...");
+  internetConnected = false;
+}
+
 void verifyTelecommunicationsIntegrity() {
-  static unsigned long lastIntegrityVerification = 0;
-  
-  // Periodic telecommunications link integrity verification
-  if (millis() - lastIntegrityVerification > 60000) {  // 60-second verification periodicity
-    lastIntegrityVerification = millis();
-    
-    if (WiFi.status() != WL_CONNECTED) {
-      // Telecommunications link disruption mitigation protocol
-      Serial.println(F("Telecommunications disruption detected. Initiating recovery sequence..."));
-      WiFi.disconnect();
-      delay(1000);  // RF transceiver reset stabilization period
-      establishTelecommunicationsChannel();
-    } else {
-      // Verify end-to-end connectivity via meteorological data acquisition endpoint probe
-      WiFiClient client;
-      HTTPClient http;
-      http.begin(client, "http://api.weatherapi.com/v1/ping.json");
-      int httpCode = http.GET();
-      
-      if (httpCode == 200) {
-        internetConnected = true;
-        lastSuccessfulConnection = millis();
-        Serial.println(F("End-to-end telecommunications integrity verified"));
-      } else {
-        Serial.println(F("Endpoint connectivity verification failure detected"));
-        // Maintain previous chronological reference for failsafe triggering calculation
-      }
-      
-      http.end();
+  // Periodic telecommunications link integrity verification (dispatched every 60 seconds)
+  PROFILE_STAGE(executionProfiler, integrityVerificationStage);
+  WATCHDOG_SCOPE(loopWatchdog, integrityVerificationOperation);
+  if (!wifiLink.connected()) {
+    // Recovery is already under way in the link manager - report its progress only
+    const WiFiLinkStats &linkStats = wifiLink.stats();
+    LOG_INFO(LOG_NETWORK, "Telecommunications link down: %u attempts, %u failed, %u drops",
+             linkStats.attempts, linkStats.failures, linkStats.drops);
+  } else {
+    // Verify end-to-end connectivity via meteorological data acquisition endpoint probe
+    // (rides the persistent weather service socket - no DNS or TCP handshake while it stays open;
+    // the verdict arrives asynchronously in onIntegrityProbeResponse())
+    weatherClient.probe("/v1/ping.json", onIntegrityProbeResponse);
+
+    const PublisherStats &publishStats = telemetryPublisher.stats();
+    LOG_INFO(LOG_CLOUD, "Cloud publication: %u property updates in %u messages, %u suppressed (%u duplicate, %u deadband, %u coalesced)",
+             publishStats.sent, publishStats.transmissions, publishStats.suppressed(),
+             publishStats.suppressedDuplicate, publishStats.suppressedDeadband, publishStats.coalesced);
+    if (ECOPULSE_LAN_TELEMETRY) {
+      const TelemetryStreamStats &streamStats = lanTelemetryStreamer.stats();
+      LOG_INFO(LOG_CLOUD, "LAN telemetry: %u frames (%u B) broadcast, %u failed",
+               streamStats.sent, streamStats.bytes, streamStats.failed);
+    }
+
+    const ConnectionStats &linkStats = weatherService.stats();
+    LOG_INFO(LOG_WEATHER, "Weather service link: %u requests, %u handshakes, %u saved, latency %lu ms (avg %lu, max %lu)",
+             linkStats.requests, linkStats.handshakes, linkStats.handshakesSaved,
+             linkStats.lastLatencyMs, linkStats.averageLatencyMs(), linkStats.maxLatencyMs);
+    LOG_INFO(LOG_WEATHER, "Weather service TLS: %u full, %u resumed handshakes (avg %lu ms), %u-byte records, %u B held (peak %u, lowest free heap %u)",
+             linkStats.tlsFullHandshakes, linkStats.tlsResumedHandshakes, linkStats.averageTlsHandshakeMs(),
+             linkStats.tlsFragmentLength ? linkStats.tlsFragmentLength : 16384, linkStats.connectionHeap,
+             linkStats.peakConnectionHeap, linkStats.lowestFreeHeap);
+
+    const WeatherForecastStats &forecastStats = weatherForecast.stats();
+    if (ECOPULSE_WEATHER_SHARE) {
+      const WeatherShareStats &shareStats = meteorologicalConsortium.stats();
+      LOG_INFO(LOG_WEATHER, "Forecast sharing: role %u, %u tables sent, %u adopted, %u requests (%u answered), %u takeovers, %u step-downs",
+               meteorologicalConsortium.currentRole(), shareStats.recordsSent, shareStats.recordsAdopted,
+               shareStats.requestsSent, shareStats.requestsAnswered, shareStats.takeovers, shareStats.stepDowns);
     }
+    LOG_INFO(LOG_WEATHER, "Forecast table: %u hours, %u refreshes (%u failed), %u local answers, %u uncovered",
+             forecastStats.hours, forecastStats.refreshes, forecastStats.failures,
+             forecastStats.lookups, forecastStats.misses);
+  }
+}
+
+void onIntegrityProbeResponse(const WeatherFetchResult &result, const WeatherConditions &) {
+  if (result.httpCode == 200) {
+    internetConnected = true;
+    controlState.lastSuccessfulConnection = dutyCycle.now();
+    persistControlState();
+    LOG_DEBUG(LOG_NETWORK, "End-to-end telecommunications integrity verified");
+  } else {
+    LOG_WARN(LOG_NETWORK, "Endpoint connectivity verification failure detected");
+    // Maintain previous chronological reference for failsafe triggering calculation
   }
 }
 
-bool updateLocalTime() {
+bool synchronizeChronologicalReference() {
   if(!getLocalTime(&timeinfo)) {
-    Serial.println(F("Failed to obtain time"));
+    LOG_WARN(LOG_SYSTEM, "Failed to obtain time");
     return false;
   }
   
   char timeStr[30];
   strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
-  Serial.print(F("Current time: "));
-  Serial.println(timeStr);
+  LOG_INFO(LOG_SYSTEM, "Current time: %s", timeStr);
   return true;
 }
 
 void loop() {
+  PROFILE_STAGE(executionProfiler, loopPassStage);
+
+  // Advance association and reconnection without waiting on the transceiver
+  {
+    PROFILE_STAGE(executionProfiler, associationStage);
+    WATCHDOG_SCOPE(loopWatchdog, associationOperation);
+    wifiLink.poll();
+  }
+
   // Conditional telemetry synchronization based on connectivity state
   if (internetConnected) {
-    ArduinoCloud.update();
+    PROFILE_STAGE(executionProfiler, cloudSynchronizationStage);
+    WATCHDOG_SCOPE(loopWatchdog, cloudSynchronizationOperation);
+    // Coalesced property changes are released first so this update carries them in one message
+    telemetryPublisher.poll();
+    if (ECOPULSE_LAN_TELEMETRY != 2) {
+      ArduinoCloud.update();
+    }
   }
   
-  // Telecommunications link integrity verification
-  verifyTelecommunicationsIntegrity();
-  
-  // Environmental parameter acquisition
-  acquireSubstrateHydrationMetrics();
-  regulatePhotosyntheticalSupplementationSystem();
-  
+  // Advance the analog channel scheduler; filtered channel values are then available in O(1)
+  {
+    PROFILE_STAGE(executionProfiler, analogAcquisitionStage);
+    analogMultiplexer.poll();
+  }
+
+  // Consume whatever weather service bytes have arrived; completed requests dispatch their handlers
+  {
+    PROFILE_STAGE(executionProfiler, meteorologicalExchangeStage);
+    WATCHDOG_SCOPE(loopWatchdog, meteorologicalExchangeOperation);
+    weatherClient.poll();
+    if (ECOPULSE_WEATHER_SHARE && meteorologicalConsortium.poll()) {
+      LOG_INFO(LOG_WEATHER, "Meteorological forecast adopted from a co-located unit: %u hourly entries",
+               weatherForecast.stats().hours);
+      updateAtmosphericThermalParameters();
+    } else if (ECOPULSE_WEATHER_SHARE && !ECOPULSE_DEEP_SLEEP && internetConnected &&
+               meteorologicalConsortium.fetchDue()) {
+      // Evaluated every pass rather than on the acquisition schedule, preserving the election spacing
+      acquireAtmosphericThermalParameters();
+    }
+  }
+
+  // Dispatch every due operation; nothing in the loop blocks, so cloud traffic
+  // and remote actuation commands are serviced on every pass
+  taskScheduler.run();
+
+  // Hand buffered diagnostics to the UART as its FIFO frees up, then take any typed command
+  {
+    PROFILE_STAGE(executionProfiler, diagnosticOutputStage);
+    logger.poll();
+    diagnosticConsole.poll();
+    memoryUtilizationMonitor.poll();
+    if (ECOPULSE_INPUT_TRACE) {
+      inputTrace.poll();  // Actuator changes of this pass, and the periodic flash write
+    }
+  }
+
+  // Serve the LAN endpoint a send window at a time; a slow reader delays its own response only
+  if (ECOPULSE_HTTP_ENDPOINT && !ECOPULSE_DEEP_SLEEP) {
+    PROFILE_STAGE(executionProfiler, statusEndpointStage);
+    WATCHDOG_SCOPE(loopWatchdog, statusEndpointOperation);
+    statusEndpoint.poll();
+  }
+  yield();
+}
+
+void scheduledAtmosphericAcquisition() {
+  // Thermal coefficient comes from the retained forecast, connected or not;
+  // the table itself is only refetched when it has aged out
+  updateAtmosphericThermalParameters();
+  if (!ECOPULSE_WEATHER_SHARE && internetConnected && weatherForecast.refreshDue()) {
+    acquireAtmosphericThermalParameters();
+  }
+}
+
+void scheduledChronologicalSynchronization() {
+  // Conditional chronological reference resynchronization
+  WATCHDOG_SCOPE(loopWatchdog, chronologicalSyncOperation);
+  if (internetConnected) {
+    synchronizeChronologicalReference();
+  }
+}
+
+void executeHydraulicControlTick() {
   // Hydraulic circulation control logic with redundant operational protocols
-  if (internetConnected || (millis() - lastSuccessfulConnection < MAX_OFFLINE_TIME)) {
+  PROFILE_STAGE(executionProfiler, hydraulicRegulationStage);
+  if (internetConnected || (dutyCycle.now() - controlState.lastSuccessfulConnection < MAX_OFFLINE_TIME)) {
     // Standard operational protocol - sensory feedback-based actuation
     implementPrimaryHydraulicRegulationAlgorithm();
   } else {
     // Autonomous failsafe protocol - chronologically deterministic actuation
     implementSecondaryHydraulicRegulationAlgorithm();
   }
+
+  pumpStatus = hydraulicZones.anyWatering();
+
+  // A starved loop had the relays de-energized by the watchdog - restore the decided state
+  if (loopWatchdog.controlTick()) {
+    hydraulicZones.reassertOutputs();
+  }
+}
+
+void acquireSubstrateHydrationMetrics() {
+  // Latest conditioned permittivity reading from the multiplexed acquisition pathway
+  PROFILE_STAGE(executionProfiler, hydrationAcquisitionStage);
+  WATCHDOG_SCOPE(loopWatchdog, hydrationAcquisitionOperation);
+  if (!hydrationChannelsReady()) {
+    return;  // First channel visits still pending after boot
+  }
+  for (uint8_t zone = 0; zone < hydraulicZones.zoneCount(); zone++) {
+    int rawDielectricValue = analogMultiplexer.value(hydraulicZones.sensorChannel(zone));
+
+    // Transform sensor response to volumetric water content through the zone's calibration table
+    // (fixed-point interpolation between the dry and wet references, bounded to 0-100%)
+    hydraulicZones.setMoisture(zone, hydrationCalibration[zone].convert(rawDielectricValue));
+  }
+  hydrationLevel = hydraulicZones.driestMoisture();
+  telemetryPublisher.set(hydrationPublication, hydrationLevel);
   
-  // Conditional atmospheric parameter synchronization
-  if (internetConnected) {
-    static unsigned long lastAtmosphericDataAcquisition = 0;
-    if (millis() - lastAtmosphericDataAcquisition > 300000) { // 5-minute acquisition periodicity
-      acquireAtmosphericThermalParameters();
-      lastAtmosphericDataAcquisition = millis();
+  LOG_DEBUG(LOG_SENSOR, "Substrate hydration coefficient: %d%% (driest of %u zones)", hydrationLevel,
+            hydraulicZones.zoneCount());
+
+  executeHydraulicControlTick();
+  regulatePhotosyntheticalSupplementationSystem();
+  retainOfflineTelemetry();
+}
+
+bool hydrationChannelsReady() {
+  for (uint8_t zone = 0; zone < hydraulicZones.zoneCount(); zone++) {
+    if (!analogMultiplexer.ready(hydraulicZones.sensorChannel(zone))) {
+      return false;
     }
   }
-  
-  // Conditional chronological reference resynchronization
-  static unsigned long lastChronologicalSynchronization = 0;
-  if (internetConnected && (millis() - lastChronologicalSynchronization > 3600000)) { // Hourly synchronization
-    synchronizeChronologicalReference();
-    lastChronologicalSynchronization = millis();
+  return true;
+}
+
+void retainOfflineTelemetry() {
+  // Cloud synchronization is suspended while offline - retain the readings in flash instead
+  if (internetConnected) {
+    return;
   }
-  
-  // System execution periodicity control
-  delay(1000);
+  unsigned long currentReference = dutyCycle.now();
+  bool intervalElapsed = journalRecordingPending || currentReference - lastJournalRecording >= JOURNAL_RECORDING_INTERVAL;
+  if (!intervalElapsed && pumpStatus == lastJournaledPumpStatus) {
+    return;
+  }
+
+  TelemetrySample sample = captureTelemetrySample();
+  TelemetryRecord record = {};
+  record.timestamp = sample.timestamp;
+  record.temperatureDeci = sample.temperatureDeci;
+  record.light = sample.light;
+  record.moisture = sample.moisture;
+  record.flags = sample.flags;
+  telemetryJournal.append(record);
+  lastJournalRecording = currentReference;
+  lastJournaledPumpStatus = pumpStatus;
+  journalRecordingPending = false;
 }
 
-void acquireSubstrateHydrationMetrics() {
-  // Preserve current multiplexer state for subsequent restoration
-  int previousMultiplexerState = digitalRead(D3);
-  
-  // Configure analog acquisition pathway for substrate permittivity measurement
-  pinMode(moisturePin, INPUT);
-  delay(100);  // Circuit stabilization delay to prevent capacitive transients
-  
-  // Acquire and transform dielectric permittivity data
-  int rawDielectricValue = analogRead(moisturePin);
-  
-  // Transform non-linear sensor response to volumetric water content
-  // Using polynomial approximation of Topp equation for mineral soils
-  soil_Moisture = map(rawDielectricValue, 1023, 0, 0, 100);
-  soil_Moisture = constrain(soil_Moisture, 0, 100);  // Boundary condition enforcement
-  
-  // Restore previous multiplexer configuration
-  digitalWrite(D3, previousMultiplexerState);
-  
-  Serial.print(F("Substrate hydration coefficient: "));
-  Serial.print(soil_Moisture);
-  Serial.println(F("%"));
+TelemetrySample captureTelemetrySample() {
+  TelemetrySample sample;
+  sample.timestamp = dutyCycle.now() / 1000;
+  sample.temperatureDeci = telemetryTemperature(controlState.lastTemperature);
+  sample.light = analogMultiplexer.value(photonicChannel);
+  sample.moisture = hydrationLevel;
+  sample.flags = (pumpStatus ? TELEMETRY_FLAG_PUMP : 0) | (photonicSupplementationActive ? TELEMETRY_FLAG_LIGHTS : 0) |
+                 (hydraulicZones.cyclingZones() ? TELEMETRY_FLAG_FAILSAFE : 0);
+  return sample;
+}
+
+void broadcastTelemetryFrame() {
+  // One 20-byte datagram per sample; the retained sequence is persisted with the control state
+  if (!internetConnected) {
+    return;
+  }
+  lanTelemetryStreamer.send(captureTelemetrySample());
+  controlState.telemetryFrameSequence = lanTelemetryStreamer.nextSequence();
+}
+
+void replayTelemetryBacklog() {
+  // Rate-limited background upload of the retained backlog: one batch per dispatch,
+  // acknowledged on the next dispatch once the cloud session (or the LAN) has carried it
+  WATCHDOG_SCOPE(loopWatchdog, journalReplayOperation);
+  if (!internetConnected || (ECOPULSE_LAN_TELEMETRY != 2 && !ArduinoCloud.connected())) {
+    return;
+  }
+  if (backlogBatchInFlight) {
+    telemetryJournal.commit();
+    backlogBatchInFlight = false;
+  }
+  if (telemetryJournal.backlog() == 0) {
+    return;
+  }
+
+  TelemetryRecord batch[JOURNAL_REPLAY_BATCH];
+  size_t count = telemetryJournal.readBatch(batch, JOURNAL_REPLAY_BATCH);
+  if (count == 0) {
+    return;
+  }
+  if (ECOPULSE_LAN_TELEMETRY == 2) {
+    // LAN-only: every record leaves as its own frame with its original timestamp; a batch
+    // the link dropped part of is not acknowledged and goes out again on the next dispatch
+    bool batchDelivered = true;
+    for (size_t i = 0; i < count; i++) {
+      batchDelivered &= lanTelemetryStreamer.send(telemetryRecordSample(batch[i]));
+    }
+    controlState.telemetryFrameSequence = lanTelemetryStreamer.nextSequence();
+    if (!batchDelivered) {
+      return;
+    }
+  } else {
+    char text[JOURNAL_REPLAY_BATCH * TELEMETRY_BATCH_FIELD_MAX + 1];
+    size_t fitted = formatTelemetryBatch(text, sizeof(text), batch, count, dutyCycle.now() / 1000);
+    if (fitted < count) {
+      // Re-read only the records that made it into the text, so commit() cannot acknowledge the rest
+      count = fitted ? telemetryJournal.readBatch(batch, fitted) : 0;
+      if (count == 0) {
+        return;
+      }
+    }
+    telemetryBacklog = text;
+  }
+  backlogBatchInFlight = true;
+
+  const TelemetryJournalStats &journalStats = telemetryJournal.stats();
+  LOG_INFO(LOG_STORAGE, "Telemetry backlog: %u records published, %u pending, %u lost to flash budget",
+           (unsigned)(journalStats.replayed + count), (unsigned)(telemetryJournal.backlog() - count),
+           (unsigned)journalStats.dropped);
 }
 
 void implementPrimaryHydraulicRegulationAlgorithm() {
-  // Extract contextualized hydration threshold based on seasonal parameters
-  int requiredHydrationThreshold = WINTER_MOISTURE_THRESHOLD;
-  
-  // Implement hysteresis-based control to prevent oscillation
-  if (soil_Moisture < requiredHydrationThreshold && !pumpStatus) {
-    // Activate hydraulic circulation system - drought condition detected
-    pumpStatus = true;
-    digitalWrite(relayPin, HIGH);
-    Serial.println(F("Hydraulic circulation system activated (substrate dehydration detected)"));
-  } 
-  // Deactivate system when hydration objectives achieved
-  else if (soil_Moisture >= requiredHydrationThreshold && pumpStatus) {
-    pumpStatus = false;
-    digitalWrite(relayPin, LOW);
-    Serial.println(F("Hydraulic circulation system deactivated (optimal hydration achieved)"));
+  // Extract contextualized hydration thresholds based on seasonal parameters
+  int thresholdAdjustment = 0;
+  if (controlState.lastTemperature < COLD_STRESS_TEMPERATURE) {
+    // Cold-stress mitigation: reduced metabolic demand tolerates a drier substrate
+    thresholdAdjustment = -COLD_STRESS_THRESHOLD_REDUCTION;
   }
+
+  // Forecast precipitation defers irrigation unless the substrate is critically dehydrated -
+  // the forecast is consulted only when some zone is within the deferral margin
+  ZoneMask deferrableZones = hydraulicZones.deferrable(thresholdAdjustment, PRECIPITATION_DEFERRAL_MARGIN);
+  ZoneMask deferredZones = deferrableZones && precipitationExpected() ? deferrableZones : 0;
+  for (ZoneMask zones = deferredZones & ~hydrationWithheldZones; zones; zones &= zones - 1) {
+    uint8_t zone = __builtin_ctz(zones);
+    LOG_INFO(LOG_ACTUATOR, "Hydration deferred: precipitation forecast within %u h (zone %u substrate %d%%)",
+             PRECIPITATION_DEFERRAL_HORIZON, zone, hydraulicZones.moistureOf(zone));
+  }
+  hydrationWithheldZones = deferredZones;
+
+  // Threshold-with-hysteresis control of every zone in one pass, within the pump budget
+  hydraulicZones.regulate(thresholdAdjustment, deferredZones);
+  for (ZoneMask zones = hydraulicZones.started(); zones; zones &= zones - 1) {
+    uint8_t zone = __builtin_ctz(zones);
+    LOG_INFO(LOG_ACTUATOR, "Hydraulic circulation zone %u activated (substrate dehydration detected: %d%%)", zone,
+             hydraulicZones.moistureOf(zone));
+  }
+  for (ZoneMask zones = hydraulicZones.stopped(); zones; zones &= zones - 1) {
+    uint8_t zone = __builtin_ctz(zones);
+    LOG_INFO(LOG_ACTUATOR, "Hydraulic circulation zone %u deactivated (optimal hydration achieved: %d%%)", zone,
+             hydraulicZones.moistureOf(zone));
+  }
+  reportIrrigationQueue();
 }
 
 void implementSecondaryHydraulicRegulationAlgorithm() {
-  // Static temporal reference preservation for algorithmic state maintenance
-  static unsigned long lastHydrationCycleTimestamp = 0;
-  static bool hydrationCycleActive = false;
-  static unsigned long hydrationCycleInitiationTimestamp = 0;
-  
-  // Monotonically increasing chronological reference acquisition
-  unsigned long currentChronologicalReference = millis();
-  
-  // Conditional state transition logic for hydration cycle termination
-  if (hydrationCycleActive) {
-    if (currentChronologicalReference - hydrationCycleInitiationTimestamp >= WINTER_WATERING_DURATION) {
-      // Hydration cycle termination - duration threshold exceeded
-      digitalWrite(relayPin, LOW);
-      pumpStatus = false;
-      hydrationCycleActive = false;
-      lastHydrationCycleTimestamp = currentChronologicalReference;
-      Serial.println(F("Autonomous protocol: Hydration cycle terminated according to temporal parameters"));
+  // Algorithmic state is retained in RTC memory, so cycles survive deep sleep and resets
+  // Monotonically increasing chronological reference acquisition (continues through deep sleep)
+  unsigned long currentChronologicalReference = dutyCycle.now();
+
+  // The retained forecast still answers offline: postpone due cycles for expected rain or frost
+  ZoneMask dueZones = hydraulicZones.cyclesDue(currentChronologicalReference);
+  ZoneMask postponedZones = 0;
+  if (dueZones) {
+    bool frostRisk = controlState.lastTemperature < FROST_PROTECTION_TEMPERATURE;
+    if (frostRisk || precipitationExpected()) {
+      postponedZones = dueZones;
+      if (postponedZones & ~hydrationWithheldZones) {
+        LOG_INFO(LOG_ACTUATOR, "Autonomous protocol: Hydration cycles postponed for %u zones (%s forecast)",
+                 (unsigned)__builtin_popcount(postponedZones & ~hydrationWithheldZones), frostRisk ? "frost" : "precipitation");
+      }
     }
   }
-  // Conditional state transition logic for hydration cycle initiation
-  else if (currentChronologicalReference - lastHydrationCycleTimestamp >= WINTER_WATERING_INTERVAL) {
-    // Hydration cycle initiation - interval threshold exceeded
-    digitalWrite(relayPin, HIGH);
-    pumpStatus = true;
-    hydrationCycleActive = true;
-    hydrationCycleInitiationTimestamp = currentChronologicalReference;
-    Serial.println(F("Autonomous protocol: Hydration cycle initiated according to seasonal parameters"));
+  hydrationWithheldZones = postponedZones;
+
+  // Cycle termination and initiation for every zone in one pass, within the pump budget
+  ZoneMask cyclingZones = hydraulicZones.cyclingZones();
+  if (hydraulicZones.regulateTimed(currentChronologicalReference, postponedZones)) {
+    controlState.hydrationSchedule = hydraulicZones.schedule();
+    persistControlState();
+  }
+  for (ZoneMask zones = cyclingZones & ~hydraulicZones.cyclingZones(); zones; zones &= zones - 1) {
+    LOG_INFO(LOG_ACTUATOR, "Autonomous protocol: Zone %u hydration cycle terminated according to temporal parameters",
+             __builtin_ctz(zones));
+  }
+  for (ZoneMask zones = hydraulicZones.cyclingZones() & ~cyclingZones; zones; zones &= zones - 1) {
+    LOG_INFO(LOG_ACTUATOR, "Autonomous protocol: Zone %u hydration cycle initiated according to seasonal parameters",
+             __builtin_ctz(zones));
+  }
+  reportIrrigationQueue();
+}
+
+void reportIrrigationQueue() {
+  // Zones held back by the simultaneous pump budget - reported once when they start waiting
+  ZoneMask waitingZones = hydraulicZones.waiting();
+  if (waitingZones & ~irrigationQueueReported) {
+    LOG_INFO(LOG_ACTUATOR, "Hydraulic circulation: %u zones awaiting a pump (%u of %u running)",
+             (unsigned)__builtin_popcount(waitingZones), hydraulicZones.activeCount(), hydraulicZones.maxSimultaneous());
+  }
+  irrigationQueueReported = waitingZones;
+}
+
+void restoreControlState() {
+  if (controlStateRecord.load(controlState)) {
+    LOG_INFO(LOG_SYSTEM, "Control state restored from RTC memory");
+    // Reset interrupted failsafe hydration cycles - resume them for the remaining duration
+    hydraulicZones.restore(controlState.hydrationSchedule);
+    pumpStatus = hydraulicZones.anyWatering();
+    return;
   }
+  // Cold start: timestamps are relative to the DutyCycle clock origin, exactly like millis() was
+  controlState = HydraulicControlState();
+  controlState.lastTemperature = NAN;
+  controlState.lastPublishedMoisture = -1;
+}
+
+void persistControlState() {
+  controlStateRecord.save(controlState);
+  dutyCycle.checkpoint();
 }
 
 void regulatePhotosyntheticalSupplementationSystem() {
-  // Preserve current multiplexer state for subsequent restoration
-  int previousMultiplexerState = digitalRead(D3);
-  
-  // Configure analog acquisition pathway for photonic flux measurement
-  pinMode(photoSensorPin, INPUT);
-  delay(100);  // Photodiode response stabilization period
-  
-  // Acquire and quantify ambient photonic flux density
-  int photosyntheticallyActiveRadiation = analogRead(photoSensorPin);
-  
-  // Restore previous multiplexer configuration
-  digitalWrite(D3, previousMultiplexerState);
+  PROFILE_STAGE(executionProfiler, photonicRegulationStage);
+  if (!analogMultiplexer.ready(photonicChannel)) {
+    return;
+  }
+  // Latest conditioned photonic flux density from the multiplexed acquisition pathway (µmol/m²/s)
+  int photosyntheticallyActiveRadiation = PHOTONIC_CALIBRATION.convert(analogMultiplexer.value(photonicChannel));
   
   // Implement spectral supplementation algorithm
   // When PAR decreases below physiological threshold, activate artificial illumination
   // Using PAR threshold that accounts for metabolic requirements of C3 photosynthesis pathway
-  if (photosyntheticallyActiveRadiation < 300) {  // ~50 µmol/m²/s equivalent
-    digitalWrite(lightsPin, HIGH);
-    Serial.println(F("Photosynthetical supplementation system activated"));
+  // The array is only switched, and the transition only logged, when the demanded state changes
+  bool supplementationDemanded = photosyntheticallyActiveRadiation < PHOTONIC_SUPPLEMENTATION_THRESHOLD;
+  if (supplementationDemanded == photonicSupplementationActive) {
+    return;
+  }
+  photonicSupplementationActive = supplementationDemanded;
+  digitalWrite(lightsPin, supplementationDemanded ? HIGH : LOW);
+  LOG_INFO(LOG_ACTUATOR, "Photosynthetical supplementation system %s", supplementationDemanded ? "activated" : "deactivated");
+}
+
+void superviseDutyCycle() {
+  // First evaluation as soon as both multiplexed channels hold a conditioned reading
+  if (!wakeCycleEvaluated) {
+    if (!hydrationChannelsReady() || !analogMultiplexer.ready(photonicChannel)) {
+      return;
+    }
+    updateAtmosphericThermalParameters();
+    acquireSubstrateHydrationMetrics();
+    wakeCycleEvaluated = true;
+  }
+
+  if (networkWindowOpen) {
+    unsigned long windowAge = dutyCycle.now() - networkWindowOpenedAt;
+    bool backlogPublished = telemetryJournal.backlog() == 0 && !backlogBatchInFlight;
+    if (cloudSessionStarted && dutyCycle.now() - cloudSessionStartedAt >= CLOUD_SYNCHRONIZATION_GRACE &&
+        internetConnected && backlogPublished) {
+      // Cloud session has flushed the telemetry; complete the due acquisitions on the same association
+      if (!windowAcquisitionsIssued) {
+        unsigned long currentReference = dutyCycle.now();
+        if (!ECOPULSE_WEATHER_SHARE && weatherForecast.refreshDue()) {
+          acquireAtmosphericThermalParameters();
+        }
+        if ((long)(currentReference - controlState.nextChronologicalSyncDue) >= 0 && synchronizeChronologicalReference()) {
+          controlState.nextChronologicalSyncDue = currentReference + CHRONOLOGICAL_SYNC_INTERVAL;
+        }
+        windowAcquisitionsIssued = true;
+      }
+      // A shared acquisition is re-evaluated every pass: the elected unit may answer the request
+      // first, or stay silent until this unit's answer window lapses and it acquires itself
+      if (ECOPULSE_WEATHER_SHARE && meteorologicalConsortium.fetchDue()) {
+        acquireAtmosphericThermalParameters();
+      }
+      // The meteorological response completes on later passes; the radio stays up until it has
+      if (weatherClient.idle() && !(ECOPULSE_WEATHER_SHARE && meteorologicalConsortium.awaitingAnswer())) {
+        closeNetworkWindow();
+      }
+    } else if (windowAge >= NETWORK_WINDOW_TIMEOUT) {
+      LOG_WARN(LOG_NETWORK, "Network window expired without connectivity - continuing autonomously");
+      closeNetworkWindow();
+    }
+    return;
+  }
+
+  if (publicationDue()) {
+    openNetworkWindow();
+    return;
+  }
+
+  // GPIO outputs are not retained in deep sleep - stay awake while any actuator is energized
+  if (pumpStatus || photonicSupplementationActive) {
+    return;
+  }
+  enterDutyCycleSleep();
+}
+
+bool publicationDue() {
+  unsigned long currentReference = dutyCycle.now();
+  // Meteorological and NTP acquisitions ride along with publication windows rather than forcing their own
+  return (long)(currentReference - controlState.nextCloudPublicationDue) >= 0 ||
+         abs(hydrationLevel - controlState.lastPublishedMoisture) >= MOISTURE_PUBLICATION_DELTA ||
+         pumpStatus != controlState.lastPublishedPumpStatus;
+}
+
+void openNetworkWindow() {
+  networkWindowOpen = true;
+  networkWindowOpenedAt = dutyCycle.now();
+  windowAcquisitionsIssued = false;
+  // Association completes in the background; superviseDutyCycle() starts the cloud session once it is up
+  establishTelecommunicationsChannel();
+}
+
+void closeNetworkWindow() {
+  // Due times advance even after a failed window so an unreachable network is retried once per interval
+  unsigned long currentReference = dutyCycle.now();
+  networkWindowOpen = false;
+  controlState.nextCloudPublicationDue = currentReference + CLOUD_PUBLICATION_INTERVAL;
+  controlState.lastPublishedMoisture = hydrationLevel;
+  controlState.lastPublishedPumpStatus = pumpStatus;
+  persistControlState();
+  // The association is kept while actuators hold the board awake; deep sleep powers the radio down
+}
+
+void enterDutyCycleSleep() {
+  telemetryJournal.flush();
+  if (ECOPULSE_INPUT_TRACE) {
+    inputTrace.poll();   // Actuators released in this pass, before the loop would have seen them
+    inputTrace.flush();
+  }
+  persistControlState();
+  LOG_INFO(LOG_SYSTEM, "Entering deep sleep for %lu s after %lu ms awake",
+           DUTY_CYCLE_SLEEP_INTERVAL / 1000, dutyCycle.awakeMs());
+  logger.flush();  // The ring lives in RAM that deep sleep does not retain
+  dutyCycle.sleep(DUTY_CYCLE_SLEEP_INTERVAL);
+}
+
+void acquireAtmosphericThermalParameters() {
+  // Today and tomorrow, hour by hour - the ~35 KB response streams through the table's
+  // key scanner as it arrives and is never held in memory
+  PROFILE_STAGE(executionProfiler, forecastAcquisitionStage);
+  LOG_DEBUG(LOG_WEATHER, "Initiating meteorological forecast acquisition sequence...");
+
+  // Request proceeds in slices from loop(); hydraulic regulation keeps its cadence meanwhile
+  if (!weatherClient.stream(meteorologicalEndpoint, weatherForecast.receiver(), onAtmosphericForecast)) {
+    LOG_WARN(LOG_WEATHER, "Meteorological request queue saturated - acquisition deferred");
+  }
+}
+
+void onAtmosphericForecast(const WeatherFetchResult &result, const WeatherConditions &) {
+  // The socket and its TLS buffers are still held - the low point of the heap's cycle
+  memoryUtilizationMonitor.sample();
+  if (weatherForecast.commit(result.httpCode)) {
+    LOG_INFO(LOG_WEATHER, "Meteorological forecast retained: %u hourly entries", weatherForecast.stats().hours);
+    if (ECOPULSE_WEATHER_SHARE) {
+      meteorologicalConsortium.publish();
+    }
+    updateAtmosphericThermalParameters();
+  } else if (result.httpCode == 200) {
+    LOG_WARN(LOG_WEATHER, "Forecast response lacked hourly data - retaining previous table");
   } else {
-    digitalWrite(lightsPin, LOW);
-    Serial.println(F("Photosynthetical supplementation system deactivated"));
+    LOG_WARN(LOG_WEATHER, "HTTP transaction failure, response anomaly: %d", result.httpCode);
+  }
+}
+
+void updateAtmosphericThermalParameters() {
+  // Interpolated between the neighbouring forecast hours - no telecommunications cost
+  float forecastTemperature = weatherForecast.temperatureNow();
+  if (isnan(forecastTemperature)) {
+    return;  // Table absent or exhausted: retain the previous coefficient until a refresh succeeds
+  }
+  controlState.lastTemperature = forecastTemperature;
+  telemetryPublisher.set(thermalPublication, controlState.lastTemperature);
+  LOG_DEBUG(LOG_WEATHER, "Atmospheric thermal coefficient: %.2f°C", controlState.lastTemperature);
+}
+
+unsigned long sleepSpanningChronologicalReference() {
+  return dutyCycle.now();
+}
+
+bool precipitationExpected() {
+  return weatherForecast.rainExpectedWithin(PRECIPITATION_DEFERRAL_HORIZON, PRECIPITATION_DEFERRAL_PROBABILITY);
+}
+
+void configureTelemetryPublication() {
+  // ON_CHANGE properties would otherwise publish every one-count sensor flicker;
+  // measured values are offered here and copied into the properties when due
+  PublishPolicy hydrationPolicy;
+  hydrationPolicy.deadband = HYDRATION_PUBLICATION_DEADBAND;
+  hydrationPolicy.minIntervalMs = HYDRATION_PUBLICATION_MIN_INTERVAL;
+
+  PublishPolicy thermalPolicy;
+  thermalPolicy.deadband = THERMAL_PUBLICATION_DEADBAND;
+  thermalPolicy.minIntervalMs = THERMAL_PUBLICATION_MIN_INTERVAL;
+
+  telemetryPublisher.begin(publishTelemetryProperty, PUBLICATION_COALESCING_WINDOW);
+  hydrationPublication = telemetryPublisher.add(hydrationPolicy);
+  thermalPublication = telemetryPublisher.add(thermalPolicy);
+}
+
+void configureExecutionProfiling() {
+  // Stage names are kept short - they make up most of the loopProfile summary text
+  executionProfiler.begin();
+  loopPassStage = executionProfiler.addStage("loop");
+  associationStage = executionProfiler.addStage("wifi");
+  cloudSynchronizationStage = executionProfiler.addStage("cloud");
+  analogAcquisitionStage = executionProfiler.addStage("analog");
+  meteorologicalExchangeStage = executionProfiler.addStage("weather");
+  integrityVerificationStage = executionProfiler.addStage("integrity");
+  hydrationAcquisitionStage = executionProfiler.addStage("hydration");
+  hydraulicRegulationStage = executionProfiler.addStage("hydraulic");
+  photonicRegulationStage = executionProfiler.addStage("photonic");
+  forecastAcquisitionStage = executionProfiler.addStage("forecast");
+  diagnosticOutputStage = executionProfiler.addStage("diag");
+  statusEndpointStage = ECOPULSE_HTTP_ENDPOINT ? executionProfiler.addStage("http") : -1;
+
+  diagnosticConsole.begin(Serial);
+  diagnosticConsole.add("profile", onProfileCommand, "loop stage latencies; 'profile reset' clears them");
+}
+
+void configureLoopWatchdog() {
+  // Overruns are stamped on the sleep-spanning clock and retained in RTC memory across resets
+  loopWatchdog.begin(DEADLINE_INSPECTION_INTERVAL, sleepSpanningChronologicalReference);
+  associationOperation = loopWatchdog.addOperation("wifi", ASSOCIATION_BUDGET);
+  cloudSynchronizationOperation = loopWatchdog.addOperation("cloud", CLOUD_SYNCHRONIZATION_BUDGET);
+  meteorologicalExchangeOperation = loopWatchdog.addOperation("weather", METEOROLOGICAL_EXCHANGE_BUDGET);
+  integrityVerificationOperation = loopWatchdog.addOperation("integrity", INTEGRITY_VERIFICATION_BUDGET);
+  hydrationAcquisitionOperation = loopWatchdog.addOperation("hydration", HYDRATION_ACQUISITION_BUDGET);
+  chronologicalSyncOperation = loopWatchdog.addOperation("ntp", CHRONOLOGICAL_SYNC_BUDGET);
+  journalReplayOperation = loopWatchdog.addOperation("journal", JOURNAL_REPLAY_BUDGET);
+  statusEndpointOperation = ECOPULSE_HTTP_ENDPOINT ? loopWatchdog.addOperation("http", STATUS_ENDPOINT_BUDGET) : -1;
+
+  // Hydraulic circulation must never outlive a starved control tick
+  for (uint8_t zone = 0; zone < IRRIGATION_ZONE_COUNT; zone++) {
+    loopWatchdog.addSafeOutput(HYDRAULIC_RELAY_PINS[zone], LOW);
+  }
+  loopWatchdog.setControlDeadline(HYDRAULIC_CONTROL_DEADLINE);
+
+  WatchdogOverrun interrupted;
+  if (loopWatchdog.interruptedByReset(interrupted)) {
+    LOG_WARN(LOG_SYSTEM, "Previous reset occurred %u ms into '%s' (budget exceeded)", interrupted.elapsedMs,
+             loopWatchdog.operationName(interrupted.operation));
+  }
+  diagnosticConsole.add("watchdog", onWatchdogCommand, "retained loop overruns; 'watchdog clear' forgets them");
+}
+
+void onWatchdogCommand(const char *arguments) {
+  if (!strcmp(arguments, "clear")) {
+    loopWatchdog.clear();
+    LOG_INFO(LOG_SYSTEM, "Loop overrun history cleared");
+    return;
+  }
+  loopWatchdog.report();
+}
+
+void composeMeteorologicalEndpoint() {
+  // Composed once; each refresh reuses the same bytes instead of concatenating Strings on the heap
+  int length = snprintf(meteorologicalEndpoint, sizeof(meteorologicalEndpoint),
+                        "/v1/forecast.json?key=%s&q=%s&days=2&aqi=no&alerts=no", apiKey, location);
+  if (length < 0 || length >= (int)sizeof(meteorologicalEndpoint)) {
+    LOG_WARN(LOG_WEATHER, "Meteorological endpoint exceeds %u bytes - check apiKey and location",
+             (unsigned)sizeof(meteorologicalEndpoint));
+  }
+}
+
+void configureMemoryTelemetry() {
+  // Steady-state operation allocates nothing, so free heap should hold flat across days;
+  // a falling trend or a shrinking largest block points at a leak or fragmentation
+  memoryUtilizationMonitor.begin(HEAP_SAMPLING_INTERVAL, CONTIGUOUS_HEAP_WARNING);
+  diagnosticConsole.add("heap", onHeapCommand, "free heap, largest block, fragmentation and trend");
+  diagnosticConsole.add("history", onHistoryCommand, "24 h summary and hourly trend; 'history minute|quarter|hour|raw'");
+}
+
+void onHeapCommand(const char *) {
+  memoryUtilizationMonitor.sample();
+  memoryUtilizationMonitor.report();
+}
+
+void retainEnvironmentalHistory() {
+  // Readings enter the history once every multiplexed channel has been conditioned
+  if (!hydrationChannelsReady() || !analogMultiplexer.ready(photonicChannel)) {
+    return;
   }
+  environmentalHistory.append(captureTelemetrySample());
 }
 
-void getWeatherTemperature() {
-  WiFiClient client;
-  HTTPClient http;
-  String url = "http://api.weatherapi.com/v1/current.json?key=" + apiKey + "&q=" + location + "&aqi=no";
+void reportHistoricalInterval(const char *label, const HistoryRollup &interval) {
+  if (!interval.samples) {
+    LOG_INFO(LOG_SENSOR, "  %s: no readings", label);
+    return;
+  }
+  char thermal[32] = "n/a";
+  if (interval.temperatureMean != TELEMETRY_TEMPERATURE_UNKNOWN) {
+    snprintf(thermal, sizeof(thermal), "%.1f-%.1f C (avg %.1f)", interval.temperatureMin / 10.0f,
+             interval.temperatureMax / 10.0f, interval.temperatureMean / 10.0f);
+  }
+  LOG_INFO(LOG_SENSOR, "  %s: substrate %u-%u%% (avg %u), %s, photonic %u-%u (avg %u), pump %u%%", label,
+           interval.moistureMin, interval.moistureMax, interval.moistureMean, thermal, interval.lightMin,
+           interval.lightMax, interval.lightMean, (unsigned)(interval.pumpSamples * 100 / interval.samples));
+}
+
+void onHistoryCommand(const char *arguments) {
+  const TelemetryHistoryStats &historyStats = environmentalHistory.stats();
+  const uint32_t currentReference = dutyCycle.now() / 1000;
+  if (!strcmp(arguments, "raw")) {
+    // The last 20 retained readings, decoded from the compressed blocks (the log ring holds ~40 lines)
+    environmentalHistory.forEachSample(currentReference - 20, currentReference + 1, [&](const TelemetrySample &sample) {
+      LOG_INFO(LOG_SENSOR, "  t-%lus: substrate %u%%, %d dC, photonic %u, flags 0x%02x",
+               (unsigned long)(currentReference - sample.timestamp), sample.moisture, sample.temperatureDeci,
+               sample.light, sample.flags);
+    });
+    return;
+  }
+  LOG_INFO(LOG_SENSOR, "History: %u readings, raw tier %lu s in %u B (%.1f bits/reading), %u blocks dropped",
+           historyStats.appended, (unsigned long)(historyStats.newestRaw - historyStats.oldestRaw),
+           (unsigned)((historyStats.retainedBits + 7) / 8), historyStats.bitsPerSample(), historyStats.blocksDropped);
+
+  HistoryResolution resolution = HISTORY_HOUR;
+  if (!strcmp(arguments, "minute")) {
+    resolution = HISTORY_MINUTE;
+  } else if (!strcmp(arguments, "quarter")) {
+    resolution = HISTORY_QUARTER;
+  } else if (!*arguments) {
+    HistoryRollup day;
+    if (environmentalHistory.summarize(HISTORY_QUARTER, currentReference - 86400, currentReference + 1, day)) {
+      reportHistoricalInterval("last 24 h", day);
+    }
+  }
+  // Most recent intervals, the one still filling last
+  const uint32_t period = historyPeriodSeconds(resolution);
+  const uint32_t newest = environmentalHistory.newestRollup(resolution);
+  const uint32_t earliest = newest - (HISTORY_REPORT_INTERVALS - 1) * period;
+  environmentalHistory.forEachRollup(resolution, earliest, newest + 1, [&](uint32_t start, const HistoryRollup &interval) {
+    char label[16];
+    snprintf(label, sizeof(label), "t-%lum", (unsigned long)((currentReference - start) / 60));
+    reportHistoricalInterval(label, interval);
+  });
+}
+
+void configureStatusEndpoint() {
+  // Every body is written straight from the live structures, a chunk at a time - no response is ever held whole
+  statusEndpoint.on("/", "text/plain", writeEndpointIndex);
+  statusEndpoint.on("/state.json", "application/json", writeOperationalState);
+  statusEndpoint.on("/metrics.json", "application/json", writeExecutionMetrics);
+  statusEndpoint.on("/history.csv", "text/csv", writeHistoryCsv);
+  statusEndpoint.on("/history.json", "application/json", writeHistoryJson);
+  if (ECOPULSE_INPUT_TRACE) {
+    statusEndpoint.on("/trace.bin", "application/octet-stream", writeInputTrace);
+  }
+  statusEndpoint.begin();
+  LOG_INFO(LOG_NETWORK, "Status endpoint listening on port %u", STATUS_ENDPOINT_PORT);
+}
+
+bool writeEndpointIndex(HttpBody &body) {
+  body.print("EcoPulse status endpoint\n"
+             "  /state.json     readings, actuators and zones\n"
+             "  /metrics.json   loop stage latencies, watchdog, heap, logger, history and endpoint counters\n"
+             "  /history.csv    ?res=raw|minute|quarter|hour&from=-3600&to=0 (seconds: negative = before now)\n"
+             "  /history.json   same parameters\n");
+  if (ECOPULSE_INPUT_TRACE) {
+    body.print("  /trace.bin      input trace, oldest segment first, for sim-main --replay\n");
+  }
+  return false;
+}
+
+// Field printers shared by the state and history bodies; a reading the unit never took is null
+void formatThermalField(char *buffer, size_t size, int16_t temperatureDeci, bool json) {
+  if (temperatureDeci == TELEMETRY_TEMPERATURE_UNKNOWN) {
+    snprintf(buffer, size, "%s", json ? "null" : "");
+    return;
+  }
+  snprintf(buffer, size, "%.1f", temperatureDeci / 10.0f);
+}
+
+bool writeOperationalState(HttpBody &body) {
+  for (;; body.phase++) {
+    switch (body.phase) {
+      case 0: {
+        const TelemetrySample current = captureTelemetrySample();
+        char thermal[12];
+        formatThermalField(thermal, sizeof(thermal), current.temperatureDeci, true);
+        if (!body.printf("{\"time\":%lu,\"uptime_s\":%lu,\"moisture\":%d,\"temperature\":%s,\"light\":%u,"
+                         "\"pump\":%s,\"lights\":%s,\"failsafe\":%s,\"internet\":%s,\"zones\":[",
+                         (unsigned long)current.timestamp, millis() / 1000, hydrationLevel, thermal, current.light,
+                         pumpStatus ? "true" : "false", photonicSupplementationActive ? "true" : "false",
+                         current.flags & TELEMETRY_FLAG_FAILSAFE ? "true" : "false", internetConnected ? "true" : "false")) {
+          return true;
+        }
+        break;
+      }
+      case 1:
+        for (; body.cursor < IRRIGATION_ZONE_COUNT; body.cursor++) {
+          const uint8_t zone = body.cursor;
+          const ZoneMask bit = (ZoneMask)1 << zone;
+          if (!body.printf("%s{\"zone\":%u,\"moisture\":%d,\"threshold\":%d,\"watering\":%s,\"waiting\":%s}",
+                           zone ? "," : "", zone, hydraulicZones.moistureOf(zone), HYDRATION_THRESHOLDS[zone],
+                           hydraulicZones.wateringZones() & bit ? "true" : "false",
+                           hydraulicZones.waiting() & bit ? "true" : "false")) {
+            return true;
+          }
+        }
+        break;
+      case 2: {
+        uint32_t freeHeap = 0;
+        uint32_t largestBlock = 0;
+        uint8_t fragmentation = 0;
+        ESP.getHeapStats(&freeHeap, &largestBlock, &fragmentation);
+        if (!body.printf("],\"heap\":{\"free\":%lu,\"largest_block\":%lu,\"fragmentation\":%u}}\n",
+                         (unsigned long)freeHeap, (unsigned long)largestBlock, fragmentation)) {
+          return true;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+}
+
+bool writeExecutionMetrics(HttpBody &body) {
+  for (;; body.phase++) {
+    switch (body.phase) {
+      case 0:
+        if (!body.printf("{\"uptime_s\":%lu,\"stages\":[", millis() / 1000)) return true;
+        break;
+      case 1:
+        // One stage per row; a summary reads the histogram, it does not copy it
+        for (StageSummary stage; body.cursor < executionProfiler.stageCount(); body.cursor++) {
+          executionProfiler.summary(body.cursor, stage);
+          if (!body.printf("%s{\"name\":\"%s\",\"calls\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"max_us\":%lu,\"total_ms\":%lu}",
+                           body.cursor ? "," : "", stage.name, (unsigned long)stage.calls, (unsigned long)stage.p50Us,
+                           (unsigned long)stage.p99Us, (unsigned long)stage.maxUs, (unsigned long)stage.totalMs)) {
+            return true;
+          }
+        }
+        break;
+      case 2: {
+        const WatchdogStats &watchdogStats = loopWatchdog.stats();
+        if (!body.printf("],\"watchdog\":{\"overruns\":%lu,\"control_misses\":%lu,\"worst_overrun_ms\":%lu,"
+                         "\"worst_operation\":\"%s\",\"retained_overruns\":%lu}",
+                         (unsigned long)watchdogStats.overruns, (unsigned long)watchdogStats.controlMisses,
+                         (unsigned long)watchdogStats.worstOverrunMs, loopWatchdog.operationName(watchdogStats.worstOperation),
+                         (unsigned long)watchdogStats.retainedOverruns)) {
+          return true;
+        }
+        break;
+      }
+      case 3: {
+        const MemoryStats &memoryStats = memoryUtilizationMonitor.stats();
+        const LoggerStats &loggerStats = logger.stats();
+        if (!body.printf(",\"heap\":{\"lowest_free\":%u,\"lowest_largest_block\":%u,\"highest_fragmentation\":%u,"
+                         "\"free_trend_per_hour\":%ld},\"logger\":{\"lines\":%lu,\"bytes\":%lu,\"suppressed\":%lu,"
+                         "\"overflowed\":%lu,\"peak_backlog\":%u}",
+                         memoryStats.lowestFreeHeap, memoryStats.lowestLargestBlock, memoryStats.highestFragmentation,
+                         (long)memoryUtilizationMonitor.freeHeapTrendPerHour(), (unsigned long)loggerStats.lines,
+                         (unsigned long)loggerStats.bytes, (unsigned long)loggerStats.repeatsSuppressed,
+                         (unsigned long)loggerStats.overflowed, loggerStats.peakBacklog)) {
+          return true;
+        }
+        break;
+      }
+      case 4: {
+        const TelemetryHistoryStats &historyStats = environmentalHistory.stats();
+        const HttpEndpointStats &endpointStats = statusEndpoint.stats();
+        if (!body.printf(",\"history\":{\"readings\":%lu,\"raw_seconds\":%lu,\"raw_bytes\":%lu,\"bits_per_reading\":%.2f,"
+                         "\"blocks_dropped\":%lu},\"http\":{\"requests\":%lu,\"rejected\":%lu,\"aborted\":%lu,\"bytes\":%lu}",
+                         (unsigned long)historyStats.appended, (unsigned long)(historyStats.newestRaw - historyStats.oldestRaw),
+                         (unsigned long)((historyStats.retainedBits + 7) / 8), historyStats.bitsPerSample(),
+                         (unsigned long)historyStats.blocksDropped, (unsigned long)endpointStats.requests,
+                         (unsigned long)endpointStats.rejected, (unsigned long)endpointStats.aborted,
+                         (unsigned long)endpointStats.bytesSent)) {
+          return true;
+        }
+        break;
+      }
+      case 5: {
+        const InputTraceStats &traceStats = inputTrace.stats();
+        if (ECOPULSE_INPUT_TRACE &&
+            !body.printf(",\"trace\":{\"events\":%lu,\"bytes\":%lu,\"flash_writes\":%lu,\"segments\":%lu,"
+                         "\"segments_dropped\":%lu,\"write_failures\":%lu}",
+                         (unsigned long)traceStats.events, (unsigned long)traceStats.bytes,
+                         (unsigned long)traceStats.flashWrites,
+                         (unsigned long)(inputTrace.newest() ? inputTrace.newest() - inputTrace.oldest() + 1 : 0),
+                         (unsigned long)traceStats.segmentsDropped, (unsigned long)traceStats.writeFailures)) {
+          return true;
+        }
+        break;
+      }
+      case 6:
+        if (!body.print("}\n")) {
+          return true;
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+}
+
+void configureInputTrace() {
+  // Conversions are traced where the multiplexer keeps them, link status where the association
+  // manager reads it, exchanges where the service channel completes them; outputs by level
+  InputTraceConfig traceConfig;
+  traceConfig.segments = INPUT_TRACE_SEGMENTS;
+  if (!inputTrace.begin(traceConfig)) {
+    LOG_WARN(LOG_STORAGE, "Input trace unavailable - flash filesystem not mounted");
+    return;
+  }
+  analogMultiplexer.traceInputs(inputTrace);
+  wifiLink.traceInputs(inputTrace);
+  weatherService.traceInputs(inputTrace);
+  for (uint8_t zone = 0; zone < IRRIGATION_ZONE_COUNT; zone++) {
+    inputTrace.watchOutput(HYDRAULIC_RELAY_PINS[zone]);
+  }
+  inputTrace.watchOutput(lightsPin);
+  LOG_INFO(LOG_STORAGE, "Input trace recording, segments %lu-%lu retained", (unsigned long)inputTrace.oldest(),
+           (unsigned long)inputTrace.newest());
+}
+
+bool writeInputTrace(HttpBody &body) {
+  if (body.phase == 0) {
+    inputTrace.flush();  // Events still in RAM go out with the rest
+    traceDownloadSegment = inputTrace.oldest();
+    body.phase = 1;
+  }
+  // Segment files back to back, the offset within the current one in body.cursor
+  uint8_t block[256];
+  while (traceDownloadSegment && traceDownloadSegment <= inputTrace.newest()) {
+    const size_t length = inputTrace.readSegment(traceDownloadSegment, body.cursor, block,
+                                                 min(sizeof(block), body.available()));
+    if (!length) {
+      traceDownloadSegment++;  // Complete, or rotated away meanwhile
+      body.cursor = 0;
+      continue;
+    }
+    body.write(block, length);
+    body.cursor += length;
+    if (!body.available()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// History body phases: the first row is written without a separator, later rows with one
+enum HistoryBodyPhase : uint8_t { HISTORY_HEADER, HISTORY_FIRST_ROW, HISTORY_ROWS, HISTORY_FOOTER, HISTORY_COMPLETE };
 
-  Serial.println(F("Requesting weather data..."));
+bool printHistoricalReading(HttpBody &body, const TelemetrySample &sample, bool json) {
+  char thermal[12];
+  formatThermalField(thermal, sizeof(thermal), sample.temperatureDeci, json);
+  if (json) {
+    return body.printf("%s\n{\"time\":%lu,\"moisture\":%u,\"temperature\":%s,\"light\":%u,\"flags\":%u}",
+                       body.phase == HISTORY_FIRST_ROW ? "" : ",", (unsigned long)sample.timestamp, sample.moisture,
+                       thermal, sample.light, sample.flags);
+  }
+  return body.printf("%lu,%u,%s,%u,%u,%u,%u\n", (unsigned long)sample.timestamp, sample.moisture, thermal, sample.light,
+                     sample.flags & TELEMETRY_FLAG_PUMP ? 1 : 0, sample.flags & TELEMETRY_FLAG_LIGHTS ? 1 : 0,
+                     sample.flags & TELEMETRY_FLAG_FAILSAFE ? 1 : 0);
+}
 
-  http.begin(client, url);
-  int httpCode = http.GET();
+bool printHistoricalInterval(HttpBody &body, uint32_t start, const HistoryRollup &interval, bool json) {
+  const char *separator = json && body.phase != HISTORY_FIRST_ROW ? "," : "";
+  if (!interval.samples) {
+    return json ? body.printf("%s\n{\"start\":%lu,\"samples\":0}", separator, (unsigned long)start)
+                : body.printf("%lu,0,,,,,,,,,,\n", (unsigned long)start);
+  }
+  char thermal[3][12];
+  formatThermalField(thermal[0], sizeof(thermal[0]), interval.temperatureMin, json);
+  formatThermalField(thermal[1], sizeof(thermal[1]), interval.temperatureMean, json);
+  formatThermalField(thermal[2], sizeof(thermal[2]), interval.temperatureMax, json);
+  const unsigned pumpPercent = (unsigned)(interval.pumpSamples * 100 / interval.samples);
+  if (json) {
+    char thermalRange[40] = "null";
+    if (interval.temperatureMean != TELEMETRY_TEMPERATURE_UNKNOWN) {
+      snprintf(thermalRange, sizeof(thermalRange), "[%s,%s,%s]", thermal[0], thermal[1], thermal[2]);
+    }
+    return body.printf("%s\n{\"start\":%lu,\"samples\":%lu,\"moisture\":[%u,%u,%u],\"temperature\":%s,"
+                       "\"light\":[%u,%u,%u],\"pump_pct\":%u}",
+                       separator, (unsigned long)start, (unsigned long)interval.samples, interval.moistureMin,
+                       interval.moistureMean, interval.moistureMax, thermalRange, interval.lightMin, interval.lightMean,
+                       interval.lightMax, pumpPercent);
+  }
+  return body.printf("%lu,%lu,%u,%u,%u,%s,%s,%s,%u,%u,%u,%u\n", (unsigned long)start, (unsigned long)interval.samples,
+                     interval.moistureMin, interval.moistureMean, interval.moistureMax, thermal[0], thermal[1], thermal[2],
+                     interval.lightMin, interval.lightMean, interval.lightMax, pumpPercent);
+}
 
-  if (httpCode == 200) {
-    String payload = http.getString();
-    
-    StaticJsonDocument<1024> doc;
-    DeserializationError error = deserializeJson(doc, payload);
+// Streams one resolution of environmentalHistory between `from` and `to`. body.cursor is the
+// timestamp to resume at; the range is re-read on every chunk, so the end follows the present
+bool writeEnvironmentalHistory(HttpBody &body, bool json) {
+  const uint32_t currentReference = dutyCycle.now() / 1000;
+  char requested[8] = "minute";
+  body.parameter("res", requested, sizeof(requested));
+  const bool raw = !strcmp(requested, "raw");
+  const HistoryResolution resolution = !strcmp(requested, "hour")      ? HISTORY_HOUR
+                                       : !strcmp(requested, "quarter") ? HISTORY_QUARTER
+                                                                       : HISTORY_MINUTE;
+  // Non-positive times count back from now; to is inclusive
+  const long fromParameter = body.parameter("from", -HISTORY_DEFAULT_SPAN);
+  const long toParameter = body.parameter("to", 0L);
+  const uint32_t from = fromParameter <= 0 ? currentReference - min((uint32_t)-fromParameter, currentReference) : fromParameter;
+  const uint32_t to = (toParameter <= 0 ? currentReference - min((uint32_t)-toParameter, currentReference) : toParameter) + 1;
 
-    if (!error) {
-      temperature = doc["current"]["temp_c"];
-      Serial.print(F("Current temperature: "));
-      Serial.print(temperature);
-      Serial.println(F("°C"));
-      
-      // Adjust watering based on temperature in winter
-      if (temperature < 15) {
-        // Extend watering interval in colder weather
-        // This is handled by the constants, but we could make them dynamic here
+  for (;; body.phase++) {
+    switch (body.phase) {
+      case HISTORY_HEADER: {
+        const char *name = raw ? "raw" : resolution == HISTORY_HOUR ? "hour" : resolution == HISTORY_QUARTER ? "quarter" : "minute";
+        bool written = json ? body.printf("{\"resolution\":\"%s\",\"now\":%lu,\"from\":%lu,\"to\":%lu,\"rows\":[", name,
+                                          (unsigned long)currentReference, (unsigned long)from, (unsigned long)(to - 1))
+                            : raw ? body.print("time,moisture,temperature,light,pump,lights,failsafe\n")
+                                  : body.print("start,samples,moisture_min,moisture_mean,moisture_max,temperature_min,"
+                                               "temperature_mean,temperature_max,light_min,light_mean,light_max,pump_pct\n");
+        if (!written) return true;
+        body.cursor = from;
+        break;
       }
-    } else {
-      Serial.print(F("JSON parse error: "));
-      Serial.println(error.c_str());
+      case HISTORY_FIRST_ROW:
+      case HISTORY_ROWS:
+        if (raw) {
+          // Readings sharing a second never straddle a chunk: the cursor has one-second resolution
+          size_t secondStart = body.length();
+          uint32_t second = body.cursor;
+          uint8_t secondPhase = body.phase;
+          bool complete = environmentalHistory.forEachSampleWhile(body.cursor, to, [&](const TelemetrySample &sample) {
+            if (sample.timestamp != second) {
+              secondStart = body.length();
+              second = sample.timestamp;
+              secondPhase = body.phase;
+            }
+            if (!printHistoricalReading(body, sample, json)) {
+              body.truncate(secondStart);
+              body.cursor = second;
+              body.phase = secondPhase;
+              return false;
+            }
+            body.phase = HISTORY_ROWS;
+            return true;
+          });
+          if (!complete) return true;
+        } else {
+          bool full = false;
+          environmentalHistory.forEachRollup(resolution, body.cursor, to, [&](uint32_t start, const HistoryRollup &interval) {
+            if (full) return;
+            if (!printHistoricalInterval(body, start, interval, json)) {
+              full = true;
+              body.cursor = start;
+              return;
+            }
+            body.phase = HISTORY_ROWS;
+          });
+          if (full) return true;
+        }
+        body.phase = HISTORY_ROWS;
+        break;
+      case HISTORY_FOOTER:
+        if (json && !body.print("\n]}\n")) return true;
+        break;
+      default:
+        return false;
+    }
+  }
+}
+
+bool writeHistoryCsv(HttpBody &body) { return writeEnvironmentalHistory(body, false); }
+bool writeHistoryJson(HttpBody &body) { return writeEnvironmentalHistory(body, true); }
+
+void configureIrrigationZones() {
+  // One relay, permittivity channel, threshold and failsafe cycle per zone, in table order
+  hydraulicZones.begin(MAX_SIMULTANEOUS_PUMPS);
+  for (uint8_t zone = 0; zone < IRRIGATION_ZONE_COUNT; zone++) {
+    IrrigationZoneConfig zoneConfig;
+    zoneConfig.relayPin = HYDRAULIC_RELAY_PINS[zone];
+    zoneConfig.sensorChannel = analogMultiplexer.addChannel(HYDRATION_MUX_ADDRESSES[zone], HYDRATION_SAMPLING_PERIOD);
+    zoneConfig.thresholdPct = HYDRATION_THRESHOLDS[zone];
+    zoneConfig.hysteresisPct = HYDRATION_HYSTERESIS[zone];
+    zoneConfig.timedDurationMs = WINTER_WATERING_DURATION;
+    zoneConfig.timedIntervalMs = WINTER_WATERING_INTERVAL;
+    hydraulicZones.addZone(zoneConfig);
+  }
+  restoreHydrationCalibration();
+  diagnosticConsole.add("zones", onZonesCommand, "per-zone hydration, thresholds and pump state");
+  diagnosticConsole.add("calibrate", onCalibrateCommand, "'calibrate <zone> dry|wet|factory' sets a hydration reference");
+}
+
+void restoreHydrationCalibration() {
+  for (uint8_t zone = 0; zone < IRRIGATION_ZONE_COUNT; zone++) {
+    hydrationReferences.dryReference[zone] = HYDRATION_DRY_REFERENCE;
+    hydrationReferences.wetReference[zone] = HYDRATION_WET_REFERENCE;
+    hydrationCalibration[zone] = FACTORY_HYDRATION_CALIBRATION;
+  }
+  if (!LittleFS.begin()) {
+    return;
+  }
+  File file = LittleFS.open(CALIBRATION_PATH, "r");
+  if (!file) {
+    return;  // Factory calibration
+  }
+  uint32_t storedCrc;
+  HydrationCalibrationRecord stored;
+  bool valid = file.read((uint8_t *)&storedCrc, sizeof(storedCrc)) == sizeof(storedCrc) &&
+               file.read((uint8_t *)&stored, sizeof(stored)) == sizeof(stored) && storedCrc == crc32(&stored, sizeof(stored));
+  file.close();
+  if (!valid) {
+    LOG_WARN(LOG_STORAGE, "Hydration calibration in %s is invalid - factory references in use", CALIBRATION_PATH);
+    return;
+  }
+  hydrationReferences = stored;
+  for (uint8_t zone = 0; zone < IRRIGATION_ZONE_COUNT; zone++) {
+    hydrationCalibration[zone] =
+        CalibrationTable<>::twoPoint(hydrationReferences.dryReference[zone], hydrationReferences.wetReference[zone], 0, 100);
+  }
+  LOG_INFO(LOG_SENSOR, "Hydration calibration restored from %s", CALIBRATION_PATH);
+}
+
+void onCalibrateCommand(const char *arguments) {
+  char *reference;
+  long zone = strtol(arguments, &reference, 10);
+  while (*reference == ' ') reference++;
+  if (reference == arguments || zone < 0 || zone >= IRRIGATION_ZONE_COUNT || !*reference) {
+    for (uint8_t listed = 0; listed < IRRIGATION_ZONE_COUNT; listed++) {
+      LOG_INFO(LOG_SENSOR, "Hydration calibration zone %u: dry %u counts, wet %u counts", listed,
+               hydrationReferences.dryReference[listed].raw, hydrationReferences.wetReference[listed].raw);
     }
+    return;
+  }
+
+  // Two-point recalibration: the zone's current conditioned reading becomes the dry (0%) or wet (100%) reference
+  CalibrationPoint dryReference = hydrationReferences.dryReference[zone];
+  CalibrationPoint wetReference = hydrationReferences.wetReference[zone];
+  int8_t channel = hydraulicZones.sensorChannel(zone);
+  if (!strcmp(reference, "factory")) {
+    dryReference = HYDRATION_DRY_REFERENCE;
+    wetReference = HYDRATION_WET_REFERENCE;
+  } else if (analogMultiplexer.ready(channel) && (!strcmp(reference, "dry") || !strcmp(reference, "wet"))) {
+    CalibrationPoint &captured = reference[0] == 'd' ? dryReference : wetReference;
+    captured.raw = analogMultiplexer.value(channel);
   } else {
-    Serial.print(F("HTTP error: "));
-    Serial.println(httpCode);
+    LOG_WARN(LOG_SENSOR, "Hydration calibration: expected 'dry', 'wet' or 'factory' with a zone reading available");
+    return;
+  }
+  if (abs((int)dryReference.raw - (int)wetReference.raw) < CALIBRATION_MINIMUM_SPAN) {
+    LOG_WARN(LOG_SENSOR, "Hydration calibration zone %ld rejected: dry %u and wet %u counts are under %u apart", zone,
+             dryReference.raw, wetReference.raw, CALIBRATION_MINIMUM_SPAN);
+    return;
+  }
+
+  hydrationReferences.dryReference[zone] = dryReference;
+  hydrationReferences.wetReference[zone] = wetReference;
+  hydrationCalibration[zone] = CalibrationTable<>::twoPoint(dryReference, wetReference, 0, 100);
+  if (LittleFS.begin()) {
+    File file = LittleFS.open(CALIBRATION_PATH, "w");
+    if (file) {
+      uint32_t storedCrc = crc32(&hydrationReferences, sizeof(hydrationReferences));
+      file.write((const uint8_t *)&storedCrc, sizeof(storedCrc));
+      file.write((const uint8_t *)&hydrationReferences, sizeof(hydrationReferences));
+      file.close();
+    }
   }
+  LOG_INFO(LOG_SENSOR, "Hydration calibration zone %ld: dry %u counts, wet %u counts", zone, dryReference.raw,
+           wetReference.raw);
+}
+
+void onZonesCommand(const char *) {
+  const IrrigationStats &irrigationStats = hydraulicZones.stats();
+  LOG_INFO(LOG_ACTUATOR, "Irrigation zones: %u of %u pumps running, %u starts (%u failsafe cycles), %u pump waits",
+           hydraulicZones.activeCount(), hydraulicZones.maxSimultaneous(), irrigationStats.starts,
+           irrigationStats.timedCycles, irrigationStats.capacityWaits);
+  for (uint8_t zone = 0; zone < hydraulicZones.zoneCount(); zone++) {
+    ZoneMask zoneBit = (ZoneMask)1 << zone;
+    LOG_INFO(LOG_ACTUATOR, "  zone %u: substrate %d%%, threshold %d%%, %s%s%s", zone, hydraulicZones.moistureOf(zone),
+             HYDRATION_THRESHOLDS[zone], hydraulicZones.wateringZones() & zoneBit ? "irrigating" : "idle",
+             hydraulicZones.cyclingZones() & zoneBit ? ", failsafe cycle" : "",
+             hydraulicZones.waiting() & zoneBit ? ", awaiting a pump" : "");
+  }
+}
+
+void onProfileCommand(const char *arguments) {
+  if (!strcmp(arguments, "reset")) {
+    executionProfiler.reset();
+    LOG_INFO(LOG_SYSTEM, "Loop profile cleared");
+    return;
+  }
+  executionProfiler.report();
+}
 
-  http.end();
+void publishExecutionProfile() {
+  // Stages nest (hydration contains hydraulic and photonic; loop contains everything)
+  char summary[PROFILE_SUMMARY_CAPACITY];
+  executionProfiler.format(summary, sizeof(summary));
+  loopProfile = summary;
+}
+
+void publishTelemetryProperty(uint8_t property, float value) {
+  // Heartbeats are unnecessary here - the cloud retains the last value of ON_CHANGE properties
+  if (property == hydrationPublication) {
+    soil_Moisture = (int)value;
+  } else if (property == thermalPublication) {
+    temperature = value;
+  }
 }
 
 // Event-driven callback handlers for asynchronous telemetry events
@@ -405,10 +1720,10 @@ void onSoilMoistureChange() {
 
 void onPumpStatusChange() {
   // Remote hydraulic actuation state change event processor
-  // Implement remote override capability with physical actuation
-  digitalWrite(relayPin, pumpStatus ? HIGH : LOW);
-  Serial.println(pumpStatus ? F("Hydraulic circulation system activated (remote command)") : 
-                            F("Hydraulic circulation system deactivated (remote command)"));
+  // Implement remote override capability with physical actuation - every zone the pump budget admits
+  hydraulicZones.command(pumpStatus);
+  pumpStatus = hydraulicZones.anyWatering();
+  LOG_INFO(LOG_ACTUATOR, "Hydraulic circulation system %s (remote command)", pumpStatus ? "activated" : "deactivated");
 }
 
 void onTemperatureChange() {
@@ -418,6 +1733,5 @@ void onTemperatureChange() {
 
 void onInternetConnectedChange() {
   // Telecommunications link state transition event processor
-  Serial.print(F("Telecommunications link status transition: "));
-  Serial.println(internetConnected ? F("Established") : F("Interrupted"));
+  LOG_INFO(LOG_CLOUD, "Telecommunications link status transition: %s", internetConnected ? "Established" : "Interrupted");
 }
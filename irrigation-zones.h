@@ -0,0 +1,267 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// Multi-Zone Irrigation Engine
+// ─────────────────────────────────────
+// Drives N independently sensed beds from one control tick. Each zone has
+// a relay line, a sensor channel, a start threshold with hysteresis and a
+// timed-cycle schedule for when the sensors cannot be trusted:
+//
+//   zones.begin(2);                           // at most two pumps at once
+//   zones.addZone(config);                    // once per bed
+//   zones.setMoisture(zone, percent);         // from the sensor tick
+//   zones.regulate(thresholdOffset);          // or regulateTimed(now) offline
+//
+// Zone state is kept as parallel arrays indexed by zone (structure of
+// arrays), with the on/off, cycling and withheld sets as bit masks, so a
+// tick is one pass over a few short arrays at constant cost per zone and
+// no per-zone objects or allocations.
+//
+// A zone starts below its threshold and stops at threshold + hysteresis.
+// Zones that want water while the pump limit is reached wait, and are
+// admitted round-robin as pumps free up, so a permanently dry bed cannot
+// starve the others. Relays are written only on transitions.
+//
+// The timed schedule (cycle start and completion per zone) is trivially
+// copyable, to be embedded in a sketch's RTC control state and handed back
+// with restore() after a reset.
+
+typedef uint32_t ZoneMask;   // Bit n = zone n
+
+struct IrrigationZoneConfig {
+  uint8_t relayPin = 0;
+  int8_t sensorChannel = -1;            // Caller's handle for the zone's sensor (e.g. an AnalogMux channel)
+  int8_t thresholdPct = 20;             // Start watering below this moisture
+  int8_t hysteresisPct = 0;             // ...and stop at threshold + hysteresis
+  unsigned long timedDurationMs = 0;    // Timed-mode cycle length; 0 = no timed cycles
+  unsigned long timedIntervalMs = 0;    // Timed-mode cycle period
+};
+
+struct IrrigationStats {
+  uint32_t starts = 0;           // Zone pump starts, both modes
+  uint32_t timedCycles = 0;      // Of which timed cycles
+  uint32_t capacityWaits = 0;    // Times a zone had to wait for a free pump
+};
+
+template <uint8_t MAX_ZONES = 8>
+class IrrigationZones {
+  static_assert(MAX_ZONES >= 1 && MAX_ZONES <= 32, "Zone masks hold 32 zones");
+
+public:
+  struct Schedule {
+    uint32_t cycleStartedAt[MAX_ZONES];   // Caller's clock, running cycle
+    uint32_t lastCycleAt[MAX_ZONES];      // Completion of the previous cycle
+    ZoneMask cycling;
+  };
+
+  // `maxSimultaneous` of 0 lets every zone run at once.
+  void begin(uint8_t maxSimultaneous) {
+    pumpLimit = maxSimultaneous ? maxSimultaneous : MAX_ZONES;
+  }
+
+  // Returns the zone index or -1 when full. Drives the relay off.
+  int8_t addZone(const IrrigationZoneConfig &config) {
+    if (count >= MAX_ZONES) return -1;
+    relayPins[count] = config.relayPin;
+    sensorChannels[count] = config.sensorChannel;
+    thresholds[count] = config.thresholdPct;
+    hysteresis[count] = config.hysteresisPct;
+    durations[count] = config.timedDurationMs;
+    intervals[count] = config.timedIntervalMs;
+    moisture[count] = -1;
+    timing.cycleStartedAt[count] = 0;
+    timing.lastCycleAt[count] = 0;
+    pinMode(config.relayPin, OUTPUT);
+    digitalWrite(config.relayPin, LOW);
+    return count++;
+  }
+
+  uint8_t zoneCount() const { return count; }
+  uint8_t maxSimultaneous() const { return pumpLimit; }
+  int8_t sensorChannel(uint8_t zone) const { return sensorChannels[zone]; }
+  uint8_t relayPin(uint8_t zone) const { return relayPins[zone]; }
+
+  // Latest reading, 0-100 %; a zone without one is left alone by regulate().
+  void setMoisture(uint8_t zone, int8_t percent) { moisture[zone] = percent; }
+  int8_t moistureOf(uint8_t zone) const { return moisture[zone]; }
+
+  // Lowest reading across the zones, or -1 before any
+  int8_t driestMoisture() const {
+    int8_t driest = -1;
+    for (uint8_t zone = 0; zone < count; zone++) {
+      if (moisture[zone] >= 0 && (driest < 0 || moisture[zone] < driest)) driest = moisture[zone];
+    }
+    return driest;
+  }
+
+  // Idle zones short of their threshold by less than `margin`: the ones a
+  // forecast may hold back. Lets the caller skip the forecast query when
+  // nothing could be deferred.
+  ZoneMask deferrable(int thresholdOffset, int margin) const {
+    ZoneMask result = 0;
+    for (uint8_t zone = 0; zone < count; zone++) {
+      int start = thresholds[zone] + thresholdOffset;
+      if (!(watering & bit(zone)) && moisture[zone] >= 0 && moisture[zone] < start && moisture[zone] >= start - margin) {
+        result |= bit(zone);
+      }
+    }
+    return result;
+  }
+
+  // Sensor-driven pass. `thresholdOffset` shifts every zone's threshold
+  // (e.g. lowered in the cold); zones in `withheld` are not started.
+  void regulate(int thresholdOffset = 0, ZoneMask withheld = 0) {
+    startedZones = stoppedZones = 0;
+    ZoneMask wanting = 0;
+    for (uint8_t zone = 0; zone < count; zone++) {
+      if (moisture[zone] < 0) continue;
+      int start = thresholds[zone] + thresholdOffset;
+      if (watering & bit(zone)) {
+        if (moisture[zone] >= start + hysteresis[zone]) stop(zone);
+      } else if (moisture[zone] < start && !(withheld & bit(zone))) {
+        wanting |= bit(zone);
+      }
+    }
+    admit(wanting, false, 0);
+  }
+
+  // Idle zones whose timed cycle is due at `now`, for the same purpose as
+  // deferrable().
+  ZoneMask cyclesDue(unsigned long now) const {
+    ZoneMask result = 0;
+    for (uint8_t zone = 0; zone < count; zone++) {
+      if (durations[zone] && !(timing.cycling & bit(zone)) && (uint32_t)now - timing.lastCycleAt[zone] >= intervals[zone]) {
+        result |= bit(zone);
+      }
+    }
+    return result;
+  }
+
+  // Timed pass for when the sensors cannot be trusted: each zone runs for
+  // its duration once per interval. Zones in `withheld` are postponed.
+  // Returns true when the schedule changed and should be persisted.
+  bool regulateTimed(unsigned long now, ZoneMask withheld = 0) {
+    startedZones = stoppedZones = 0;
+    ZoneMask before = timing.cycling;
+    ZoneMask wanting = 0;
+    for (uint8_t zone = 0; zone < count; zone++) {
+      if (!durations[zone]) continue;
+      uint32_t elapsed = (uint32_t)now - (timing.cycling & bit(zone) ? timing.cycleStartedAt[zone] : timing.lastCycleAt[zone]);
+      if (timing.cycling & bit(zone)) {
+        if (elapsed >= durations[zone]) {
+          stop(zone);
+          timing.cycling &= ~bit(zone);
+          timing.lastCycleAt[zone] = now;
+        }
+      } else if (elapsed >= intervals[zone] && !(withheld & bit(zone))) {
+        wanting |= bit(zone);
+      }
+    }
+    admit(wanting, true, now);
+    return timing.cycling != before;
+  }
+
+  // Remote override: start every zone the pump limit admits, or stop all.
+  void command(bool on) {
+    startedZones = stoppedZones = 0;
+    if (on) {
+      admit(allZones(), false, 0);
+      return;
+    }
+    for (ZoneMask zones = watering; zones; zones &= zones - 1) stop(__builtin_ctz(zones));
+  }
+
+  // Drive every relay to the decided state, e.g. after a watchdog forced
+  // them safe.
+  void reassertOutputs() const {
+    for (uint8_t zone = 0; zone < count; zone++) digitalWrite(relayPins[zone], watering & bit(zone) ? HIGH : LOW);
+  }
+
+  // Resume the cycles a reset interrupted.
+  void restore(const Schedule &retained) {
+    timing = retained;
+    timing.cycling &= allZones();
+    for (ZoneMask zones = timing.cycling & ~watering; zones; zones &= zones - 1) start(__builtin_ctz(zones));
+  }
+
+  const Schedule &schedule() const { return timing; }
+
+  // Transitions of the last pass, for logging
+  ZoneMask started() const { return startedZones; }
+  ZoneMask stopped() const { return stoppedZones; }
+  ZoneMask waiting() const { return waitingZones; }     // Wanted water, pump limit reached
+
+  ZoneMask wateringZones() const { return watering; }
+  ZoneMask cyclingZones() const { return timing.cycling; }
+  bool anyWatering() const { return watering != 0; }
+  uint8_t activeCount() const { return active; }
+
+  const IrrigationStats &stats() const { return statistics; }
+
+private:
+  uint8_t relayPins[MAX_ZONES];
+  int8_t sensorChannels[MAX_ZONES];
+  int8_t thresholds[MAX_ZONES];
+  int8_t hysteresis[MAX_ZONES];
+  int8_t moisture[MAX_ZONES];
+  uint32_t durations[MAX_ZONES];
+  uint32_t intervals[MAX_ZONES];
+  Schedule timing = {};
+  ZoneMask watering = 0;
+  ZoneMask startedZones = 0;
+  ZoneMask stoppedZones = 0;
+  ZoneMask waitingZones = 0;
+  uint8_t count = 0;
+  uint8_t active = 0;
+  uint8_t pumpLimit = MAX_ZONES;
+  uint8_t nextAdmission = 0;     // Round-robin cursor
+  IrrigationStats statistics;
+
+  static ZoneMask bit(uint8_t zone) { return (ZoneMask)1 << zone; }
+  ZoneMask allZones() const { return count ? (ZoneMask)-1 >> (32 - count) : 0; }
+
+  void start(uint8_t zone) {
+    watering |= bit(zone);
+    active++;
+    startedZones |= bit(zone);
+    statistics.starts++;
+    digitalWrite(relayPins[zone], HIGH);
+  }
+
+  void stop(uint8_t zone) {
+    if (watering & bit(zone)) {
+      watering &= ~bit(zone);
+      active--;
+      stoppedZones |= bit(zone);
+    }
+    digitalWrite(relayPins[zone], LOW);
+  }
+
+  // Start the wanting zones in rotation from the cursor while pumps are
+  // free. A timed cycle claims a zone even if it is already watering.
+  void admit(ZoneMask wanting, bool timed, unsigned long now) {
+    ZoneMask blocked = 0;
+    uint8_t zone = nextAdmission < count ? nextAdmission : 0;
+    for (uint8_t visited = 0; visited < count && wanting; visited++, zone = zone + 1 < count ? zone + 1 : 0) {
+      if (!(wanting & bit(zone))) continue;
+      wanting &= ~bit(zone);
+      if (!(watering & bit(zone))) {
+        if (active >= pumpLimit) {
+          blocked |= bit(zone);
+          continue;
+        }
+        start(zone);
+        nextAdmission = zone + 1 < count ? zone + 1 : 0;
+      }
+      if (timed) {
+        timing.cycling |= bit(zone);
+        timing.cycleStartedAt[zone] = now;
+        statistics.timedCycles++;
+      }
+    }
+    statistics.capacityWaits += __builtin_popcount(blocked & ~waitingZones);
+    waitingZones = blocked;
+  }
+};
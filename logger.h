@@ -0,0 +1,230 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+// ─────────────────────────────────────
+// Buffered Event Logger
+// ─────────────────────────────────────
+// Serial.print() blocks as soon as the 128-byte UART FIFO is full - at
+// 115200 baud every further byte costs ~87 µs of loop time. Log lines are
+// instead formatted into a RAM ring and poll() hands the UART only what
+// its FIFO can take without waiting, so logging never stalls the loop.
+//
+//   LOG_INFO(LOG_ACTUATOR, "Pump on (moisture %d%%)", moisture);
+//
+// Levels above ECOPULSE_LOG_LEVEL compile to nothing: neither the format
+// string nor the arguments reach the binary. Categories can additionally
+// be muted at runtime. An identical line (same level, category and text)
+// is printed at most once per repeat window; the next copy that gets
+// through reports how many were suppressed in between.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef ECOPULSE_LOG_LEVEL
+#define ECOPULSE_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+enum LogCategory : uint8_t {
+  LOG_SYSTEM,
+  LOG_SENSOR,
+  LOG_ACTUATOR,
+  LOG_NETWORK,
+  LOG_CLOUD,
+  LOG_WEATHER,
+  LOG_STORAGE,
+  LOG_CATEGORY_COUNT
+};
+
+struct LoggerStats {
+  uint32_t lines = 0;              // Lines queued for the UART
+  uint32_t bytes = 0;
+  uint32_t repeatsSuppressed = 0;  // Dropped by the repeat limiter
+  uint32_t overflowed = 0;         // Dropped because the ring was full
+  uint16_t peakBacklog = 0;        // Most bytes ever waiting in the ring
+};
+
+class Logger {
+public:
+  static const uint16_t CAPACITY = 2048;      // Ring size; holds ~40 typical lines
+  static const uint8_t MAX_LINE = 160;
+  static const uint8_t REPEAT_SLOTS = 8;      // Distinct recent lines tracked by the limiter
+
+  void begin(Print &uart, unsigned long repeatWindowMs = 10000) {
+    output = &uart;
+    repeatWindow = repeatWindowMs;
+    categoryMask = 0xFF;
+  }
+
+  void enableCategory(LogCategory category, bool enabled) {
+    if (enabled) {
+      categoryMask |= 1 << category;
+    } else {
+      categoryMask &= ~(1 << category);
+    }
+  }
+
+  // Use the LOG_* macros rather than calling this directly - they strip
+  // disabled levels and keep format strings in flash.
+  void write(uint8_t level, LogCategory category, PGM_P format, ...) __attribute__((format(printf, 4, 5))) {
+    if (!output || !(categoryMask & (1 << category))) return;
+
+    char text[MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf_P(text, sizeof(text), format, args);
+    va_end(args);
+
+    uint16_t repeats;
+    if (!admit(level, category, text, repeats)) return;
+
+    char line[MAX_LINE + 48];
+    unsigned long now = millis();
+    int length = snprintf(line, sizeof(line), "%6lu.%03lu %c %-3s %s", now / 1000, now % 1000, LEVEL_TAGS[level],
+                          CATEGORY_TAGS[category], text);
+    if (repeats && length < (int)sizeof(line)) {
+      length += snprintf(line + length, sizeof(line) - length, " [+%u repeats]", repeats);
+    }
+    if (length >= (int)sizeof(line) - 2) length = sizeof(line) - 3;
+    line[length++] = '\r';
+    line[length++] = '\n';
+    enqueue(line, length);
+  }
+
+  // Move as much of the ring into the UART FIFO as fits without blocking.
+  // Call every loop pass.
+  void poll() {
+    while (used && output) {
+      int room = output->availableForWrite();
+      if (room <= 0) return;
+      uint16_t chunk = contiguous();
+      if (chunk > (uint16_t)room) chunk = room;
+      output->write((const uint8_t *)&ring[tail], chunk);
+      tail = (tail + chunk) % CAPACITY;
+      used -= chunk;
+    }
+  }
+
+  // Write everything out, blocking - before deep sleep or a restart.
+  void flush() {
+    while (used && output) {
+      uint16_t chunk = contiguous();
+      output->write((const uint8_t *)&ring[tail], chunk);
+      tail = (tail + chunk) % CAPACITY;
+      used -= chunk;
+    }
+    if (output) output->flush();
+  }
+
+  uint16_t backlog() const { return used; }
+  const LoggerStats &stats() const { return statistics; }
+
+private:
+  struct RepeatSlot {
+    uint32_t hash;
+    unsigned long lastPrinted;
+    uint16_t suppressed;
+    bool used;
+  };
+
+  static constexpr const char *LEVEL_TAGS = "-EWID";
+  static constexpr const char *CATEGORY_TAGS[LOG_CATEGORY_COUNT] = { "SYS", "SNS", "ACT", "NET", "CLD", "WX", "FS" };
+
+  Print *output = nullptr;
+  char ring[CAPACITY];
+  uint16_t head = 0;
+  uint16_t tail = 0;
+  uint16_t used = 0;
+  uint8_t categoryMask = 0xFF;
+  unsigned long repeatWindow = 10000;
+  RepeatSlot slots[REPEAT_SLOTS] = {};
+  LoggerStats statistics;
+
+  uint16_t contiguous() const {
+    uint16_t toEnd = CAPACITY - tail;
+    return used < toEnd ? used : toEnd;
+  }
+
+  // FNV-1a over level, category and text
+  static uint32_t lineHash(uint8_t level, LogCategory category, const char *text) {
+    uint32_t hash = 2166136261UL;
+    hash = (hash ^ level) * 16777619UL;
+    hash = (hash ^ category) * 16777619UL;
+    while (*text) hash = (hash ^ (uint8_t)*text++) * 16777619UL;
+    return hash;
+  }
+
+  bool admit(uint8_t level, LogCategory category, const char *text, uint16_t &repeats) {
+    uint32_t hash = lineHash(level, category, text);
+    unsigned long now = millis();
+    RepeatSlot *reuse = &slots[0];
+    for (RepeatSlot &slot : slots) {
+      if (slot.used && slot.hash == hash) {
+        if (now - slot.lastPrinted < repeatWindow) {
+          if (slot.suppressed < UINT16_MAX) slot.suppressed++;
+          statistics.repeatsSuppressed++;
+          return false;
+        }
+        repeats = slot.suppressed;
+        slot.suppressed = 0;
+        slot.lastPrinted = now;
+        return true;
+      }
+      // New lines take a free slot, else the one printed longest ago
+      if (reuse->used && (!slot.used || now - slot.lastPrinted > now - reuse->lastPrinted)) {
+        reuse = &slot;
+      }
+    }
+    reuse->used = true;
+    reuse->hash = hash;
+    reuse->lastPrinted = now;
+    reuse->suppressed = 0;
+    repeats = 0;
+    return true;
+  }
+
+  void enqueue(const char *line, uint16_t length) {
+    if (CAPACITY - used < length) {
+      statistics.overflowed++;  // Keep what is queued - it is older and already in order
+      return;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+      ring[head] = line[i];
+      head = (head + 1) % CAPACITY;
+    }
+    used += length;
+    statistics.lines++;
+    statistics.bytes += length;
+    if (used > statistics.peakBacklog) statistics.peakBacklog = used;
+  }
+};
+
+inline Logger logger;
+
+#if ECOPULSE_LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(category, format, ...) logger.write(LOG_LEVEL_ERROR, category, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(category, format, ...) do {} while (0)
+#endif
+
+#if ECOPULSE_LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(category, format, ...) logger.write(LOG_LEVEL_WARN, category, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_WARN(category, format, ...) do {} while (0)
+#endif
+
+#if ECOPULSE_LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(category, format, ...) logger.write(LOG_LEVEL_INFO, category, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_INFO(category, format, ...) do {} while (0)
+#endif
+
+#if ECOPULSE_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, format, ...) logger.write(LOG_LEVEL_DEBUG, category, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(category, format, ...) do {} while (0)
+#endif
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <Arduino.h>
+#include "logger.h"
+
+// ─────────────────────────────────────
+// Per-Stage Loop Profiler
+// ─────────────────────────────────────
+// Wraps each stage of the loop (cloud update, sensor tasks, weather
+// polling, ...) and keeps, per stage, a call count, total and maximum time
+// and a log-bucketed latency histogram from which p50/p99 are read:
+//
+//   PROFILE_STAGE(loopProfiler, cloudStage);   // measures to end of scope
+//   ArduinoCloud.update();
+//
+// Timing uses the CPU cycle counter (ESP.getCycleCount(), one register
+// read), so a measurement costs two reads, a count-leading-zeros and a few
+// adds - no division (the LX106 has no divider) and well under a
+// microsecond at 80 MHz, cheap enough to leave on in production. Stages
+// may nest; times are inclusive.
+//
+// Histogram buckets are in cycles and split every power of two in half
+// (..., 64, 96, 128, 192, 256, ... cycles, up to the 53 s the 32-bit
+// counter spans at 80 MHz), so a percentile is reported to within 50 % at
+// worst - enough to tell a 200 µs stage from a 2 ms one, in 104 bytes per
+// stage. Conversion to µs happens only when a summary is read. The
+// maximum is exact. A bucket about to overflow halves the whole
+// histogram, which keeps percentiles weighted towards recent passes.
+//
+// Build with -DECOPULSE_PROFILE=0 to compile the instrumentation out.
+
+#ifndef ECOPULSE_PROFILE
+#define ECOPULSE_PROFILE 1
+#endif
+
+struct StageSummary {
+  const char *name;
+  uint32_t calls;
+  uint32_t p50Us;
+  uint32_t p99Us;
+  uint32_t maxUs;
+  uint32_t totalMs;   // Time spent in the stage since the last reset
+};
+
+template <uint8_t MAX_STAGES = 12>
+class LoopProfiler {
+public:
+  static const uint8_t FIRST_OCTAVE = 6;    // Everything under 128 cycles (1.6 µs) shares the first buckets
+  static const uint8_t BUCKETS = (32 - FIRST_OCTAVE) * 2;
+
+  // Measures from construction to the end of the enclosing scope
+  class Scope {
+  public:
+    Scope(LoopProfiler &owner, int8_t stage) : profiler(owner), handle(stage), started(ESP.getCycleCount()) {}
+    ~Scope() { profiler.record(handle, started); }
+
+  private:
+    LoopProfiler &profiler;
+    int8_t handle;
+    uint32_t started;
+  };
+
+  void begin() {
+    cyclesPerMicro = ESP.getCpuFreqMHz();
+    if (!cyclesPerMicro) cyclesPerMicro = 80;
+  }
+
+  // Register a stage; returns its handle or -1 when full. `name` must
+  // outlive the profiler (a string literal).
+  int8_t addStage(const char *name) {
+    if (count >= MAX_STAGES) return -1;
+    stages[count] = Stage();
+    stages[count].name = name;
+    return count++;
+  }
+
+  Scope scope(int8_t stage) { return Scope(*this, stage); }
+
+  void record(int8_t stage, uint32_t startedCycles) {
+    uint32_t cycles = ESP.getCycleCount() - startedCycles;  // Wraps every 53 s at 80 MHz; differences stay valid
+    if (stage < 0 || stage >= count) return;
+    Stage &entry = stages[stage];
+    entry.calls++;
+    entry.totalCycles += cycles;
+    if (cycles > entry.maxCycles) entry.maxCycles = cycles;
+    uint8_t bucket = bucketOf(cycles);
+    if (entry.buckets[bucket] == UINT16_MAX) {
+      for (uint16_t &slot : entry.buckets) slot >>= 1;
+    }
+    entry.buckets[bucket]++;
+  }
+
+  void reset() {
+    for (uint8_t stage = 0; stage < count; stage++) {
+      const char *name = stages[stage].name;
+      stages[stage] = Stage();
+      stages[stage].name = name;
+    }
+  }
+
+  uint8_t stageCount() const { return count; }
+
+  bool summary(uint8_t stage, StageSummary &result) const {
+    if (stage >= count) return false;
+    const Stage &entry = stages[stage];
+    result.name = entry.name;
+    result.calls = entry.calls;
+    result.p50Us = percentile(entry, 50);
+    result.p99Us = percentile(entry, 99);
+    result.maxUs = entry.maxCycles / cyclesPerMicro;
+    result.totalMs = (uint32_t)(entry.totalCycles / cyclesPerMicro / 1000);
+    if (result.p50Us > result.maxUs) result.p50Us = result.maxUs;  // Bucket bounds overshoot the real extreme
+    if (result.p99Us > result.maxUs) result.p99Us = result.maxUs;
+    return true;
+  }
+
+  // One log line per stage, through the buffered logger
+  void report() const {
+    LOG_INFO(LOG_SYSTEM, "Loop profile: stage calls p50/p99/max us, total ms");
+    StageSummary stage;
+    for (uint8_t handle = 0; summary(handle, stage); handle++) {
+      LOG_INFO(LOG_SYSTEM, "  %-10s %8u %6u/%u/%u %u", stage.name, stage.calls, stage.p50Us, stage.p99Us,
+               stage.maxUs, stage.totalMs);
+    }
+  }
+
+  // Compact text for a diagnostic cloud property:
+  // "<stage>:<p50>/<p99>/<max>;..." in µs. Returns the length written.
+  size_t format(char *buffer, size_t size) const {
+    size_t length = 0;
+    buffer[0] = '\0';
+    StageSummary stage;
+    for (uint8_t handle = 0; summary(handle, stage); handle++) {
+      int written = snprintf(buffer + length, size - length, "%s:%u/%u/%u;", stage.name, stage.p50Us, stage.p99Us,
+                             stage.maxUs);
+      if (written < 0 || (size_t)written >= size - length) {
+        buffer[length] = '\0';  // Drop the stage that did not fit rather than truncating it
+        break;
+      }
+      length += written;
+    }
+    return length;
+  }
+
+private:
+  struct Stage {
+    const char *name = nullptr;
+    uint32_t calls = 0;
+    uint32_t maxCycles = 0;
+    uint64_t totalCycles = 0;
+    uint16_t buckets[BUCKETS] = {};
+  };
+
+  Stage stages[MAX_STAGES];
+  uint8_t count = 0;
+  uint32_t cyclesPerMicro = 80;
+
+  // Octave k (2^k <= cycles < 2^(k+1)) splits into [2^k, 1.5 * 2^k) and
+  // [1.5 * 2^k, 2^(k+1)); octaves below FIRST_OCTAVE fold into bucket 0
+  static uint8_t bucketOf(uint32_t cycles) {
+    if (cycles < (1UL << FIRST_OCTAVE)) return 0;
+    uint8_t octave = 31 - __builtin_clz(cycles);
+    return (octave - FIRST_OCTAVE) * 2 + ((cycles >> (octave - 1)) & 1);
+  }
+
+  // Largest cycle count that falls in `bucket`
+  static uint32_t bucketLimit(uint8_t bucket) {
+    uint8_t octave = bucket / 2 + FIRST_OCTAVE;
+    uint32_t lower = (bucket & 1) ? (3UL << (octave - 1)) : (1UL << octave);
+    return lower + ((1UL << (octave - 1)) - 1);
+  }
+
+  uint32_t percentile(const Stage &entry, uint8_t percent) const {
+    uint32_t samples = 0;
+    for (uint16_t slot : entry.buckets) samples += slot;
+    if (!samples) return 0;
+    uint32_t rank = (samples * percent + 99) / 100;  // Nearest-rank
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+      seen += entry.buckets[bucket];
+      if (seen >= rank) return bucketLimit(bucket) / cyclesPerMicro;
+    }
+    return bucketLimit(BUCKETS - 1) / cyclesPerMicro;
+  }
+};
+
+#if ECOPULSE_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_STAGE(profiler, stage) auto PROFILE_CONCAT(profileScope, __LINE__) = (profiler).scope(stage)
+#else
+#define PROFILE_STAGE(profiler, stage) do {} while (0)
+#endif
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Ticker.h>
+#include "logger.h"
+#include "rtc-memory.h"
+
+// ─────────────────────────────────────
+// Loop Deadline Watchdog
+// ─────────────────────────────────────
+// One blocking call (a TLS handshake, a WiFi reconnect, an NTP wait) can
+// starve the loop long enough for a soft-WDT reset, or keep the pump
+// running long after its cycle should have ended. The watchdog gives each
+// wrapped operation a time budget and watches the control tick:
+//
+//   WATCHDOG_SCOPE(loopWatchdog, weatherOperation);   // budget checked to end of scope
+//   weatherClient.poll();
+//
+//   if (loopWatchdog.controlTick()) { ...re-assert outputs... }
+//
+// A Ticker inspects the running operation every few ms. The SDK runs it
+// whenever the sketch yields, which blocking network calls do while they
+// wait, so an overrun is attributed while it is still in progress: the
+// record (operation, time spent, watchdog clock) is written to RTC memory
+// at once and kept up to date, and survives the reset if the operation
+// never returns. The last HISTORY overruns are retained.
+//
+// If the control tick has not run for the control deadline, the Ticker
+// drives the registered safe outputs (the pump relay) to their safe level.
+// The next controlTick() reports it so the sketch can re-assert what its
+// control logic decides.
+//
+// A Ticker is an os_timer, dispatched from the SDK task queue, so it only
+// runs when the loop yields. For a stall that yields (network waits,
+// delay(), yield()) pump-off latency is the deadline plus one inspection
+// interval. A stall that never yields - a CPU-bound loop, interrupts held
+// off - does not run the Ticker at all: there the soft WDT resets the
+// board after ~3.2 s (the hardware WDT after ~8 s if the soft one cannot
+// fire) and setup() drives the relay off. Timer1, the only hardware timer
+// that could preempt such a stall, paces the ADC sampler.
+
+struct WatchdogOverrun {
+  uint32_t atMs;          // Watchdog clock when the overrun was detected
+  uint16_t elapsedMs;     // Time spent in the operation (saturates at 65535)
+  uint8_t operation;      // Handle from addOperation(), or WATCHDOG_UNATTRIBUTED
+  uint8_t flags;          // WATCHDOG_OVERRUN_*
+};
+
+const uint8_t WATCHDOG_UNATTRIBUTED = 0xFF;             // Control deadline missed outside any wrapped operation
+const uint8_t WATCHDOG_OVERRUN_IN_PROGRESS = 0x01;      // Operation had not returned when last recorded
+const uint8_t WATCHDOG_OVERRUN_CONTROL_MISSED = 0x02;   // Outputs were forced safe during it
+const uint8_t WATCHDOG_OVERRUN_RESET = 0x04;            // A reset ended it
+
+struct WatchdogStats {
+  uint32_t overruns = 0;          // This boot
+  uint32_t controlMisses = 0;     // Control deadlines missed (outputs forced safe)
+  uint32_t worstOverrunMs = 0;
+  uint8_t worstOperation = WATCHDOG_UNATTRIBUTED;
+  uint32_t retainedOverruns = 0;  // Since power-on, from RTC memory
+};
+
+typedef unsigned long (*WatchdogClock)();
+
+template <uint8_t MAX_OPERATIONS = 8, uint8_t MAX_SAFE_OUTPUTS = 4>
+class LoopWatchdog {
+public:
+  static const uint8_t HISTORY = 5;        // What fits the RTC blocks left after the other records
+  static const uint8_t MAX_DEPTH = 4;      // Nested operations tracked
+
+  // Enters an operation on construction and leaves it at the end of scope
+  class Guard {
+  public:
+    Guard(LoopWatchdog &owner, int8_t operation) : watchdog(owner), entered(owner.enter(operation)) {}
+    ~Guard() {
+      if (entered) watchdog.leave();
+    }
+
+  private:
+    LoopWatchdog &watchdog;
+    bool entered;
+  };
+
+  // Starts the inspection Ticker and restores the retained overrun history.
+  // An overrun still marked in progress was cut short by a reset.
+  void begin(unsigned long inspectionIntervalMs = 100, WatchdogClock monotonicClock = millis) {
+    clock = monotonicClock;
+    if (!logRecord.load(history)) history = History();
+    for (uint8_t i = 0; i < history.count; i++) {
+      WatchdogOverrun &entry = history.entries[i];
+      if (entry.flags & WATCHDOG_OVERRUN_IN_PROGRESS) {
+        entry.flags = (entry.flags & ~WATCHDOG_OVERRUN_IN_PROGRESS) | WATCHDOG_OVERRUN_RESET;
+        interruptedSlot = i;
+      }
+    }
+    if (interruptedSlot >= 0) logRecord.save(history);
+    statistics.retainedOverruns = history.total;
+    ticker.attach_ms(inspectionIntervalMs, inspect, this);
+  }
+
+  // Register an operation; returns its handle or -1 when full. `name`
+  // must outlive the watchdog (a string literal).
+  int8_t addOperation(const char *name, unsigned long budgetMs) {
+    if (count >= MAX_OPERATIONS) return -1;
+    operations[count].name = name;
+    operations[count].budgetMs = budgetMs;
+    return count++;
+  }
+
+  // Pin driven to `level` when the control deadline is missed
+  bool addSafeOutput(uint8_t pin, uint8_t level) {
+    if (safeOutputCount >= MAX_SAFE_OUTPUTS) return false;
+    safeOutputs[safeOutputCount++] = { pin, level };
+    return true;
+  }
+
+  // Armed by the first controlTick(), so a slow boot is not a miss
+  void setControlDeadline(unsigned long deadlineMs) { controlDeadlineMs = deadlineMs; }
+
+  Guard guard(int8_t operation) { return Guard(*this, operation); }
+
+  bool enter(int8_t operation) {
+    if (operation < 0 || operation >= count || depth >= MAX_DEPTH) return false;
+    frames[depth] = { clock(), (uint8_t)operation, -1 };
+    depth++;
+    return true;
+  }
+
+  void leave() {
+    if (!depth) return;
+    Frame &frame = frames[depth - 1];
+    unsigned long elapsed = clock() - frame.startedAt;
+    const Operation &operation = operations[frame.operation];
+    if (frame.slot >= 0) {
+      WatchdogOverrun &entry = history.entries[frame.slot];
+      entry.elapsedMs = saturate(elapsed);
+      entry.flags &= ~WATCHDOG_OVERRUN_IN_PROGRESS;
+      logRecord.save(history);
+    } else if (elapsed > operation.budgetMs) {
+      record(frame.operation, elapsed, 0);
+    }
+    if (elapsed > operation.budgetMs) {
+      LOG_WARN(LOG_SYSTEM, "Loop overrun: %s took %lu ms (budget %lu ms)", operation.name, elapsed, operation.budgetMs);
+      if (elapsed > statistics.worstOverrunMs) {
+        statistics.worstOverrunMs = elapsed;
+        statistics.worstOperation = frame.operation;
+      }
+    }
+    depth--;
+  }
+
+  // Call from the control tick. Returns true once after the outputs were
+  // forced safe, so the sketch re-asserts them from its control state.
+  bool controlTick() {
+    unsigned long now = clock();
+    lastControlTick = now;
+    controlArmed = true;
+    if (!outputsForcedSafe) return false;
+    outputsForcedSafe = false;
+    LOG_WARN(LOG_ACTUATOR, "Control deadline missed: outputs held safe for %lu ms", now - forcedSafeAt);
+    return true;
+  }
+
+  bool outputsSafe() const { return outputsForcedSafe; }
+
+  // Newest first; false past the retained history
+  bool overrun(uint8_t newest, WatchdogOverrun &entry) const {
+    if (newest >= history.count) return false;
+    entry = history.entries[(history.next + HISTORY - 1 - newest) % HISTORY];
+    return true;
+  }
+
+  const char *operationName(uint8_t operation) const {
+    if (operation == WATCHDOG_UNATTRIBUTED) return "(none)";
+    return operation < count ? operations[operation].name : "(unknown)";
+  }
+
+  // The overrun a reset cut short, if the last reset happened during one
+  bool interruptedByReset(WatchdogOverrun &entry) const {
+    if (interruptedSlot < 0) return false;
+    entry = history.entries[interruptedSlot];
+    return true;
+  }
+
+  // Retained history through the buffered logger, newest first
+  void report() const {
+    LOG_INFO(LOG_SYSTEM, "Loop watchdog: %u overruns this boot (%u retained since power-on), %u control deadlines missed",
+             statistics.overruns, history.total, statistics.controlMisses);
+    WatchdogOverrun entry;
+    for (uint8_t i = 0; overrun(i, entry); i++) {
+      LOG_INFO(LOG_SYSTEM, "  %-10s %5u ms at %lu s%s%s", operationName(entry.operation), entry.elapsedMs,
+               (unsigned long)(entry.atMs / 1000), entry.flags & WATCHDOG_OVERRUN_CONTROL_MISSED ? ", outputs forced safe" : "",
+               entry.flags & WATCHDOG_OVERRUN_RESET ? ", ended by reset" : "");
+    }
+  }
+
+  const WatchdogStats &stats() const { return statistics; }
+
+  // Forget the retained history, e.g. after reviewing it
+  void clear() {
+    history = History();
+    logRecord.save(history);
+    statistics.retainedOverruns = 0;
+    interruptedSlot = -1;
+    for (uint8_t i = 0; i < depth; i++) frames[i].slot = -1;
+  }
+
+private:
+  struct Operation {
+    const char *name;
+    unsigned long budgetMs;
+  };
+
+  struct Frame {
+    unsigned long startedAt;
+    uint8_t operation;
+    int8_t slot;          // History entry tracking this frame's overrun
+  };
+
+  struct SafeOutput {
+    uint8_t pin;
+    uint8_t level;
+  };
+
+  struct History {
+    uint8_t next;
+    uint8_t count;
+    uint16_t reserved;
+    uint32_t total;       // Overruns recorded since power-on
+    WatchdogOverrun entries[HISTORY];
+  };
+
+  RtcRecord<History, RTC_BLOCK_LOOP_WATCHDOG> logRecord;
+  History history = {};
+  Operation operations[MAX_OPERATIONS];
+  uint8_t count = 0;
+  Frame frames[MAX_DEPTH];
+  volatile uint8_t depth = 0;
+  SafeOutput safeOutputs[MAX_SAFE_OUTPUTS];
+  uint8_t safeOutputCount = 0;
+  unsigned long controlDeadlineMs = 0;
+  volatile unsigned long lastControlTick = 0;
+  volatile bool controlArmed = false;
+  volatile bool outputsForcedSafe = false;
+  unsigned long forcedSafeAt = 0;
+  int8_t interruptedSlot = -1;
+  WatchdogStats statistics;
+  WatchdogClock clock = millis;
+  Ticker ticker;
+
+  static uint16_t saturate(unsigned long elapsedMs) {
+    return elapsedMs > UINT16_MAX ? UINT16_MAX : (uint16_t)elapsedMs;
+  }
+
+  int8_t record(uint8_t operation, unsigned long elapsedMs, uint8_t flags) {
+    int8_t slot = history.next;
+    history.entries[slot] = { (uint32_t)clock(), saturate(elapsedMs), operation, flags };
+    history.next = (history.next + 1) % HISTORY;
+    if (history.count < HISTORY) history.count++;
+    history.total++;
+    if (interruptedSlot == slot) interruptedSlot = -1;
+    for (uint8_t i = 0; i < depth; i++) {
+      if (frames[i].slot == slot) frames[i].slot = -1;  // Overwritten by a newer record
+    }
+    statistics.overruns++;
+    statistics.retainedOverruns = history.total;
+    logRecord.save(history);
+    return slot;
+  }
+
+  // Runs from the Ticker, i.e. only where the loop yields - never inside
+  // enter()/leave() - so the frame stack is consistent here. A loop that
+  // does not yield is never inspected; see the header comment.
+  static void inspect(LoopWatchdog *watchdog) { watchdog->inspectNow(); }
+
+  void inspectNow() {
+    unsigned long now = clock();
+    if (depth) {
+      Frame &frame = frames[depth - 1];
+      unsigned long elapsed = now - frame.startedAt;
+      if (frame.slot >= 0) {
+        history.entries[frame.slot].elapsedMs = saturate(elapsed);  // Kept current in case it never returns
+        logRecord.save(history);
+      } else if (elapsed > operations[frame.operation].budgetMs) {
+        frame.slot = record(frame.operation, elapsed, WATCHDOG_OVERRUN_IN_PROGRESS);
+      }
+    }
+
+    if (!controlDeadlineMs || !controlArmed || outputsForcedSafe || now - lastControlTick <= controlDeadlineMs) return;
+    for (uint8_t i = 0; i < safeOutputCount; i++) digitalWrite(safeOutputs[i].pin, safeOutputs[i].level);
+    outputsForcedSafe = true;
+    forcedSafeAt = now;
+    statistics.controlMisses++;
+
+    // Blame whatever the loop is stuck in
+    if (depth) {
+      Frame &frame = frames[depth - 1];
+      if (frame.slot < 0) frame.slot = record(frame.operation, now - frame.startedAt, WATCHDOG_OVERRUN_IN_PROGRESS);
+      history.entries[frame.slot].flags |= WATCHDOG_OVERRUN_CONTROL_MISSED;
+      logRecord.save(history);
+    } else {
+      record(WATCHDOG_UNATTRIBUTED, now - lastControlTick, WATCHDOG_OVERRUN_CONTROL_MISSED);
+    }
+  }
+};
+
+#define WATCHDOG_CONCAT_(a, b) a##b
+#define WATCHDOG_CONCAT(a, b) WATCHDOG_CONCAT_(a, b)
+#define WATCHDOG_SCOPE(watchdog, operation) auto WATCHDOG_CONCAT(watchdogGuard, __LINE__) = (watchdog).guard(operation)
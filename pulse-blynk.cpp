@@ -6,7 +6,27 @@
 #include <BlynkSimpleEsp8266.h>
 #include <ESP8266HTTPClient.h>
 #include <WiFiClient.h>
-#include <ArduinoJson.h>
+#include "weather-client.h"
+#include "weather-forecast.h"
+#include "adc-sampler.h"
+#include "telemetry-publisher.h"
+#include "logger.h"
+#include "wifi-link.h"
+#include "calibration.h"
+#include "telemetry-stream.h"
+#include "weather-share.h"
+
+// Binary telemetry frames on the LAN: 0 = off, 1 = alongside Blynk,
+// 2 = instead of Blynk (no app control). Build with -DECOPULSE_LAN_TELEMETRY=1
+#ifndef ECOPULSE_LAN_TELEMETRY
+#define ECOPULSE_LAN_TELEMETRY 0
+#endif
+
+// One board per site fetches the forecast and multicasts it to the others:
+// 1 = on. Build with -DECOPULSE_WEATHER_SHARE=1
+#ifndef ECOPULSE_WEATHER_SHARE
+#define ECOPULSE_WEATHER_SHARE 0
+#endif
 
 // Replace with your Wi-Fi credentials
 char ssid[] = "YourWiFiSSID";      
@@ -16,67 +36,150 @@ char pass[] = "YourWiFiPassword";
 char auth[] = BLYNK_AUTH_TOKEN;
 
 // Weather API key & location
-const String apiKey = "your-weatherapi-key";  
-const String location = "Jessore,BD";
+const char apiKey[] = "your-weatherapi-key";
+const char location[] = "Jessore,BD";
+char forecastUrl[160];  // Built once in setup()
+const char *apiFingerprint = nullptr;  // SHA-1 of the API certificate; nullptr encrypts without verifying
+WeatherServiceConnection weatherService("api.weatherapi.com");
+AsyncWeatherClient weatherClient(weatherService);
+WeatherForecast forecast;  // Hourly table, refetched every 6 h - temperature is read from it locally
+WeatherShare weatherShare;  // Fetcher election and table multicast (ECOPULSE_WEATHER_SHARE)
 
 // Hardware pins
 const int moisturePin = A0;
 const int relayPin = D1;
 
+// Moisture sampling - timer1 ticks at 50 Hz; each tick is converted in loop
+// context by poll() or, through the 1 s wait, by delaySampling()
+AdcSampler moistureSampler;
+// Probe in dry air reads 1023, in water 0; the table is built at compile time
+constexpr CalibrationTable<> moistureCalibration = CalibrationTable<>::twoPoint({ 1023, 0 }, { 0, 100 }, 0, 100);
+
 // Global values
 int soilMoisture = 0;
 float temperature = 0.0;
 bool pumpState = false;
 bool manualOverride = false;
 
+// Publish coalescer in front of Blynk.virtualWrite - V0/V1 jitter is held back by deadbands
+TelemetryPublisher<4> telemetryPublisher;
+WiFiLink wifiLink;  // Replaces the blocking WiFi wait in setup(); Blynk runs only while the link is up
+int8_t moisturePublication;     // V0
+int8_t temperaturePublication;  // V1
+int8_t pumpPublication;         // V2
+int8_t overridePublication;     // V3 - manual toggle kept in sync
+
+// 20-byte UDP frames to a collector on the local network, every 10 s while online
+TelemetryStreamer lanTelemetry;
+const unsigned long lanTelemetryInterval = 10000;
+
+void updateSoilAndPump();
+void updateTemperature();
+void refreshForecast();
+void onForecast(const WeatherFetchResult &result, const WeatherConditions &conditions);
+void publishToBlynk(uint8_t property, float value);
+void setupTelemetryPublisher();
+void onWiFiConnected();
+void sendTelemetryFrame();
+
 // Blynk virtual pin handlers
 BLYNK_WRITE(V3) {
   manualOverride = param.asInt();  // Read manual switch
   pumpState = manualOverride;
   digitalWrite(relayPin, pumpState ? HIGH : LOW);
-  Blynk.virtualWrite(V2, pumpState);  // Reflect pump state
+  telemetryPublisher.resync(overridePublication, manualOverride);  // App already shows the new toggle
+  telemetryPublisher.set(pumpPublication, pumpState);             // Reflect pump state
 }
 
 void setup() {
   Serial.begin(115200);
+  logger.begin(Serial);
   delay(1000);
 
   pinMode(moisturePin, INPUT);
   pinMode(relayPin, OUTPUT);
   digitalWrite(relayPin, LOW);
 
-  WiFi.begin(ssid, pass);
-  Serial.print("Connecting to WiFi");
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
+  AdcSamplerConfig samplerConfig;
+  samplerConfig.sampleRateHz = 50;
+  moistureSampler.begin(moisturePin, samplerConfig);
+  forecast.begin();
+  if (ECOPULSE_WEATHER_SHARE) {
+    weatherShare.begin(forecast, ESP.getChipId(), location);
+  }
+  WeatherTlsConfig tlsConfig;
+  tlsConfig.fingerprint = apiFingerprint;
+  weatherService.useTls(tlsConfig);
+  snprintf(forecastUrl, sizeof(forecastUrl), "/v1/forecast.json?key=%s&q=%s&days=2&aqi=no&alerts=no", apiKey, location);
+  setupTelemetryPublisher();
+
+  // Blynk.begin() would block until WiFi is up; the link is brought up by wifiLink.poll() instead
+  if (ECOPULSE_LAN_TELEMETRY != 2) {
+    Blynk.config(auth);
+  }
+  if (ECOPULSE_LAN_TELEMETRY) {
+    lanTelemetry.begin(ESP.getChipId());
   }
-  Serial.println("\nWiFi Connected");
+  wifiLink.onConnected(onWiFiConnected);
+  wifiLink.begin(ssid, pass);
+  LOG_INFO(LOG_NETWORK, "Connecting to WiFi");
+}
 
-  Blynk.begin(auth, ssid, pass);
+void onWiFiConnected() {
+  const WiFiLinkStats &linkStats = wifiLink.stats();
+  LOG_INFO(LOG_NETWORK, "WiFi Connected in %lu ms (%s)", linkStats.lastConnectMs,
+           linkStats.lastConnectFast ? "cached AP" : "full scan");
 
-  // Optional: Run initial temperature fetch
-  getWeatherTemperature();
+  // Fetch the forecast straight away if there is none yet
+  updateTemperature();
 }
 
 void loop() {
-  Blynk.run();
+  wifiLink.poll();
+  if (wifiLink.connected() && ECOPULSE_LAN_TELEMETRY != 2) {
+    Blynk.run();
+  }
   updateSoilAndPump();
+  weatherClient.poll();
+  if (ECOPULSE_WEATHER_SHARE) {
+    if (weatherShare.poll()) {
+      updateTemperature();
+      LOG_INFO(LOG_WEATHER, "Forecast from a peer: %u hours, %.2f°C now", forecast.stats().hours, temperature);
+    } else if (wifiLink.connected() && weatherShare.fetchDue()) {
+      refreshForecast();
+    }
+  }
+  if (ECOPULSE_LAN_TELEMETRY != 2) {
+    telemetryPublisher.poll();
+  }
+
+  static unsigned long lastFrame = 0;
+  if (ECOPULSE_LAN_TELEMETRY && millis() - lastFrame >= lanTelemetryInterval) {
+    sendTelemetryFrame();
+    lastFrame = millis();
+  }
 
   static unsigned long lastUpdate = 0;
-  if (millis() - lastUpdate > 60000) {  // Every 60 seconds
-    getWeatherTemperature();
+  if (millis() - lastUpdate > 60000) {  // Every 60 seconds, from the cached forecast
+    updateTemperature();
     lastUpdate = millis();
+
+    const PublisherStats &publishStats = telemetryPublisher.stats();
+    LOG_INFO(LOG_CLOUD, "Blynk writes: %u sent in %u windows, %u suppressed (%u duplicate, %u deadband, %u coalesced)",
+             publishStats.sent, publishStats.transmissions, publishStats.suppressed(),
+             publishStats.suppressedDuplicate, publishStats.suppressedDeadband, publishStats.coalesced);
   }
 
-  delay(1000);
+  logger.poll();
+
+  moistureSampler.delaySampling(1000);  // Conversions keep their 50 Hz pace through the wait
 }
 
 void updateSoilAndPump() {
-  int rawValue = analogRead(moisturePin);
-  soilMoisture = map(rawValue, 1023, 0, 0, 100);
-  soilMoisture = constrain(soilMoisture, 0, 100);
-  Blynk.virtualWrite(V0, soilMoisture);
+  moistureSampler.poll();
+  int rawValue = moistureSampler.value();
+  soilMoisture = moistureCalibration.convert(rawValue);
+  telemetryPublisher.set(moisturePublication, soilMoisture);
 
   // Auto pump logic only if manual override is off
   if (!manualOverride) {
@@ -86,38 +189,79 @@ void updateSoilAndPump() {
       pumpState = false;
     }
     digitalWrite(relayPin, pumpState ? HIGH : LOW);
-    Blynk.virtualWrite(V2, pumpState);
-    Blynk.virtualWrite(V3, pumpState);  // Keep manual toggle in sync
+    telemetryPublisher.set(pumpPublication, pumpState);
+    telemetryPublisher.set(overridePublication, pumpState);  // Keep manual toggle in sync
+  }
+
+  LOG_DEBUG(LOG_SENSOR, "Soil Moisture: %d%%, Pump: %s", soilMoisture, pumpState ? "ON" : "OFF");
+}
+
+void sendTelemetryFrame() {
+  TelemetrySample sample = {};
+  sample.timestamp = millis() / 1000;
+  sample.temperatureDeci = telemetryTemperature(forecast.temperatureNow());
+  sample.moisture = soilMoisture;
+  sample.flags = pumpState ? TELEMETRY_FLAG_PUMP : 0;
+  lanTelemetry.send(sample);
+}
+
+void updateTemperature() {
+  float temperatureNow = forecast.temperatureNow();
+  if (!isnan(temperatureNow)) {
+    temperature = temperatureNow;
+    telemetryPublisher.set(temperaturePublication, temperature);
+  }
+
+  if (!ECOPULSE_WEATHER_SHARE && wifiLink.connected() && forecast.refreshDue()) {
+    refreshForecast();
   }
+}
 
-  Serial.print("Soil Moisture: ");
-  Serial.print(soilMoisture);
-  Serial.print("%, Pump: ");
-  Serial.println(pumpState ? "ON" : "OFF");
+void refreshForecast() {
+  weatherClient.stream(forecastUrl, forecast.receiver(), onForecast);
 }
 
-void getWeatherTemperature() {
-  WiFiClient client;
-  HTTPClient http;
-
-  String url = "http://api.weatherapi.com/v1/current.json?key=" + apiKey + "&q=" + location + "&aqi=no";
-  http.begin(client, url);
-  int httpCode = http.GET();
-
-  if (httpCode == 200) {
-    String payload = http.getString();
-    StaticJsonDocument<1024> doc;
-    DeserializationError error = deserializeJson(doc, payload);
-    if (!error) {
-      temperature = doc["current"]["temp_c"];
-      Blynk.virtualWrite(V1, temperature);
-      Serial.println("WeatherAPI Temperature: " + String(temperature) + "°C");
-    } else {
-      Serial.println("JSON parse error");
+void onForecast(const WeatherFetchResult &result, const WeatherConditions &) {
+  if (forecast.commit(result.httpCode)) {
+    if (ECOPULSE_WEATHER_SHARE) {
+      weatherShare.publish();
     }
+    updateTemperature();
+    LOG_INFO(LOG_WEATHER, "WeatherAPI forecast: %u hours, %.2f°C now", forecast.stats().hours, temperature);
   } else {
-    Serial.print("HTTP error code: ");
-    Serial.println(httpCode);
+    LOG_WARN(LOG_WEATHER, "Forecast HTTP error code: %d", result.httpCode);
+  }
+}
+
+void setupTelemetryPublisher() {
+  PublishPolicy moisturePolicy;
+  moisturePolicy.deadband = 2;                 // ±1 % ADC jitter never reaches the app
+  moisturePolicy.minIntervalMs = 10000;
+  moisturePolicy.maxIntervalMs = 10UL * 60UL * 1000UL;
+
+  PublishPolicy temperaturePolicy;
+  temperaturePolicy.deadband = 0.2;
+  temperaturePolicy.minIntervalMs = 60000;
+  temperaturePolicy.maxIntervalMs = 30UL * 60UL * 1000UL;
+
+  PublishPolicy statePolicy;                   // Pump changes go out in the next window
+  statePolicy.maxIntervalMs = 10UL * 60UL * 1000UL;
+
+  telemetryPublisher.begin(publishToBlynk, 1000);
+  moisturePublication = telemetryPublisher.add(moisturePolicy);
+  temperaturePublication = telemetryPublisher.add(temperaturePolicy);
+  pumpPublication = telemetryPublisher.add(statePolicy);
+  overridePublication = telemetryPublisher.add(statePolicy);
+}
+
+void publishToBlynk(uint8_t property, float value) {
+  if (property == moisturePublication) {
+    Blynk.virtualWrite(V0, (int)value);
+  } else if (property == temperaturePublication) {
+    Blynk.virtualWrite(V1, value);
+  } else if (property == pumpPublication) {
+    Blynk.virtualWrite(V2, (int)value);
+  } else if (property == overridePublication) {
+    Blynk.virtualWrite(V3, (int)value);
   }
-  http.end();
 }
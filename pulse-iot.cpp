@@ -3,7 +3,27 @@
 #include <ESP8266WiFi.h>                // Native ESP8266 WiFi functions
 #include <ESP8266HTTPClient.h>          // HTTP client for REST API consumption
 #include <WiFiClient.h>
-#include <ArduinoJson.h>                // For JSON parsing of weather API response
+#include "weather-client.h"             // Streaming, filtered weather API client
+#include "weather-forecast.h"           // Hourly forecast table answering "temperature now" locally
+#include "adc-sampler.h"                // Timer-driven, filtered A0 sampling
+#include "telemetry-publisher.h"        // Deadband + rate limit in front of ON_CHANGE properties
+#include "logger.h"                     // Buffered, levelled serial logging
+#include "wifi-link.h"                  // Non-blocking association with cached fast reconnect
+#include "calibration.h"                // Compile-time fixed-point sensor conversion tables
+#include "telemetry-stream.h"           // 20-byte binary telemetry frames over LAN UDP
+#include "weather-share.h"              // One board fetches the forecast, peers take it over LAN multicast
+
+// LAN telemetry for an on-site collector: 0 = off, 1 = alongside the cloud,
+// 2 = instead of it. Build with -DECOPULSE_LAN_TELEMETRY=1
+#ifndef ECOPULSE_LAN_TELEMETRY
+#define ECOPULSE_LAN_TELEMETRY 0
+#endif
+
+// LAN weather sharing between the boards of a site: 1 = on.
+// Build with -DECOPULSE_WEATHER_SHARE=1
+#ifndef ECOPULSE_WEATHER_SHARE
+#define ECOPULSE_WEATHER_SHARE 0
+#endif
 
 // ─────────────────────────────────────
 // Device + Cloud Identity Configuration
@@ -20,8 +40,14 @@ const char PASS[] = "your-wifi-password";       // Replace with your WiFi passwo
 // ─────────────────────────────────────
 // Weather API Configuration
 // ─────────────────────────────────────
-const String apiKey = "your-weatherapi-key";   // Obtain your free API key from weatherapi.com
-const String location = "Jessore,BD";          // Target location for weather data
+const char apiKey[] = "your-weatherapi-key";   // Obtain your free API key from weatherapi.com
+const char location[] = "Jessore,BD";          // Target location for weather data
+char forecastUrl[160];                         // Request path, built once in setup() - no heap churn per refresh
+const char *apiFingerprint = nullptr;          // SHA-1 fingerprint of the API certificate (nullptr = encrypt, don't verify)
+WeatherServiceConnection weatherService("api.weatherapi.com");  // Keep-alive socket reused across polls
+AsyncWeatherClient weatherClient(weatherService);               // Request pipeline advanced from loop()
+WeatherForecast forecast;                                       // forecast.json reduced to 48 hourly entries, refreshed every 6 h
+WeatherShare weatherShare;                                      // Elected fetcher and peers on the LAN (ECOPULSE_WEATHER_SHARE)
 
 // ─────────────────────────────────────
 // Cloud-Synchronized Variables
@@ -30,18 +56,46 @@ int soil_Moisture;       // Cloud-synced soil moisture percentage (0–100%)
 bool pumpStatus;         // Reflects real-time irrigation state
 float temperature;       // Ambient temperature (°C) from cloud or API
 
+// ─────────────────────────────────────
+// Publication Coalescing (measured values → cloud variables)
+// ─────────────────────────────────────
+int moistureLevel;                    // Measured soil moisture driving the pump (0–100%)
+TelemetryPublisher<2> publisher;      // Only meaningful changes reach the cloud variables
+WiFiLink wifiLink;                    // Station association state machine, advanced from loop()
+int8_t moisturePublication;
+int8_t temperaturePublication;
+
 // ─────────────────────────────────────
 // Hardware Interface Pin Assignments
 // ─────────────────────────────────────
 const int moisturePin = A0;   // Analog pin for resistive soil moisture sensor
 const int relayPin    = D1;   // GPIO controlling the irrigation pump relay
 
+// ─────────────────────────────────────
+// Moisture Sampling (timer1 ticks at 50 Hz; delaySampling() converts each tick during the 1 s wait)
+// ─────────────────────────────────────
+AdcSampler moistureSampler;
+// Raw-to-percent table generated at compile time: probe in dry air reads 1023, in water 0
+constexpr CalibrationTable<> moistureCalibration = CalibrationTable<>::twoPoint({ 1023, 0 }, { 0, 100 }, 0, 100);
+
+// ─────────────────────────────────────
+// LAN Telemetry (ECOPULSE_LAN_TELEMETRY only)
+// ─────────────────────────────────────
+TelemetryStreamer lanTelemetry;                        // Broadcast on UDP port 47800
+const unsigned long lanTelemetryInterval = 10000;      // One frame every 10 s while the link is up
+
 // ─────────────────────────────────────
 // Forward Declaration of Cloud Event Handlers
 // ─────────────────────────────────────
 void onSoilMoistureChange();
 void onPumpStatusChange();
 void onTemperatureChange();
+void updateTemperature();
+void refreshForecast();
+void onForecast(const WeatherFetchResult &result, const WeatherConditions &conditions);
+void publishProperty(uint8_t property, float value);
+void onWiFiConnected();
+void sendTelemetryFrame();
 
 // ─────────────────────────────────────
 // Cloud Variable Registration and Setup
@@ -62,112 +116,194 @@ WiFiConnectionHandler ArduinoIoTPreferredConnection(SSID, PASS);
 // ─────────────────────────────────────
 void setup() {
   Serial.begin(115200);
+  logger.begin(Serial);
   delay(1500);  // Wait for serial console to initialize
 
   pinMode(moisturePin, INPUT);
   pinMode(relayPin, OUTPUT);
   digitalWrite(relayPin, LOW);  // Ensure pump is OFF initially
 
-  // WiFi Initialization with retry logic
-  WiFi.begin(SSID, PASS);
-  int attempts = 0;
-  Serial.print("Connecting to Wi-Fi");
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(1000);
-    Serial.print(".");
-    attempts++;
-  }
+  AdcSamplerConfig samplerConfig;
+  samplerConfig.sampleRateHz = 50;
+  moistureSampler.begin(moisturePin, samplerConfig);
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nWi-Fi connected. IP: " + WiFi.localIP().toString());
-  } else {
-    Serial.println("\nWi-Fi connection failed!");
-    return;
+  PublishPolicy moisturePolicy;
+  moisturePolicy.deadband = 2;              // Ignore ±1 % sensor jitter
+  moisturePolicy.minIntervalMs = 10000;     // At most one moisture update per 10 s
+  PublishPolicy temperaturePolicy;
+  temperaturePolicy.deadband = 0.2;
+  temperaturePolicy.minIntervalMs = 60000;
+  forecast.begin();
+  if (ECOPULSE_WEATHER_SHARE) {
+    weatherShare.begin(forecast, ESP.getChipId(), location);
   }
 
+  // HTTPS keeps the API key off the air; sessions are resumed on reconnect
+  WeatherTlsConfig tlsConfig;
+  tlsConfig.fingerprint = apiFingerprint;
+  weatherService.useTls(tlsConfig);
+  snprintf(forecastUrl, sizeof(forecastUrl), "/v1/forecast.json?key=%s&q=%s&days=2&aqi=no&alerts=no", apiKey, location);
+  publisher.begin(publishProperty);
+  moisturePublication = publisher.add(moisturePolicy);
+  temperaturePublication = publisher.add(temperaturePolicy);
+
+  // WiFi Initialization - associates and retries in the background from loop()
+  wifiLink.onConnected(onWiFiConnected);
+  wifiLink.begin(SSID, PASS);
+  LOG_INFO(LOG_NETWORK, "Connecting to Wi-Fi");
+
   initProperties();
-  ArduinoCloud.begin(ArduinoIoTPreferredConnection);
+  if (ECOPULSE_LAN_TELEMETRY) {
+    lanTelemetry.begin(ESP.getChipId());
+  }
+  if (ECOPULSE_LAN_TELEMETRY != 2) {
+    ArduinoCloud.begin(ArduinoIoTPreferredConnection);
+  }
 }
 
 // ─────────────────────────────────────
 // Main Execution Loop (Runs every ~1s)
 // ─────────────────────────────────────
 void loop() {
-  ArduinoCloud.update();
+  wifiLink.poll();
+  if (ECOPULSE_LAN_TELEMETRY != 2) {
+    ArduinoCloud.update();
+  }
 
   // ── Moisture Sensing & Conversion ──
-  int rawValue = analogRead(moisturePin);
-  soil_Moisture = map(rawValue, 1023, 0, 0, 100);  // Map dry-to-wet scale
-  soil_Moisture = constrain(soil_Moisture, 0, 100);
+  moistureSampler.poll();
+  int rawValue = moistureSampler.value();          // Oversampled, median + IIR filtered
+  moistureLevel = moistureCalibration.convert(rawValue);  // Dry-to-wet scale, 0-100 %
+  publisher.set(moisturePublication, moistureLevel);
 
   // ── Conditional Irrigation Logic ──
-  if (soil_Moisture < 30 && !pumpStatus) {
+  if (moistureLevel < 30 && !pumpStatus) {
     pumpStatus = true;
-  } else if (soil_Moisture >= 30 && pumpStatus) {
+  } else if (moistureLevel >= 30 && pumpStatus) {
     pumpStatus = false;
   }
   digitalWrite(relayPin, pumpStatus ? HIGH : LOW);
 
-  // ── Temperature Update from API (Every 60 seconds) ──
+  // ── Temperature Update from the Forecast Cache (Every 60 seconds) ──
   static unsigned long lastUpdate = 0;
   if (millis() - lastUpdate > 60000) {
-    getWeatherTemperature();  // Async HTTP JSON call
+    updateTemperature();  // Local lookup; queues a forecast refresh only when the table has aged out
     lastUpdate = millis();
+
+    const PublisherStats &stats = publisher.stats();
+    LOG_INFO(LOG_CLOUD, "Cloud publication: %u sent, %u suppressed (%u duplicate, %u deadband, %u coalesced)",
+             stats.sent, stats.suppressed(), stats.suppressedDuplicate, stats.suppressedDeadband,
+             stats.coalesced);
+  }
+
+  // ── Weather Response Progress (never waits on the socket) ──
+  weatherClient.poll();
+  if (ECOPULSE_WEATHER_SHARE) {
+    if (weatherShare.poll()) {
+      LOG_INFO(LOG_WEATHER, "Shared forecast adopted: %u hours", forecast.stats().hours);
+      updateTemperature();
+    } else if (wifiLink.connected() && weatherShare.fetchDue()) {
+      refreshForecast();   // Checked every pass so the fetcher election keeps its spacing
+    }
   }
 
-  delay(1000);
+  // ── Coalesced Publication (carried by the next ArduinoCloud.update) ──
+  publisher.poll();
+
+  // ── LAN Telemetry Frame ──
+  static unsigned long lastFrame = 0;
+  if (ECOPULSE_LAN_TELEMETRY && millis() - lastFrame >= lanTelemetryInterval) {
+    sendTelemetryFrame();
+    lastFrame = millis();
+  }
+
+  // ── Buffered Log Output (never waits on the UART) ──
+  logger.poll();
+
+  moistureSampler.delaySampling(1000);  // Conversions keep their 50 Hz pace through the wait
 }
 
 // ─────────────────────────────────────
-// RESTful Weather API Consumption Logic
+// Forecast-Backed Temperature (4 API calls a day instead of 1,440)
 // ─────────────────────────────────────
-void getWeatherTemperature() {
-  WiFiClient client;
-  HTTPClient http;
-
-  String url = "http://api.weatherapi.com/v1/current.json?key=" + apiKey + "&q=" + location + "&aqi=no";
-  Serial.println("Requesting: " + url);
+void updateTemperature() {
+  float temperatureNow = forecast.temperatureNow();  // Interpolated between forecast hours
+  if (!isnan(temperatureNow)) {
+    publisher.set(temperaturePublication, temperatureNow);
+    LOG_DEBUG(LOG_WEATHER, "Forecast temperature: %.2f", temperatureNow);
+  }
 
-  http.begin(client, url);
-  int httpCode = http.GET();
+  // With sharing, the loop asks weatherShare instead: only the elected fetcher calls the API
+  if (!ECOPULSE_WEATHER_SHARE && wifiLink.connected() && forecast.refreshDue()) {
+    refreshForecast();
+  }
+}
 
-  Serial.print("HTTP code: ");
-  Serial.println(httpCode);
+void refreshForecast() {
+  // The URL carries the API key - log the location only
+  LOG_DEBUG(LOG_WEATHER, "Refreshing forecast for %s", location);
 
-  if (httpCode == 200) {
-    String payload = http.getString();
-    Serial.println("Received JSON:");
-    Serial.println(payload);
+  // Streamed into the table as it arrives; onForecast() adopts it once complete
+  weatherClient.stream(forecastUrl, forecast.receiver(), onForecast);
+}
 
-    StaticJsonDocument<1024> doc;
-    DeserializationError error = deserializeJson(doc, payload);
+void onForecast(const WeatherFetchResult &result, const WeatherConditions &) {
+  LOG_DEBUG(LOG_WEATHER, "HTTP code: %d", result.httpCode);
 
-    if (!error) {
-      temperature = doc["current"]["temp_c"];
-      Serial.println("Parsed Temperature: " + String(temperature));
-    } else {
-      Serial.print("JSON parse error: ");
-      Serial.println(error.c_str());
+  if (forecast.commit(result.httpCode)) {
+    LOG_INFO(LOG_WEATHER, "Forecast updated: %u hours, %.2f now", forecast.stats().hours, forecast.temperatureNow());
+    if (ECOPULSE_WEATHER_SHARE) {
+      weatherShare.publish();
     }
+    updateTemperature();
   } else {
-    Serial.print("HTTP error: ");
-    Serial.println(httpCode);
+    LOG_WARN(LOG_WEATHER, "Forecast refresh failed: %d", result.httpCode);
   }
+}
 
-  http.end();
+// ─────────────────────────────────────
+// Publisher Sink (copies due values into the cloud variables)
+// ─────────────────────────────────────
+void publishProperty(uint8_t property, float value) {
+  if (property == moisturePublication) {
+    soil_Moisture = (int)value;
+  } else if (property == temperaturePublication) {
+    temperature = value;
+  }
+}
+
+// ─────────────────────────────────────
+// LAN Telemetry Frame (the measured values, not the coalesced cloud copies)
+// ─────────────────────────────────────
+void sendTelemetryFrame() {
+  TelemetrySample sample = {};
+  sample.timestamp = millis() / 1000;
+  sample.temperatureDeci = telemetryTemperature(forecast.temperatureNow());
+  sample.moisture = moistureLevel;
+  sample.flags = pumpStatus ? TELEMETRY_FLAG_PUMP : 0;
+  lanTelemetry.send(sample);
 }
 
 // ─────────────────────────────────────
 // Callback Functions (Triggered on cloud variable changes)
 // ─────────────────────────────────────
 void onSoilMoistureChange() {
-  Serial.println("Soil moisture: " + String(soil_Moisture) + "%");
+  LOG_INFO(LOG_CLOUD, "Soil moisture: %d%%", soil_Moisture);
 }
 
 void onPumpStatusChange() {
-  Serial.println(pumpStatus ? "Pump turned ON (remote)" : "Pump turned OFF (remote)");
+  LOG_INFO(LOG_ACTUATOR, "Pump turned %s (remote)", pumpStatus ? "ON" : "OFF");
 }
 
 void onTemperatureChange() {
-  Serial.println("Temp (Cloud Updated): " + String(temperature));
+  LOG_INFO(LOG_CLOUD, "Temp (Cloud Updated): %.2f", temperature);
+}
+
+// ─────────────────────────────────────
+// Link Status Reporting
+// ─────────────────────────────────────
+void onWiFiConnected() {
+  const WiFiLinkStats &stats = wifiLink.stats();
+  LOG_INFO(LOG_NETWORK, "Wi-Fi connected in %lu ms (%s). IP: %s", stats.lastConnectMs,
+           stats.lastConnectFast ? "cached AP" : "full scan", WiFi.localIP().toString().c_str());
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// CRC-Protected RTC User Memory
+// ─────────────────────────────────────
+// The ESP8266 keeps 512 bytes of RTC user memory powered through deep
+// sleep, watchdog resets and ESP.restart(), but not through a power cycle.
+// Each record owns a fixed block range and is stored with its length and a
+// CRC32, so power-on garbage or a layout change from a firmware update
+// reads back as "no state" instead of being trusted.
+//
+// Block map (4-byte blocks, 128 in total; 0-31 are left to eboot/OTA):
+const uint8_t RTC_BLOCK_DUTY_CYCLE = 32;      // DutyCycle clock and wake statistics (12 blocks)
+const uint8_t RTC_BLOCK_CONTROL_STATE = 44;   // Per-sketch control state (32 blocks)
+const uint8_t RTC_BLOCK_TELEMETRY_JOURNAL = 76; // TelemetryJournal replay cursor (4 blocks)
+const uint8_t RTC_BLOCK_WIFI_LINK = 80;       // WiFiLink association cache (10 blocks)
+const uint8_t RTC_BLOCK_TLS_SESSION = 90;     // WeatherServiceConnection TLS session (24 blocks)
+const uint8_t RTC_BLOCK_LOOP_WATCHDOG = 114;  // LoopWatchdog overrun history (14 blocks)
+const uint8_t RTC_BLOCK_COUNT = 128;
+
+// Bitwise CRC-32 (IEEE 802.3, reflected). Records are a few dozen bytes
+// and written at most a few times per second, so no table is kept in RAM.
+inline uint32_t crc32(const void *data, size_t length, uint32_t crc = 0) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  crc = ~crc;
+  while (length--) {
+    crc ^= *bytes++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+template <typename T, uint8_t FIRST_BLOCK>
+class RtcRecord {
+public:
+  // Returns false (leaving `value` untouched) when nothing valid is stored.
+  bool load(T &value) {
+    Frame frame;
+    if (!ESP.rtcUserMemoryRead(FIRST_BLOCK, (uint32_t *)&frame, sizeof(frame))) return false;
+    if (frame.length != sizeof(T) || frame.crc != checksum(frame)) return false;
+    value = frame.payload;
+    return true;
+  }
+
+  bool save(const T &value) {
+    Frame frame;
+    frame.length = sizeof(T);
+    frame.reserved = 0;
+    frame.payload = value;
+    frame.crc = checksum(frame);
+    return ESP.rtcUserMemoryWrite(FIRST_BLOCK, (uint32_t *)&frame, sizeof(frame));
+  }
+
+  // Force the next load() to fail, e.g. after a factory reset command.
+  void invalidate() {
+    uint32_t zero = 0;
+    ESP.rtcUserMemoryWrite(FIRST_BLOCK, &zero, sizeof(zero));
+  }
+
+private:
+  struct Frame {
+    uint32_t crc;
+    uint16_t length;
+    uint16_t reserved;
+    T payload;
+  };
+  static_assert(FIRST_BLOCK * 4 + sizeof(Frame) <= RTC_BLOCK_COUNT * 4, "RTC record does not fit in user memory");
+
+  static uint32_t checksum(const Frame &frame) {
+    return crc32(&frame.length, sizeof(Frame) - sizeof(frame.crc));
+  }
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// Serial Command Console
+// ─────────────────────────────────────
+// Line-oriented commands typed at the serial monitor, for diagnostics and
+// maintenance that have no cloud property:
+//
+//   > profile            dispatches to the handler registered as "profile"
+//   > profile reset      ...with arguments "reset"
+//   > help               lists the registered commands
+//
+// poll() only takes the bytes already in the UART receive buffer, so the
+// loop never waits for a line to be finished. Command names must outlive
+// the console (string literals).
+
+typedef void (*ConsoleHandler)(const char *arguments);
+
+template <uint8_t MAX_COMMANDS = 8>
+class SerialConsole {
+public:
+  static const uint8_t MAX_LINE = 64;
+
+  void begin(Stream &port) {
+    input = &port;
+    length = 0;
+  }
+
+  // Returns false when the command table is full.
+  bool add(const char *name, ConsoleHandler handler, const char *help = "") {
+    if (count >= MAX_COMMANDS) return false;
+    commands[count++] = { name, help, handler };
+    return true;
+  }
+
+  // Read what has arrived; a completed line is dispatched at once.
+  void poll() {
+    if (!input) return;
+    while (input->available() > 0) {
+      int c = input->read();
+      if (c == '\r' || c == '\n') {
+        if (length) dispatch();
+        length = 0;
+      } else if (length < MAX_LINE - 1) {
+        line[length++] = (char)c;
+      }  // Overlong lines are cut short; the command name still matches
+    }
+  }
+
+private:
+  struct Command {
+    const char *name;
+    const char *help;
+    ConsoleHandler handler;
+  };
+
+  Stream *input = nullptr;
+  Command commands[MAX_COMMANDS];
+  uint8_t count = 0;
+  char line[MAX_LINE];
+  uint8_t length = 0;
+
+  void dispatch() {
+    line[length] = '\0';
+    char *name = line;
+    while (*name == ' ') name++;
+    char *arguments = name;
+    while (*arguments && *arguments != ' ') arguments++;
+    if (*arguments) *arguments++ = '\0';
+    while (*arguments == ' ') arguments++;
+
+    for (uint8_t i = 0; i < count; i++) {
+      if (!strcmp(commands[i].name, name)) {
+        commands[i].handler(arguments);
+        return;
+      }
+    }
+    if (strcmp(name, "help")) input->printf("Unknown command '%s'\n", name);
+    for (uint8_t i = 0; i < count; i++) input->printf("  %-12s %s\n", commands[i].name, commands[i].help);
+  }
+};
@@ -0,0 +1,454 @@
+#pragma once
+
+// ─────────────────────────────────────
+// Host-side ESP8266 Arduino Core
+// ─────────────────────────────────────
+// The subset of the Arduino/ESP8266 core API the sketches use, implemented
+// on top of the simulated board in sim/sim-board.h. Together with the other
+// headers in this directory it forms the simulator side of the hardware
+// abstraction: sketches compile unchanged against either the real core or
+// this one.
+
+#define ECOPULSE_SIM 1
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "../sim-board.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PSTR(s) (s)
+#define PGM_P const char *
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+// NodeMCU pin labels mapped to ESP8266 GPIO numbers
+static const uint8_t D0 = 16;
+static const uint8_t D1 = 5;
+static const uint8_t D2 = 4;
+static const uint8_t D3 = 0;
+static const uint8_t D4 = 2;
+static const uint8_t D5 = 14;
+static const uint8_t D6 = 12;
+static const uint8_t D7 = 13;
+static const uint8_t D8 = 15;
+static const uint8_t A0 = sim::ADC_PIN;
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper *>(pstr_pointer))
+
+using std::min;
+using std::max;
+using std::isnan;
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ── String ──
+class String {
+public:
+  String() {}
+  String(const char *text) : value(text ? text : "") {}
+  String(const __FlashStringHelper *text) : value(reinterpret_cast<const char *>(text)) {}
+  String(const std::string &text) : value(text) {}
+  explicit String(char c) : value(1, c) {}
+  explicit String(int number, unsigned char base = DEC) : value(formatInteger(number, base)) {}
+  explicit String(unsigned int number, unsigned char base = DEC) : value(formatInteger(number, base)) {}
+  explicit String(long number, unsigned char base = DEC) : value(formatInteger(number, base)) {}
+  explicit String(unsigned long number, unsigned char base = DEC) : value(formatInteger(number, base)) {}
+  explicit String(float number, unsigned char decimals = 2) : value(formatFloat(number, decimals)) {}
+  explicit String(double number, unsigned char decimals = 2) : value(formatFloat(number, decimals)) {}
+
+  // Copies into the existing buffer like the core's String, so a reserve()d
+  // String takes a new value without touching the heap
+  String &operator=(const char *text) {
+    value.assign(text ? text : "");
+    return *this;
+  }
+
+  const char *c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  bool isEmpty() const { return value.empty(); }
+  void reserve(unsigned int size) { value.reserve(size); }
+  char operator[](unsigned int index) const { return index < value.size() ? value[index] : 0; }
+
+  String &operator+=(const String &rhs) { value += rhs.value; return *this; }
+  String &operator+=(const char *rhs) { value += rhs; return *this; }
+  String &operator+=(char rhs) { value += rhs; return *this; }
+  bool concat(const String &rhs) { value += rhs.value; return true; }
+
+  bool operator==(const String &rhs) const { return value == rhs.value; }
+  bool operator==(const char *rhs) const { return value == rhs; }
+  bool operator!=(const String &rhs) const { return value != rhs.value; }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = value.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String &needle, unsigned int from = 0) const {
+    size_t pos = value.find(needle.value, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  bool startsWith(const String &prefix) const { return value.rfind(prefix.value, 0) == 0; }
+  String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < value.size() && to > from ? String(value.substr(from, to - from)) : String();
+  }
+  long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(value.c_str(), nullptr); }
+  void trim() {
+    size_t start = value.find_first_not_of(" \t\r\n");
+    size_t end = value.find_last_not_of(" \t\r\n");
+    value = start == std::string::npos ? std::string() : value.substr(start, end - start + 1);
+  }
+
+  friend String operator+(String lhs, const String &rhs) { lhs.value += rhs.value; return lhs; }
+  friend String operator+(String lhs, const char *rhs) { lhs.value += rhs; return lhs; }
+  friend String operator+(String lhs, char rhs) { lhs.value += rhs; return lhs; }
+  friend String operator+(const char *lhs, const String &rhs) { return String(std::string(lhs) + rhs.value); }
+  friend String operator+(const __FlashStringHelper *lhs, const String &rhs) {
+    return String(std::string(reinterpret_cast<const char *>(lhs)) + rhs.value);
+  }
+
+private:
+  std::string value;
+
+  static std::string formatInteger(long long number, unsigned char base) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%llx" : "%lld", number);
+    return buffer;
+  }
+  static std::string formatFloat(double number, unsigned char decimals) {
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+    return buffer;
+  }
+};
+
+// ── Print / Stream ──
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t written = 0;
+    while (size--) written += write(*buffer++);
+    return written;
+  }
+  size_t write(const char *text) { return text ? write((const uint8_t *)text, strlen(text)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char *text) { return write(text); }
+  size_t print(const __FlashStringHelper *text) { return write(reinterpret_cast<const char *>(text)); }
+  size_t print(const String &text) { return write(text.c_str(), text.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned int number, int base = DEC) { return print(String(number, base)); }
+  size_t print(long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(double number, int decimals = 2) { return print(String(number, (unsigned char)decimals)); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return write(buffer, std::min<size_t>(length < 0 ? 0 : length, sizeof(buffer) - 1));
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+  size_t readBytes(char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) break;
+      buffer[count++] = (char)c;
+    }
+    return count;
+  }
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+  size_t readBytesUntil(char terminator, char *buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0 || c == terminator) break;
+      buffer[count++] = (char)c;
+    }
+    return count;
+  }
+  String readStringUntil(char terminator) {
+    std::string text;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) text += (char)c;
+    return String(text);
+  }
+
+protected:
+  unsigned long timeout = 1000;
+
+  // Like the core's Stream::timedRead(): sources whose bytes arrive over
+  // time wait for the next one (up to `timeout`) instead of giving up
+  virtual int timedRead() { return read(); }
+};
+
+// ── Serial console ──
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { sim::uartBaud = baud; }
+  size_t write(uint8_t c) override {
+    if (sim::echoSerial) fputc(c, stdout);
+    sim::uartTransmit(1);
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    if (sim::echoSerial) fwrite(buffer, 1, size, stdout);
+    sim::uartTransmit(size);
+    return size;
+  }
+  using Print::write;
+  int availableForWrite() override { return (int)(sim::uartFifoBytes - sim::uartQueued()); }
+  void flush() override {
+    if (sim::uartIdleAtMicros > sim::clockMicros) sim::advanceMicros(sim::uartIdleAtMicros - sim::clockMicros);
+  }
+  int available() override {
+    sim::deliverConsoleInput();
+    return (int)sim::serialInput.size();
+  }
+  int read() override {
+    if (sim::serialInput.empty()) return -1;
+    int c = (uint8_t)sim::serialInput[0];
+    sim::serialInput.erase(0, 1);
+    return c;
+  }
+  int peek() override { return sim::serialInput.empty() ? -1 : (uint8_t)sim::serialInput[0]; }
+  operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+// ── Timing ──
+// Both restart from zero on every boot, as on the device
+inline unsigned long millis() { return (unsigned long)(uint32_t)((sim::clockMicros - sim::bootMicros) / 1000); }
+inline unsigned long micros() { return (unsigned long)(uint32_t)(sim::clockMicros - sim::bootMicros); }
+inline void delay(unsigned long ms) { sim::advanceMicros((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { sim::advanceMicros(us); }
+inline void yield() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// ── GPIO / ADC ──
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < sim::PIN_COUNT) sim::pins[pin].mode = mode;
+}
+inline void digitalWrite(uint8_t pin, uint8_t level) { sim::recordPinWrite(pin, level ? HIGH : LOW); }
+inline int digitalRead(uint8_t pin) { return pin < sim::PIN_COUNT ? sim::pins[pin].level : LOW; }
+inline int analogRead(uint8_t pin) {
+  return pin == A0 ? sim::adcSource(pin) : 0;
+}
+
+// ── ESP ──
+// Reset cause, RTC user memory (512 bytes addressed in 4-byte blocks) and
+// the sleep/restart entry points. deepSleep() never returns: the boot ends
+// and sim-main powers up a fresh one once the sleep time has elapsed.
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+  uint32_t reason;
+  uint32_t exccause;
+  uint32_t epc1, epc2, epc3, excvaddr, depc;
+};
+
+enum RFMode { RF_DEFAULT = 0, RF_CAL = 1, RF_NO_CAL = 2, RF_DISABLED = 4 };
+#define WAKE_RF_DEFAULT RF_DEFAULT
+#define WAKE_RFCAL RF_CAL
+#define WAKE_NO_RFCAL RF_NO_CAL
+#define WAKE_RF_DISABLED RF_DISABLED
+
+class EspClass {
+public:
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size) {
+    if (!validRtcRange(offset, size)) return false;
+    memcpy(data, sim::rtcUserMemory.bytes + offset * 4, size);
+    return true;
+  }
+
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size) {
+    if (!validRtcRange(offset, size)) return false;
+    memcpy(sim::rtcUserMemory.bytes + offset * 4, data, size);
+    return true;
+  }
+
+  [[noreturn]] void deepSleep(uint64_t timeUs, RFMode = RF_DEFAULT) {
+    sim::power.deepSleeps++;
+    sim::power.sleepMicros += timeUs;
+    throw sim::ResetRequest{ REASON_DEEP_SLEEP_AWAKE, timeUs };
+  }
+  uint64_t deepSleepMax() { return 3ULL * 3600ULL * 1000000ULL; }
+
+  [[noreturn]] void restart() {
+    sim::power.restarts++;
+    throw sim::ResetRequest{ REASON_SOFT_RESTART, 0 };
+  }
+
+  // Only the modelled allocations (sim-board.h) move these
+  uint32_t getFreeHeap() { return sim::HEAP_BASELINE - sim::heapTaken; }
+  uint32_t getMaxFreeBlockSize() { return getFreeHeap(); }
+  uint8_t getHeapFragmentation() { return 0; }  // Modelled allocations come and go whole
+  void getHeapStats(uint32_t *free = nullptr, uint32_t *max = nullptr, uint8_t *frag = nullptr) {
+    if (free) *free = getFreeHeap();
+    if (max) *max = getMaxFreeBlockSize();
+    if (frag) *frag = getHeapFragmentation();
+  }
+
+  rst_info *getResetInfoPtr() {
+    resetInfo.reason = sim::power.resetReason;
+    return &resetInfo;
+  }
+
+  String getResetReason() {
+    switch (sim::power.resetReason) {
+      case REASON_DEEP_SLEEP_AWAKE: return String("Deep-Sleep Wake");
+      case REASON_SOFT_RESTART: return String("Software/System restart");
+      case REASON_WDT_RST: return String("Hardware Watchdog");
+      case REASON_SOFT_WDT_RST: return String("Software Watchdog");
+      default: return String("Power On");
+    }
+  }
+
+  uint32_t getChipId() { return 0x00C0FFEE + sim::nodeIndex; }
+
+  // CCOUNT at 80 MHz over the virtual clock, plus the host time spent since
+  // boot: waits the sketch charges to the virtual clock and the work it
+  // actually computes both show up in cycle-counted intervals. The host
+  // part runs at host speed and varies from run to run.
+  uint8_t getCpuFreqMHz() { return sim::CPU_MHZ; }
+  uint32_t getCycleCount() {
+    uint64_t hostNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - sim::hostBootTime).count();
+    return (uint32_t)((sim::clockMicros - sim::bootMicros) * sim::CPU_MHZ + hostNanos * sim::CPU_MHZ / 1000);
+  }
+
+private:
+  rst_info resetInfo = {};
+
+  static bool validRtcRange(uint32_t offset, size_t size) {
+    return size > 0 && offset * 4 + size <= sim::RTC_USER_MEMORY_SIZE;
+  }
+};
+
+inline EspClass ESP;
+
+// ── timer1 ──
+#define TIM_DIV1 0
+#define TIM_DIV16 1
+#define TIM_DIV256 3
+#define TIM_EDGE 0
+#define TIM_LEVEL 1
+#define TIM_SINGLE 0
+#define TIM_LOOP 1
+
+typedef void (*timercallback)(void);
+
+inline void timer1_isr_init() {}
+inline void timer1_attachInterrupt(timercallback isr) { sim::timer1.isr = isr; }
+inline void timer1_detachInterrupt() { sim::timer1.isr = nullptr; }
+inline void timer1_enable(uint8_t divider, uint8_t, uint8_t reload) {
+  static const uint32_t ticksPerMicro[] = { 80, 5, 5, 0 };
+  sim::timer1.ticksPerMicro = divider == TIM_DIV256 ? 0 : ticksPerMicro[divider & 3];
+  sim::timer1.reload = reload == TIM_LOOP;
+  sim::timer1.enabled = true;
+}
+inline void timer1_write(uint32_t ticks) {
+  // TIM_DIV256 runs at 312.5 kHz: 3.2 us per tick
+  sim::timer1.periodMicros = sim::timer1.ticksPerMicro ? ticks / sim::timer1.ticksPerMicro : ticks * 16 / 5;
+  if (sim::timer1.periodMicros == 0) sim::timer1.periodMicros = 1;
+  sim::timer1.nextFireMicros = sim::clockMicros + sim::timer1.periodMicros;
+}
+inline void timer1_disable() { sim::timer1.enabled = false; }
+
+inline long random(long howBig) { return howBig > 0 ? rand() % howBig : 0; }
+inline long random(long howSmall, long howBig) { return howSmall + random(howBig - howSmall); }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+
+// ── SNTP ──
+// Virtual wall clock starts at 2026-01-01 00:00:00 UTC and reports a valid
+// time once configTime() has been called and the link has been up.
+namespace sim {
+inline long timezoneOffset = 0;
+inline bool ntpConfigured = false;
+inline bool ntpSynchronized = false;
+inline time_t epochNow() { return EPOCH_BASE + (time_t)(clockMicros / 1000000); }
+}  // namespace sim
+
+inline void configTime(long gmtOffsetSec, int daylightOffsetSec, const char *, const char * = nullptr, const char * = nullptr) {
+  sim::timezoneOffset = gmtOffsetSec + daylightOffsetSec;
+  sim::ntpConfigured = true;
+}
+
+inline bool getLocalTime(struct tm *info, uint32_t = 5000) {
+  if (sim::ntpConfigured && sim::linkUp()) sim::ntpSynchronized = true;
+  if (!sim::ntpSynchronized) return false;
+  time_t local = sim::epochNow() + sim::timezoneOffset;
+  gmtime_r(&local, info);
+  return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Arduino_ConnectionHandler.h>
+#include <cmath>
+#include <map>
+#include <vector>
+
+// Host-side Arduino IoT Cloud. Every update() while the link is up sends one
+// message carrying all properties whose value changed since the last one,
+// which is what sim::cloudStats counts. Remote dashboard writes can be
+// injected by property name through sim::cloudInbox. The bookkeeping is the
+// backend's and is left out of the sketch's allocation count.
+
+enum Permission { READ = 0x01, WRITE = 0x02, READWRITE = READ | WRITE };
+
+#define ON_CHANGE -1
+
+namespace sim {
+inline std::multimap<std::string, double> cloudInbox;
+}
+
+class ArduinoIoTCloudClass {
+public:
+  void setBoardId(const char *) {}
+  void setSecretDeviceKey(const char *) {}
+
+  template <typename T>
+  void addPropertyReal(T &property, const char *name, Permission permission, long = ON_CHANGE, void (*callback)() = nullptr) {
+    Binding binding;
+    binding.name = name;
+    binding.permission = permission;
+    binding.callback = callback;
+    binding.read = [&property]() { return (double)property; };
+    binding.write = [&property](double value) { property = (T)value; };
+    binding.lastSent = std::nan("");
+    bindings.push_back(binding);
+  }
+
+  // String properties are compared by content; remote writes do not apply to them
+  void addPropertyReal(String &property, const char *name, Permission permission, long = ON_CHANGE, void (*callback)() = nullptr) {
+    Binding binding;
+    binding.name = name;
+    binding.permission = permission;
+    binding.callback = callback;
+    binding.read = []() { return 0.0; };
+    binding.write = [](double) {};
+    binding.readText = [&property]() { return std::string(property.c_str()); };
+    binding.lastSent = 0.0;
+    bindings.push_back(binding);
+  }
+
+  int begin(ConnectionHandler &, bool = true) { return 1; }
+  bool connected() { return sim::linkUp(); }
+
+  void update() {
+    sim::cloudStats.updateCalls++;
+    if (!connected()) return;
+
+    for (Binding &binding : bindings) {
+      auto pending = sim::cloudInbox.equal_range(binding.name);
+      for (auto it = pending.first; it != pending.second; ++it) {
+        if (!(binding.permission & WRITE)) continue;
+        binding.write(it->second);
+        binding.lastSent = binding.read();
+        if (binding.callback) binding.callback();
+      }
+      sim::cloudInbox.erase(pending.first, pending.second);
+    }
+
+    sim::SimAllocations backend;
+    uint32_t changed = 0;
+    for (Binding &binding : bindings) {
+      if (binding.readText) {
+        std::string text = binding.readText();
+        if (text != binding.lastText) {
+          binding.lastText = text;
+          sim::cloudStats.textBytes += text.size();
+          changed++;
+        }
+        continue;
+      }
+      // Like the library's delta check, a missing (NaN) reading that stays missing is not a change
+      double value = binding.read();
+      if (value != binding.lastSent && !(std::isnan(value) && std::isnan(binding.lastSent))) {
+        binding.lastSent = value;
+        changed++;
+      }
+    }
+    if (changed) {
+      sim::cloudStats.messagesSent++;
+      sim::cloudStats.propertyUpdates += changed;
+    }
+  }
+
+private:
+  struct Binding {
+    std::string name;
+    Permission permission;
+    void (*callback)();
+    std::function<double()> read;
+    std::function<void(double)> write;
+    std::function<std::string()> readText;
+    double lastSent;
+    std::string lastText;
+  };
+  std::vector<Binding> bindings;
+};
+
+// Mirrors the library's name-capturing registration macro
+#define addProperty(property, ...) addPropertyReal(property, #property, __VA_ARGS__)
+
+inline ArduinoIoTCloudClass ArduinoCloud;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+
+// Host-side connection handlers; the link itself is modelled by the
+// simulated WiFi in ESP8266WiFi.h.
+
+class ConnectionHandler {
+public:
+  virtual ~ConnectionHandler() {}
+};
+
+class WiFiConnectionHandler : public ConnectionHandler {
+public:
+  WiFiConnectionHandler(const char *ssid, const char *pass) : ssid(ssid), pass(pass) {}
+
+  const char *ssid;
+  const char *pass;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <map>
+
+// Host-side Blynk. virtualWrite() calls are counted as transmitted messages
+// and the latest value per virtual pin is kept; app-side writes can be
+// injected through sim::blynkInbox and are dispatched from run(). Neither
+// counts towards the sketch's allocations.
+
+namespace sim {
+struct BlynkStats {
+  uint32_t runCalls = 0;
+  uint32_t virtualWrites = 0;
+};
+inline BlynkStats &blynkStats = persistent<BlynkStats>();
+inline std::map<int, double> blynkPins;
+inline std::multimap<int, double> blynkInbox;
+}  // namespace sim
+
+class BlynkParam {
+public:
+  explicit BlynkParam(double value) : value(value) {}
+  int asInt() const { return (int)value; }
+  float asFloat() const { return (float)value; }
+  double asDouble() const { return value; }
+
+private:
+  double value;
+};
+
+typedef void (*BlynkWriteHandler)(const BlynkParam &param);
+
+namespace sim {
+inline std::map<int, BlynkWriteHandler> &blynkHandlers() {
+  static std::map<int, BlynkWriteHandler> handlers;
+  return handlers;
+}
+}  // namespace sim
+
+struct BlynkWriteRegistrar {
+  BlynkWriteRegistrar(int pin, BlynkWriteHandler handler) { sim::blynkHandlers()[pin] = handler; }
+};
+
+#define BLYNK_WRITE(pin)                                                          \
+  static void BlynkWidgetWrite_##pin(const BlynkParam &param);                    \
+  static BlynkWriteRegistrar BlynkWidgetRegistrar_##pin(pin, BlynkWidgetWrite_##pin); \
+  static void BlynkWidgetWrite_##pin(const BlynkParam &param)
+
+#define V0 0
+#define V1 1
+#define V2 2
+#define V3 3
+#define V4 4
+#define V5 5
+#define V6 6
+#define V7 7
+#define V8 8
+#define V9 9
+#define V10 10
+
+class BlynkSim {
+public:
+  void config(const char *) {}
+  bool connect(unsigned long = 0) { return connected(); }
+  void begin(const char *auth, const char *ssid, const char *pass) {
+    config(auth);
+    if (WiFi.status() != WL_CONNECTED) {
+      WiFi.begin(ssid, pass);
+      while (WiFi.status() != WL_CONNECTED) delay(100);
+    }
+  }
+  bool connected() { return sim::linkUp(); }
+
+  void run() {
+    sim::blynkStats.runCalls++;
+    if (!connected()) return;
+    for (auto &pending : sim::blynkInbox) {
+      auto handler = sim::blynkHandlers().find(pending.first);
+      if (handler != sim::blynkHandlers().end()) handler->second(BlynkParam(pending.second));
+    }
+    sim::blynkInbox.clear();
+  }
+
+  template <typename T>
+  void virtualWrite(int pin, const T &value) {
+    if (!connected()) return;
+    sim::SimAllocations backend;
+    sim::blynkStats.virtualWrites++;
+    sim::blynkPins[pin] = (double)value;
+  }
+};
+
+inline BlynkSim Blynk;
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <WiFiClient.h>
+
+// Host-side ESP8266HTTPClient. Requests never leave the process: they are
+// answered by sim::serveHttp(), whose default route stands in for
+// api.weatherapi.com. The TCP client passed to begin() still goes through
+// its connect/keep-alive lifecycle so connection reuse is observable.
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+typedef enum {
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_NO_CONTENT = 204,
+  HTTP_CODE_BAD_REQUEST = 400,
+  HTTP_CODE_UNAUTHORIZED = 401,
+  HTTP_CODE_FORBIDDEN = 403,
+  HTTP_CODE_NOT_FOUND = 404,
+  HTTP_CODE_INTERNAL_SERVER_ERROR = 500
+} t_http_codes;
+
+namespace sim {
+
+// Read-only Stream over an in-memory response body
+class MemoryStream : public Stream {
+public:
+  void assign(const std::string &data) {
+    body = data;
+    position = 0;
+  }
+  int available() override { return (int)(body.size() - position); }
+  int read() override { return position < body.size() ? (uint8_t)body[position++] : -1; }
+  int peek() override { return position < body.size() ? (uint8_t)body[position] : -1; }
+  size_t write(uint8_t) override { return 0; }
+  using Print::write;
+
+private:
+  std::string body;
+  size_t position = 0;
+};
+
+}  // namespace sim
+
+class HTTPClient {
+public:
+  bool begin(WiFiClient &client, const String &url) {
+    std::string text = url.c_str();
+    size_t schemeEnd = text.find("://");
+    if (schemeEnd == std::string::npos) return false;
+    std::string rest = text.substr(schemeEnd + 3);
+    size_t pathStart = rest.find('/');
+    std::string hostPort = rest.substr(0, pathStart);
+    std::string path = pathStart == std::string::npos ? "/" : rest.substr(pathStart);
+    size_t colon = hostPort.find(':');
+    uint16_t port = text.rfind("https", 0) == 0 ? 443 : 80;
+    if (colon != std::string::npos) {
+      port = (uint16_t)atoi(hostPort.c_str() + colon + 1);
+      hostPort = hostPort.substr(0, colon);
+    }
+    return begin(client, String(hostPort), port, String(path));
+  }
+
+  bool begin(WiFiClient &client, const String &hostName, uint16_t portNumber, const String &uri = "/", bool = false) {
+    tcp = &client;
+    host = hostName.c_str();
+    port = portNumber;
+    path = uri.c_str();
+    return true;
+  }
+
+  void end() {
+    if (tcp && !(reuse && canReuse)) tcp->stop();
+    canReuse = false;
+  }
+
+  void setReuse(bool enabled) { reuse = enabled; }
+  void useHTTP10(bool enabled) { http10 = enabled; if (enabled) reuse = false; }
+  void setTimeout(uint16_t timeoutMs) { timeout = timeoutMs; }
+  void addHeader(const String &, const String &, bool = false, bool = true) {}
+  bool connected() { return tcp && tcp->connected(); }
+
+  int GET() { return sendRequest("GET"); }
+  int POST(const String &payload) { return sendRequest("POST", (const uint8_t *)payload.c_str(), payload.length()); }
+  int POST(const uint8_t *payload, size_t size) { return sendRequest("POST", payload, size); }
+
+  int sendRequest(const char *, const uint8_t * = nullptr, size_t size = 0) {
+    if (!tcp) return HTTPC_ERROR_CONNECTION_REFUSED;
+    if (!tcp->connected() && !tcp->connect(host.c_str(), port)) {
+      return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    sim::advanceMicros(size / 8);  // ~64 kbit/s uplink for request bodies
+    sim::HttpExchange exchange = sim::serveHttp(host, path);
+    if (exchange.status < 0) {
+      tcp->stop();
+      return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    response.assign(exchange.body);
+    responseSize = (int)exchange.body.size();
+    canReuse = reuse && !http10;
+    return exchange.status;
+  }
+
+  int getSize() { return responseSize; }
+  Stream &getStream() { return response; }
+  WiFiClient *getStreamPtr() { return tcp; }
+
+  String getString() {
+    std::string body;
+    int c;
+    while ((c = response.read()) >= 0) body += (char)c;
+    return String(body);
+  }
+
+  static String errorToString(int error) { return String("HTTP error ") + String(error); }
+
+private:
+  WiFiClient *tcp = nullptr;
+  std::string host;
+  std::string path;
+  uint16_t port = 80;
+  bool reuse = true;
+  bool canReuse = false;
+  bool http10 = false;
+  uint16_t timeout = 5000;
+  int responseSize = -1;
+  sim::MemoryStream response;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Host-side ESP8266WiFi: station-mode association against the simulated
+// access point in sim-board.h. begin() starts association, which completes
+// after scan + authentication + DHCP time if the AP is reachable. A
+// channel/BSSID hint skips the scan (and fails if the AP is no longer
+// there), a static config() skips DHCP. Outages drop the link until the
+// sketch reconnects.
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+
+class IPAddress {
+public:
+  IPAddress() : address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+  IPAddress(uint32_t raw) : address(raw) {}
+
+  operator uint32_t() const { return address; }
+  uint8_t operator[](int index) const { return (address >> (8 * index)) & 0xFF; }
+  bool isSet() const { return address != 0; }
+
+  bool fromString(const char *text) {
+    unsigned a, b, c, d;
+    if (sscanf(text, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(text);
+  }
+
+private:
+  uint32_t address;
+};
+
+class ESP8266WiFiClass {
+public:
+  wl_status_t begin(const char *, const char * = nullptr, int32_t channel = 0, const uint8_t *bssid = nullptr,
+                    bool connect = true) {
+    hintChannel = channel;
+    hintBssid = bssid != nullptr;
+    if (bssid) memcpy(hintedBssid, bssid, sizeof(hintedBssid));
+    if (connect) startAssociation();
+    return status();
+  }
+  bool reconnect() {
+    startAssociation();
+    return true;
+  }
+  bool disconnect(bool = false) {
+    sim::network.associating = false;
+    sim::network.associated = false;
+    sim::network.associationFailed = false;
+    return true;
+  }
+
+  // All-zero addresses switch back to DHCP, as on the device
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+              IPAddress = IPAddress()) {
+    staticAddress = local;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDns = dns1;
+    return true;
+  }
+
+  wl_status_t status() {
+    if (sim::linkUp()) return WL_CONNECTED;
+    if (sim::network.associationFailed) return WL_NO_SSID_AVAIL;
+    return sim::network.associating ? WL_DISCONNECTED : WL_CONNECTION_LOST;
+  }
+  bool isConnected() { return status() == WL_CONNECTED; }
+
+  bool mode(WiFiMode_t) { return true; }
+  bool persistent(bool) { return true; }
+  bool setAutoReconnect(bool) { return true; }
+
+  IPAddress localIP() {
+    if (!isConnected()) return IPAddress();
+    return staticAddress.isSet() ? staticAddress : IPAddress(192, 168, 1, 50);
+  }
+  IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+  IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+  IPAddress dnsIP(uint8_t = 0) { return IPAddress(192, 168, 1, 1); }
+  uint8_t *BSSID() { return isConnected() ? sim::network.apBssid : nullptr; }
+  int32_t channel() { return isConnected() ? sim::accessPointChannel() : 0; }
+  int32_t RSSI() { return isConnected() ? -61 : 31; }
+  String macAddress() { return String("5C:CF:7F:00:00:01"); }
+
+  int hostByName(const char *, IPAddress &result) {
+    if (!isConnected()) return 0;
+    sim::advanceMicros(sim::network.dnsMicros);
+    result = IPAddress(203, 0, 113, 10);  // TEST-NET-3 address for the stand-in API host
+    return 1;
+  }
+
+private:
+  int32_t hintChannel = 0;
+  bool hintBssid = false;
+  uint8_t hintedBssid[6] = {};
+  IPAddress staticAddress;
+  IPAddress staticGateway;
+  IPAddress staticSubnet;
+  IPAddress staticDns;
+
+  bool hintMatches() {
+    return hintChannel == sim::accessPointChannel() &&
+           (!hintBssid || !memcmp(hintedBssid, sim::network.apBssid, sizeof(hintedBssid)));
+  }
+
+  void startAssociation() {
+    sim::linkStats.associationAttempts++;
+    if (hintChannel) sim::linkStats.hintedAttempts++;
+    sim::network.associated = false;
+    sim::network.associationFailed = false;
+    sim::network.hintMismatch = hintChannel && !hintMatches();
+    sim::network.associating = true;
+    sim::network.associationStartedAt = sim::clockMicros;
+    uint64_t duration = sim::network.authMicros;
+    if (!hintChannel) duration += sim::network.scanMicros;
+    if (!staticAddress.isSet()) duration += sim::network.dhcpMicros;
+    sim::network.associatedAt = sim::clockMicros + duration;
+  }
+};
+
+inline ESP8266WiFiClass WiFi;
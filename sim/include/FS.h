@@ -0,0 +1,204 @@
+#pragma once
+
+#include <Arduino.h>
+#include <filesystem>
+#include <memory>
+
+// Host-side ESP8266 filesystem API (File, Dir, FSInfo) over a directory on
+// the host, so files survive simulated resets like flash does. Writes are
+// charged program time on the virtual clock and counted in sim::flashStats.
+// What the host side allocates is not the sketch's; the handle and cache
+// LittleFS mallocs for each open file are counted instead.
+
+namespace sim {
+struct FlashStats {
+  uint32_t writeCalls = 0;
+  uint64_t bytesWritten = 0;
+  uint64_t bytesRead = 0;
+  uint32_t filesRemoved = 0;
+};
+inline FlashStats &flashStats = persistent<FlashStats>();
+inline std::string flashDirectory;                  // Host directory backing the filesystem
+inline uint64_t flashProgramMicrosPerPage = 600;    // 256-byte page program incl. metadata commit
+inline size_t flashCapacityBytes = 1024 * 1024;     // "FS: 1MB" flash layout
+}  // namespace sim
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class File : public Stream {
+public:
+  File() {}
+  File(FILE *handle, const std::string &fileName) : file(handle, fclose), path(fileName) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    if (!file) return 0;
+    size_t written = fwrite(buffer, 1, size, file.get());
+    fflush(file.get());
+    sim::flashStats.writeCalls++;
+    sim::flashStats.bytesWritten += written;
+    sim::advanceMicros(((written + 255) / 256 + 1) * sim::flashProgramMicrosPerPage);
+    return written;
+  }
+  using Print::write;
+
+  int available() override { return file ? (int)(size() - position()) : 0; }
+  int read() override {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t read(uint8_t *buffer, size_t size) {
+    if (!file) return 0;
+    size_t count = fread(buffer, 1, size, file.get());
+    sim::flashStats.bytesRead += count;
+    return count;
+  }
+  int peek() override {
+    if (!file) return -1;
+    int c = fgetc(file.get());
+    if (c >= 0) ungetc(c, file.get());
+    return c;
+  }
+
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+    return file && fseek(file.get(), (long)pos, mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END) == 0;
+  }
+  size_t position() const { return file ? (size_t)ftell(file.get()) : 0; }
+  size_t size() const {
+    if (!file) return 0;
+    long here = ftell(file.get());
+    fseek(file.get(), 0, SEEK_END);
+    long end = ftell(file.get());
+    fseek(file.get(), here, SEEK_SET);
+    return (size_t)end;
+  }
+  void close() { file.reset(); }
+  const char *name() const { return path.c_str(); }
+  operator bool() const { return (bool)file; }
+
+private:
+  std::shared_ptr<FILE> file;
+  std::string path;
+};
+
+class Dir {
+public:
+  Dir() {}
+  explicit Dir(const std::string &hostPath) {
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(hostPath, error)) {
+      entries.push_back(entry.path().filename().string());
+    }
+  }
+  bool next() { return ++index < (int)entries.size(); }
+  String fileName() const { return String(entries[index].c_str()); }
+
+private:
+  std::vector<std::string> entries;
+  int index = -1;
+};
+
+class FS {
+public:
+  bool begin() {
+    if (sim::flashDirectory.empty()) return false;
+    sim::SimAllocations host;
+    std::error_code error;
+    std::filesystem::create_directories(sim::flashDirectory, error);
+    return !error;
+  }
+  void end() {}
+
+  bool format() {
+    sim::SimAllocations host;
+    std::error_code error;
+    std::filesystem::remove_all(sim::flashDirectory, error);
+    return begin();
+  }
+
+  File open(const char *path, const char *mode) {
+    File file;
+    {
+      sim::SimAllocations host;
+      std::string mapped = hostPath(path);
+      FILE *handle = fopen(mapped.c_str(), !strcmp(mode, "r") ? "rb" : !strcmp(mode, "w") ? "wb" :
+                                           !strcmp(mode, "a") ? "ab" : !strcmp(mode, "r+") ? "r+b" : "a+b");
+      if (!handle) return file;
+      file = File(handle, path);
+    }
+    sim::noteFileHandle();  // lfs_file_t and its cache page, freed on close
+    return file;
+  }
+  File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+
+  bool exists(const char *path) {
+    sim::SimAllocations host;
+    return std::filesystem::exists(hostPath(path));
+  }
+  bool mkdir(const char *path) {
+    sim::SimAllocations host;
+    std::error_code error;
+    std::filesystem::create_directories(hostPath(path), error);
+    return !error;
+  }
+  bool remove(const char *path) {
+    sim::SimAllocations host;
+    std::error_code error;
+    bool removed = std::filesystem::remove(hostPath(path), error);
+    if (removed) sim::flashStats.filesRemoved++;
+    return removed;
+  }
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *from, const char *to) {
+    sim::SimAllocations host;
+    std::error_code error;
+    std::filesystem::rename(hostPath(from), hostPath(to), error);
+    return !error;
+  }
+  Dir openDir(const char *path) {
+    sim::SimAllocations host;
+    return Dir(hostPath(path));
+  }
+
+  bool info(FSInfo &info) {
+    info.totalBytes = sim::flashCapacityBytes;
+    info.usedBytes = 0;
+    sim::SimAllocations host;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(sim::flashDirectory, error)) {
+      if (entry.is_regular_file()) info.usedBytes += (entry.file_size() + 4095) / 4096 * 4096;
+    }
+    info.blockSize = 8192;
+    info.pageSize = 256;
+    info.maxOpenFiles = 5;
+    info.maxPathLength = 32;
+    return true;
+  }
+
+private:
+  static std::string hostPath(const char *path) {
+    return sim::flashDirectory + (path[0] == '/' ? "" : "/") + path;
+  }
+};
+
+}  // namespace fs
+
+using fs::Dir;
+using fs::File;
+using fs::FS;
+using fs::FSInfo;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekMode;
+using fs::SeekSet;
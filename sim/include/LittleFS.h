@@ -0,0 +1,7 @@
+#pragma once
+
+#include <FS.h>
+
+// Host-side LittleFS: the filesystem object the ESP8266 core exports,
+// rooted at sim::flashDirectory.
+inline fs::FS LittleFS;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Ticker on the simulated os_timer slots in sim-board.h. Callbacks run
+// from the virtual clock at the next wait after their deadline, as the
+// SDK's timer task does on the device.
+class Ticker {
+public:
+  typedef void (*callback_function_t)();
+
+  ~Ticker() { detach(); }
+
+  void attach(float seconds, callback_function_t callback) { arm((uint64_t)(seconds * 1e6), true, callback); }
+  void attach_ms(uint32_t milliseconds, callback_function_t callback) {
+    arm((uint64_t)milliseconds * 1000, true, callback);
+  }
+  void once_ms(uint32_t milliseconds, callback_function_t callback) {
+    arm((uint64_t)milliseconds * 1000, false, callback);
+  }
+
+  template <typename TArg>
+  void attach_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) {
+    arm((uint64_t)milliseconds * 1000, true, [callback, arg]() { callback(arg); });
+  }
+  template <typename TArg>
+  void once_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) {
+    arm((uint64_t)milliseconds * 1000, false, [callback, arg]() { callback(arg); });
+  }
+
+  void detach() {
+    if (slot < 0) return;
+    sim::softwareTimers[slot] = sim::SoftwareTimer();
+    slot = -1;
+  }
+
+  bool active() const { return slot >= 0 && sim::softwareTimers[slot].armed; }
+
+private:
+  int slot = -1;
+
+  void arm(uint64_t periodMicros, bool repeat, std::function<void()> callback) {
+    detach();
+    for (int i = 0; i < sim::SOFTWARE_TIMER_SLOTS; i++) {
+      if (sim::softwareTimers[i].allocated) continue;
+      sim::SoftwareTimer &timer = sim::softwareTimers[i];
+      timer.callback = callback;
+      timer.periodMicros = std::max<uint64_t>(periodMicros, 1000);  // os_timer resolution is 1 ms
+      timer.nextFireMicros = sim::clockMicros + timer.periodMicros;
+      timer.repeat = repeat;
+      timer.allocated = true;
+      timer.armed = true;
+      slot = i;
+      return;
+    }
+    fprintf(stderr, "sim: out of software timers\n");
+    abort();
+  }
+};
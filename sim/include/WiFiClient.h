@@ -0,0 +1,231 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <linux/sockios.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+
+// Host-side TCP client. A connected socket talks to the in-process HTTP
+// stand-in: a complete request written to it is answered through
+// sim::routeHttp() with an HTTP/1.1 keep-alive response, which the sketch
+// then reads back. The stand-in closes sockets left idle for longer than
+// sim::network.serverIdleTimeoutMicros, like a real front end would.
+//
+// Responses arrive over virtual time: nothing is available() until the
+// route's latency has passed, and with sim::httpBytesPerSecond set the
+// bytes trickle in at that rate. A polling reader sees them as they land;
+// a blocking reader (readBytes() and friends) waits for them, and that
+// wait is charged to the clock, as on the device.
+//
+// A client returned by WiFiServer::accept() is a real socket instead, with
+// a peer on the host. Copies share the connection, which closes when the
+// last copy goes or on stop(), like the core's reference-counted client.
+// Writes never block: availableForWrite() reports the room left in a send
+// window the size of lwIP's TCP_SND_BUF, and write() takes no more.
+namespace sim {
+struct AcceptedSocket {
+  static const size_t SEND_WINDOW = 2 * 1460;   // TCP_SND_BUF of the lwIP build
+
+  int fd;
+  explicit AcceptedSocket(int socketFd) : fd(socketFd) {}
+  ~AcceptedSocket() { close(fd); }
+  AcceptedSocket(const AcceptedSocket &) = delete;
+  AcceptedSocket &operator=(const AcceptedSocket &) = delete;
+
+  int sendRoom() const {
+    int queued = 0;
+    if (ioctl(fd, SIOCOUTQ, &queued) < 0) return 0;
+    return queued >= (int)SEND_WINDOW ? 0 : (int)SEND_WINDOW - queued;
+  }
+};
+}  // namespace sim
+
+class WiFiClient : public Stream {
+public:
+  WiFiClient() {}
+  explicit WiFiClient(int acceptedFd) : accepted(std::make_shared<sim::AcceptedSocket>(acceptedFd)) {
+    open = true;
+  }
+  virtual ~WiFiClient() {}
+
+  virtual int connect(const char *host, uint16_t port) {
+    IPAddress address;
+    if (!WiFi.hostByName(host, address)) return 0;
+    return connect(address, port);
+  }
+  virtual int connect(IPAddress, uint16_t) {
+    if (!sim::linkUp()) return 0;
+    sim::advanceMicros(sim::network.tcpHandshakeMicros);
+    sim::linkStats.tcpHandshakes++;
+    open = true;
+    request.clear();
+    response.clear();
+    responseOffset = 0;
+    responseBase = 0;
+    lastActivity = sim::clockMicros;
+    return 1;
+  }
+  virtual uint8_t connected() {
+    if (accepted) return socketConnected() || available() > 0;
+    if (open && (!sim::linkUp() || sim::clockMicros - lastActivity > sim::network.serverIdleTimeoutMicros)) {
+      open = false;
+    }
+    return open || available() > 0;
+  }
+  virtual void stop() {
+    accepted.reset();
+    open = false;
+    response.clear();
+    responseOffset = 0;
+    responseBase = 0;
+  }
+  // Drops the connection at once with a reset, discarding unsent data
+  void abort() {
+    if (accepted) {
+      linger reset = { 1, 0 };
+      setsockopt(accepted->fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    }
+    stop();
+  }
+  operator bool() { return connected(); }
+
+  void setNoDelay(bool) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    if (accepted) return socketWrite(buffer, size);
+    if (!connected()) return 0;
+    sim::SimAllocations remote;  // Request buffering and the answer belong to the far end
+    request.append((const char *)buffer, size);
+    size_t end = request.find("\r\n\r\n");
+    if (end != std::string::npos) {
+      respond(request.substr(0, end));
+      request.erase(0, end + 4);
+    }
+    lastActivity = sim::clockMicros;
+    return size;
+  }
+  using Print::write;
+
+  int availableForWrite() override {
+    if (accepted) return socketConnected() && sim::linkUp() ? accepted->sendRoom() : 0;
+    return connected() ? 1460 : 0;
+  }
+
+  int available() override {
+    if (accepted) {
+      int queued = 0;
+      return ioctl(accepted->fd, FIONREAD, &queued) < 0 ? 0 : queued;
+    }
+    return (int)(arrived() - responseOffset);
+  }
+  int read() override {
+    if (accepted) {
+      uint8_t c;
+      return read(&c, 1) == 1 ? c : -1;
+    }
+    if (responseOffset >= arrived()) return -1;
+    lastActivity = sim::clockMicros;
+    return (uint8_t)response[responseOffset++];
+  }
+  int read(uint8_t *buffer, size_t size) {
+    if (!accepted) return (int)readBytes(buffer, std::min(size, (size_t)std::max(available(), 0)));
+    ssize_t count = recv(accepted->fd, buffer, size, MSG_DONTWAIT);
+    return count > 0 ? (int)count : 0;
+  }
+  int peek() override {
+    if (accepted) {
+      uint8_t c;
+      return recv(accepted->fd, &c, 1, MSG_DONTWAIT | MSG_PEEK) == 1 ? c : -1;
+    }
+    return responseOffset < arrived() ? (uint8_t)response[responseOffset] : -1;
+  }
+
+protected:
+  std::shared_ptr<sim::AcceptedSocket> accepted;
+  bool open = false;
+  std::string request;
+  std::string response;
+  size_t responseOffset = 0;
+  size_t responseBase = 0;        // Offset of the latest response's first byte
+  uint64_t firstByteAt = 0;       // Virtual time that byte lands
+  uint64_t lastActivity = 0;
+
+  // Arrival time of the byte at `offset` of the latest response
+  uint64_t arrivalAt(size_t offset) const {
+    if (offset < responseBase) return 0;
+    uint64_t spread = sim::httpBytesPerSecond ? (uint64_t)(offset - responseBase) * 1000000 / sim::httpBytesPerSecond : 0;
+    return firstByteAt + spread;
+  }
+
+  size_t arrived() const {
+    if (responseOffset >= response.size() || arrivalAt(responseOffset) > sim::clockMicros) return responseOffset;
+    if (arrivalAt(response.size() - 1) <= sim::clockMicros) return response.size();
+    size_t landed = responseBase + (size_t)((sim::clockMicros - firstByteAt) * sim::httpBytesPerSecond / 1000000) + 1;
+    return std::min(landed, response.size());
+  }
+
+  // The peer has not closed its side; a reset or FIN ends the connection
+  bool socketConnected() {
+    if (!open) return false;
+    uint8_t c;
+    ssize_t peeked = recv(accepted->fd, &c, 1, MSG_DONTWAIT | MSG_PEEK);
+    if (peeked == 0 || (peeked < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) open = false;
+    return open;
+  }
+
+  size_t socketWrite(const uint8_t *buffer, size_t size) {
+    if (!sim::linkUp() || !socketConnected()) return 0;
+    size = std::min(size, (size_t)accepted->sendRoom());
+    if (!size) {
+      sim::serverStats.refusedWrites++;
+      return 0;
+    }
+    ssize_t sent = send(accepted->fd, buffer, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent <= 0) return 0;
+    sim::serverStats.bytesSent += sent;
+    return (size_t)sent;
+  }
+
+  int timedRead() override {
+    if (responseOffset < response.size() && arrivalAt(responseOffset) > sim::clockMicros) {
+      uint64_t waitMicros = arrivalAt(responseOffset) - sim::clockMicros;
+      if (waitMicros > (uint64_t)timeout * 1000) {
+        sim::advanceMicros((uint64_t)timeout * 1000);
+        return -1;
+      }
+      sim::advanceMicros(waitMicros);
+    }
+    return read();
+  }
+
+  void respond(const std::string &head) {
+    size_t pathStart = head.find(' ');
+    size_t pathEnd = head.find(' ', pathStart + 1);
+    std::string path = head.substr(pathStart + 1, pathEnd - pathStart - 1);
+    std::string host;
+    size_t hostHeader = head.find("\r\nHost: ");
+    if (hostHeader != std::string::npos) {
+      size_t hostEnd = head.find("\r\n", hostHeader + 8);
+      host = head.substr(hostHeader + 8, hostEnd - hostHeader - 8);
+    }
+
+    sim::HttpExchange exchange = sim::routeHttp(host, path);
+    if (exchange.status < 0) {
+      open = false;
+      return;
+    }
+    char statusLine[96];
+    snprintf(statusLine, sizeof(statusLine), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+             exchange.status, exchange.status == 200 ? "OK" : "Error", exchange.body.size());
+    response.erase(0, responseOffset);
+    responseOffset = 0;
+    responseBase = response.size();
+    firstByteAt = sim::clockMicros + exchange.latencyMicros;
+    response += statusLine;
+    response += exchange.body;
+  }
+};
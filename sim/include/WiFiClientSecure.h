@@ -0,0 +1,141 @@
+#pragma once
+
+#include <WiFiClient.h>
+
+// Host-side BearSSL client against the TLS stand-in in sim-board.h. The
+// socket underneath is the plain simulated WiFiClient; connect() adds the
+// handshake cost and holds the modelled BearSSL heap (engine context plus
+// I/O buffers sized by setBufferSizes()) until stop(). Sessions carry an
+// identifier the stand-in recognises for resumption, in the same bytes a
+// br_ssl_session_parameters would occupy.
+namespace BearSSL {
+
+class Session {
+public:
+  Session() { memset(this, 0, sizeof(*this)); }
+
+private:
+  // Layout of br_ssl_session_parameters
+  uint8_t sessionId[32];
+  uint8_t sessionIdLength;
+  uint16_t version;
+  uint16_t cipherSuite;
+  uint8_t masterSecret[48];
+
+  uint64_t id() const {
+    uint64_t value = 0;
+    if (sessionIdLength) memcpy(&value, sessionId, sizeof(value));
+    return value;
+  }
+
+  void assign(uint64_t value) {
+    memset(sessionId, 0, sizeof(sessionId));
+    memcpy(sessionId, &value, sizeof(value));
+    sessionIdLength = sizeof(sessionId);
+    version = 0x0303;        // TLS 1.2
+    cipherSuite = 0xC02F;    // ECDHE-RSA-AES128-GCM-SHA256
+    for (uint8_t i = 0; i < sizeof(masterSecret); i++) masterSecret[i] = (uint8_t)(value * 31 + i);
+  }
+
+  friend class WiFiClientSecure;
+};
+
+class X509List {
+public:
+  explicit X509List(const char *) {}
+};
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  // Engine context, x509 state and the handshake's hashing, beside the I/O buffers
+  static const uint32_t CONTEXT_HEAP = 3900;
+  static const uint32_t STACK_THUNK_HEAP = 4500;   // BearSSL's separate stack, held while any client exists
+  static const int MAX_IN_OVERHEAD = 325;
+  static const int MAX_OUT_OVERHEAD = 85;
+
+  WiFiClientSecure() { sim::heapAllocate(STACK_THUNK_HEAP); }
+  ~WiFiClientSecure() override {
+    releaseBuffers();
+    sim::heapRelease(STACK_THUNK_HEAP);
+  }
+
+  void setInsecure() {}
+  bool setFingerprint(const char *) { return true; }
+  void setTrustAnchors(const X509List *) {}
+  void setSession(Session *resumable) { session = resumable; }
+
+  void setBufferSizes(int recv, int xmit) {
+    recv = std::max(512, std::min(16384, recv));
+    xmit = std::max(512, std::min(16384, xmit));
+    receiveBuffer = recv + MAX_IN_OVERHEAD;
+    transmitBuffer = xmit + MAX_OUT_OVERHEAD;
+  }
+
+  // One ClientHello with the extension on a throwaway socket
+  static bool probeMaxFragmentLength(IPAddress, uint16_t port, uint16_t) {
+    if (!sim::linkUp()) return false;
+    sim::advanceMicros(sim::network.tcpHandshakeMicros * 2);
+    sim::tlsStats.mflnProbes++;
+    return port == sim::tlsServer.port && sim::tlsServer.mflnSupported;
+  }
+  static bool probeMaxFragmentLength(const char *host, uint16_t port, uint16_t length) {
+    IPAddress address;
+    if (!WiFi.hostByName(host, address)) return false;
+    return probeMaxFragmentLength(address, port, length);
+  }
+
+  // The front end picks its certificate by SNI, so only a connect by name
+  // gets through the handshake - as with CDN-hosted APIs.
+  int connect(const char *host, uint16_t port) override {
+    IPAddress address;
+    if (!WiFi.hostByName(host, address)) return 0;
+    return connectSecure(address, port);
+  }
+  int connect(IPAddress address, uint16_t port) override {
+    WiFiClient::connect(address, port);
+    WiFiClient::stop();
+    return 0;
+  }
+
+  void stop() override {
+    releaseBuffers();
+    WiFiClient::stop();
+  }
+
+private:
+  Session *session = nullptr;
+  uint32_t receiveBuffer = 16384 + MAX_IN_OVERHEAD;
+  uint32_t transmitBuffer = 16384 + MAX_OUT_OVERHEAD;
+  uint32_t held = 0;
+
+  int connectSecure(IPAddress address, uint16_t port) {
+    releaseBuffers();
+    if (!WiFiClient::connect(address, port)) return 0;
+    if (port != sim::tlsServer.port) {
+      WiFiClient::stop();  // Nothing speaks TLS there
+      return 0;
+    }
+    held = CONTEXT_HEAP + receiveBuffer + transmitBuffer;
+    sim::heapAllocate(held);
+
+    uint64_t sessionId = session ? session->id() : 0;
+    sim::tlsHandshake(sessionId);
+    // A reduced receive buffer only works if the server agreed to send short
+    // records; otherwise its first full-size record overflows it
+    if (receiveBuffer < 16384 + MAX_IN_OVERHEAD && !sim::tlsServer.mflnSupported) {
+      stop();
+      return 0;
+    }
+    if (session) session->assign(sessionId);
+    return 1;
+  }
+
+  void releaseBuffers() {
+    sim::heapRelease(held);
+    held = 0;
+  }
+};
+
+}  // namespace BearSSL
+
+using namespace BearSSL;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+
+// Host-side WiFiServer on a real listening socket bound to loopback, so a
+// browser or curl on the host can talk to the sketch. A device port below
+// 1024 is served at port + 8000 (80 becomes 8080) and the node number is
+// added, as sim::hostServerPort() describes. accept() never blocks and
+// hands out nothing while the simulated link is down; connections that
+// wait meanwhile are taken once it is back.
+class WiFiServer {
+public:
+  explicit WiFiServer(uint16_t port) : devicePort(port) {}
+  ~WiFiServer() { stop(); }
+
+  void begin() {
+    stop();
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return;
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    local.sin_port = htons(sim::hostServerPort(devicePort));
+    if (bind(fd, (sockaddr *)&local, sizeof(local)) < 0 || listen(fd, 4) < 0) {
+      fprintf(stderr, "sim: WiFiServer port %u: %s\n", sim::hostServerPort(devicePort), strerror(errno));
+      ::close(fd);
+      return;
+    }
+    listener = fd;
+    sim::serverStats.listeningPort = sim::hostServerPort(devicePort);
+  }
+  void begin(uint16_t port) {
+    devicePort = port;
+    begin();
+  }
+
+  WiFiClient accept() {
+    if (listener < 0 || !sim::linkUp()) return WiFiClient();
+    int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return WiFiClient();
+    int window = (int)sim::AcceptedSocket::SEND_WINDOW;   // Keep the kernel from buffering past lwIP's window
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &window, sizeof(window));
+    if (noDelay) {
+      int enable = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+    sim::serverStats.connections++;
+    return WiFiClient(fd);
+  }
+  WiFiClient available() { return accept(); }   // Older name in the core
+
+  void setNoDelay(bool enable) { noDelay = enable; }
+  bool getNoDelay() const { return noDelay; }
+  uint8_t status() const { return listener >= 0 ? 1 : 0; }   // LISTEN or CLOSED
+
+  void stop() {
+    if (listener >= 0) ::close(listener);
+    listener = -1;
+  }
+  void close() { stop(); }
+
+private:
+  uint16_t devicePort;
+  int listener = -1;
+  bool noDelay = false;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Host-side WiFiUDP on real sockets, so a collector on the host - or
+// another simulated board - receives what the sketch sends. The simulated
+// LAN is mapped onto the loopback interface: unicast and broadcast
+// datagrams go to 127.0.0.1 at the same port, multicast groups are joined
+// and sent on loopback. Bound sockets share their port (SO_REUSEPORT), so
+// several boards and a collector can listen side by side; only multicast
+// reaches all of them, unicast goes to one.
+//
+// Nothing is sent or received while the simulated link is down: endPacket()
+// fails as it does on the device, and datagrams that arrive meanwhile are
+// dropped. Datagrams leave immediately in host time; virtual time is not
+// charged for them.
+class WiFiUDP : public Stream {
+public:
+  static const size_t MAX_DATAGRAM = 1472;   // One Ethernet frame of UDP payload
+
+  ~WiFiUDP() { stop(); }
+
+  uint8_t begin(uint16_t port) {
+    stop();
+    if (!open()) return 0;
+    sockaddr_in local = address(htonl(INADDR_ANY), port);
+    if (bind(socketFd, (sockaddr *)&local, sizeof(local)) < 0) {
+      stop();
+      return 0;
+    }
+    boundPort = port;
+    return 1;
+  }
+
+  uint8_t beginMulticast(IPAddress, IPAddress multicast, uint16_t port) {
+    if (!begin(port)) return 0;
+    ip_mreq membership = {};
+    membership.imr_multiaddr.s_addr = (uint32_t)multicast;
+    membership.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    if (setsockopt(socketFd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+      stop();
+      return 0;
+    }
+    return 1;
+  }
+
+  void stop() {
+    if (socketFd >= 0) close(socketFd);
+    socketFd = -1;
+    boundPort = 0;
+    received = receivedOffset = 0;
+  }
+
+  int beginPacket(IPAddress destination, uint16_t port) {
+    outgoing = 0;
+    target = destination;
+    targetPort = port;
+    return socketFd >= 0 || open() ? 1 : 0;
+  }
+  int beginPacket(const char *host, uint16_t port) {
+    IPAddress destination;
+    if (!destination.fromString(host) && !WiFi.hostByName(host, destination)) return 0;
+    return beginPacket(destination, port);
+  }
+  int beginPacketMulticast(IPAddress multicast, uint16_t port, IPAddress, int = 1) {
+    return beginPacket(multicast, port);
+  }
+
+  int endPacket() {
+    if (socketFd < 0 || !sim::linkUp()) {
+      sim::udpStats.sendFailures++;
+      return 0;
+    }
+    bool multicast = (target[0] & 0xF0) == 0xE0;
+    sockaddr_in remote = address(multicast ? (uint32_t)target : htonl(INADDR_LOOPBACK), targetPort);
+    if (sendto(socketFd, outgoingBuffer, outgoing, 0, (sockaddr *)&remote, sizeof(remote)) != (ssize_t)outgoing) {
+      sim::udpStats.sendFailures++;
+      return 0;
+    }
+    sim::udpStats.datagramsSent++;
+    sim::udpStats.bytesSent += outgoing;
+    return 1;
+  }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    size_t room = MAX_DATAGRAM - outgoing;
+    if (size > room) size = room;
+    memcpy(outgoingBuffer + outgoing, buffer, size);
+    outgoing += size;
+    return size;
+  }
+  using Print::write;
+
+  // Size of the next datagram, 0 when none is waiting
+  int parsePacket() {
+    received = receivedOffset = 0;
+    if (socketFd < 0 || !boundPort) return 0;
+    sockaddr_in remote = {};
+    socklen_t remoteLength = sizeof(remote);
+    ssize_t length;
+    while ((length = recvfrom(socketFd, incomingBuffer, sizeof(incomingBuffer), 0, (sockaddr *)&remote, &remoteLength)) >= 0) {
+      if (sim::linkUp()) {
+        received = (size_t)length;
+        sender = IPAddress((uint32_t)remote.sin_addr.s_addr);
+        senderPort = ntohs(remote.sin_port);
+        sim::udpStats.datagramsReceived++;
+        return (int)received;
+      }
+      sim::udpStats.receiveDrops++;
+    }
+    return 0;
+  }
+
+  int available() override { return (int)(received - receivedOffset); }
+  int read() override { return receivedOffset < received ? incomingBuffer[receivedOffset++] : -1; }
+  int read(uint8_t *buffer, size_t length) {
+    size_t count = std::min(length, received - receivedOffset);
+    memcpy(buffer, incomingBuffer + receivedOffset, count);
+    receivedOffset += count;
+    return (int)count;
+  }
+  int peek() override { return receivedOffset < received ? incomingBuffer[receivedOffset] : -1; }
+
+  IPAddress remoteIP() const { return sender; }
+  uint16_t remotePort() const { return senderPort; }
+  uint16_t localPort() const { return boundPort; }
+
+private:
+  int socketFd = -1;
+  uint16_t boundPort = 0;
+  IPAddress target;
+  uint16_t targetPort = 0;
+  uint8_t outgoingBuffer[MAX_DATAGRAM];
+  size_t outgoing = 0;
+  uint8_t incomingBuffer[MAX_DATAGRAM];
+  size_t received = 0;
+  size_t receivedOffset = 0;
+  IPAddress sender;
+  uint16_t senderPort = 0;
+
+  static sockaddr_in address(uint32_t networkOrderAddress, uint16_t port) {
+    sockaddr_in result = {};
+    result.sin_family = AF_INET;
+    result.sin_addr.s_addr = networkOrderAddress;
+    result.sin_port = htons(port);
+    return result;
+  }
+
+  bool open() {
+    socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socketFd < 0) return false;
+    int enable = 1;
+    setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(socketFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    in_addr loopback = {};
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(socketFd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback));
+    uint8_t loop = 1;
+    setsockopt(socketFd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL) | O_NONBLOCK);
+    return true;
+  }
+};
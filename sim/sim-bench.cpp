@@ -0,0 +1,542 @@
+// ─────────────────────────────────────
+// EcoPulse Host Micro-Benchmarks
+// ─────────────────────────────────────
+// Standalone driver (no sketch linked) that times the shared firmware
+// building blocks on the host. Absolute numbers are host nanoseconds; use
+// them to compare configurations and revisions, not as device timings.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../adc-sampler.h"
+#include "../calibration.h"
+#include "../logger.h"
+#include "../loop-profiler.h"
+#include "../telemetry-frame.h"
+#include "../telemetry-history.h"
+#include "../telemetry-journal.h"
+
+namespace {
+
+typedef std::chrono::steady_clock BenchClock;
+
+// Keeps the optimiser from discarding benchmarked work
+volatile int benchSink;
+
+double nanosPerIteration(BenchClock::time_point start, size_t iterations) {
+  return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / iterations;
+}
+
+std::vector<uint16_t> noisyMoistureTrace(size_t count) {
+  std::vector<uint16_t> samples(count);
+  for (size_t i = 0; i < count; i++) {
+    samples[i] = (uint16_t)sim::moistureCounts();
+  }
+  return samples;
+}
+
+void benchAdcFilter() {
+  const size_t SAMPLES = 4000000;
+  std::vector<uint16_t> trace = noisyMoistureTrace(SAMPLES);
+
+  printf("adc filter (ns per raw sample)\n");
+  auto start = BenchClock::now();
+  for (size_t i = 0; i < SAMPLES; i++) {
+    benchSink = constrain(map(trace[i], 1023, 0, 0, 100), 0, 100);
+  }
+  printf("  %-34s %7.2f\n", "single sample + map()", nanosPerIteration(start, SAMPLES));
+
+  const AdcFilterConfig configs[] = {
+    { 1, 1, 0 }, { 4, 1, 3 }, { 4, 5, 3 }, { 8, 5, 4 }, { 4, 9, 3 },
+  };
+  for (const AdcFilterConfig &config : configs) {
+    AdcFilter filter;
+    filter.configure(config);
+    start = BenchClock::now();
+    for (size_t i = 0; i < SAMPLES; i++) {
+      filter.push(trace[i]);
+    }
+    benchSink = filter.value();
+    char label[48];
+    snprintf(label, sizeof(label), "oversample %u, median %u, iir 1/%u", config.oversampling, config.medianWindow,
+             1u << config.iirShift);
+    printf("  %-34s %7.2f\n", label, nanosPerIteration(start, SAMPLES));
+  }
+}
+
+// A 1 kHz control loop that reports status once per second - moisture,
+// actuator state and link statistics, ~200 bytes - the way the sketches
+// did with Serial.print. Pass times are virtual: the sim charges UART
+// FIFO waits to the clock, so they show what the device loop would see.
+enum LoggingMode { LOGGING_NONE, LOGGING_SERIAL, LOGGING_BUFFERED };
+
+void statusBurst(LoggingMode mode, uint32_t second) {
+  int moisture = 40 + second % 7;
+  if (mode == LOGGING_SERIAL) {
+    Serial.printf("Substrate hydration coefficient: %d%%\n", moisture);
+    Serial.printf("Photosynthetical supplementation system activated\n");
+    Serial.printf("Cloud publication: %u property updates in %u messages\n", second / 10, second / 10);
+    Serial.printf("Weather service link: %u requests, latency %u ms\n", second / 60, 180 + second % 50);
+  } else if (mode == LOGGING_BUFFERED) {
+    LOG_INFO(LOG_SENSOR, "Substrate hydration coefficient: %d%%", moisture);
+    LOG_INFO(LOG_ACTUATOR, "Photosynthetical supplementation system activated");
+    LOG_INFO(LOG_CLOUD, "Cloud publication: %u property updates in %u messages", second / 10, second / 10);
+    LOG_INFO(LOG_WEATHER, "Weather service link: %u requests, latency %u ms", second / 60, 180 + second % 50);
+  }
+}
+
+void benchLogging() {
+  const uint32_t SECONDS = 120;
+  const uint32_t PASSES_PER_SECOND = 1000;
+  const uint64_t WORK_MICROS = 1000;
+
+  printf("logging (virtual loop pass, 1 ms of work per pass, status burst once per second)\n");
+  printf("  %-26s %10s %10s %12s %14s\n", "mode", "mean us", "max us", "blocked ms", "host ns/line");
+  const struct {
+    LoggingMode mode;
+    const char *name;
+  } modes[] = {
+    { LOGGING_NONE, "no logging" },
+    { LOGGING_SERIAL, "Serial.printf" },
+    { LOGGING_BUFFERED, "logger ring + poll()" },
+  };
+  for (const auto &run : modes) {
+    Serial.flush();
+    logger.begin(Serial);
+    sim::UartStats before = sim::uartStats;
+    uint64_t totalMicros = 0;
+    uint64_t worstMicros = 0;
+    double burstNanos = 0;
+    for (uint32_t second = 0; second < SECONDS; second++) {
+      for (uint32_t pass = 0; pass < PASSES_PER_SECOND; pass++) {
+        uint64_t start = sim::clockMicros;
+        if (pass == 0) {
+          auto hostStart = BenchClock::now();
+          statusBurst(run.mode, second);
+          burstNanos += std::chrono::duration<double, std::nano>(BenchClock::now() - hostStart).count();
+        }
+        logger.poll();
+        sim::advanceMicros(WORK_MICROS);
+        uint64_t elapsed = sim::clockMicros - start;
+        totalMicros += elapsed;
+        if (elapsed > worstMicros) worstMicros = elapsed;
+      }
+    }
+    printf("  %-26s %10.1f %10llu %12.1f %14.0f\n", run.name, (double)totalMicros / (SECONDS * PASSES_PER_SECOND),
+           (unsigned long long)worstMicros, (sim::uartStats.blockedMicros - before.blockedMicros) / 1000.0,
+           run.mode == LOGGING_NONE ? 0.0 : burstNanos / (SECONDS * 4));
+  }
+  const LoggerStats &stats = logger.stats();
+  printf("  logger: %u lines queued, %u repeats suppressed, %u overflowed, peak backlog %u bytes\n", stats.lines,
+         stats.repeatsSuppressed, stats.overflowed, stats.peakBacklog);
+}
+
+// Cost of one profiled stage. The sim's cycle counter reads the host clock,
+// which dominates here; on the device each read is a single RSR CCOUNT
+// instruction, so the bookkeeping line is what a stage costs there. Each
+// figure is the best of a few runs, since the difference is small.
+void benchProfiler() {
+  const size_t PASSES = 5000000;
+  const int RUNS = 5;
+  LoopProfiler<12> profiler;
+  profiler.begin();
+  int8_t stage = profiler.addStage("bench");
+
+  double readNanos = 1e9, recordNanos = 1e9, scopeNanos = 1e9;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < PASSES; i++) benchSink = ESP.getCycleCount();
+    readNanos = std::min(readNanos, nanosPerIteration(start, PASSES));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < PASSES; i++) profiler.record(stage, (uint32_t)i);  // One read inside
+    recordNanos = std::min(recordNanos, nanosPerIteration(start, PASSES));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < PASSES; i++) {
+      PROFILE_STAGE(profiler, stage);
+      benchSink = i;
+    }
+    scopeNanos = std::min(scopeNanos, nanosPerIteration(start, PASSES));
+  }
+
+  printf("loop profiler (ns per profiled stage, best of %d)\n", RUNS);
+  printf("  %-34s %7.2f\n", "cycle counter read", readNanos);
+  printf("  %-34s %7.2f\n", "PROFILE_STAGE scope (two reads)", scopeNanos);
+  printf("  %-34s %7.2f\n", "bookkeeping (record - one read)", recordNanos - readNanos);
+}
+
+// Raw-to-percent conversion: the sketches' former map() + constrain(), a
+// float quadratic (what a curve-fitted calibration would cost), and the
+// fixed-point tables. The host divides in a few cycles; the LX106 has no
+// divider and calls a ~40-cycle routine for map()'s division and a
+// software float library for the quadratic, so on the device the gap is wider.
+// The ESP8266 core compiles map() out of line (WMath.cpp), so its division
+// is a real one; the sim's inline map() lets the host fold it into a multiply.
+__attribute__((noinline)) long outOfLineMap(long x, long inMin, long inMax, long outMin, long outMax) {
+  return map(x, inMin, inMax, outMin, outMax);
+}
+
+constexpr CalibrationTable<> BENCH_LINEAR = CalibrationTable<>::twoPoint({ 1023, 0 }, { 0, 100 }, 0, 100);
+constexpr double BENCH_CURVE_COEFFICIENTS[] = { 100.0, -0.1466, 0.0000465, 0.0 };
+constexpr CalibrationTable<> BENCH_CURVE = CalibrationTable<>::polynomial(BENCH_CURVE_COEFFICIENTS, 0, 100);
+
+void benchCalibration() {
+  const size_t SAMPLES = 4000000;
+  const int RUNS = 5;
+  std::vector<uint16_t> trace = noisyMoistureTrace(SAMPLES);
+
+  uint32_t linearMismatches = 0, curveWorstError = 0;
+  for (uint16_t raw = 0; raw <= 1023; raw++) {
+    linearMismatches += BENCH_LINEAR.convert(raw) != constrain(map(raw, 1023, 0, 0, 100), 0, 100);
+    float curve = 100.0f - 0.1466f * raw + 0.0000465f * raw * raw;
+    int32_t error = BENCH_CURVE.fixed(raw) - (int32_t)(constrain(curve, 0.0f, 100.0f) * 65536.0f);
+    if ((uint32_t)abs(error) > curveWorstError) curveWorstError = abs(error);
+  }
+
+  double mapNanos = 1e9, outOfLineNanos = 1e9, floatNanos = 1e9, tableNanos = 1e9, curveTableNanos = 1e9;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < SAMPLES; i++) benchSink = constrain(map(trace[i], 1023, 0, 0, 100), 0, 100);
+    mapNanos = std::min(mapNanos, nanosPerIteration(start, SAMPLES));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < SAMPLES; i++) benchSink = constrain(outOfLineMap(trace[i], 1023, 0, 0, 100), 0, 100);
+    outOfLineNanos = std::min(outOfLineNanos, nanosPerIteration(start, SAMPLES));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < SAMPLES; i++) {
+      float raw = trace[i];
+      benchSink = (int)constrain(100.0f - 0.1466f * raw + 0.0000465f * raw * raw, 0.0f, 100.0f);
+    }
+    floatNanos = std::min(floatNanos, nanosPerIteration(start, SAMPLES));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < SAMPLES; i++) benchSink = BENCH_LINEAR.convert(trace[i]);
+    tableNanos = std::min(tableNanos, nanosPerIteration(start, SAMPLES));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < SAMPLES; i++) benchSink = BENCH_CURVE.convert(trace[i]);
+    curveTableNanos = std::min(curveTableNanos, nanosPerIteration(start, SAMPLES));
+  }
+
+  printf("calibration (ns per conversion, best of %d)\n", RUNS);
+  printf("  %-34s %7.2f\n", "map() + constrain(), inlined", mapNanos);
+  printf("  %-34s %7.2f\n", "map() + constrain(), out of line", outOfLineNanos);
+  printf("  %-34s %7.2f\n", "float quadratic + constrain()", floatNanos);
+  printf("  %-34s %7.2f\n", "table, two-point", tableNanos);
+  printf("  %-34s %7.2f\n", "table, polynomial", curveTableNanos);
+  printf("  two-point table vs map(): %u of 1024 counts differ; polynomial table within %.4f %% of float\n",
+         linearMismatches, curveWorstError / 65536.0);
+  printf("  table size %u bytes\n", (unsigned)sizeof(CalibrationTable<>));
+}
+
+// One minute-by-minute day of winter telemetry: moisture drifting down
+// with pump runs, the light curve and a slow temperature swing.
+std::vector<TelemetrySample> telemetryDay() {
+  std::vector<TelemetrySample> samples(1440);
+  for (size_t minute = 0; minute < samples.size(); minute++) {
+    TelemetrySample &sample = samples[minute];
+    bool pump = minute % 240 < 3;
+    sample.timestamp = 86400 + minute * 60;
+    sample.temperatureDeci = (int16_t)(140 + 60 * std::sin(minute * 2 * M_PI / 1440));
+    sample.light = (uint16_t)(40 + std::max(0.0, std::sin((minute / 1440.0 - 0.25) * 2 * M_PI)) * 900);
+    sample.moisture = (uint8_t)(45 - (minute % 240) / 20);
+    sample.flags = (pump ? TELEMETRY_FLAG_PUMP : 0) | (sample.light < 300 ? TELEMETRY_FLAG_LIGHTS : 0);
+  }
+  return samples;
+}
+
+// A property update as the Arduino IoT Cloud library sends it: a SenML pack
+// in CBOR with integer labels (0 = name, 2 = value, 4 = boolean value),
+// here carrying the iot-winter properties one sample changes. MQTT and TLS
+// framing come on top and are not counted.
+size_t cborHead(uint8_t *out, uint8_t major, uint32_t value) {
+  if (value < 24) {
+    out[0] = major << 5 | value;
+    return 1;
+  }
+  out[0] = major << 5 | 24;
+  out[1] = value;
+  return 2;
+}
+
+size_t cborName(uint8_t *out, const char *name) {
+  size_t length = strlen(name);
+  size_t used = cborHead(out, 5, 2);  // Map of two pairs
+  out[used++] = 0x00;                 // n
+  used += cborHead(out + used, 3, length);
+  memcpy(out + used, name, length);
+  return used + length;
+}
+
+size_t encodeCloudUpdate(uint8_t *out, const TelemetrySample &sample) {
+  size_t used = cborHead(out, 4, 4);
+  used += cborName(out + used, "soil_Moisture");
+  out[used++] = 0x02;
+  used += cborHead(out + used, 0, sample.moisture);
+  used += cborName(out + used, "pumpStatus");
+  out[used++] = 0x04;
+  out[used++] = sample.flags & TELEMETRY_FLAG_PUMP ? 0xF5 : 0xF4;
+  used += cborName(out + used, "temperature");
+  out[used++] = 0x02;
+  out[used++] = 0xFA;                 // Single-precision float, big-endian
+  float celsius = sample.temperatureDeci / 10.0f;
+  uint32_t bits;
+  memcpy(&bits, &celsius, sizeof(bits));
+  for (int shift = 24; shift >= 0; shift -= 8) out[used++] = bits >> shift;
+  used += cborName(out + used, "internetConnected");
+  out[used++] = 0x04;
+  out[used++] = 0xF5;
+  return used;
+}
+
+// The LAN frame against the current cloud paths for the same samples: the
+// per-sample property update and the journal's text backlog records. Also
+// checks that every frame decodes to what was encoded and that corruption
+// is caught.
+void benchTelemetryFrame() {
+  const int RUNS = 5;
+  const size_t UDP_IP_HEADERS = 28;
+  const std::vector<TelemetrySample> day = telemetryDay();
+  const size_t COUNT = day.size();
+  std::vector<uint8_t> frames(COUNT * TELEMETRY_FRAME_SIZE);
+
+  // Round trip over the day plus edge values, then every single-bit error
+  // and a few malformed datagrams
+  uint32_t mismatches = 0, roundTrips = 0, corruptAccepted = 0, corruptions = 0, malformedAccepted = 0;
+  uint32_t state = 0x2545F491;
+  for (size_t i = 0; i < COUNT + 4096; i++) {
+    TelemetrySample sample = i < COUNT ? day[i] : TelemetrySample();
+    if (i >= COUNT) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      sample.timestamp = state;
+      sample.temperatureDeci = i % 7 == 0 ? TELEMETRY_TEMPERATURE_UNKNOWN : (int16_t)(state >> 16);
+      sample.light = state >> 3;
+      sample.moisture = state >> 11;
+      sample.flags = state >> 24;
+    }
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    encodeTelemetryFrame(frame, (uint16_t)(i * 7919), 0x00C0FFEE ^ (uint32_t)i, sample);
+    TelemetryFrame decoded;
+    roundTrips++;
+    if (decodeTelemetryFrame(frame, sizeof(frame), decoded) != TELEMETRY_FRAME_OK || decoded.sequence != (uint16_t)(i * 7919) ||
+        decoded.deviceId != (0x00C0FFEE ^ (uint32_t)i) || decoded.sample.timestamp != sample.timestamp ||
+        decoded.sample.temperatureDeci != sample.temperatureDeci || decoded.sample.light != sample.light ||
+        decoded.sample.moisture != sample.moisture || decoded.sample.flags != sample.flags) {
+      mismatches++;
+    }
+    for (size_t bit = 0; bit < TELEMETRY_FRAME_SIZE * 8; bit++) {
+      frame[bit / 8] ^= 1 << (bit % 8);
+      corruptAccepted += decodeTelemetryFrame(frame, sizeof(frame), decoded) == TELEMETRY_FRAME_OK;
+      corruptions++;
+      frame[bit / 8] ^= 1 << (bit % 8);
+    }
+    malformedAccepted += decodeTelemetryFrame(frame, sizeof(frame) - 1, decoded) == TELEMETRY_FRAME_OK;
+    frame[1] = TELEMETRY_FRAME_VERSION + 1;
+    malformedAccepted += decodeTelemetryFrame(frame, sizeof(frame), decoded) == TELEMETRY_FRAME_OK;
+  }
+
+  uint8_t cloudMessage[128];
+  size_t cloudBytes = 0;
+  for (const TelemetrySample &sample : day) cloudBytes += encodeCloudUpdate(cloudMessage, sample);
+
+  const size_t BATCH = 12;
+  TelemetryRecord records[BATCH];
+  char text[BATCH * TELEMETRY_BATCH_FIELD_MAX + 1];
+  size_t textBytes = 0;
+  for (size_t first = 0; first + BATCH <= COUNT; first += BATCH) {
+    for (size_t i = 0; i < BATCH; i++) {
+      const TelemetrySample &sample = day[first + i];
+      records[i] = { sample.timestamp, sample.temperatureDeci, sample.light, sample.moisture, sample.flags, 0 };
+    }
+    formatTelemetryBatch(text, sizeof(text), records, BATCH, day[first + BATCH - 1].timestamp + 30);
+    textBytes += strlen(text);
+  }
+
+  double encodeNanos = 1e9, decodeNanos = 1e9, cloudNanos = 1e9, textNanos = 1e9;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < COUNT; i++) encodeTelemetryFrame(&frames[i * TELEMETRY_FRAME_SIZE], i, 0x00C0FFEE, day[i]);
+    encodeNanos = std::min(encodeNanos, nanosPerIteration(start, COUNT));
+    benchSink = frames[COUNT * TELEMETRY_FRAME_SIZE - 1];
+
+    start = BenchClock::now();
+    TelemetryFrame decoded;
+    for (size_t i = 0; i < COUNT; i++) benchSink = decodeTelemetryFrame(&frames[i * TELEMETRY_FRAME_SIZE], TELEMETRY_FRAME_SIZE, decoded);
+    decodeNanos = std::min(decodeNanos, nanosPerIteration(start, COUNT));
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < COUNT; i++) benchSink = encodeCloudUpdate(cloudMessage, day[i]);
+    cloudNanos = std::min(cloudNanos, nanosPerIteration(start, COUNT));
+
+    start = BenchClock::now();
+    for (size_t first = 0; first + BATCH <= COUNT; first += BATCH) {
+      benchSink = formatTelemetryBatch(text, sizeof(text), records, BATCH, day[first].timestamp);
+    }
+    textNanos = std::min(textNanos, nanosPerIteration(start, COUNT / BATCH * BATCH));
+  }
+
+  printf("telemetry frame (per sample, best of %d)\n", RUNS);
+  printf("  %-34s %7s %9s\n", "", "ns", "bytes");
+  printf("  %-34s %7.2f %9.1f\n", "binary frame encode", encodeNanos, (double)TELEMETRY_FRAME_SIZE);
+  printf("  %-34s %7.2f\n", "binary frame decode + CRC check", decodeNanos);
+  printf("  %-34s %7.2f %9.1f\n", "cloud property update (SenML/CBOR)", cloudNanos, (double)cloudBytes / COUNT);
+  printf("  %-34s %7.2f %9.1f\n", "cloud backlog text record", textNanos, (double)textBytes / (COUNT / BATCH * BATCH));
+  printf("  frame on the air with UDP/IP headers: %u bytes\n", (unsigned)(TELEMETRY_FRAME_SIZE + UDP_IP_HEADERS));
+  printf("  round trip: %u of %u frames differ; %u of %u single-bit errors and %u malformed frames accepted\n",
+         mismatches, roundTrips, corruptAccepted, corruptions, malformedAccepted);
+}
+
+// Two days of 1 Hz samples as the sketches take them: forecast temperature
+// interpolated in 0.1 degree steps, a filtered photosensor with a count or
+// two of noise, moisture that dries by whole percents and a pump cycle.
+std::vector<TelemetrySample> historyTrace(size_t seconds) {
+  std::vector<TelemetrySample> samples(seconds);
+  uint32_t state = 0x9E3779B9;
+  for (size_t second = 0; second < seconds; second++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    double day = (second % 86400) / 86400.0;
+    bool pump = second % 14400 < 180;
+    TelemetrySample &sample = samples[second];
+    sample.timestamp = 3600 + second;
+    sample.temperatureDeci = (int16_t)lround(140 + 60 * std::sin(day * 2 * M_PI));
+    sample.light = (uint16_t)(40 + std::max(0.0, std::sin((day - 0.25) * 2 * M_PI)) * 900 + (state & 3));
+    sample.moisture = (uint8_t)(pump ? 45 : 45 - (second % 14400) / 1200);
+    sample.flags = (pump ? TELEMETRY_FLAG_PUMP : 0) | (sample.light < 300 ? TELEMETRY_FLAG_LIGHTS : 0);
+  }
+  return samples;
+}
+
+// Append and query cost of the compressed history, and a check that the raw
+// tier decodes to the samples appended and the rollups match a recount.
+void benchHistory() {
+  const int RUNS = 5;
+  const std::vector<TelemetrySample> trace = historyTrace(2 * 86400);
+  const size_t COUNT = trace.size();
+  static TelemetryHistory<> history;
+
+  double appendNanos = 1e9;
+  for (int run = 0; run < RUNS; run++) {
+    history.clear();
+    auto start = BenchClock::now();
+    for (const TelemetrySample &sample : trace) history.append(sample);
+    appendNanos = std::min(appendNanos, nanosPerIteration(start, COUNT));
+  }
+  const TelemetryHistoryStats &stats = history.stats();
+  const uint32_t newest = trace.back().timestamp;
+
+  // Raw round trip: the retained samples are exactly the newest ones appended
+  size_t decoded = 0, mismatches = 0;
+  const size_t firstRetained = COUNT - stats.retainedSamples;
+  history.forEachSample(0, UINT32_MAX, [&](const TelemetrySample &sample) {
+    const TelemetrySample &expected = trace[firstRetained + decoded++];
+    mismatches += sample.timestamp != expected.timestamp || sample.temperatureDeci != expected.temperatureDeci ||
+                  sample.light != expected.light || sample.moisture != expected.moisture || sample.flags != expected.flags;
+  });
+
+  // Hourly rollups against a recount of the trace
+  size_t intervals = 0, rollupMismatches = 0;
+  history.forEachRollup(HISTORY_HOUR, 0, UINT32_MAX, [&](uint32_t start, const HistoryRollup &hour) {
+    intervals++;
+    uint32_t samples = 0, pump = 0, moistureSum = 0;
+    uint16_t lightMax = 0;
+    int16_t temperatureMin = INT16_MAX;
+    for (const TelemetrySample &sample : trace) {
+      if (sample.timestamp < start || sample.timestamp >= start + 3600) continue;
+      samples++;
+      pump += (sample.flags & TELEMETRY_FLAG_PUMP) != 0;
+      moistureSum += sample.moisture;
+      lightMax = std::max(lightMax, sample.light);
+      temperatureMin = std::min(temperatureMin, sample.temperatureDeci);
+    }
+    rollupMismatches += hour.samples != samples || hour.pumpSamples != pump || hour.lightMax != lightMax ||
+                        hour.temperatureMin != temperatureMin || hour.moistureMean != (moistureSum + samples / 2) / samples;
+  });
+
+  double decodeNanos = 1e9, recentNanos = 1e9, summaryNanos = 1e9, rollupNanos = 1e9;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = BenchClock::now();
+    uint32_t sum = 0;
+    history.forEachSample(0, UINT32_MAX, [&](const TelemetrySample &sample) { sum += sample.light; });
+    decodeNanos = std::min(decodeNanos, nanosPerIteration(start, decoded));
+
+    start = BenchClock::now();
+    for (int i = 0; i < 100; i++) {
+      history.forEachSample(newest - 600, newest + 1, [&](const TelemetrySample &sample) { sum += sample.moisture; });
+    }
+    recentNanos = std::min(recentNanos, nanosPerIteration(start, 100));
+
+    start = BenchClock::now();
+    HistoryRollup day;
+    for (int i = 0; i < 1000; i++) sum += history.summarize(HISTORY_QUARTER, newest - 86400, newest + 1, day) + day.moistureMean;
+    summaryNanos = std::min(summaryNanos, nanosPerIteration(start, 1000));
+
+    start = BenchClock::now();
+    for (int i = 0; i < 1000; i++) {
+      history.forEachRollup(HISTORY_HOUR, newest - 86400, newest + 1, [&](uint32_t, const HistoryRollup &hour) { sum += hour.lightMean; });
+    }
+    rollupNanos = std::min(rollupNanos, nanosPerIteration(start, 1000));
+    benchSink = sum;
+  }
+
+  printf("telemetry history (%u s of 1 Hz samples, best of %d)\n", (unsigned)COUNT, RUNS);
+  printf("  %-40s %10.2f ns/sample\n", "append (raw + three rollups)", appendNanos);
+  printf("  %-40s %10.2f ns/sample\n", "decode the raw tier", decodeNanos);
+  printf("  %-40s %10.2f us\n", "last 10 min of raw samples", recentNanos / 1000);
+  printf("  %-40s %10.2f us\n", "24 h summary from 15-min rollups", summaryNanos / 1000);
+  printf("  %-40s %10.2f us\n", "24 hourly rollups", rollupNanos / 1000);
+  printf("  raw tier: %u samples (%.1f h) in %u B, %.2f bits/sample vs %u uncompressed\n", stats.retainedSamples,
+         (stats.newestRaw - stats.oldestRaw + 1) / 3600.0, (unsigned)((stats.retainedBits + 7) / 8), stats.bitsPerSample(),
+         (unsigned)(sizeof(TelemetrySample) * 8));
+  printf("  rollups: 1 min back %.1f h, 15 min back %.1f h, 1 h back %.1f h; %u B in all\n",
+         (newest - history.oldestRollup(HISTORY_MINUTE)) / 3600.0, (newest - history.oldestRollup(HISTORY_QUARTER)) / 3600.0,
+         (newest - history.oldestRollup(HISTORY_HOUR)) / 3600.0, (unsigned)history.memoryBytes());
+  printf("  round trip: %zu of %zu raw samples differ, %zu of %zu hourly rollups differ from a recount\n", mismatches,
+         decoded, rollupMismatches, intervals);
+}
+
+struct Benchmark {
+  const char *name;
+  void (*run)();
+};
+
+const Benchmark BENCHMARKS[] = {
+  { "adc-filter", benchAdcFilter },
+  { "logging", benchLogging },
+  { "profiler", benchProfiler },
+  { "calibration", benchCalibration },
+  { "telemetry-frame", benchTelemetryFrame },
+  { "history", benchHistory },
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool ranAny = false;
+  for (const Benchmark &benchmark : BENCHMARKS) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++) {
+      selected |= !strcmp(argv[i], benchmark.name);
+    }
+    if (selected) {
+      benchmark.run();
+      ranAny = true;
+    }
+  }
+  if (!ranAny) {
+    printf("usage: %s [benchmark...]\navailable:", argv[0]);
+    for (const Benchmark &benchmark : BENCHMARKS) printf(" %s", benchmark.name);
+    printf("\n");
+    return 2;
+  }
+  return 0;
+}
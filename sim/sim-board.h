@@ -0,0 +1,784 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <sys/mman.h>
+
+// ─────────────────────────────────────
+// Simulated EcoPulse Board
+// ─────────────────────────────────────
+// Virtual world behind the host-side Arduino core in sim/include: a
+// microsecond clock that only moves when the sketch waits or a loop pass
+// completes, NodeMCU GPIO/ADC with a soil and daylight model, a WiFi link
+// with scripted outages, and an in-process stand-in for api.weatherapi.com.
+// Everything is header-only so a sketch and sim-main.cpp link without a
+// separate library.
+
+namespace sim {
+
+// ── Persistent world ──
+// sim-main runs every boot of the sketch in a forked child, so a reset
+// (deep sleep, ESP.restart()) starts from pristine sketch RAM exactly like
+// the device. Variables created with persistent<T>() live in one shared
+// mapping and carry over between boots: the clock, the physical
+// environment, RTC user memory and the statistics. Plain inline variables
+// are either configuration (set before the first boot and inherited) or
+// device state that a reset clears.
+inline void *persistentArena(size_t bytes) {
+  static const size_t ARENA_SIZE = (size_t)256 << 20;
+  static uint8_t *base = (uint8_t *)mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  static size_t used = 0;
+  bytes = (bytes + 15) & ~(size_t)15;
+  if (base == (uint8_t *)MAP_FAILED || used + bytes > ARENA_SIZE) {
+    fprintf(stderr, "sim: persistent arena exhausted\n");
+    abort();
+  }
+  void *block = base + used;
+  used += bytes;
+  return block;
+}
+
+template <typename T>
+T &persistent() {
+  static_assert(std::is_trivially_copyable<T>::value, "persistent state must not own heap memory");
+  return *new (persistentArena(sizeof(T))) T();
+}
+
+// ── Virtual clock ──
+inline uint64_t &clockMicros = persistent<uint64_t>();
+inline uint64_t bootMicros = 0;              // clockMicros when the current boot started
+inline uint64_t loopQuantumMicros = 5000;   // Virtual time charged per loop() pass
+const uint64_t EPOCH_BASE = 1767225600;     // Wall time at clock zero: 2026-01-01 00:00:00 UTC
+inline uint64_t slowPassMicros = 50000;     // loop() passes longer than this are counted as slow
+const uint8_t CPU_MHZ = 80;
+inline std::chrono::steady_clock::time_point hostBootTime;  // Host time when the current boot started
+
+// ── Pacing ──
+// Several sims on one loopback LAN only see each other's traffic at
+// matching virtual times if their clocks advance together. With a pace,
+// virtual time is held to at most `paceFactor` times host time since the
+// first boot; sims started together then share a timeline to within their
+// start skew times the factor.
+inline double paceFactor = 0;                // 0 = as fast as possible
+inline std::chrono::steady_clock::time_point &paceOrigin = persistent<std::chrono::steady_clock::time_point>();
+
+inline void holdPace() {
+  auto due = paceOrigin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double, std::micro>(clockMicros / paceFactor));
+  if (due > std::chrono::steady_clock::now() + std::chrono::milliseconds(1)) std::this_thread::sleep_until(due);
+}
+
+// Board number for sims sharing a LAN; offsets the chip ID
+inline uint32_t nodeIndex = 0;
+
+inline void advanceMicros(uint64_t delta);
+
+// ── Hardware timer ──
+// timer1 as exposed by the ESP8266 core; its interrupt is raised from
+// advanceMicros() at the exact virtual deadline.
+struct HardwareTimer {
+  void (*isr)() = nullptr;
+  uint64_t periodMicros = 0;
+  uint64_t nextFireMicros = 0;
+  uint32_t ticksPerMicro = 5;   // TIM_DIV16 at 80 MHz
+  bool enabled = false;
+  bool reload = false;
+  uint64_t interrupts = 0;
+};
+inline HardwareTimer timer1;
+
+// ── Software timers ──
+// os_timer slots behind Ticker. On the device their callbacks run from the
+// SDK task whenever the sketch yields - delay(), waits inside network
+// calls, the end of loop() - so here they run from advanceMicros() at
+// their virtual deadline, which is always such a wait.
+struct SoftwareTimer {
+  std::function<void()> callback;
+  uint64_t periodMicros = 0;
+  uint64_t nextFireMicros = 0;
+  bool allocated = false;   // Owned by a Ticker, armed or not
+  bool armed = false;
+  bool repeat = false;
+};
+const uint8_t SOFTWARE_TIMER_SLOTS = 8;
+inline SoftwareTimer softwareTimers[SOFTWARE_TIMER_SLOTS];
+inline bool runningSoftwareTimer = false;   // A callback that waits does not re-enter the timer task
+
+// ── GPIO ──
+const uint8_t PIN_COUNT = 18;               // GPIO0..16 plus A0 (17)
+const uint8_t ADC_PIN = 17;
+const uint8_t PUMP_PIN = 5;                 // D1 - relay in every sketch
+const uint8_t LIGHTS_PIN = 4;               // D2 - grow lights in iot-winter
+
+struct PinState {
+  uint8_t mode = 0;
+  int level = 0;
+};
+
+struct ActuatorEvent {
+  uint64_t atMicros;
+  uint8_t pin;
+  int level;
+};
+
+// Fixed-capacity so it can live in the persistent arena across boots
+struct ActuatorLog {
+  static const size_t CAPACITY = (size_t)1 << 20;
+  ActuatorEvent *entries = (ActuatorEvent *)persistentArena(CAPACITY * sizeof(ActuatorEvent));
+  size_t count = 0;
+
+  void push_back(const ActuatorEvent &event) {
+    if (count < CAPACITY) entries[count++] = event;
+  }
+  const ActuatorEvent *begin() const { return entries; }
+  const ActuatorEvent *end() const { return entries + count; }
+};
+
+inline PinState pins[PIN_COUNT];
+inline ActuatorLog &actuatorLog = persistent<ActuatorLog>();
+inline bool recordActuatorLog = false;
+inline uint32_t actuatorLogPins = UINT32_MAX;   // Pins whose changes go to actuatorLog
+
+struct ActuatorStats {
+  uint32_t switchCount = 0;
+  uint64_t onMicros = 0;
+  uint64_t lastOnAt = 0;
+};
+struct ActuatorStatsTable {
+  ActuatorStats pins[PIN_COUNT];
+  ActuatorStats &operator[](size_t pin) { return pins[pin]; }
+};
+inline ActuatorStatsTable &actuatorStats = persistent<ActuatorStatsTable>();
+
+// ── Environment model ──
+// Soil dries at a constant rate and is rewetted while the pump relay is
+// energised or it rains; daylight follows a clipped sinusoid over a 24 h
+// virtual day.
+struct Environment {
+  double soilMoisturePct = 45.0;
+  double dryingPctPerHour = 1.2;
+  double wettingPctPerMinute = 6.0;
+  double rainWettingPctPerHour = 8.0;
+  double adcNoiseCounts = 6.0;
+  double weatherTempMeanC = 14.0;
+  double weatherTempSwingC = 6.0;
+  int lightPeakCounts = 900;
+  int lightNightCounts = 40;
+};
+inline Environment &environment = persistent<Environment>();
+inline uint32_t &noiseState = persistent<uint32_t>() = 0x9E3779B9u;
+
+// Scripted rain (--rain), also what the forecast stand-in predicts
+struct RainSpell {
+  uint64_t startMicros;
+  uint64_t endMicros;
+};
+inline std::vector<RainSpell> rainSpells;
+
+inline bool rainingAt(uint64_t micros) {
+  for (const RainSpell &spell : rainSpells) {
+    if (micros >= spell.startMicros && micros < spell.endMicros) return true;
+  }
+  return false;
+}
+
+inline double secondsOfDay() {
+  return std::fmod(clockMicros / 1e6, 86400.0);
+}
+
+inline double adcNoise() {
+  noiseState ^= noiseState << 13;
+  noiseState ^= noiseState >> 17;
+  noiseState ^= noiseState << 5;
+  return ((noiseState & 0xFFFF) / 32768.0 - 1.0) * environment.adcNoiseCounts;
+}
+
+inline int moistureCounts() {
+  // Resistive probe: 1023 bone dry, 0 saturated (matches map(raw, 1023, 0, 0, 100))
+  double counts = 1023.0 - environment.soilMoisturePct * 10.23 + adcNoise();
+  return (int)std::fmin(1023.0, std::fmax(0.0, counts));
+}
+
+inline int lightCounts() {
+  double phase = std::sin((secondsOfDay() / 86400.0 - 0.25) * 2.0 * M_PI);
+  double counts = environment.lightNightCounts + std::fmax(0.0, phase) * environment.lightPeakCounts + adcNoise();
+  return (int)std::fmin(1023.0, std::fmax(0.0, counts));
+}
+
+inline double weatherTemperatureAtC(uint64_t micros) {
+  double phase = std::sin((std::fmod(micros / 1e6, 86400.0) / 86400.0 - 0.375) * 2.0 * M_PI);
+  return environment.weatherTempMeanC + phase * environment.weatherTempSwingC;
+}
+
+inline double weatherTemperatureC() {
+  return weatherTemperatureAtC(clockMicros);
+}
+
+// A0 is a single ADC; GPIO0 (D3) is treated as the analog mux select line,
+// LOW routing the moisture probe and HIGH the photosensor.
+inline std::function<int(uint8_t)> adcSource = [](uint8_t) {
+  return pins[0].level ? lightCounts() : moistureCounts();
+};
+
+inline void stepEnvironment(double seconds) {
+  if (pins[PUMP_PIN].level) {
+    environment.soilMoisturePct += environment.wettingPctPerMinute * seconds / 60.0;
+  } else if (rainingAt(clockMicros)) {
+    environment.soilMoisturePct += environment.rainWettingPctPerHour * seconds / 3600.0;
+  } else {
+    environment.soilMoisturePct -= environment.dryingPctPerHour * seconds / 3600.0;
+  }
+  environment.soilMoisturePct = std::fmin(100.0, std::fmax(0.0, environment.soilMoisturePct));
+}
+
+// ── WiFi link ──
+struct Outage {
+  uint64_t startMicros;
+  uint64_t endMicros;
+};
+
+struct Network {
+  std::vector<Outage> outages;
+  // Association cost: a station without a channel/BSSID hint scans every
+  // channel first, and one without a static address waits for DHCP
+  uint64_t scanMicros = 1800000;
+  uint64_t authMicros = 250000;             // Authentication + WPA2 4-way handshake
+  uint64_t dhcpMicros = 450000;
+  uint8_t apBssid[6] = { 0x60, 0x38, 0xE0, 0x4A, 0x21, 0x07 };
+  int32_t apChannel = 6;
+  uint64_t apChannelChangeMicros = UINT64_MAX;  // --ap-channel: the AP moves to a new channel
+  int32_t apChannelAfterChange = 11;
+  uint64_t dnsMicros = 60000;
+  uint64_t tcpHandshakeMicros = 90000;
+  uint64_t serverIdleTimeoutMicros = 120000000;  // Keep-alive idle limit at the API front end
+  uint64_t associatedAt = 0;
+  uint64_t associationStartedAt = 0;
+  bool associating = false;
+  bool associated = false;
+  bool hintMismatch = false;                // Attempt hinted a channel/BSSID the AP is not on
+  bool associationFailed = false;           // ...and has given up (WL_NO_SSID_AVAIL)
+};
+inline Network network;
+
+inline int32_t accessPointChannel() {
+  return clockMicros >= network.apChannelChangeMicros ? network.apChannelAfterChange : network.apChannel;
+}
+
+struct LinkStats {
+  uint32_t associationAttempts = 0;
+  uint32_t hintedAttempts = 0;              // begin() with a channel and BSSID - no scan
+  uint32_t associations = 0;
+  uint64_t associationMicros = 0;           // Attempt start to link up, summed over associations
+  uint32_t tcpHandshakes = 0;
+};
+inline LinkStats &linkStats = persistent<LinkStats>();
+
+// WiFiUDP traffic (sim/include/WiFiUdp.h)
+struct UdpStats {
+  uint32_t datagramsSent = 0;
+  uint64_t bytesSent = 0;
+  uint32_t sendFailures = 0;                // endPacket() while the link was down
+  uint32_t datagramsReceived = 0;
+  uint32_t receiveDrops = 0;                // Arrived while the link was down
+};
+inline UdpStats &udpStats = persistent<UdpStats>();
+
+// WiFiServer connections (sim/include/WiFiServer.h). A device port below
+// 1024 is served on the host at port + 8000, so no privileges are needed;
+// the node number is added so several boards can listen side by side.
+struct ServerStats {
+  uint16_t listeningPort = 0;               // Host port of the latest listener, 0 = none
+  uint32_t connections = 0;
+  uint64_t bytesSent = 0;
+  uint32_t refusedWrites = 0;               // write() calls that found the send buffer full
+};
+inline ServerStats &serverStats = persistent<ServerStats>();
+
+inline uint16_t hostServerPort(uint16_t devicePort) {
+  return (devicePort < 1024 ? devicePort + 8000 : devicePort) + nodeIndex;
+}
+
+inline bool accessPointReachable() {
+  for (const Outage &outage : network.outages) {
+    if (clockMicros >= outage.startMicros && clockMicros < outage.endMicros) return false;
+  }
+  return true;
+}
+
+inline bool linkUp() {
+  if (network.associating && network.hintMismatch && clockMicros >= network.associatedAt) {
+    network.associating = false;
+    network.associationFailed = true;
+  }
+  if (network.associating && clockMicros >= network.associatedAt && accessPointReachable()) {
+    network.associating = false;
+    network.associated = true;
+    linkStats.associations++;
+    linkStats.associationMicros += clockMicros - network.associationStartedAt;
+  }
+  if (network.associated && !accessPointReachable()) {
+    network.associated = false;
+  }
+  return network.associated;
+}
+
+// ── HTTP stand-in ──
+struct HttpExchange {
+  int status;
+  std::string body;
+  uint64_t latencyMicros;
+};
+
+typedef std::function<bool(const std::string &host, const std::string &path, HttpExchange &response)> HttpRoute;
+
+struct HttpStats {
+  uint32_t requests = 0;
+  uint32_t failures = 0;
+  uint64_t bytesServed = 0;
+};
+
+inline std::vector<HttpRoute> httpRoutes;
+inline HttpStats &httpStats = persistent<HttpStats>();
+inline uint64_t httpLatencyMicros = 180000;
+inline uint32_t httpBytesPerSecond = 0;   // Response trickle rate on sockets, 0 = all at once
+
+inline std::string weatherApiCurrentBody() {
+  // Shaped like the real current.json, including the fields the sketches skip
+  char body[1400];
+  double temp = weatherTemperatureC();
+  snprintf(body, sizeof(body),
+           "{\"location\":{\"name\":\"Jessore\",\"region\":\"Khulna\",\"country\":\"Bangladesh\","
+           "\"lat\":23.17,\"lon\":89.22,\"tz_id\":\"Asia/Dhaka\",\"localtime_epoch\":%llu,"
+           "\"localtime\":\"sim\"},\"current\":{\"last_updated_epoch\":%llu,\"last_updated\":\"sim\","
+           "\"temp_c\":%.1f,\"temp_f\":%.1f,\"is_day\":%d,\"condition\":{\"text\":\"Partly cloudy\","
+           "\"icon\":\"//cdn.weatherapi.com/weather/64x64/day/116.png\",\"code\":1003},"
+           "\"wind_mph\":5.6,\"wind_kph\":9.0,\"wind_degree\":310,\"wind_dir\":\"NW\","
+           "\"pressure_mb\":1014.0,\"pressure_in\":29.94,\"precip_mm\":%.2f,\"precip_in\":0.0,"
+           "\"humidity\":%d,\"cloud\":25,\"feelslike_c\":%.1f,\"feelslike_f\":%.1f,"
+           "\"windchill_c\":%.1f,\"windchill_f\":%.1f,\"heatindex_c\":%.1f,\"heatindex_f\":%.1f,"
+           "\"dewpoint_c\":9.8,\"dewpoint_f\":49.6,\"vis_km\":10.0,\"vis_miles\":6.0,"
+           "\"uv\":3.0,\"gust_mph\":7.9,\"gust_kph\":12.7}}",
+           (unsigned long long)(EPOCH_BASE + clockMicros / 1000000), (unsigned long long)(EPOCH_BASE + clockMicros / 1000000),
+           temp, temp * 1.8 + 32, lightCounts() > 300 ? 1 : 0, rainingAt(clockMicros) ? 2.4 : 0.0,
+           rainingAt(clockMicros) ? 92 : 70,
+           temp, temp * 1.8 + 32, temp, temp * 1.8 + 32, temp, temp * 1.8 + 32);
+  return body;
+}
+
+// forecast.json for `days` days from UTC midnight, hour by hour from the
+// same temperature model, with rain predicted for the scripted spells.
+// Full-size like the real response (~17 KB per day).
+inline std::string weatherApiForecastBody(int days) {
+  std::string body = weatherApiCurrentBody();
+  body.pop_back();  // Reopen the top-level object after "current"
+  body += ",\"forecast\":{\"forecastday\":[";
+  uint64_t midnight = clockMicros - (uint64_t)(secondsOfDay() * 1e6);
+  for (int day = 0; day < days; day++) {
+    uint64_t dayStart = midnight + (uint64_t)day * 86400000000ULL;
+    unsigned long long dayEpoch = (unsigned long long)(dayStart / 1000000) + EPOCH_BASE;
+    char summary[640];
+    snprintf(summary, sizeof(summary),
+             "%s{\"date\":\"sim\",\"date_epoch\":%llu,\"day\":{\"maxtemp_c\":%.1f,\"mintemp_c\":%.1f,"
+             "\"avgtemp_c\":%.1f,\"maxwind_kph\":14.0,\"totalprecip_mm\":0.0,\"avgvis_km\":10.0,\"avghumidity\":70,"
+             "\"daily_will_it_rain\":0,\"daily_chance_of_rain\":0,\"condition\":{\"text\":\"Sunny\","
+             "\"icon\":\"//cdn.weatherapi.com/weather/64x64/day/113.png\",\"code\":1000},\"uv\":4.0},"
+             "\"astro\":{\"sunrise\":\"06:00 AM\",\"sunset\":\"06:00 PM\",\"moonrise\":\"09:12 PM\","
+             "\"moonset\":\"09:41 AM\",\"moon_phase\":\"Waning Gibbous\",\"moon_illumination\":83},\"hour\":[",
+             day ? "," : "", dayEpoch, environment.weatherTempMeanC + environment.weatherTempSwingC,
+             environment.weatherTempMeanC - environment.weatherTempSwingC, environment.weatherTempMeanC);
+    body += summary;
+    for (int hour = 0; hour < 24; hour++) {
+      uint64_t at = dayStart + (uint64_t)hour * 3600000000ULL;
+      double temp = weatherTemperatureAtC(at);
+      bool rain = rainingAt(at);
+      char entry[900];
+      snprintf(entry, sizeof(entry),
+               "%s{\"time_epoch\":%llu,\"time\":\"sim %02d:00\",\"temp_c\":%.1f,\"temp_f\":%.1f,\"is_day\":%d,"
+               "\"condition\":{\"text\":\"%s\",\"icon\":\"//cdn.weatherapi.com/weather/64x64/day/%d.png\",\"code\":%d},"
+               "\"wind_mph\":5.6,\"wind_kph\":9.0,\"wind_degree\":310,\"wind_dir\":\"NW\",\"pressure_mb\":1014.0,"
+               "\"pressure_in\":29.94,\"precip_mm\":%.1f,\"precip_in\":0.0,\"snow_cm\":0.0,\"humidity\":%d,"
+               "\"cloud\":%d,\"feelslike_c\":%.1f,\"feelslike_f\":%.1f,\"windchill_c\":%.1f,\"windchill_f\":%.1f,"
+               "\"heatindex_c\":%.1f,\"heatindex_f\":%.1f,\"dewpoint_c\":9.8,\"dewpoint_f\":49.6,"
+               "\"will_it_rain\":%d,\"chance_of_rain\":%d,\"will_it_snow\":0,\"chance_of_snow\":0,"
+               "\"vis_km\":10.0,\"vis_miles\":6.0,\"gust_mph\":7.9,\"gust_kph\":12.7,\"uv\":3.0}",
+               hour ? "," : "", (unsigned long long)(at / 1000000) + EPOCH_BASE, hour, temp, temp * 1.8 + 32,
+               hour >= 6 && hour < 18 ? 1 : 0, rain ? "Moderate rain" : "Partly cloudy", rain ? 302 : 116,
+               rain ? 1189 : 1003, rain ? 2.4 : 0.0, rain ? 92 : 70, rain ? 90 : 25, temp, temp * 1.8 + 32, temp,
+               temp * 1.8 + 32, temp, temp * 1.8 + 32, rain ? 1 : 0, rain ? 87 : 4);
+      body += entry;
+    }
+    body += "]}";
+  }
+  body += "]}}";
+  return body;
+}
+
+inline bool serveWeatherApi(const std::string &host, const std::string &path, HttpExchange &response) {
+  if (host != "api.weatherapi.com") return false;
+  response.latencyMicros = httpLatencyMicros;
+  if (path.rfind("/v1/forecast.json", 0) == 0) {
+    size_t daysParameter = path.find("days=");
+    int days = daysParameter == std::string::npos ? 1 : atoi(path.c_str() + daysParameter + 5);
+    response.status = 200;
+    response.body = weatherApiForecastBody(days < 1 ? 1 : days > 3 ? 3 : days);
+  } else if (path.rfind("/v1/current.json", 0) == 0) {
+    response.status = 200;
+    response.body = weatherApiCurrentBody();
+  } else if (path.rfind("/v1/ping.json", 0) == 0) {
+    response.status = 200;
+    response.body = "{}";
+  } else {
+    response.status = 404;
+    response.body = "{\"error\":{\"code\":1005,\"message\":\"API URL is invalid.\"}}";
+  }
+  return true;
+}
+
+// Resolve a request against the registered routes without touching the
+// clock; the caller decides how the latency is spent. Returns a negative
+// HTTPClient-style code when the link is down or no route answers the host.
+// A route refuses the connection by answering with a negative status.
+inline HttpExchange routeHttp(const std::string &host, const std::string &path) {
+  HttpExchange response = { -1, std::string(), 0 };
+  httpStats.requests++;
+  if (!linkUp()) {
+    httpStats.failures++;
+    return response;
+  }
+  bool answered = false;
+  for (const HttpRoute &route : httpRoutes) {
+    if ((answered = route(host, path, response))) break;
+  }
+  if (answered ? response.status < 0 : !serveWeatherApi(host, path, response)) {
+    httpStats.failures++;
+    return response;
+  }
+  httpStats.bytesServed += response.body.size();
+  return response;
+}
+
+// Blocking variant: the whole latency is charged to the virtual clock.
+inline HttpExchange serveHttp(const std::string &host, const std::string &path) {
+  HttpExchange response = routeHttp(host, path);
+  if (response.status >= 0) advanceMicros(response.latencyMicros);
+  return response;
+}
+
+// ── Heap ──
+// Only the large transient allocations the sketches make are modelled: a
+// fixed baseline after the core, WiFi stack and sketch globals, minus what
+// is currently taken. RAM is fresh on every boot.
+const uint32_t HEAP_BASELINE = 40000;      // Typical free heap of a sketch with WiFi and a cloud client
+inline uint32_t heapTaken = 0;
+
+struct HeapStats {
+  uint32_t peakTaken = 0;                  // Largest modelled allocation total on any boot
+};
+inline HeapStats &heapStats = persistent<HeapStats>();
+
+inline void heapAllocate(uint32_t bytes) {
+  heapTaken += bytes;
+  if (heapTaken > heapStats.peakTaken) heapStats.peakTaken = heapTaken;
+}
+
+inline void heapRelease(uint32_t bytes) {
+  heapTaken = bytes < heapTaken ? heapTaken - bytes : 0;
+}
+
+// ── Allocation counter ──
+// sim-main replaces the global operator new and reports every allocation
+// the sketch makes here, split by whether setup() or loop() was running.
+// Everything on the device that allocates (String, new, the Arduino
+// libraries' containers) goes through it in the sim as well. The sim's own
+// world model - the HTTP stand-in's responses, cloud message bookkeeping,
+// the host directory behind LittleFS - runs inside a SimAllocations scope
+// and is not counted: it lives outside the board. LittleFS's own per-file
+// allocation is tallied separately, since no sketch change can avoid it.
+enum AllocationPhase : uint8_t { ALLOCATIONS_UNCOUNTED, ALLOCATIONS_IN_SETUP, ALLOCATIONS_IN_LOOP };
+inline AllocationPhase allocationPhase = ALLOCATIONS_UNCOUNTED;
+inline uint32_t simAllocationDepth = 0;
+inline bool traceAllocations = false;      // Print a backtrace for each allocation loop() makes
+
+struct AllocationStats {
+  uint64_t setupAllocations = 0;
+  uint64_t loopAllocations = 0;
+  uint64_t loopBytes = 0;
+  uint32_t fileHandles = 0;                // LittleFS open() calls
+};
+inline AllocationStats &allocationStats = persistent<AllocationStats>();
+
+class SimAllocations {
+public:
+  SimAllocations() { simAllocationDepth++; }
+  ~SimAllocations() { simAllocationDepth--; }
+  SimAllocations(const SimAllocations &) = delete;
+  SimAllocations &operator=(const SimAllocations &) = delete;
+};
+
+// True when the allocation should be traced
+inline bool noteAllocation(size_t bytes) {
+  if (allocationPhase == ALLOCATIONS_UNCOUNTED || simAllocationDepth) return false;
+  if (allocationPhase == ALLOCATIONS_IN_SETUP) {
+    allocationStats.setupAllocations++;
+    return false;
+  }
+  allocationStats.loopAllocations++;
+  allocationStats.loopBytes += bytes;
+  return traceAllocations;
+}
+
+inline void noteFileHandle() {
+  if (allocationPhase != ALLOCATIONS_UNCOUNTED) allocationStats.fileHandles++;
+}
+
+// ── TLS stand-in ──
+// The HTTP stand-in behind port 443 speaks "TLS": no bytes are encrypted,
+// but the handshake is charged as the ESP8266 pays for it. A full
+// handshake (ECDHE + RSA-2048 certificate check in software at 80 MHz)
+// costs seconds; an abbreviated one that resumes a cached session costs
+// one round trip and some hashing. The front end keeps issued sessions for
+// a limited time and may refuse max fragment length negotiation, like many
+// CDN front ends do (--tls-session-min, --tls-no-mfln).
+struct TlsServer {
+  uint64_t fullHandshakeMicros = 1800000;
+  uint64_t resumedHandshakeMicros = 120000;
+  uint64_t sessionLifetimeMicros = 3600000000ULL;
+  bool mflnSupported = true;
+  uint16_t port = 443;
+};
+inline TlsServer tlsServer;
+
+struct TlsStats {
+  uint32_t fullHandshakes = 0;
+  uint32_t resumedHandshakes = 0;
+  uint32_t mflnProbes = 0;
+  uint64_t handshakeMicros = 0;
+};
+inline TlsStats &tlsStats = persistent<TlsStats>();
+
+// Server-side session cache; survives device resets like the real front end
+const uint8_t TLS_SESSION_CACHE_SIZE = 16;
+struct TlsSessionCache {
+  uint64_t ids[TLS_SESSION_CACHE_SIZE];
+  uint64_t issuedAt[TLS_SESSION_CACHE_SIZE];
+  uint64_t nextId;
+  uint8_t next;
+};
+inline TlsSessionCache &tlsSessionCache = persistent<TlsSessionCache>();
+
+// Handshake against the stand-in. `sessionId` is what the client offers
+// (0 = none) and is replaced with the session the server settles on.
+// Returns true when the offered session was resumed.
+inline bool tlsHandshake(uint64_t &sessionId) {
+  for (uint8_t i = 0; sessionId && i < TLS_SESSION_CACHE_SIZE; i++) {
+    if (tlsSessionCache.ids[i] == sessionId && clockMicros - tlsSessionCache.issuedAt[i] < tlsServer.sessionLifetimeMicros) {
+      advanceMicros(tlsServer.resumedHandshakeMicros);
+      tlsStats.resumedHandshakes++;
+      tlsStats.handshakeMicros += tlsServer.resumedHandshakeMicros;
+      return true;
+    }
+  }
+  advanceMicros(tlsServer.fullHandshakeMicros);
+  tlsStats.fullHandshakes++;
+  tlsStats.handshakeMicros += tlsServer.fullHandshakeMicros;
+  sessionId = ++tlsSessionCache.nextId;
+  tlsSessionCache.ids[tlsSessionCache.next] = sessionId;
+  tlsSessionCache.issuedAt[tlsSessionCache.next] = clockMicros;
+  tlsSessionCache.next = (tlsSessionCache.next + 1) % TLS_SESSION_CACHE_SIZE;
+  return false;
+}
+
+// ── Cloud backends ──
+struct CloudStats {
+  uint32_t updateCalls = 0;
+  uint32_t messagesSent = 0;     // One message per update() carrying any change
+  uint32_t propertyUpdates = 0;  // Individual property values transmitted
+  uint64_t textBytes = 0;        // Payload of String properties transmitted
+};
+inline CloudStats &cloudStats = persistent<CloudStats>();
+
+// ── Serial console ──
+inline bool echoSerial = false;
+inline std::string serialInput;
+
+// Lines typed at the console (--console). Each arrives at its virtual time
+// if the board is up then; input sent while it slept or rebooted is lost,
+// as on the device.
+struct ConsoleLine {
+  uint64_t atMicros;
+  std::string text;
+  bool delivered;
+};
+inline std::vector<ConsoleLine> consoleScript;
+
+inline void deliverConsoleInput() {
+  for (ConsoleLine &line : consoleScript) {
+    if (!line.delivered && line.atMicros >= bootMicros && line.atMicros <= clockMicros) {
+      serialInput += line.text;
+      serialInput += '\n';
+      line.delivered = true;
+    }
+  }
+}
+
+// UART0 transmit path: a 128-byte FIFO shifted out at the configured baud
+// rate. Writes that do not fit block the caller until enough of the FIFO
+// has drained, as HardwareSerial does on the device; that wait is charged
+// to the virtual clock and counted.
+struct UartStats {
+  uint64_t bytes = 0;
+  uint64_t blockedMicros = 0;
+  uint32_t blockingWrites = 0;
+};
+inline UartStats &uartStats = persistent<UartStats>();
+inline size_t uartFifoBytes = 128;
+inline uint32_t uartBaud = 115200;        // Set by Serial.begin()
+inline uint64_t uartIdleAtMicros = 0;     // clockMicros when the FIFO will be empty
+
+inline uint64_t uartByteMicros() { return 10000000ULL / uartBaud; }  // 8N1: ten bits per byte
+
+inline size_t uartQueued() {
+  if (uartIdleAtMicros <= clockMicros) return 0;
+  return (size_t)((uartIdleAtMicros - clockMicros + uartByteMicros() - 1) / uartByteMicros());
+}
+
+inline void uartTransmit(size_t count) {
+  if (uartIdleAtMicros < clockMicros) uartIdleAtMicros = clockMicros;
+  uartIdleAtMicros += count * uartByteMicros();
+  uartStats.bytes += count;
+  // The call returns once its last byte is in the FIFO
+  uint64_t fifoMicros = uartFifoBytes * uartByteMicros();
+  if (uartIdleAtMicros > clockMicros + fifoMicros) {
+    uint64_t wait = uartIdleAtMicros - fifoMicros - clockMicros;
+    uartStats.blockedMicros += wait;
+    uartStats.blockingWrites++;
+    advanceMicros(wait);
+  }
+}
+
+inline void fireTimer1() {
+  if (timer1.reload) {
+    timer1.nextFireMicros += timer1.periodMicros;
+  } else {
+    timer1.enabled = false;
+  }
+  timer1.interrupts++;
+  if (timer1.isr) timer1.isr();
+}
+
+inline void runSoftwareTimers() {
+  if (runningSoftwareTimer) return;
+  runningSoftwareTimer = true;
+  for (SoftwareTimer &timer : softwareTimers) {
+    if (!timer.armed || clockMicros < timer.nextFireMicros) continue;
+    if (timer.repeat) {
+      timer.nextFireMicros += timer.periodMicros;
+    } else {
+      timer.armed = false;
+    }
+    timer.callback();
+  }
+  runningSoftwareTimer = false;
+}
+
+inline void advanceMicros(uint64_t delta) {
+  // Integrate the environment in bounded steps so long delay() calls stay
+  // accurate, stopping at every timer1 and software timer deadline
+  uint64_t target = clockMicros + delta;
+  while (clockMicros < target) {
+    uint64_t next = std::min<uint64_t>(target, clockMicros + 1000000);
+    if (timer1.enabled && timer1.nextFireMicros < next) {
+      next = std::max(timer1.nextFireMicros, clockMicros);
+    }
+    for (const SoftwareTimer &timer : softwareTimers) {
+      if (timer.armed && !runningSoftwareTimer && timer.nextFireMicros < next) {
+        next = std::max(timer.nextFireMicros, clockMicros);
+      }
+    }
+    stepEnvironment((next - clockMicros) / 1e6);
+    clockMicros = next;
+    if (paceFactor > 0) holdPace();
+    if (timer1.enabled && clockMicros >= timer1.nextFireMicros) {
+      fireTimer1();
+    }
+    runSoftwareTimers();
+  }
+}
+
+// ── Power and reset ──
+// ESP.deepSleep() and ESP.restart() throw a ResetRequest out of the sketch;
+// sim-main catches it, powers the board down for offMicros and boots a
+// fresh copy. RTC user memory is the only device state that survives.
+const uint16_t RTC_USER_MEMORY_SIZE = 512;
+
+struct RtcUserMemory {
+  uint8_t bytes[RTC_USER_MEMORY_SIZE];
+};
+inline RtcUserMemory &rtcUserMemory = persistent<RtcUserMemory>();
+
+struct ResetRequest {
+  uint32_t reason;     // rst_info reason code reported on the next boot
+  uint64_t offMicros;  // Time the CPU is held off before booting again
+};
+
+struct PowerStats {
+  uint32_t boots = 0;
+  uint32_t deepSleeps = 0;
+  uint32_t restarts = 0;
+  uint64_t sleepMicros = 0;
+  uint64_t loopPasses = 0;
+  uint64_t longestPassMicros = 0;   // Virtual time spent inside one loop() call
+  uint64_t slowPasses = 0;          // Passes longer than slowPassMicros
+  uint32_t resetReason = 0;
+};
+inline PowerStats &power = persistent<PowerStats>();
+
+inline void recordPinWrite(uint8_t pin, int level);
+
+// Everything but the RTC domain loses power: GPIOs float (relays drop out),
+// timer1 stops and the radio disassociates.
+inline void powerDown(const ResetRequest &reset) {
+  for (uint8_t pin = 0; pin < PIN_COUNT; pin++) {
+    recordPinWrite(pin, 0);
+  }
+  timer1.enabled = false;
+  network.associating = false;
+  network.associated = false;
+  power.resetReason = reset.reason;
+  advanceMicros(reset.offMicros);
+}
+
+inline void recordPinWrite(uint8_t pin, int level) {
+  if (pin >= PIN_COUNT) return;
+  int previous = pins[pin].level;
+  pins[pin].level = level;
+  if (previous == level) return;
+
+  ActuatorStats &stats = actuatorStats[pin];
+  if (level) {
+    stats.switchCount++;
+    stats.lastOnAt = clockMicros;
+  } else {
+    stats.onMicros += clockMicros - stats.lastOnAt;
+  }
+  if (recordActuatorLog && (actuatorLogPins >> pin & 1)) {
+    actuatorLog.push_back({ clockMicros, pin, level });
+  }
+}
+
+inline uint64_t onTimeMicros(uint8_t pin) {
+  const ActuatorStats &stats = actuatorStats[pin];
+  return stats.onMicros + (pins[pin].level ? clockMicros - stats.lastOnAt : 0);
+}
+
+}  // namespace sim
@@ -0,0 +1,792 @@
+// ─────────────────────────────────────
+// EcoPulse Host Checks
+// ─────────────────────────────────────
+// Standalone driver (no sketch linked) that runs the shared firmware
+// modules on fixed inputs and asserts what they produce. Each check
+// prints one line per expectation; the exit status is 1 when any of them
+// failed. Pass check names to run a subset.
+
+#include <Arduino.h>
+
+#include <pthread.h>
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../calibration.h"
+#include "../telemetry-frame.h"
+#include "../telemetry-history.h"
+#include "../telemetry-journal.h"
+#include "../weather-client.h"
+
+namespace {
+
+uint32_t failures = 0;
+
+void expect(bool passed, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void expect(bool passed, const char *format, ...) {
+  va_list arguments;
+  va_start(arguments, format);
+  printf("  %s ", passed ? "ok  " : "FAIL");
+  vprintf(format, arguments);
+  printf("\n");
+  va_end(arguments);
+  if (!passed) failures++;
+}
+
+bool near(float value, float expected) { return std::fabs(value - expected) < 1e-4f; }
+
+// xorshift32, for reproducible pseudo-random inputs
+uint32_t xorshift(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// Every operator new in the process is counted, so a check can assert that
+// the code it runs does not touch the heap.
+uint32_t allocations = 0;
+
+}  // namespace
+
+void *operator new(size_t size) {
+  allocations++;
+  void *block = malloc(size ? size : 1);
+  if (!block) throw std::bad_alloc();
+  return block;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *block) noexcept { free(block); }
+void operator delete[](void *block) noexcept { free(block); }
+void operator delete(void *block, size_t) noexcept { free(block); }
+void operator delete[](void *block, size_t) noexcept { free(block); }
+
+namespace {
+
+// Bytes of stack `work` touches: it runs on a thread whose stack was
+// painted beforehand, and the deepest overwritten byte marks the high-water
+// point. Thread start-up is measured the same way and subtracted, and a
+// first unmeasured run takes the dynamic linker's symbol binding out of it.
+const size_t PAINTED_STACK_BYTES = 64 * 1024;
+alignas(4096) uint8_t paintedStack[PAINTED_STACK_BYTES];
+
+void *runOnPaintedStack(void *work) {
+  ((void (*)())work)();
+  return nullptr;
+}
+
+size_t paintedStackDepth(void (*work)()) {
+  memset(paintedStack, 0xA5, sizeof(paintedStack));
+  pthread_attr_t attributes;
+  pthread_attr_init(&attributes);
+  pthread_attr_setstack(&attributes, paintedStack, sizeof(paintedStack));
+  pthread_t thread;
+  pthread_create(&thread, &attributes, runOnPaintedStack, (void *)work);
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attributes);
+  size_t untouched = 0;
+  while (untouched < sizeof(paintedStack) && paintedStack[untouched] == 0xA5) untouched++;
+  return sizeof(paintedStack) - untouched;
+}
+
+size_t stackUsed(void (*work)()) {
+  static const size_t threadStart = paintedStackDepth([] {});
+  paintedStackDepth(work);
+  const size_t depth = paintedStackDepth(work);
+  return depth > threadStart ? depth - threadStart : 0;
+}
+
+// current.json as the API returned it before the feels-like, dew point and
+// radiation fields were added: compact, a below-zero reading in snow.
+const char RECORDED_CURRENT_SMALL[] =
+    R"json({"location":{"name":"Dhaka","region":"","country":"Bangladesh","lat":23.72,"lon":90.41,"tz_id":"Asia/Dhaka","localtime_epoch":1673061300,"localtime":"2023-01-07 9:15"},"current":{"temp_c":-3.4,"is_day":1,"condition":{"text":"Light snow","code":1213},"precip_mm":0.3,"humidity":93,"cloud":100}})json";
+
+// current.json with aqi=no, compact, as the sketches request it today.
+const char RECORDED_CURRENT_TYPICAL[] =
+    R"json({"location":{"name":"Jessore","region":"Khulna","country":"Bangladesh","lat":23.1667,"lon":89.2167,"tz_id":"Asia/Dhaka","localtime_epoch":1760680800,"localtime":"2025-10-17 12:00"},"current":{"last_updated_epoch":1760680500,"last_updated":"2025-10-17 11:55","temp_c":27.8,"temp_f":82.0,"is_day":1,"condition":{"text":"Patchy rain nearby","icon":"//cdn.weatherapi.com/weather/64x64/day/176.png","code":1063},"wind_mph":8.3,"wind_kph":13.3,"wind_degree":187,"wind_dir":"S","pressure_mb":1007.0,"pressure_in":29.74,"precip_mm":1.45,"precip_in":0.06,"humidity":84,"cloud":75,"feelslike_c":31.9,"feelslike_f":89.4,"windchill_c":27.8,"windchill_f":82.0,"heatindex_c":31.9,"heatindex_f":89.4,"dewpoint_c":24.9,"dewpoint_f":76.8,"vis_km":10.0,"vis_miles":6.0,"uv":4.6,"gust_mph":10.7,"gust_kph":17.2,"short_rad":298.55,"diff_rad":141.02,"dni":183.4,"gti":267.31}})json";
+
+// What the API answers with status 200 for some key errors: no "current".
+const char RECORDED_ERROR[] = R"json({"error":{"code":1006,"message":"No matching location found."}})json";
+
+// current.json with aqi=yes and lang=bn, indented: the condition text in
+// Bengali, the solar radiation fields of newer API versions and the air
+// quality block, whose nested members must not be taken for the ones in
+// "current".
+const char RECORDED_CURRENT_LARGE[] = R"json({
+    "location": {
+        "name": "Jessore",
+        "region": "Khulna",
+        "country": "Bangladesh",
+        "lat": 23.1667,
+        "lon": 89.2167,
+        "tz_id": "Asia/Dhaka",
+        "localtime_epoch": 1760680800,
+        "localtime": "2025-10-17 12:00"
+    },
+    "current": {
+        "last_updated_epoch": 1760680500,
+        "last_updated": "2025-10-17 11:55",
+        "temp_c": 31.2,
+        "temp_f": 88.2,
+        "is_day": 1,
+        "condition": {
+            "text": "আংশিক মেঘলা",
+            "icon": "//cdn.weatherapi.com/weather/64x64/day/116.png",
+            "code": 1003
+        },
+        "wind_mph": 6.0,
+        "wind_kph": 9.7,
+        "wind_degree": 192,
+        "wind_dir": "SSW",
+        "pressure_mb": 1008.0,
+        "pressure_in": 29.77,
+        "precip_mm": 0.12,
+        "precip_in": 0.0,
+        "humidity": 66,
+        "cloud": 37,
+        "feelslike_c": 36.4,
+        "feelslike_f": 97.5,
+        "windchill_c": 31.2,
+        "windchill_f": 88.2,
+        "heatindex_c": 36.4,
+        "heatindex_f": 97.5,
+        "dewpoint_c": 24.1,
+        "dewpoint_f": 75.4,
+        "vis_km": 10.0,
+        "vis_miles": 6.0,
+        "uv": 8.1,
+        "gust_mph": 6.9,
+        "gust_kph": 11.1,
+        "short_rad": 612.43,
+        "diff_rad": 148.27,
+        "dni": 701.9,
+        "gti": 455.16,
+        "air_quality": {
+            "co": 474.5,
+            "no2": 12.3,
+            "o3": 71.0,
+            "so2": 8.5,
+            "pm2_5": 38.9,
+            "pm10": 52.1,
+            "us-epa-index": 2,
+            "gb-defra-index": 4
+        }
+    }
+})json";
+
+// ── weather-parse ──
+// parseWeatherConditions() and WeatherConditionsScanner on recorded
+// current.json bodies from 0.3 to 1.6 KB: whole, from a Stream and one
+// byte per write() as the slowest server would deliver them. The fields
+// must match in every case, no allocation may happen, and the stack the
+// parse needs must not grow with the body.
+struct RecordedBody {
+  const char *name;
+  const char *text;
+  float temperatureC;
+  float humidity;
+  float precipitationMm;
+};
+
+const RecordedBody RECORDED_BODIES[] = {
+  { "small", RECORDED_CURRENT_SMALL, -3.4f, 93, 0.3f },
+  { "typical", RECORDED_CURRENT_TYPICAL, 27.8f, 84, 1.45f },
+  { "large", RECORDED_CURRENT_LARGE, 31.2f, 66, 0.12f },
+};
+
+class BodyStream : public Stream {
+public:
+  BodyStream(const char *text, size_t length) : text(text), length(length) {}
+  int available() override { return (int)(length - position); }
+  int read() override { return position < length ? (uint8_t)text[position++] : -1; }
+  int peek() override { return position < length ? (uint8_t)text[position] : -1; }
+  size_t write(uint8_t) override { return 0; }
+
+private:
+  const char *text;
+  size_t length;
+  size_t position = 0;
+};
+
+const RecordedBody *stackBody = nullptr;
+volatile double convertedNumber;
+
+void parseStackBody() {
+  WeatherConditions conditions;
+  parseWeatherConditions(conditions, stackBody->text, strlen(stackBody->text));
+}
+
+void convertNumber() { convertedNumber = atof("31.2"); }
+
+void checkWeatherParse() {
+  printf("weather-parse (recorded current.json bodies, scanner state %zu B)\n", sizeof(WeatherConditionsScanner));
+  size_t smallestStack = SIZE_MAX, deepestStack = 0;
+  for (const RecordedBody &body : RECORDED_BODIES) {
+    const size_t length = strlen(body.text);
+    const uint32_t allocationsBefore = allocations;
+
+    WeatherConditions whole;
+    const bool wholeParsed = parseWeatherConditions(whole, body.text, length);
+    WeatherConditions streamed;
+    BodyStream stream(body.text, length);
+    const bool streamParsed = parseWeatherConditions(streamed, stream);
+    WeatherConditionsScanner scanner;
+    scanner.reset();
+    for (size_t i = 0; i < length; i++) scanner.write((uint8_t)body.text[i]);
+    const uint32_t allocated = allocations - allocationsBefore;
+
+    expect(wholeParsed && streamParsed && scanner.complete(), "%s (%zu B): parsed whole, from a Stream and byte by byte",
+           body.name, length);
+    for (const WeatherConditions *conditions : { &whole, &streamed, &scanner.conditions }) {
+      const bool matches = near(conditions->temperatureC, body.temperatureC) &&
+                           near(conditions->humidity, body.humidity) &&
+                           near(conditions->precipitationMm, body.precipitationMm);
+      const char *path = conditions == &whole ? "whole" : conditions == &streamed ? "stream" : "bytes";
+      expect(matches, "%s %s: temp_c %.2f, humidity %.0f, precip_mm %.2f", body.name, path, conditions->temperatureC,
+             conditions->humidity, conditions->precipitationMm);
+    }
+    expect(allocated == 0, "%s: %u heap allocations", body.name, allocated);
+
+    stackBody = &body;
+    const size_t stack = stackUsed(parseStackBody);
+    smallestStack = std::min(smallestStack, stack);
+    deepestStack = std::max(deepestStack, stack);
+  }
+  const size_t conversionStack = stackUsed(convertNumber);
+  expect(deepestStack <= 2048, "stack high-water mark %zu B (%zu B of it the host's atof()), within half the 4 KB loop stack",
+         deepestStack, conversionStack);
+  expect(deepestStack - smallestStack <= 64, "stack from the smallest to the largest body grows %zu B",
+         deepestStack - smallestStack);
+
+  WeatherConditions conditions;
+  expect(!parseWeatherConditions(conditions, RECORDED_ERROR, strlen(RECORDED_ERROR)) && std::isnan(conditions.temperatureC),
+         "error body without \"current\" rejected");
+  const size_t cut = strlen(RECORDED_CURRENT_TYPICAL) / 2;
+  expect(!parseWeatherConditions(conditions, RECORDED_CURRENT_TYPICAL, cut), "typical body cut at %zu B rejected", cut);
+  const size_t beforeClose = strlen(RECORDED_CURRENT_LARGE) - 1;
+  expect(!parseWeatherConditions(conditions, RECORDED_CURRENT_LARGE, beforeClose),
+         "large body missing its closing brace rejected");
+}
+
+// ── calibration ──
+// CalibrationTable::twoPoint() must reproduce constrain(map()) for every
+// raw count: the table the sketches ship, and tables regenerated at run
+// time from field references as `calibrate` does.
+void checkCalibration() {
+  printf("calibration (%zu-byte tables)\n", sizeof(CalibrationTable<>));
+  constexpr CalibrationTable<> SHIPPED = CalibrationTable<>::twoPoint({ 1023, 0 }, { 0, 100 }, 0, 100);
+  uint32_t differ = 0;
+  for (uint16_t raw = 0; raw <= CalibrationTable<>::RAW_MAX; raw++) {
+    differ += SHIPPED.convert(raw) != constrain(map(raw, 1023, 0, 0, 100), 0, 100);
+  }
+  expect(!differ, "shipped moisture table: %u of 1024 counts differ from map()", differ);
+
+  uint32_t state = 0x6A09E667, tables = 0, tablesDiffering = 0;
+  for (; tables < 2000; tables++) {
+    const uint16_t dry = 520 + xorshift(state) % 504;
+    const uint16_t wet = xorshift(state) % 500;
+    const CalibrationTable<> field = CalibrationTable<>::twoPoint({ dry, 0 }, { wet, 100 }, 0, 100);
+    for (uint16_t raw = 0; raw <= CalibrationTable<>::RAW_MAX; raw++) {
+      if (field.convert(raw) != constrain(map(raw, dry, wet, 0, 100), 0, 100)) {
+        tablesDiffering++;
+        break;
+      }
+    }
+  }
+  expect(!tablesDiffering, "%u of %u field recalibrations differ from map() at some count", tablesDiffering, tables);
+}
+
+// ── telemetry-frame ──
+// encodeTelemetryFrame()/decodeTelemetryFrame(): the documented byte
+// layout, the CRC's standard check value, a round trip over edge and
+// random samples, and rejection of every single-bit error and of each kind
+// of malformed datagram.
+bool sameFrame(const TelemetryFrame &frame, uint16_t sequence, uint32_t deviceId, const TelemetrySample &sample) {
+  return frame.version == TELEMETRY_FRAME_VERSION && frame.sequence == sequence && frame.deviceId == deviceId &&
+         frame.sample.timestamp == sample.timestamp && frame.sample.temperatureDeci == sample.temperatureDeci &&
+         frame.sample.light == sample.light && frame.sample.moisture == sample.moisture && frame.sample.flags == sample.flags;
+}
+
+void checkTelemetryFrame() {
+  printf("telemetry-frame (%zu-byte frames)\n", TELEMETRY_FRAME_SIZE);
+  const uint8_t CHECK_INPUT[] = "123456789";
+  const uint16_t checkValue = telemetryFrameCrc(CHECK_INPUT, 9);
+  expect(checkValue == 0x29B1, "CRC-16/CCITT-FALSE of \"123456789\" is 0x%04X (0x29B1)", checkValue);
+
+  const TelemetrySample known = { 0x11223344, -123, 900, 42, TELEMETRY_FLAG_PUMP | TELEMETRY_FLAG_FAILSAFE };
+  const uint8_t KNOWN_LAYOUT[TELEMETRY_FRAME_SIZE - 2] = { 0xEC, 0x01, 0xEF, 0xBE, 0x01, 0x00, 0x00, 0xEC, 0x44,
+                                                           0x33, 0x22, 0x11, 0x85, 0xFF, 0x84, 0x03, 0x2A, 0x05 };
+  uint8_t frame[TELEMETRY_FRAME_SIZE + 4] = {};
+  const size_t written = encodeTelemetryFrame(frame, 0xBEEF, 0xEC000001, known);
+  const uint16_t crc = telemetryFrameCrc(frame, TELEMETRY_FRAME_SIZE - 2);
+  expect(written == TELEMETRY_FRAME_SIZE && !memcmp(frame, KNOWN_LAYOUT, sizeof(KNOWN_LAYOUT)) &&
+             frame[18] == (uint8_t)crc && frame[19] == (uint8_t)(crc >> 8),
+         "fields little-endian at their documented offsets, CRC last");
+
+  TelemetryFrame decoded;
+  expect(decodeTelemetryFrame(frame, sizeof(frame), decoded) == TELEMETRY_FRAME_OK &&
+             sameFrame(decoded, 0xBEEF, 0xEC000001, known),
+         "bytes past the frame are ignored");
+  TelemetryFrame untouched = {};
+  TelemetryFrameStatus status = decodeTelemetryFrame(frame, TELEMETRY_FRAME_SIZE - 1, untouched);
+  expect(status == TELEMETRY_FRAME_TRUNCATED && untouched.deviceId == 0, "19 bytes: %s, frame not written",
+         telemetryFrameStatusName(status));
+  frame[0] ^= 0xFF;
+  status = decodeTelemetryFrame(frame, TELEMETRY_FRAME_SIZE, decoded);
+  expect(status == TELEMETRY_FRAME_BAD_MAGIC, "wrong magic: %s", telemetryFrameStatusName(status));
+  frame[0] ^= 0xFF;
+  frame[1] = TELEMETRY_FRAME_VERSION + 1;
+  status = decodeTelemetryFrame(frame, TELEMETRY_FRAME_SIZE, decoded);
+  expect(status == TELEMETRY_FRAME_UNKNOWN_VERSION, "version %u: %s", frame[1], telemetryFrameStatusName(status));
+
+  const TelemetrySample EDGES[] = {
+    { 0, 0, 0, 0, 0 },
+    { UINT32_MAX, INT16_MAX, UINT16_MAX, UINT8_MAX, UINT8_MAX },
+    { 86400, TELEMETRY_TEMPERATURE_UNKNOWN, 1023, 100, TELEMETRY_FLAG_LIGHTS },
+    { 1760680800, telemetryTemperature(-40.05f), 1, 0, 0 },
+  };
+  uint32_t roundTrips = 0, mismatches = 0, corruptions = 0, corruptAccepted = 0;
+  uint32_t state = 0x2545F491;
+  for (uint32_t i = 0; i < 4096 + sizeof(EDGES) / sizeof(EDGES[0]); i++) {
+    TelemetrySample sample;
+    if (i < sizeof(EDGES) / sizeof(EDGES[0])) {
+      sample = EDGES[i];
+    } else {
+      sample.timestamp = xorshift(state);
+      sample.temperatureDeci = (int16_t)(xorshift(state) >> 16);
+      sample.light = xorshift(state) >> 3;
+      sample.moisture = xorshift(state) >> 11;
+      sample.flags = xorshift(state) >> 24;
+    }
+    const uint16_t sequence = i == 1 ? UINT16_MAX : (uint16_t)(i * 7919);
+    const uint32_t deviceId = i == 1 ? UINT32_MAX : 0x00C0FFEE ^ i;
+    encodeTelemetryFrame(frame, sequence, deviceId, sample);
+    roundTrips++;
+    if (decodeTelemetryFrame(frame, TELEMETRY_FRAME_SIZE, decoded) != TELEMETRY_FRAME_OK ||
+        !sameFrame(decoded, sequence, deviceId, sample)) {
+      mismatches++;
+    }
+    for (size_t bit = 0; bit < TELEMETRY_FRAME_SIZE * 8; bit++) {
+      frame[bit / 8] ^= 1 << (bit % 8);
+      corruptAccepted += decodeTelemetryFrame(frame, TELEMETRY_FRAME_SIZE, decoded) == TELEMETRY_FRAME_OK;
+      corruptions++;
+      frame[bit / 8] ^= 1 << (bit % 8);
+    }
+  }
+  expect(!mismatches, "round trip: %u of %u frames differ", mismatches, roundTrips);
+  expect(!corruptAccepted, "%u of %u single-bit errors accepted", corruptAccepted, corruptions);
+}
+
+// ── history ──
+// TelemetryHistory over two days of 1 Hz samples with noise, outages and a
+// spell without a temperature reading: the raw tier must decode to exactly
+// the newest samples appended, and every hourly and minute rollup must
+// match a recount of the trace.
+std::vector<TelemetrySample> historyCheckTrace() {
+  std::vector<TelemetrySample> trace;
+  uint32_t state = 0x9E3779B9;
+  for (uint32_t second = 0; second < 2 * 86400; second++) {
+    if (second % 18000 >= 9000 && second % 18000 < 9420) continue;   // A 7-minute outage every 5 h
+    const uint32_t noise = xorshift(state);
+    const double day = (second % 86400) / 86400.0;
+    const bool pump = second % 14400 < 180;
+    TelemetrySample sample;
+    sample.timestamp = 3600 + second;
+    sample.temperatureDeci = second >= 100000 && second < 104000
+                                 ? TELEMETRY_TEMPERATURE_UNKNOWN
+                                 : (int16_t)lround(-20 + 180 * std::sin(day * 2 * M_PI)) + (int16_t)(noise % 3);
+    sample.light = (uint16_t)(std::max(0.0, std::sin((day - 0.25) * 2 * M_PI)) * 1000 + (noise >> 8) % 16);
+    sample.moisture = (uint8_t)(pump ? 45 : 45 - (second % 14400) / 1200);
+    sample.flags = (pump ? TELEMETRY_FLAG_PUMP : 0) | (sample.light < 300 ? TELEMETRY_FLAG_LIGHTS : 0);
+    trace.push_back(sample);
+  }
+  return trace;
+}
+
+// The rollup TelemetryHistory should hold for [from, to), counted directly
+HistoryRollup recount(const std::vector<TelemetrySample> &trace, uint32_t from, uint32_t to) {
+  HistoryRollup expected = { 0, 0, INT16_MAX, INT16_MIN, 0, UINT16_MAX, 0, 0, UINT8_MAX, 0, 0, 0 };
+  int64_t temperatureSum = 0;
+  uint32_t temperatureSamples = 0;
+  uint64_t lightSum = 0, moistureSum = 0;
+  for (const TelemetrySample &sample : trace) {
+    if (sample.timestamp < from || sample.timestamp >= to) continue;
+    expected.samples++;
+    expected.pumpSamples += (sample.flags & TELEMETRY_FLAG_PUMP) != 0;
+    expected.flags |= sample.flags;
+    if (sample.temperatureDeci != TELEMETRY_TEMPERATURE_UNKNOWN) {
+      temperatureSamples++;
+      temperatureSum += sample.temperatureDeci;
+      expected.temperatureMin = std::min(expected.temperatureMin, sample.temperatureDeci);
+      expected.temperatureMax = std::max(expected.temperatureMax, sample.temperatureDeci);
+    }
+    lightSum += sample.light;
+    expected.lightMin = std::min(expected.lightMin, sample.light);
+    expected.lightMax = std::max(expected.lightMax, sample.light);
+    moistureSum += sample.moisture;
+    expected.moistureMin = std::min(expected.moistureMin, sample.moisture);
+    expected.moistureMax = std::max(expected.moistureMax, sample.moisture);
+  }
+  if (!temperatureSamples) {
+    expected.temperatureMin = expected.temperatureMax = expected.temperatureMean = TELEMETRY_TEMPERATURE_UNKNOWN;
+  } else {
+    expected.temperatureMean = (int16_t)lround((double)temperatureSum / temperatureSamples);
+  }
+  if (expected.samples) {
+    expected.lightMean = (uint16_t)((lightSum + expected.samples / 2) / expected.samples);
+    expected.moistureMean = (uint8_t)((moistureSum + expected.samples / 2) / expected.samples);
+  }
+  return expected;
+}
+
+bool sameRollup(const HistoryRollup &rollup, const HistoryRollup &expected) {
+  if (rollup.samples != expected.samples) return false;
+  if (!expected.samples) return true;
+  return rollup.pumpSamples == expected.pumpSamples && rollup.flags == expected.flags &&
+         rollup.temperatureMin == expected.temperatureMin && rollup.temperatureMax == expected.temperatureMax &&
+         rollup.temperatureMean == expected.temperatureMean && rollup.lightMin == expected.lightMin &&
+         rollup.lightMax == expected.lightMax && rollup.lightMean == expected.lightMean &&
+         rollup.moistureMin == expected.moistureMin && rollup.moistureMax == expected.moistureMax &&
+         rollup.moistureMean == expected.moistureMean;
+}
+
+void checkHistory() {
+  const std::vector<TelemetrySample> trace = historyCheckTrace();
+  static TelemetryHistory<> history;
+  history.clear();
+  for (const TelemetrySample &sample : trace) history.append(sample);
+  TelemetrySample stale = trace[trace.size() - 10];
+  history.append(stale);
+  const TelemetryHistoryStats &stats = history.stats();
+  const uint32_t newest = trace.back().timestamp;
+  printf("history (%zu samples over 2 days, %u B)\n", trace.size(), (unsigned)history.memoryBytes());
+
+  expect(stats.appended == trace.size() && stats.rejected == 1, "%u appended, %u older than the newest rejected",
+         stats.appended, stats.rejected);
+  size_t decoded = 0, mismatches = 0;
+  const size_t firstRetained = trace.size() - stats.retainedSamples;
+  history.forEachSample(0, UINT32_MAX, [&](const TelemetrySample &sample) {
+    const TelemetrySample &expected = trace[firstRetained + decoded++];
+    mismatches += sample.timestamp != expected.timestamp || sample.temperatureDeci != expected.temperatureDeci ||
+                  sample.light != expected.light || sample.moisture != expected.moisture || sample.flags != expected.flags;
+  });
+  expect(decoded == stats.retainedSamples && decoded > 0 && !mismatches,
+         "raw tier: %zu newest samples (%.1f min, %.2f bits each) decoded, %zu differ", decoded,
+         (stats.newestRaw - stats.oldestRaw + 1) / 60.0, stats.bitsPerSample(), mismatches);
+
+  for (HistoryResolution resolution : { HISTORY_MINUTE, HISTORY_QUARTER, HISTORY_HOUR }) {
+    const uint32_t period = historyPeriodSeconds(resolution);
+    size_t intervals = 0, empty = 0, differ = 0;
+    history.forEachRollup(resolution, 0, UINT32_MAX, [&](uint32_t start, const HistoryRollup &interval) {
+      intervals++;
+      empty += interval.samples == 0;
+      differ += !sameRollup(interval, recount(trace, start, start + period));
+    });
+    expect(intervals > 0 && !differ, "%u s rollups: %zu of %zu differ from a recount (%zu empty)", period, differ,
+           intervals, empty);
+  }
+
+  HistoryRollup day;
+  history.summarize(HISTORY_HOUR, newest - 86400, newest + 1, day);
+  // Hours starting in the window; means are merged from rounded hourly means, so only counts and extremes are exact
+  HistoryRollup expected = recount(trace, (newest - 86400 + 3599) / 3600 * 3600, newest + 1);
+  expect(day.samples == expected.samples && day.pumpSamples == expected.pumpSamples &&
+             day.temperatureMin == expected.temperatureMin && day.temperatureMax == expected.temperatureMax &&
+             day.lightMax == expected.lightMax && day.moistureMin == expected.moistureMin,
+         "24 h summary: %u samples, %u pumping, %.1f..%.1f C (recount %u, %u, %.1f..%.1f C)", day.samples,
+         day.pumpSamples, day.temperatureMin / 10.0, day.temperatureMax / 10.0, expected.samples, expected.pumpSamples,
+         expected.temperatureMin / 10.0, expected.temperatureMax / 10.0);
+}
+
+// ── slow-weather ──
+// AsyncWeatherClient::fetch() against a 3 s, 400 B/s stand-in serving a
+// body larger than any fixed buffer the client could hold. The body must
+// parse slice by slice, and no loop pass may wait on the response.
+struct FetchOutcome {
+  bool delivered = false;
+  uint32_t handlerCalls = 0;
+  WeatherFetchResult result = { 0, true };
+  WeatherConditions conditions;
+};
+FetchOutcome fetchOutcome;
+
+void onFetched(const WeatherFetchResult &result, const WeatherConditions &conditions) {
+  fetchOutcome.delivered = true;
+  fetchOutcome.handlerCalls++;
+  fetchOutcome.result = result;
+  fetchOutcome.conditions = conditions;
+}
+
+void checkSlowWeather() {
+  const uint64_t LATENCY_MICROS = 3000000;
+  const uint32_t BYTES_PER_SECOND = 400;
+  const uint64_t LOOP_QUANTUM_MICROS = 5000;
+  const std::string body = RECORDED_CURRENT_LARGE;
+
+  printf("slow-weather (current.json of %zu B at %u B/s after %.1f s)\n", body.size(), BYTES_PER_SECOND,
+         LATENCY_MICROS / 1e6);
+  sim::network.associated = true;
+  sim::httpRoutes.push_back([&](const std::string &host, const std::string &path, sim::HttpExchange &response) {
+    if (host != "api.weatherapi.com" || path.rfind("/v1/current.json", 0) != 0) return false;
+    response.status = 200;
+    response.body = body;
+    response.latencyMicros = LATENCY_MICROS;
+    return true;
+  });
+  sim::httpBytesPerSecond = BYTES_PER_SECOND;
+
+  WeatherServiceConnection service("api.weatherapi.com");
+  AsyncWeatherClient client(service);
+  fetchOutcome = FetchOutcome();
+  const uint64_t started = sim::clockMicros;
+  expect(client.fetch("/v1/current.json?key=check&q=Jessore&aqi=yes&lang=bn", onFetched), "request queued");
+
+  uint32_t passes = 0;
+  uint64_t longestPass = 0;
+  while (!fetchOutcome.delivered && sim::clockMicros - started < 60000000) {
+    const uint64_t passStart = sim::clockMicros;
+    client.poll();
+    longestPass = std::max(longestPass, sim::clockMicros - passStart);
+    passes++;
+    sim::advanceMicros(LOOP_QUANTUM_MICROS);
+  }
+  const double elapsed = (sim::clockMicros - started) / 1e6;
+  const double transfer = LATENCY_MICROS / 1e6 + (double)body.size() / BYTES_PER_SECOND;
+
+  expect(body.size() > 1536, "body is %zu B, over the 1536 B buffer the client used to copy it into", body.size());
+  expect(fetchOutcome.handlerCalls == 1, "handler called once (%u)", fetchOutcome.handlerCalls);
+  expect(fetchOutcome.result.httpCode == HTTP_CODE_OK, "status %d", fetchOutcome.result.httpCode);
+  expect(!fetchOutcome.result.parseError, "body parsed");
+  expect(near(fetchOutcome.conditions.temperatureC, 31.2f), "temp_c %.2f", fetchOutcome.conditions.temperatureC);
+  expect(near(fetchOutcome.conditions.humidity, 66), "humidity %.2f", fetchOutcome.conditions.humidity);
+  expect(near(fetchOutcome.conditions.precipitationMm, 0.12f), "precip_mm %.2f", fetchOutcome.conditions.precipitationMm);
+  expect(elapsed >= transfer, "delivered after %.2f s (transfer takes %.2f s)", elapsed, transfer);
+  expect(passes > 1000, "response spread over %u loop passes", passes);
+  expect(longestPass <= 200000, "longest pass %.1f ms (DNS lookup and TCP connect only)", longestPass / 1000.0);
+  expect(service.stats().requests == 1 && service.stats().failures == 0, "%u request, %u failed",
+         service.stats().requests, service.stats().failures);
+
+  sim::httpRoutes.clear();
+  sim::httpBytesPerSecond = 0;
+}
+
+// ── journal-batch ──
+// A replay batch larger than the text buffer: only the records that fit are
+// published, so re-reading that many and committing must leave the rest in
+// the backlog for the next batch, in order.
+void checkJournalBatch() {
+  const size_t RECORDS = 12;
+  printf("journal-batch (%zu records, text buffer for fewer)\n", RECORDS);
+  char directory[] = "/tmp/ecopulse-check-XXXXXX";
+  if (!mkdtemp(directory)) {
+    expect(false, "temporary flash directory");
+    return;
+  }
+  sim::flashDirectory = directory;
+
+  TelemetryJournal journal;
+  expect(journal.begin(), "journal mounted");
+  for (size_t i = 0; i < RECORDS; i++) {
+    TelemetryRecord record = {};
+    record.timestamp = 1000 + 60 * i;
+    record.temperatureDeci = 250 + i;
+    record.moisture = 30 + i;
+    journal.append(record);
+  }
+
+  TelemetryRecord batch[RECORDS];
+  size_t count = journal.readBatch(batch, RECORDS);
+  char text[4 * TELEMETRY_BATCH_FIELD_MAX + 1];
+  size_t fitted = formatTelemetryBatch(text, sizeof(text), batch, count, 2000);
+  expect(count == RECORDS, "read %zu of %zu", count, RECORDS);
+  expect(fitted > 0 && fitted < count, "%zu records fit in %zu B", fitted, sizeof(text));
+  expect(strlen(text) < sizeof(text), "text %zu B", strlen(text));
+
+  size_t reread = journal.readBatch(batch, fitted);
+  journal.commit();
+  expect(reread == fitted, "re-read %zu", reread);
+  expect(journal.backlog() == RECORDS - fitted, "backlog %u after commit (expected %zu)", journal.backlog(),
+         RECORDS - fitted);
+  expect(journal.stats().replayed == fitted, "%u replayed", journal.stats().replayed);
+
+  TelemetryRecord next = {};
+  size_t nextCount = journal.readBatch(&next, 1);
+  expect(nextCount == 1 && next.timestamp == 1000 + 60 * fitted, "next batch starts at record %zu (timestamp %u)",
+         fitted, next.timestamp);
+
+  std::error_code error;
+  std::filesystem::remove_all(directory, error);
+  sim::flashDirectory.clear();
+}
+
+// ── bulk-weather ──
+// A forecast.json-sized body streamed through AsyncWeatherClient by a loop
+// paced at 1 s, as in the sketches, with a probe queued behind it. Bytes
+// already in the socket are drained past POLL_SLICE within one pass, so
+// neither the body nor the probe waits a pass per TCP segment.
+struct CountingSink : public Print {
+  size_t bytes = 0;
+  size_t write(uint8_t) override {
+    bytes++;
+    return 1;
+  }
+};
+
+struct StatusOutcome {
+  uint32_t pass = 0;
+  int httpCode = 0;
+};
+StatusOutcome streamOutcome, probeOutcome;
+uint32_t bulkPass = 0;
+
+void checkBulkWeather() {
+  const size_t BODY_BYTES = 35000;
+  const uint64_t LOOP_PERIOD_MICROS = 1000000;
+  const std::string body(BODY_BYTES, ' ');
+
+  printf("bulk-weather (%zu B forecast.json and a probe, loop paced at 1 s)\n", BODY_BYTES);
+  sim::network.associated = true;
+  sim::httpRoutes.push_back([&](const std::string &host, const std::string &path, sim::HttpExchange &response) {
+    if (host != "api.weatherapi.com") return false;
+    response.status = 200;
+    response.body = path.rfind("/v1/forecast.json", 0) == 0 ? body : std::string("{}");
+    return true;
+  });
+
+  WeatherServiceConnection service("api.weatherapi.com");
+  AsyncWeatherClient client(service);
+  CountingSink sink;
+  streamOutcome = StatusOutcome();
+  probeOutcome = StatusOutcome();
+  expect(client.stream("/v1/forecast.json?key=check&q=Jessore&days=2", sink,
+                       [](const WeatherFetchResult &result, const WeatherConditions &) {
+                         streamOutcome = { bulkPass, result.httpCode };
+                       }),
+         "forecast queued");
+  expect(client.probe("/v1/ping.json", [](const WeatherFetchResult &result, const WeatherConditions &) {
+           probeOutcome = { bulkPass, result.httpCode };
+         }),
+         "probe queued behind it");
+
+  for (bulkPass = 1; bulkPass <= 60 && !client.idle(); bulkPass++) {
+    client.poll();
+    sim::advanceMicros(LOOP_PERIOD_MICROS);
+  }
+
+  const uint32_t segments = (BODY_BYTES + WeatherServiceConnection::POLL_SLICE - 1) / WeatherServiceConnection::POLL_SLICE;
+  expect(streamOutcome.httpCode == HTTP_CODE_OK && sink.bytes == BODY_BYTES, "forecast: status %d, %zu B streamed",
+         streamOutcome.httpCode, sink.bytes);
+  expect(streamOutcome.pass <= 2, "forecast delivered on pass %u (%u slices of %u B)", streamOutcome.pass, segments,
+         WeatherServiceConnection::POLL_SLICE);
+  expect(probeOutcome.httpCode == HTTP_CODE_OK && probeOutcome.pass <= streamOutcome.pass + 2,
+         "probe: status %d on pass %u", probeOutcome.httpCode, probeOutcome.pass);
+  expect(service.stats().handshakes == 1 && service.stats().handshakesSaved == 1,
+         "%u connect, %u request on the kept socket", service.stats().handshakes, service.stats().handshakesSaved);
+
+  sim::httpRoutes.clear();
+}
+
+// ── tls-refresh ──
+// The HTTPS connection at the request spacings the sketches use. Within the
+// server's idle timeout the socket is reused; after it, within the session
+// lifetime, the session resumes; at the 6-hourly forecast refresh both are
+// gone and the connection pays a full handshake, as the README states.
+StatusOutcome refreshOutcome;
+
+void checkTlsRefresh() {
+  const uint64_t MINUTE_MICROS = 60000000ULL;
+  const uint64_t STEP_MICROS = 5000;
+
+  printf("tls-refresh (requests 1 min, 10 min and 6 h apart; %llu min sessions, %llu s idle timeout)\n",
+         (unsigned long long)(sim::tlsServer.sessionLifetimeMicros / MINUTE_MICROS),
+         (unsigned long long)(sim::network.serverIdleTimeoutMicros / 1000000));
+  sim::network.associated = true;
+  sim::httpRoutes.push_back([](const std::string &host, const std::string &, sim::HttpExchange &response) {
+    if (host != "api.weatherapi.com") return false;
+    response.status = 200;
+    response.body = "{}";
+    return true;
+  });
+
+  WeatherServiceConnection service("api.weatherapi.com");
+  service.useTls();
+  AsyncWeatherClient client(service);
+  auto request = [&](uint64_t afterMicros) {
+    sim::advanceMicros(afterMicros);
+    refreshOutcome = StatusOutcome();
+    client.probe("/v1/forecast.json?key=check&q=Jessore&days=2", [](const WeatherFetchResult &result, const WeatherConditions &) {
+      refreshOutcome.httpCode = result.httpCode;
+    });
+    for (uint32_t pass = 0; pass < 2000 && !client.idle(); pass++) {
+      client.poll();
+      sim::advanceMicros(STEP_MICROS);
+    }
+    const ConnectionStats &stats = service.stats();
+    return std::make_tuple(refreshOutcome.httpCode, stats.handshakes, stats.tlsFullHandshakes, stats.tlsResumedHandshakes);
+  };
+
+  auto first = request(0);
+  expect(first == std::make_tuple(200, 1u, 1u, 0u), "first request: full handshake (status %d, %u connects, %u full, %u resumed)",
+         std::get<0>(first), std::get<1>(first), std::get<2>(first), std::get<3>(first));
+  auto kept = request(MINUTE_MICROS);
+  expect(kept == std::make_tuple(200, 1u, 1u, 0u), "1 min later: kept socket, no handshake (%u connects, %u full, %u resumed)",
+         std::get<1>(kept), std::get<2>(kept), std::get<3>(kept));
+  auto resumed = request(10 * MINUTE_MICROS);
+  expect(resumed == std::make_tuple(200, 2u, 1u, 1u), "10 min later: socket closed, session resumed (%u connects, %u full, %u resumed)",
+         std::get<1>(resumed), std::get<2>(resumed), std::get<3>(resumed));
+  auto refresh = request(6 * 60 * MINUTE_MICROS);
+  expect(refresh == std::make_tuple(200, 3u, 2u, 1u), "6 h later: session expired, full handshake (%u connects, %u full, %u resumed)",
+         std::get<1>(refresh), std::get<2>(refresh), std::get<3>(refresh));
+  expect(service.stats().failures == 0, "%u failed", service.stats().failures);
+
+  sim::httpRoutes.clear();
+}
+
+struct Check {
+  const char *name;
+  void (*run)();
+};
+
+const Check CHECKS[] = {
+  { "calibration", checkCalibration },
+  { "telemetry-frame", checkTelemetryFrame },
+  { "history", checkHistory },
+  { "journal-batch", checkJournalBatch },
+  { "weather-parse", checkWeatherParse },
+  { "slow-weather", checkSlowWeather },
+  { "bulk-weather", checkBulkWeather },
+  { "tls-refresh", checkTlsRefresh },
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool ranAny = false;
+  for (const Check &check : CHECKS) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++) {
+      selected |= !strcmp(argv[i], check.name);
+    }
+    if (selected) {
+      check.run();
+      ranAny = true;
+    }
+  }
+  if (!ranAny) {
+    printf("usage: %s [check...]\navailable:", argv[0]);
+    for (const Check &check : CHECKS) printf(" %s", check.name);
+    printf("\n");
+    return 2;
+  }
+  printf("%s: %u failed\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,356 @@
+// ─────────────────────────────────────
+// EcoPulse Host Simulator Driver
+// ─────────────────────────────────────
+// Links against exactly one sketch (iot-winter.cpp, iot-summer.cpp,
+// pulse-iot.cpp or pulse-blynk.cpp) and runs its setup()/loop() against
+// the simulated board, charging sim::loopQuantumMicros of virtual time per
+// loop() pass on top of whatever the sketch itself waits for. Each boot
+// runs in a forked child so ESP.deepSleep()/ESP.restart() come back up
+// with fresh RAM; only sim::persistent<> state crosses a reset. With
+// --replay the boots follow an input trace instead (sim-replay.h). See
+// README.md for build commands.
+
+#include <Arduino.h>
+#include <ArduinoIoTCloud.h>
+#include <BlynkSimpleEsp8266.h>
+#include <LittleFS.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <execinfo.h>
+#include <filesystem>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim-replay.h"
+
+void setup();
+void loop();
+
+static void printUsage(const char *program) {
+  printf("usage: %s [options]\n"
+         "  --days N              virtual time to simulate (default 1)\n"
+         "  --hours N             virtual time to simulate, in hours\n"
+         "  --tick-ms N           virtual time charged per loop() pass (default 5)\n"
+         "  --moisture PCT        initial soil moisture (default 45)\n"
+         "  --drying PCT          soil drying rate per hour (default 1.2)\n"
+         "  --outage START:LEN    WiFi outage, hours from boot (repeatable)\n"
+         "  --rain START:LEN      rain spell, hours from boot; forecast.json predicts it (repeatable)\n"
+         "  --ap-channel H:CH     access point moves to channel CH after H hours\n"
+         "  --http-latency-ms N   stand-in API response latency (default 180)\n"
+         "  --http-rate BPS       trickle socket responses at BPS bytes/s (slow uplink)\n"
+         "  --tls-session-min N   TLS session lifetime at the stand-in front end (default 60)\n"
+         "  --tls-no-mfln         TLS stand-in refuses max fragment length negotiation\n"
+         "  --tls-handshake-ms N  full TLS handshake time at the stand-in (default 1800)\n"
+         "  --cloud-write P=V     queue a remote write to cloud property P\n"
+         "  --flash DIR           keep the LittleFS contents in DIR (default: fresh temp dir)\n"
+         "  --console H:LINE      type LINE at the serial console after H hours (repeatable)\n"
+         "  --node N              board number on a shared loopback LAN; offsets the chip ID\n"
+         "  --pace X              run at most X times real time, so sims started together stay in step\n"
+         "  --serial              echo the sketch's Serial output\n"
+         "  --trace               print every actuator transition\n"
+         "  --replay PATH         run the firmware on an input trace (directory or file) and compare its\n"
+         "                        actuator decisions; until the trace ends unless --days/--hours is given\n"
+         "  --alloc-trace         print a backtrace for every allocation loop() makes\n",
+         program);
+}
+
+static uint64_t hoursToMicros(double hours) {
+  return (uint64_t)(hours * 3600.0 * 1e6);
+}
+
+// Every allocation in the process passes through here; sim::noteAllocation
+// decides whether the sketch made it.
+static void *countedAllocation(size_t size) {
+  static bool tracing = false;
+  if (!tracing && sim::noteAllocation(size)) {
+    tracing = true;  // backtrace() may allocate on first use
+    void *frames[16];
+    int depth = backtrace(frames, 16);
+    fprintf(stderr, "sim: loop() allocated %zu bytes at %.3f h\n", size, sim::clockMicros / 3.6e9);
+    backtrace_symbols_fd(frames, depth, 2);
+    tracing = false;
+  }
+  void *block = malloc(size ? size : 1);
+  if (!block) throw std::bad_alloc();
+  return block;
+}
+
+void *operator new(size_t size) { return countedAllocation(size); }
+void *operator new[](size_t size) { return countedAllocation(size); }
+void operator delete(void *block) noexcept { free(block); }
+void operator delete[](void *block) noexcept { free(block); }
+void operator delete(void *block, size_t) noexcept { free(block); }
+void operator delete[](void *block, size_t) noexcept { free(block); }
+
+enum BootOutcome { BOOT_RAN_TO_END = 0, BOOT_RESET = 3 };
+
+// One power-on of the board, from setup() until the end of the simulated
+// interval or a reset requested by the sketch.
+static BootOutcome runBoot(uint64_t endMicros) {
+  sim::bootMicros = sim::clockMicros;
+  sim::hostBootTime = std::chrono::steady_clock::now();
+  if (sim::replay.active && !sim::beginReplayBoot()) return BOOT_RAN_TO_END;
+  sim::power.boots++;
+  try {
+    sim::allocationPhase = sim::ALLOCATIONS_IN_SETUP;
+    setup();
+    while (sim::clockMicros < endMicros) {
+      if (sim::replay.active && sim::replayBootOver()) {
+        if (!sim::replayBootsRemain()) break;
+        throw sim::replayReset();
+      }
+      uint64_t passStart = sim::clockMicros;
+      sim::allocationPhase = sim::ALLOCATIONS_IN_LOOP;
+      loop();
+      sim::allocationPhase = sim::ALLOCATIONS_UNCOUNTED;
+      uint64_t passMicros = sim::clockMicros - passStart;
+      if (passMicros > sim::power.longestPassMicros) sim::power.longestPassMicros = passMicros;
+      if (passMicros > sim::slowPassMicros) sim::power.slowPasses++;
+      sim::advanceMicros(sim::loopQuantumMicros);
+      sim::power.loopPasses++;
+    }
+  } catch (const sim::ResetRequest &reset) {
+    sim::allocationPhase = sim::ALLOCATIONS_UNCOUNTED;
+    if (sim::replay.active) sim::endReplayBoot();
+    sim::powerDown(reset);
+    return BOOT_RESET;
+  }
+  if (sim::replay.active) sim::endReplayBoot();
+  return BOOT_RAN_TO_END;
+}
+
+int main(int argc, char **argv) {
+  double simulatedHours = 24.0;
+  bool durationGiven = false;
+  const char *replayPath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--days") && value) {
+      simulatedHours = atof(value) * 24.0; i++;
+      durationGiven = true;
+    } else if (!strcmp(arg, "--hours") && value) {
+      simulatedHours = atof(value); i++;
+      durationGiven = true;
+    } else if (!strcmp(arg, "--tick-ms") && value) {
+      sim::loopQuantumMicros = (uint64_t)(atof(value) * 1000.0); i++;
+    } else if (!strcmp(arg, "--moisture") && value) {
+      sim::environment.soilMoisturePct = atof(value); i++;
+    } else if (!strcmp(arg, "--drying") && value) {
+      sim::environment.dryingPctPerHour = atof(value); i++;
+    } else if (!strcmp(arg, "--outage") && value) {
+      double start = 0, length = 0;
+      if (sscanf(value, "%lf:%lf", &start, &length) != 2) {
+        printUsage(argv[0]);
+        return 2;
+      }
+      sim::network.outages.push_back({ hoursToMicros(start), hoursToMicros(start + length) });
+      i++;
+    } else if (!strcmp(arg, "--rain") && value) {
+      double start = 0, length = 0;
+      if (sscanf(value, "%lf:%lf", &start, &length) != 2) {
+        printUsage(argv[0]);
+        return 2;
+      }
+      sim::rainSpells.push_back({ hoursToMicros(start), hoursToMicros(start + length) });
+      i++;
+    } else if (!strcmp(arg, "--ap-channel") && value) {
+      double at = 0;
+      int channel = 0;
+      if (sscanf(value, "%lf:%d", &at, &channel) != 2) {
+        printUsage(argv[0]);
+        return 2;
+      }
+      sim::network.apChannelChangeMicros = hoursToMicros(at);
+      sim::network.apChannelAfterChange = channel;
+      i++;
+    } else if (!strcmp(arg, "--http-latency-ms") && value) {
+      sim::httpLatencyMicros = (uint64_t)(atof(value) * 1000.0); i++;
+    } else if (!strcmp(arg, "--http-rate") && value) {
+      sim::httpBytesPerSecond = (uint32_t)atol(value); i++;
+    } else if (!strcmp(arg, "--tls-session-min") && value) {
+      sim::tlsServer.sessionLifetimeMicros = (uint64_t)(atof(value) * 6e7); i++;
+    } else if (!strcmp(arg, "--tls-handshake-ms") && value) {
+      sim::tlsServer.fullHandshakeMicros = (uint64_t)(atof(value) * 1000.0); i++;
+    } else if (!strcmp(arg, "--tls-no-mfln")) {
+      sim::tlsServer.mflnSupported = false;
+    } else if (!strcmp(arg, "--cloud-write") && value) {
+      const char *separator = strchr(value, '=');
+      if (!separator) {
+        printUsage(argv[0]);
+        return 2;
+      }
+      sim::cloudInbox.emplace(std::string(value, separator), atof(separator + 1));
+      i++;
+    } else if (!strcmp(arg, "--flash") && value) {
+      sim::flashDirectory = value; i++;
+    } else if (!strcmp(arg, "--console") && value) {
+      const char *separator = strchr(value, ':');
+      if (!separator) {
+        printUsage(argv[0]);
+        return 2;
+      }
+      sim::consoleScript.push_back({ hoursToMicros(atof(value)), std::string(separator + 1), false });
+      i++;
+    } else if (!strcmp(arg, "--node") && value) {
+      sim::nodeIndex = (uint32_t)atoi(value); i++;
+    } else if (!strcmp(arg, "--pace") && value) {
+      sim::paceFactor = atof(value); i++;
+    } else if (!strcmp(arg, "--serial")) {
+      sim::echoSerial = true;
+    } else if (!strcmp(arg, "--trace")) {
+      sim::recordActuatorLog = true;
+    } else if (!strcmp(arg, "--replay") && value) {
+      replayPath = value; i++;
+    } else if (!strcmp(arg, "--alloc-trace")) {
+      sim::traceAllocations = true;
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  sim::paceOrigin = std::chrono::steady_clock::now();
+
+  bool temporaryFlash = sim::flashDirectory.empty();
+  if (temporaryFlash) {
+    char pattern[] = "/tmp/ecopulse-flash-XXXXXX";
+    if (!mkdtemp(pattern)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    sim::flashDirectory = pattern;
+  }
+
+  const bool printActuatorLog = sim::recordActuatorLog;
+  if (replayPath) {
+    if (!sim::loadTrace(replayPath)) {
+      fprintf(stderr, "sim: no input trace in %s\n", replayPath);
+      return 2;
+    }
+    // The firmware traces the replay into its own flash; keep that trace to this run
+    std::error_code error;
+    const std::filesystem::path ownTrace = std::filesystem::path(sim::flashDirectory) / "trace";
+    if (std::filesystem::equivalent(ownTrace, replayPath, error)) {
+      fprintf(stderr, "sim: %s is the replay's own trace directory - copy it or use another --flash\n", replayPath);
+      return 2;
+    }
+    std::filesystem::remove_all(ownTrace, error);
+    sim::replay.active = true;
+    sim::httpRoutes.push_back(sim::replayExchange);
+    sim::recordActuatorLog = true;
+    sim::actuatorLogPins = sim::replay.watchedPins;
+  }
+
+  const uint64_t endMicros = replayPath && !durationGiven ? UINT64_MAX : hoursToMicros(simulatedHours);
+  auto wallStart = std::chrono::steady_clock::now();
+
+  while (sim::clockMicros < endMicros) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (child == 0) {
+      BootOutcome outcome = runBoot(endMicros);
+      fflush(stdout);
+      _exit(outcome);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != BOOT_RESET && WEXITSTATUS(status) != BOOT_RAN_TO_END)) {
+      fprintf(stderr, "sim: boot %u terminated abnormally at %.3f h\n", sim::power.boots, sim::clockMicros / 3.6e9);
+      return 1;
+    }
+    if (WEXITSTATUS(status) == BOOT_RAN_TO_END) break;
+  }
+
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  if (printActuatorLog) {
+    for (const sim::ActuatorEvent &event : sim::actuatorLog) {
+      printf("%10.3f h  GPIO%-2u -> %s\n", event.atMicros / 3.6e9, event.pin, event.level ? "HIGH" : "LOW");
+    }
+  }
+
+  printf("virtual time      %.2f h in %.3f s wall (%.0fx)\n", sim::clockMicros / 3.6e9, wallSeconds,
+         sim::clockMicros / 1e6 / (wallSeconds > 0 ? wallSeconds : 1e-9));
+  printf("loop passes       %llu, longest %.1f ms, %llu over %.0f ms\n", (unsigned long long)sim::power.loopPasses,
+         sim::power.longestPassMicros / 1000.0, (unsigned long long)sim::power.slowPasses, sim::slowPassMicros / 1000.0);
+  printf("power             %u boots, %u deep sleeps, %u restarts, awake %.1f %%\n", sim::power.boots,
+         sim::power.deepSleeps, sim::power.restarts,
+         100.0 * (1.0 - (double)sim::power.sleepMicros / (sim::clockMicros ? sim::clockMicros : 1)));
+  printf("pump              %u starts, %.1f min on\n", sim::actuatorStats[sim::PUMP_PIN].switchCount,
+         sim::onTimeMicros(sim::PUMP_PIN) / 6e7);
+  printf("grow lights       %u starts, %.1f h on\n", sim::actuatorStats[sim::LIGHTS_PIN].switchCount,
+         sim::onTimeMicros(sim::LIGHTS_PIN) / 3.6e9);
+  printf("soil moisture     %.1f %% at end\n", sim::environment.soilMoisturePct);
+  printf("wifi              %u association attempts (%u hinted), %u TCP handshakes\n",
+         sim::linkStats.associationAttempts, sim::linkStats.hintedAttempts, sim::linkStats.tcpHandshakes);
+  printf("wifi association  %u links, %.0f ms average to associate\n", sim::linkStats.associations,
+         sim::linkStats.associations ? sim::linkStats.associationMicros / 1000.0 / sim::linkStats.associations : 0.0);
+  printf("http              %u requests, %u failed, %llu bytes\n", sim::httpStats.requests, sim::httpStats.failures,
+         (unsigned long long)sim::httpStats.bytesServed);
+  printf("tls               %u full, %u resumed handshakes, %.1f s handshaking, %u MFLN probes\n",
+         sim::tlsStats.fullHandshakes, sim::tlsStats.resumedHandshakes, sim::tlsStats.handshakeMicros / 1e6,
+         sim::tlsStats.mflnProbes);
+  printf("heap              %.1f KB peak in modelled allocations (free %.1f KB of %.1f KB at worst)\n",
+         sim::heapStats.peakTaken / 1024.0, (sim::HEAP_BASELINE - sim::heapStats.peakTaken) / 1024.0,
+         sim::HEAP_BASELINE / 1024.0);
+  printf("allocations       %llu in setup(), %llu in loop() (%llu bytes), %u LittleFS file handles\n",
+         (unsigned long long)sim::allocationStats.setupAllocations,
+         (unsigned long long)sim::allocationStats.loopAllocations, (unsigned long long)sim::allocationStats.loopBytes,
+         sim::allocationStats.fileHandles);
+  printf("arduino cloud     %u messages, %u property updates, %.1f KB text\n", sim::cloudStats.messagesSent,
+         sim::cloudStats.propertyUpdates, sim::cloudStats.textBytes / 1024.0);
+  printf("blynk             %u virtual writes\n", sim::blynkStats.virtualWrites);
+  printf("udp               %u datagrams, %.1f KB sent, %u failed, %u received\n", sim::udpStats.datagramsSent,
+         sim::udpStats.bytesSent / 1024.0, sim::udpStats.sendFailures, sim::udpStats.datagramsReceived);
+  if (sim::serverStats.listeningPort) {
+    printf("tcp server        port %u, %u connections, %.1f KB sent, %u writes refused\n", sim::serverStats.listeningPort,
+           sim::serverStats.connections, sim::serverStats.bytesSent / 1024.0, sim::serverStats.refusedWrites);
+  }
+  printf("serial            %.1f KB, %u blocking writes, %.1f s blocked\n", sim::uartStats.bytes / 1024.0,
+         sim::uartStats.blockingWrites, sim::uartStats.blockedMicros / 1e6);
+  printf("flash             %u writes, %.1f KB written, %u files removed\n", sim::flashStats.writeCalls,
+         sim::flashStats.bytesWritten / 1024.0, sim::flashStats.filesRemoved);
+
+  int exitStatus = 0;
+  if (replayPath) {
+    const sim::ReplayStats &stats = sim::replayStats;
+    const sim::ReplayVerdict verdict = sim::compareDecisions();
+    const size_t partialBoots = std::count_if(sim::replay.boots.begin(), sim::replay.boots.end(),
+                                              [](const sim::TraceBoot &boot) { return boot.partial; });
+    printf("replay            %u of %zu traced boots (%zu partial, %u reset by the trace), %.1f KB, %u events, %zu bytes skipped\n",
+           stats.bootsRun, sim::replay.boots.size(), partialBoots, stats.forcedResets, sim::replay.traceBytes / 1024.0,
+           sim::replay.events, sim::replay.skippedBytes);
+    printf("replay inputs     %llu conversions replayed, %llu held, %llu live; %u exchanges served, %u failures, %u requests not traced\n",
+           (unsigned long long)stats.conversions, (unsigned long long)stats.held, (unsigned long long)stats.live,
+           stats.exchangesServed, stats.exchangesRefused, stats.requestsUnmatched);
+    printf("decisions         %u traced, %u matched (worst skew %u ms), %u missing, %u extra\n", verdict.decisions,
+           verdict.matched, verdict.worstSkewMs, verdict.missing, verdict.extra);
+    const size_t MAX_LISTED = 20;
+    for (size_t i = 0; i < verdict.divergences.size() && i < MAX_LISTED; i++) {
+      const sim::ReplayDivergence &divergence = verdict.divergences[i];
+      printf("  boot %-4u %10.1f s  GPIO%-2u -> %-4s  %s%s\n", divergence.boot + 1, divergence.timeMs / 1000.0,
+             divergence.pin, divergence.level ? "HIGH" : "LOW", divergence.inTrace ? "traced, not replayed" : "replayed, not traced",
+             divergence.partial ? " (partial boot)" : "");
+    }
+    if (verdict.divergences.size() > MAX_LISTED) printf("  ... %zu more\n", verdict.divergences.size() - MAX_LISTED);
+    if (stats.conversions == 0) {
+      fprintf(stderr, "sim: no traced conversion was used - is the firmware built with ECOPULSE_INPUT_TRACE=1?\n");
+    }
+    if (verdict.missing || verdict.extra) exitStatus = 1;
+  }
+
+  if (temporaryFlash) {
+    std::error_code error;
+    std::filesystem::remove_all(sim::flashDirectory, error);
+  }
+  return exitStatus;
+}
@@ -0,0 +1,401 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266HTTPClient.h>
+#include <ESP8266WiFi.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../input-trace.h"
+
+// ─────────────────────────────────────
+// Input Trace Replay
+// ─────────────────────────────────────
+// sim-main --replay PATH runs the linked firmware against an input trace
+// (input-trace.h) instead of the board models, then compares the actuator
+// decisions the firmware took with the ones in the trace. PATH is the
+// trace directory of a flash image or a download of /trace.bin.
+//
+// The trace's boots are replayed one sim boot each, with millis() mapped
+// onto the traced boot's time:
+//
+//   - ADC conversions are handed to the firmware through
+//     InputTrace::replaySource in the order they were traced, per mux
+//     address. Conversions traced more than STALE_MS before the firmware
+//     asks are skipped; when none is due, the last traced one is held.
+//   - Spans in which the traced WiFi status was not WL_CONNECTED become
+//     access point outages, so the firmware's own association attempts
+//     see the same link.
+//   - Each request is answered with the traced exchange for its path
+//     nearest in order within MATCH_WINDOW_MS: the status, the body and
+//     the completion time. A traced read timeout is answered never, other
+//     traced failures refuse the connection. Requests not in the trace
+//     (get(), which is not traced) go to the stand-in API and are counted.
+//   - A boot the firmware outlives by BOOT_MARGIN_MS is ended with the
+//     reset reason the trace's next boot recorded.
+//
+// Everything else - cloud writes, console input, flash and RTC contents
+// at the start - comes from the sim as usual. The firmware must be built
+// with ECOPULSE_INPUT_TRACE=1: the trace hooks are where conversions are
+// substituted. A trace whose ring had wrapped starts in the middle of a
+// boot; that boot is replayed from a cold start and reported, but does not
+// count toward the verdict.
+
+namespace sim {
+
+// ── Loaded trace ──
+struct TraceSample {
+  uint32_t timeMs;
+  uint16_t raw;
+};
+
+struct TraceSpan {
+  uint32_t fromMs;
+  uint32_t toMs;   // UINT32_MAX: until the boot ended
+};
+
+struct TraceExchange {
+  uint32_t timeMs;
+  std::string path;   // Without the query
+  int status;
+  uint32_t latencyMs;
+  std::string body;
+};
+
+struct TraceOutput {
+  uint32_t timeMs;
+  uint8_t pin;
+  uint8_t level;
+};
+
+struct TraceBoot {
+  uint8_t resetReason = REASON_DEFAULT_RST;
+  bool partial = false;          // Starts at a SYNC, not at the boot itself
+  uint32_t offsetMs = 0;         // Traced millis() at the replayed boot's millis() 0
+  uint32_t lastMs = 0;
+  std::vector<TraceSample> samples[INPUT_TRACE_MAX_ADDRESSES];
+  std::vector<TraceSpan> linkDown;
+  std::vector<TraceExchange> exchanges;
+  std::vector<TraceOutput> outputs;   // Level changes only
+};
+
+struct Replay {
+  static const uint32_t MAX_BOOTS = 4096;
+  static const uint32_t STALE_MS = 500;
+  static const uint32_t MATCH_WINDOW_MS = 10000;
+  static const uint32_t BOOT_MARGIN_MS = 5000;
+  static const uint32_t DECISION_TOLERANCE_MS = 1000;   // Actuator changes this close count as the same decision
+
+  bool active = false;
+  std::vector<TraceBoot> boots;
+  uint32_t watchedPins = 0;      // Outputs the trace recorded
+  size_t traceBytes = 0;
+  size_t skippedBytes = 0;
+  uint32_t events = 0;
+};
+inline Replay replay;
+
+// What the replayed boots did, for the summary after the last one
+struct ReplayStats {
+  uint32_t bootsRun = 0;
+  uint32_t forcedResets = 0;
+  uint64_t conversions = 0;      // Traced conversions handed to the firmware
+  uint64_t held = 0;             // Asked for when no traced conversion was due
+  uint64_t live = 0;             // Nothing traced for the address yet: the model's
+  uint32_t exchangesServed = 0;
+  uint32_t exchangesRefused = 0; // Traced failures reproduced
+  uint32_t requestsUnmatched = 0;
+  uint64_t bootStartMicros[Replay::MAX_BOOTS];
+  uint64_t logStart[Replay::MAX_BOOTS];   // actuatorLog range of each boot, without the power-down
+  uint64_t logEnd[Replay::MAX_BOOTS];
+};
+inline ReplayStats &replayStats = persistent<ReplayStats>();
+
+inline bool readTrace(const std::string &path, std::vector<uint8_t> &data) {
+  std::vector<std::filesystem::path> files;
+  std::error_code error;
+  if (std::filesystem::is_directory(path, error)) {
+    for (const auto &entry : std::filesystem::directory_iterator(path, error)) files.push_back(entry.path());
+    std::sort(files.begin(), files.end());   // Zero-padded segment numbers sort in order
+  } else {
+    files.push_back(path);
+  }
+  for (const std::filesystem::path &file : files) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return false;
+    data.insert(data.end(), std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  return !data.empty();
+}
+
+inline bool loadTrace(const std::string &path) {
+  std::vector<uint8_t> data;
+  if (!readTrace(path, data)) return false;
+  replay.traceBytes = data.size();
+
+  InputTraceDecoder decoder(data.data(), data.size());
+  InputTraceEvent event;
+  TraceBoot *boot = nullptr;
+  bool linkDown = false;
+  bool exchangeOpen = false;
+  uint32_t bootEvents = 0;
+  uint8_t levels[32] = {};
+  auto startBoot = [&](bool partial, uint8_t reason, uint32_t offsetMs) {
+    replay.boots.emplace_back();
+    boot = &replay.boots.back();
+    boot->partial = partial;
+    boot->resetReason = reason;
+    boot->offsetMs = boot->lastMs = offsetMs;
+    linkDown = false;
+    exchangeOpen = false;
+    bootEvents = 0;
+    memset(levels, 0, sizeof(levels));
+  };
+
+  while (decoder.next(event) && replay.boots.size() <= Replay::MAX_BOOTS) {
+    replay.events++;
+    if (event.type == INPUT_TRACE_SYNC) {
+      // A gap in the stream within one boot keeps going; an earlier time means another boot
+      if (!boot || (!event.continued && event.timeMs < boot->lastMs)) startBoot(true, REASON_DEFAULT_RST, event.timeMs);
+      continue;
+    }
+    if (event.type == INPUT_TRACE_BOOT) {
+      // A segment opened by begin() has its SYNC just before the BOOT
+      if (boot && boot->partial && !bootEvents) replay.boots.pop_back();
+      startBoot(false, event.argument, 0);
+      boot->lastMs = event.timeMs;
+      continue;
+    }
+    if (!boot) continue;
+    bootEvents++;
+    boot->lastMs = std::max(boot->lastMs, event.timeMs);
+    switch (event.type) {
+      case INPUT_TRACE_ANALOG:
+        for (uint8_t i = 0; i < event.count; i++) boot->samples[event.argument].push_back({ event.timeMs, event.samples[i] });
+        break;
+      case INPUT_TRACE_LINK:
+        if (event.argument != WL_CONNECTED && !linkDown) {
+          boot->linkDown.push_back({ event.timeMs, UINT32_MAX });
+          linkDown = true;
+        } else if (event.argument == WL_CONNECTED && linkDown) {
+          boot->linkDown.back().toMs = event.timeMs;
+          linkDown = false;
+        }
+        break;
+      case INPUT_TRACE_REQUEST:
+        boot->exchanges.push_back({ event.timeMs, std::string((const char *)event.bytes, event.length), -1, 0, std::string() });
+        exchangeOpen = true;
+        break;
+      case INPUT_TRACE_BODY:
+        if (exchangeOpen) boot->exchanges.back().body.append((const char *)event.bytes, event.length);
+        break;
+      case INPUT_TRACE_RESPONSE:
+        if (exchangeOpen) {
+          boot->exchanges.back().status = event.status;
+          boot->exchanges.back().latencyMs = event.latencyMs;
+        }
+        exchangeOpen = false;
+        break;
+      case INPUT_TRACE_OUTPUT:
+        if (event.pin >= 32) break;
+        replay.watchedPins |= 1u << event.pin;
+        if (event.argument != levels[event.pin]) boot->outputs.push_back({ event.timeMs, event.pin, event.argument });
+        levels[event.pin] = event.argument;
+        break;
+      default:
+        break;
+    }
+  }
+  if (replay.boots.size() > Replay::MAX_BOOTS) {
+    fprintf(stderr, "sim: replaying the first %u boots of the trace\n", Replay::MAX_BOOTS);
+    replay.boots.resize(Replay::MAX_BOOTS);
+  }
+  replay.skippedBytes = decoder.skippedBytes();
+  return !replay.boots.empty();
+}
+
+// ── Replayed boot ──
+inline const TraceBoot *replayBoot = nullptr;   // Of the running boot, in the child
+
+inline uint32_t traceNowMs() {
+  return (uint32_t)((clockMicros - bootMicros) / 1000) + replayBoot->offsetMs;
+}
+
+class TracePlayer : public InputTraceSource {
+public:
+  void analog(uint8_t address, uint16_t &raw) override {
+    address &= INPUT_TRACE_MAX_ADDRESSES - 1;
+    const std::vector<TraceSample> &samples = replayBoot->samples[address];
+    const uint32_t now = traceNowMs();
+    size_t &next = cursor[address];
+    while (next < samples.size() && samples[next].timeMs + Replay::STALE_MS < now) next++;
+    if (next < samples.size() && samples[next].timeMs <= now + Replay::STALE_MS) {
+      raw = held[address] = samples[next++].raw;
+      holding |= 1u << address;
+      replayStats.conversions++;
+    } else if (holding & 1u << address) {
+      raw = held[address];
+      replayStats.held++;
+    } else {
+      replayStats.live++;
+    }
+  }
+
+private:
+  size_t cursor[INPUT_TRACE_MAX_ADDRESSES] = {};
+  uint16_t held[INPUT_TRACE_MAX_ADDRESSES] = {};
+  uint32_t holding = 0;
+};
+inline TracePlayer tracePlayer;
+inline std::vector<bool> exchangeTaken;
+
+inline bool replayExchange(const std::string &, const std::string &path, HttpExchange &response) {
+  const std::string bare = path.substr(0, path.find('?'));
+  const uint32_t now = traceNowMs();
+  for (size_t i = 0; i < replayBoot->exchanges.size(); i++) {
+    const TraceExchange &exchange = replayBoot->exchanges[i];
+    if (exchangeTaken[i] || exchange.path != bare) continue;
+    if (exchange.timeMs + Replay::MATCH_WINDOW_MS < now) continue;
+    if (exchange.timeMs > now + Replay::MATCH_WINDOW_MS) break;
+    exchangeTaken[i] = true;
+    if (exchange.status == HTTPC_ERROR_READ_TIMEOUT) {
+      response = { 504, std::string(), 3600000000ULL };   // Never within the firmware's patience
+      replayStats.exchangesRefused++;
+    } else if (exchange.status < 0) {
+      response.status = -1;
+      replayStats.exchangesRefused++;
+    } else {
+      // Complete when the traced one did, measured from the traced request
+      const uint32_t completedAt = exchange.timeMs + exchange.latencyMs;
+      response = { exchange.status, exchange.body, completedAt > now ? (uint64_t)(completedAt - now) * 1000 : 0 };
+      replayStats.exchangesServed++;
+    }
+    return true;
+  }
+  replayStats.requestsUnmatched++;
+  return false;
+}
+
+// Set up the child for the trace's next boot; false once all have run
+inline bool beginReplayBoot() {
+  const uint32_t index = replayStats.bootsRun;
+  if (index >= replay.boots.size()) return false;
+  replayBoot = &replay.boots[index];
+  replayStats.bootsRun++;
+  replayStats.bootStartMicros[index] = bootMicros;
+  replayStats.logStart[index] = actuatorLog.count;
+  replayStats.logEnd[index] = actuatorLog.count;
+  exchangeTaken.assign(replayBoot->exchanges.size(), false);
+  network.outages.clear();
+  for (const TraceSpan &span : replayBoot->linkDown) {
+    auto at = [&](uint32_t timeMs) {
+      return timeMs <= replayBoot->offsetMs ? bootMicros : bootMicros + (uint64_t)(timeMs - replayBoot->offsetMs) * 1000;
+    };
+    network.outages.push_back({ at(span.fromMs), span.toMs == UINT32_MAX ? UINT64_MAX : at(span.toMs) });
+  }
+  InputTrace::replaySource = &tracePlayer;
+  return true;
+}
+
+// The firmware has outlived the traced boot
+inline bool replayBootOver() {
+  return traceNowMs() > replayBoot->lastMs + Replay::BOOT_MARGIN_MS;
+}
+
+inline bool replayBootsRemain() {
+  return replayStats.bootsRun < replay.boots.size();
+}
+
+// Reset as the trace's next boot was reset; a power-on reset also loses
+// RTC user memory
+inline ResetRequest replayReset() {
+  const uint8_t reason = replay.boots[replayStats.bootsRun].resetReason;
+  replayStats.forcedResets++;
+  if (reason == REASON_DEFAULT_RST) memset(rtcUserMemory.bytes, 0, sizeof(rtcUserMemory.bytes));
+  return ResetRequest{ reason, reason == REASON_DEFAULT_RST || reason == REASON_EXT_SYS_RST ? 1000000ULL : 0 };
+}
+
+inline void endReplayBoot() {
+  replayStats.logEnd[replayStats.bootsRun - 1] = actuatorLog.count;
+}
+
+// ── Decision diff ──
+struct ReplayDivergence {
+  uint32_t boot;
+  uint32_t timeMs;
+  uint8_t pin;
+  uint8_t level;
+  bool inTrace;      // Traced but not replayed; otherwise replayed but not traced
+  bool partial;
+};
+
+struct ReplayVerdict {
+  uint32_t decisions = 0;        // Traced actuator changes in the replayed boots
+  uint32_t matched = 0;
+  uint32_t worstSkewMs = 0;
+  uint32_t missing = 0;          // Counted toward the verdict: boots that start at BOOT only
+  uint32_t extra = 0;
+  std::vector<ReplayDivergence> divergences;
+};
+
+inline ReplayVerdict compareDecisions() {
+  ReplayVerdict verdict;
+  for (uint32_t index = 0; index < replayStats.bootsRun; index++) {
+    const TraceBoot &boot = replay.boots[index];
+    for (uint8_t pin = 0; pin < 32; pin++) {
+      if (!(replay.watchedPins & 1u << pin)) continue;
+      std::vector<TraceOutput> traced, replayed;
+      for (const TraceOutput &output : boot.outputs) {
+        if (output.pin == pin) traced.push_back(output);
+      }
+      for (uint64_t i = replayStats.logStart[index]; i < replayStats.logEnd[index]; i++) {
+        const ActuatorEvent &event = actuatorLog.entries[i];
+        if (event.pin != pin) continue;
+        const uint32_t timeMs = (uint32_t)((event.atMicros - replayStats.bootStartMicros[index]) / 1000) + boot.offsetMs;
+        replayed.push_back({ timeMs, pin, (uint8_t)(event.level ? 1 : 0) });
+      }
+      verdict.decisions += traced.size();
+
+      auto diverged = [&](const TraceOutput &output, bool inTrace) {
+        verdict.divergences.push_back({ index, output.timeMs, pin, output.level, inTrace, boot.partial });
+        if (boot.partial) return;
+        if (inTrace) {
+          verdict.missing++;
+        } else {
+          verdict.extra++;
+        }
+      };
+      size_t t = 0, r = 0;
+      while (t < traced.size() || r < replayed.size()) {
+        if (t < traced.size() && r < replayed.size() && traced[t].level == replayed[r].level) {
+          const uint32_t skew = traced[t].timeMs > replayed[r].timeMs ? traced[t].timeMs - replayed[r].timeMs
+                                                                      : replayed[r].timeMs - traced[t].timeMs;
+          if (skew <= Replay::DECISION_TOLERANCE_MS) {
+            verdict.matched++;
+            verdict.worstSkewMs = std::max(verdict.worstSkewMs, skew);
+            t++;
+            r++;
+            continue;
+          }
+        }
+        // The earlier of the two has no counterpart
+        if (r == replayed.size() || (t < traced.size() && traced[t].timeMs <= replayed[r].timeMs)) {
+          diverged(traced[t++], true);
+        } else {
+          diverged(replayed[r++], false);
+        }
+      }
+    }
+  }
+  std::sort(verdict.divergences.begin(), verdict.divergences.end(), [](const ReplayDivergence &a, const ReplayDivergence &b) {
+    return a.boot != b.boot ? a.boot < b.boot : a.timeMs < b.timeMs;
+  });
+  return verdict;
+}
+
+}  // namespace sim
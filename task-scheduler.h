@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// Cooperative Task Scheduler
+// ─────────────────────────────────────
+// Single timer table for every periodic and one-shot job in a sketch, so
+// loop() never has to block in delay(). Deadlines are compared through a
+// signed difference of unsigned millis() values, which keeps ordering
+// correct across the 49.7-day millis() rollover.
+//
+// A handle holds the task's slot in its low bits and the slot's generation
+// above them. Slots are reused once a one-shot fires or a task is
+// cancelled, and the generation moves on every time a slot is taken, so a
+// handle kept past the end of its task no longer reaches whichever task
+// has the slot now: cancel() leaves that one alone and isPending() says
+// false. Generations wrap after 2048 reuses of one slot.
+
+typedef void (*TaskCallback)();
+typedef int16_t TaskHandle;
+
+const TaskHandle INVALID_TASK = -1;
+
+class TaskScheduler {
+public:
+  static const uint8_t MAX_TASKS = 16;
+
+  // Run `callback` every `periodMs`, first time after `initialDelayMs`.
+  TaskHandle every(unsigned long periodMs, TaskCallback callback, unsigned long initialDelayMs = 0) {
+    return add(callback, millis() + initialDelayMs, periodMs);
+  }
+
+  // Run `callback` once, `delayMs` from now. The slot is freed after it fires.
+  TaskHandle after(unsigned long delayMs, TaskCallback callback) {
+    return add(callback, millis() + delayMs, 0);
+  }
+
+  // Move the next deadline of an existing task to `delayMs` from now.
+  void reschedule(TaskHandle handle, unsigned long delayMs) {
+    if (isValid(handle)) {
+      tasks[slotOf(handle)].deadline = millis() + delayMs;
+    }
+  }
+
+  void cancel(TaskHandle handle) {
+    if (isValid(handle)) {
+      tasks[slotOf(handle)].callback = nullptr;
+    }
+  }
+
+  bool isPending(TaskHandle handle) const {
+    return isValid(handle);
+  }
+
+  // Milliseconds until the earliest deadline (0 if something is already due).
+  unsigned long idleBudget() const {
+    unsigned long now = millis();
+    unsigned long budget = 0xFFFFFFFFUL;
+    for (uint8_t i = 0; i < MAX_TASKS; i++) {
+      if (tasks[i].callback == nullptr) continue;
+      long remaining = (long)(tasks[i].deadline - now);
+      if (remaining <= 0) return 0;
+      if ((unsigned long)remaining < budget) budget = remaining;
+    }
+    return budget;
+  }
+
+  // Dispatch every task whose deadline has passed. Each task fires at most
+  // once per call; a periodic task that fell more than a whole period behind
+  // is re-anchored to now instead of replaying the missed ticks back-to-back.
+  void run() {
+    for (uint8_t i = 0; i < MAX_TASKS; i++) {
+      Task &task = tasks[i];
+      if (task.callback == nullptr) continue;
+
+      unsigned long now = millis();
+      long lateness = (long)(now - task.deadline);
+      if (lateness < 0) continue;
+
+      TaskCallback callback = task.callback;
+      if (task.period == 0) {
+        task.callback = nullptr;  // Free one-shot slot before it may re-arm itself
+      } else if ((unsigned long)lateness >= task.period) {
+        task.deadline = now + task.period;
+      } else {
+        task.deadline += task.period;
+      }
+      callback();
+    }
+  }
+
+private:
+  static const uint8_t SLOT_BITS = 4;
+  static const uint16_t GENERATION_MASK = 0x7FF;  // Keeps a handle positive in 15 bits
+  static_assert(MAX_TASKS <= (1 << SLOT_BITS), "slot index must fit SLOT_BITS");
+
+  struct Task {
+    TaskCallback callback;
+    unsigned long deadline;
+    unsigned long period;  // 0 = one-shot
+    uint16_t generation;   // Bumped each time the slot is taken
+  };
+
+  Task tasks[MAX_TASKS] = {};
+
+  static uint8_t slotOf(TaskHandle handle) { return handle & ((1 << SLOT_BITS) - 1); }
+
+  bool isValid(TaskHandle handle) const {
+    if (handle < 0 || slotOf(handle) >= MAX_TASKS) return false;
+    const Task &task = tasks[slotOf(handle)];
+    return task.callback != nullptr && task.generation == (uint16_t)(handle >> SLOT_BITS);
+  }
+
+  TaskHandle add(TaskCallback callback, unsigned long deadline, unsigned long period) {
+    for (uint8_t i = 0; i < MAX_TASKS; i++) {
+      if (tasks[i].callback == nullptr) {
+        tasks[i].callback = callback;
+        tasks[i].deadline = deadline;
+        tasks[i].period = period;
+        tasks[i].generation = (tasks[i].generation + 1) & GENERATION_MASK;
+        return (TaskHandle)(tasks[i].generation << SLOT_BITS | i);
+      }
+    }
+    return INVALID_TASK;  // Table full - size MAX_TASKS for the sketch
+  }
+};
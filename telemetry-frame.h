@@ -0,0 +1,132 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ─────────────────────────────────────
+// Binary Telemetry Frame
+// ─────────────────────────────────────
+// One sensor sample as a fixed 20-byte datagram for a collector on the
+// LAN, in place of a cloud message of property names and text values:
+//
+//    0  magic 0xEC        8  timestamp (device s)   16  moisture %
+//    1  version           12 temperature (°C x 10)  17  flags
+//    2  sequence          14 light (ADC counts)     18  CRC-16
+//    4  device ID
+//
+// Fields are little-endian and written byte by byte, so the layout does
+// not depend on the compiler's struct packing and the same encoder and
+// decoder build for the device and for host tools (this header needs only
+// the C library). The CRC is CRC-16/CCITT-FALSE over bytes 0-17.
+//
+// The sequence number counts frames per device and wraps at 65536, so a
+// receiver can count the frames it missed; the device ID tells boards
+// sharing one collector apart. A layout change bumps the version, and a
+// decoder rejects versions it does not know rather than misreading them.
+
+const uint8_t TELEMETRY_FRAME_MAGIC = 0xEC;
+const uint8_t TELEMETRY_FRAME_VERSION = 1;
+const size_t TELEMETRY_FRAME_SIZE = 20;
+const uint16_t TELEMETRY_FRAME_PORT = 47800;    // Default UDP port for LAN streaming
+
+const int16_t TELEMETRY_TEMPERATURE_UNKNOWN = INT16_MIN;
+const uint8_t TELEMETRY_FLAG_PUMP = 0x01;
+const uint8_t TELEMETRY_FLAG_LIGHTS = 0x02;
+const uint8_t TELEMETRY_FLAG_FAILSAFE = 0x04;   // Offline timed algorithm was in control
+
+inline int16_t telemetryTemperature(float celsius) {
+  return isnan(celsius) ? TELEMETRY_TEMPERATURE_UNKNOWN : (int16_t)lroundf(celsius * 10.0f);
+}
+
+struct TelemetrySample {
+  uint32_t timestamp;        // Device clock, seconds
+  int16_t temperatureDeci;   // Degrees C x 10, TELEMETRY_TEMPERATURE_UNKNOWN without a reading
+  uint16_t light;            // Photosensor counts, 0 when not fitted
+  uint8_t moisture;          // Soil moisture %
+  uint8_t flags;             // TELEMETRY_FLAG_*
+};
+
+struct TelemetryFrame {
+  uint8_t version;
+  uint16_t sequence;
+  uint32_t deviceId;
+  TelemetrySample sample;
+};
+
+enum TelemetryFrameStatus : uint8_t {
+  TELEMETRY_FRAME_OK,
+  TELEMETRY_FRAME_TRUNCATED,
+  TELEMETRY_FRAME_BAD_MAGIC,
+  TELEMETRY_FRAME_UNKNOWN_VERSION,
+  TELEMETRY_FRAME_BAD_CRC,
+};
+
+inline const char *telemetryFrameStatusName(TelemetryFrameStatus status) {
+  switch (status) {
+    case TELEMETRY_FRAME_OK: return "ok";
+    case TELEMETRY_FRAME_TRUNCATED: return "truncated";
+    case TELEMETRY_FRAME_BAD_MAGIC: return "bad magic";
+    case TELEMETRY_FRAME_UNKNOWN_VERSION: return "unknown version";
+    case TELEMETRY_FRAME_BAD_CRC: return "bad CRC";
+  }
+  return "?";
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), a byte at a time with
+// shifts instead of a table: the polynomial's sparse taps fold the eight
+// bit steps into a few XORs, so no 512-byte table is kept in RAM.
+inline uint16_t telemetryFrameCrc(const uint8_t *bytes, size_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    uint8_t x = (crc >> 8) ^ *bytes++;
+    x ^= x >> 4;
+    crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+  return crc;
+}
+
+// Writes TELEMETRY_FRAME_SIZE bytes; returns that size.
+inline size_t encodeTelemetryFrame(uint8_t *out, uint16_t sequence, uint32_t deviceId, const TelemetrySample &sample) {
+  const uint16_t temperature = (uint16_t)sample.temperatureDeci;
+  out[0] = TELEMETRY_FRAME_MAGIC;
+  out[1] = TELEMETRY_FRAME_VERSION;
+  out[2] = sequence;
+  out[3] = sequence >> 8;
+  out[4] = deviceId;
+  out[5] = deviceId >> 8;
+  out[6] = deviceId >> 16;
+  out[7] = deviceId >> 24;
+  out[8] = sample.timestamp;
+  out[9] = sample.timestamp >> 8;
+  out[10] = sample.timestamp >> 16;
+  out[11] = sample.timestamp >> 24;
+  out[12] = temperature;
+  out[13] = temperature >> 8;
+  out[14] = sample.light;
+  out[15] = sample.light >> 8;
+  out[16] = sample.moisture;
+  out[17] = sample.flags;
+  uint16_t crc = telemetryFrameCrc(out, TELEMETRY_FRAME_SIZE - 2);
+  out[18] = crc;
+  out[19] = crc >> 8;
+  return TELEMETRY_FRAME_SIZE;
+}
+
+// `frame` is only written when the result is TELEMETRY_FRAME_OK. Bytes
+// past the frame (e.g. padding in a larger datagram) are ignored.
+inline TelemetryFrameStatus decodeTelemetryFrame(const uint8_t *in, size_t length, TelemetryFrame &frame) {
+  if (length < TELEMETRY_FRAME_SIZE) return TELEMETRY_FRAME_TRUNCATED;
+  if (in[0] != TELEMETRY_FRAME_MAGIC) return TELEMETRY_FRAME_BAD_MAGIC;
+  if (in[1] != TELEMETRY_FRAME_VERSION) return TELEMETRY_FRAME_UNKNOWN_VERSION;
+  if (telemetryFrameCrc(in, TELEMETRY_FRAME_SIZE - 2) != (in[18] | (uint16_t)in[19] << 8)) return TELEMETRY_FRAME_BAD_CRC;
+  frame.version = in[1];
+  frame.sequence = in[2] | (uint16_t)in[3] << 8;
+  frame.deviceId = in[4] | (uint32_t)in[5] << 8 | (uint32_t)in[6] << 16 | (uint32_t)in[7] << 24;
+  frame.sample.timestamp = in[8] | (uint32_t)in[9] << 8 | (uint32_t)in[10] << 16 | (uint32_t)in[11] << 24;
+  frame.sample.temperatureDeci = (int16_t)(in[12] | (uint16_t)in[13] << 8);
+  frame.sample.light = in[14] | (uint16_t)in[15] << 8;
+  frame.sample.moisture = in[16];
+  frame.sample.flags = in[17];
+  return TELEMETRY_FRAME_OK;
+}
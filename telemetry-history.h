@@ -0,0 +1,513 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "telemetry-frame.h"
+
+// ─────────────────────────────────────
+// Compressed Telemetry History
+// ─────────────────────────────────────
+// Keeps the readings the sketch would otherwise overwrite on its next pass,
+// in a fixed RAM budget, so the board can answer "what did moisture do
+// over the last day" without the cloud:
+//
+//   history.append(captureTelemetrySample());          // 1 Hz
+//   history.forEachSample(from, to, visit);            // recent raw samples
+//   history.forEachRollup(HISTORY_HOUR, from, to, visit);
+//   history.summarize(HISTORY_QUARTER, now - 86400, now, day);
+//
+// Two tiers:
+//
+// * Raw: every sample, Gorilla-compressed into a ring of fixed blocks.
+//   Timestamps are stored as delta-of-delta (a steady 1 Hz series costs one
+//   bit per sample); each channel as the XOR with its previous value, where
+//   an unchanged value costs one bit and a change costs its meaningful bits,
+//   reusing the previous leading/trailing-zero window when it fits. Sensor
+//   values settle, so a sample typically takes 5-8 bits instead of the 12
+//   bytes of a TelemetrySample. When the ring is full the oldest block is
+//   dropped whole.
+// * Rollups: min/max/mean of each channel plus pump duty per 1-minute,
+//   15-minute and 1-hour interval, each a ring that overwrites its oldest
+//   interval in place. They are fed from every sample as it arrives, so they
+//   are exact and outlive the raw tier: with the defaults the raw tier holds
+//   the last 30-45 minutes at 1 Hz and the rollups cover 1 h, 24 h and 48 h.
+//
+// Memory is all static: 8 x 256 B blocks plus 204 x 24 B intervals, about
+// 7 KB. Times are the sample timestamps (device seconds); intervals are
+// aligned to multiples of their length. Intervals without samples are kept
+// as empty (samples == 0), so the rings stay contiguous in time. This
+// header needs only the C library and builds for host tools too.
+
+enum HistoryResolution : uint8_t {
+  HISTORY_MINUTE,
+  HISTORY_QUARTER,
+  HISTORY_HOUR,
+};
+
+inline uint32_t historyPeriodSeconds(HistoryResolution resolution) {
+  return resolution == HISTORY_MINUTE ? 60 : resolution == HISTORY_QUARTER ? 900 : 3600;
+}
+
+// One interval of one resolution. Temperature fields are
+// TELEMETRY_TEMPERATURE_UNKNOWN when no sample in it had a reading.
+struct HistoryRollup {
+  uint32_t samples;            // Wide enough for summaries over days
+  uint32_t pumpSamples;        // Samples with TELEMETRY_FLAG_PUMP set
+  int16_t temperatureMin;
+  int16_t temperatureMax;
+  int16_t temperatureMean;
+  uint16_t lightMin;
+  uint16_t lightMax;
+  uint16_t lightMean;
+  uint8_t moistureMin;
+  uint8_t moistureMax;
+  uint8_t moistureMean;
+  uint8_t flags;               // Every TELEMETRY_FLAG_* seen in the interval
+};
+
+struct TelemetryHistoryStats {
+  uint32_t appended = 0;
+  uint32_t rejected = 0;       // Older than the newest sample
+  uint32_t blocksDropped = 0;
+  uint32_t retainedSamples = 0;
+  uint32_t retainedBits = 0;   // Compressed size of the raw tier
+  uint32_t oldestRaw = 0;      // Timestamp span of the raw tier
+  uint32_t newestRaw = 0;
+
+  float bitsPerSample() const { return retainedSamples ? (float)retainedBits / retainedSamples : 0.0f; }
+};
+
+template <uint8_t BLOCKS = 8, uint16_t BLOCK_BYTES = 256, uint16_t MINUTES = 60, uint16_t QUARTERS = 96,
+          uint8_t HOURS = 48>
+class TelemetryHistory {
+public:
+  static const uint8_t CHANNELS = 4;   // Temperature, light, moisture, flags - each coded as 16 bits
+
+  TelemetryHistory() { clear(); }
+
+  void clear() {
+    for (uint8_t i = 0; i < BLOCKS; i++) blocks[i].count = 0;
+    newestBlock = 0;
+    usedBlocks = 0;
+    minutes.clear();
+    quarters.clear();
+    hours.clear();
+    statistics = TelemetryHistoryStats();
+  }
+
+  // False for a sample older than the newest one (e.g. the device clock was
+  // reset); call clear() to start over on a new time base.
+  bool append(const TelemetrySample &sample) {
+    if (usedBlocks && sample.timestamp < blocks[newestBlock].lastTime) {
+      statistics.rejected++;
+      return false;
+    }
+    appendRaw(sample);
+    minutes.add(sample, 60);
+    quarters.add(sample, 900);
+    hours.add(sample, 3600);
+    statistics.appended++;
+    return true;
+  }
+
+  // Raw samples with from <= timestamp < to, oldest first:
+  // visit(const TelemetrySample &). Decodes only the blocks that overlap.
+  template <typename Visitor>
+  void forEachSample(uint32_t from, uint32_t to, Visitor visit) const {
+    forEachSampleWhile(from, to, [&](const TelemetrySample &sample) {
+      visit(sample);
+      return true;
+    });
+  }
+
+  // As forEachSample(), stopping at the first visit() that returns false,
+  // for readers that take the samples a few at a time. False when stopped.
+  template <typename Visitor>
+  bool forEachSampleWhile(uint32_t from, uint32_t to, Visitor visit) const {
+    for (uint8_t i = 0; i < usedBlocks; i++) {
+      const Block &block = blocks[(newestBlock + BLOCKS - usedBlocks + 1 + i) % BLOCKS];
+      if (block.lastTime < from || block.firstTime >= to) continue;
+      Decoder decoder(block);
+      TelemetrySample sample;
+      for (uint16_t n = 0; n < block.count; n++) {
+        decoder.next(sample);
+        if (sample.timestamp >= to) break;
+        if (sample.timestamp >= from && !visit(sample)) return false;
+      }
+    }
+    return true;
+  }
+
+  // Intervals starting in [from, to), oldest first, including the one still
+  // filling: visit(uint32_t start, const HistoryRollup &).
+  template <typename Visitor>
+  void forEachRollup(HistoryResolution resolution, uint32_t from, uint32_t to, Visitor visit) const {
+    const uint32_t period = historyPeriodSeconds(resolution);
+    if (resolution == HISTORY_MINUTE) minutes.visit(period, from, to, visit);
+    else if (resolution == HISTORY_QUARTER) quarters.visit(period, from, to, visit);
+    else hours.visit(period, from, to, visit);
+  }
+
+  // Merges the intervals of one resolution starting in [from, to). False
+  // when none of them holds a sample.
+  bool summarize(HistoryResolution resolution, uint32_t from, uint32_t to, HistoryRollup &summary) const {
+    Accumulator total;
+    forEachRollup(resolution, from, to, [&](uint32_t, const HistoryRollup &interval) { total.merge(interval); });
+    summary = total.rollup();
+    return summary.samples > 0;
+  }
+
+  // Start of the interval still filling, and of the oldest one retained
+  uint32_t newestRollup(HistoryResolution resolution) const {
+    return resolution == HISTORY_MINUTE ? minutes.openStart : resolution == HISTORY_QUARTER ? quarters.openStart : hours.openStart;
+  }
+  uint32_t oldestRollup(HistoryResolution resolution) const {
+    const uint32_t period = historyPeriodSeconds(resolution);
+    return resolution == HISTORY_MINUTE ? minutes.oldestStart(period)
+         : resolution == HISTORY_QUARTER ? quarters.oldestStart(period)
+                                         : hours.oldestStart(period);
+  }
+
+  const TelemetryHistoryStats &stats() const { return statistics; }
+
+  static size_t memoryBytes() { return sizeof(TelemetryHistory); }
+
+private:
+  // Worst case for one sample: a 32-bit delta-of-delta with its 4-bit
+  // prefix, then per channel 2 control bits, 4 + 4 window bits and 16 bits
+  static const uint16_t MAX_SAMPLE_BITS = 36 + CHANNELS * 26;
+  static const uint16_t HEADER_BITS = 32 + CHANNELS * 16;
+
+  struct Block {
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint16_t count;
+    uint16_t bits;
+    uint8_t data[BLOCK_BYTES];
+  };
+
+  // Per-channel XOR state, identical on the encoding and decoding side
+  struct Channel {
+    uint16_t value;
+    uint8_t leading;
+    uint8_t trailing;     // leading == 0xFF: no window yet
+  };
+
+  struct Coder {
+    uint32_t time;
+    int32_t delta;
+    Channel channels[CHANNELS];
+
+    void start(const uint16_t values[CHANNELS], uint32_t timestamp) {
+      time = timestamp;
+      delta = 0;
+      for (uint8_t c = 0; c < CHANNELS; c++) channels[c] = { values[c], 0xFF, 0 };
+    }
+  };
+
+  static void channelValues(const TelemetrySample &sample, uint16_t values[CHANNELS]) {
+    values[0] = (uint16_t)sample.temperatureDeci;
+    values[1] = sample.light;
+    values[2] = sample.moisture;
+    values[3] = sample.flags;
+  }
+
+  static void putBits(Block &block, uint32_t value, uint8_t count) {
+    while (count) {
+      uint8_t offset = block.bits & 7;
+      uint8_t room = 8 - offset;
+      uint8_t take = count < room ? count : room;
+      uint8_t chunk = (uint8_t)((value >> (count - take)) & ((1u << take) - 1));
+      uint8_t &byte = block.data[block.bits >> 3];
+      if (!offset) byte = 0;
+      byte |= chunk << (room - take);
+      block.bits += take;
+      count -= take;
+    }
+  }
+
+  class Decoder {
+  public:
+    explicit Decoder(const Block &source) : block(source) {}
+
+    void next(TelemetrySample &sample) {
+      uint16_t values[CHANNELS];
+      if (!started) {
+        uint32_t time = bits(32);
+        for (uint8_t c = 0; c < CHANNELS; c++) values[c] = bits(16);
+        state.start(values, time);
+        started = true;
+      } else {
+        state.delta += timeDelta();
+        state.time += state.delta;
+        for (uint8_t c = 0; c < CHANNELS; c++) values[c] = channel(state.channels[c]);
+      }
+      sample.timestamp = state.time;
+      sample.temperatureDeci = (int16_t)values[0];
+      sample.light = values[1];
+      sample.moisture = (uint8_t)values[2];
+      sample.flags = (uint8_t)values[3];
+    }
+
+  private:
+    const Block &block;
+    Coder state;
+    uint16_t position = 0;
+    bool started = false;
+
+    uint32_t bits(uint8_t count) {
+      uint32_t value = 0;
+      while (count) {
+        uint8_t offset = position & 7;
+        uint8_t room = 8 - offset;
+        uint8_t take = count < room ? count : room;
+        uint8_t chunk = (block.data[position >> 3] >> (room - take)) & ((1u << take) - 1);
+        value = value << take | chunk;
+        position += take;
+        count -= take;
+      }
+      return value;
+    }
+
+    static int32_t signExtend(uint32_t value, uint8_t width) {
+      return (int32_t)(value << (32 - width)) >> (32 - width);
+    }
+
+    int32_t timeDelta() {
+      if (!bits(1)) return 0;
+      if (!bits(1)) return signExtend(bits(7), 7);
+      if (!bits(1)) return signExtend(bits(9), 9);
+      if (!bits(1)) return signExtend(bits(12), 12);
+      return (int32_t)bits(32);
+    }
+
+    uint16_t channel(Channel &previous) {
+      if (!bits(1)) return previous.value;
+      if (bits(1)) {
+        previous.leading = bits(4);
+        uint8_t length = bits(4) + 1;
+        previous.trailing = 16 - previous.leading - length;
+      }
+      uint8_t length = 16 - previous.leading - previous.trailing;
+      previous.value ^= bits(length) << previous.trailing;
+      return previous.value;
+    }
+  };
+
+  // Delta-of-delta buckets as in Gorilla, narrowed for second timestamps
+  static void putTimeDelta(Block &block, int32_t delta) {
+    if (delta == 0) {
+      putBits(block, 0, 1);
+    } else if (delta >= -63 && delta <= 64) {
+      putBits(block, 0x2, 2);
+      putBits(block, (uint32_t)delta & 0x7F, 7);
+    } else if (delta >= -255 && delta <= 256) {
+      putBits(block, 0x6, 3);
+      putBits(block, (uint32_t)delta & 0x1FF, 9);
+    } else if (delta >= -2047 && delta <= 2048) {
+      putBits(block, 0xE, 4);
+      putBits(block, (uint32_t)delta & 0xFFF, 12);
+    } else {
+      putBits(block, 0xF, 4);
+      putBits(block, (uint32_t)delta, 32);
+    }
+  }
+
+  static void putChannel(Block &block, Channel &previous, uint16_t value) {
+    uint16_t difference = value ^ previous.value;
+    previous.value = value;
+    if (!difference) {
+      putBits(block, 0, 1);
+      return;
+    }
+    uint8_t leading = __builtin_clz(difference) - 16;
+    uint8_t trailing = __builtin_ctz(difference);
+    if (previous.leading != 0xFF && leading >= previous.leading && trailing >= previous.trailing) {
+      putBits(block, 0x2, 2);
+      putBits(block, difference >> previous.trailing, 16 - previous.leading - previous.trailing);
+      return;
+    }
+    uint8_t length = 16 - leading - trailing;
+    putBits(block, 0x3, 2);
+    putBits(block, leading, 4);
+    putBits(block, length - 1, 4);
+    putBits(block, difference >> trailing, length);
+    previous.leading = leading;
+    previous.trailing = trailing;
+  }
+
+  void appendRaw(const TelemetrySample &sample) {
+    uint16_t values[CHANNELS];
+    channelValues(sample, values);
+    if (!usedBlocks || blocks[newestBlock].bits + MAX_SAMPLE_BITS > BLOCK_BYTES * 8) {
+      openBlock();
+      Block &block = blocks[newestBlock];
+      putBits(block, sample.timestamp, 32);
+      for (uint8_t c = 0; c < CHANNELS; c++) putBits(block, values[c], 16);
+      encoder.start(values, sample.timestamp);
+      block.firstTime = block.lastTime = sample.timestamp;
+      block.count = 1;
+      statistics.retainedBits += HEADER_BITS;
+    } else {
+      Block &block = blocks[newestBlock];
+      uint16_t before = block.bits;
+      int32_t delta = (int32_t)(sample.timestamp - encoder.time);
+      putTimeDelta(block, delta - encoder.delta);
+      encoder.delta = delta;
+      encoder.time = sample.timestamp;
+      for (uint8_t c = 0; c < CHANNELS; c++) putChannel(block, encoder.channels[c], values[c]);
+      block.lastTime = sample.timestamp;
+      block.count++;
+      statistics.retainedBits += block.bits - before;
+    }
+    statistics.retainedSamples++;
+    statistics.newestRaw = sample.timestamp;
+    statistics.oldestRaw = blocks[(newestBlock + BLOCKS - usedBlocks + 1) % BLOCKS].firstTime;
+  }
+
+  void openBlock() {
+    newestBlock = usedBlocks ? (newestBlock + 1) % BLOCKS : 0;
+    if (usedBlocks == BLOCKS) {
+      // The ring is full: the block about to be reused is the oldest
+      Block &oldest = blocks[newestBlock];
+      statistics.retainedSamples -= oldest.count;
+      statistics.retainedBits -= oldest.bits;
+      statistics.blocksDropped++;
+    } else {
+      usedBlocks++;
+    }
+    blocks[newestBlock].bits = 0;
+    blocks[newestBlock].count = 0;
+  }
+
+  // Running sums for the interval still filling, or for summarize()
+  struct Accumulator {
+    uint32_t samples = 0;
+    uint32_t pumpSamples = 0;
+    uint32_t temperatureSamples = 0;
+    int32_t temperatureSum = 0;
+    uint32_t lightSum = 0;
+    uint32_t moistureSum = 0;
+    HistoryRollup extremes = { 0, 0, INT16_MAX, INT16_MIN, 0, UINT16_MAX, 0, 0, UINT8_MAX, 0, 0, 0 };
+
+    void add(const TelemetrySample &sample) {
+      samples++;
+      if (sample.flags & TELEMETRY_FLAG_PUMP) pumpSamples++;
+      extremes.flags |= sample.flags;
+      if (sample.temperatureDeci != TELEMETRY_TEMPERATURE_UNKNOWN) {
+        temperatureSamples++;
+        temperatureSum += sample.temperatureDeci;
+        if (sample.temperatureDeci < extremes.temperatureMin) extremes.temperatureMin = sample.temperatureDeci;
+        if (sample.temperatureDeci > extremes.temperatureMax) extremes.temperatureMax = sample.temperatureDeci;
+      }
+      lightSum += sample.light;
+      if (sample.light < extremes.lightMin) extremes.lightMin = sample.light;
+      if (sample.light > extremes.lightMax) extremes.lightMax = sample.light;
+      moistureSum += sample.moisture;
+      if (sample.moisture < extremes.moistureMin) extremes.moistureMin = sample.moisture;
+      if (sample.moisture > extremes.moistureMax) extremes.moistureMax = sample.moisture;
+    }
+
+    // Weighted by sample count; temperature means by the samples that had one
+    void merge(const HistoryRollup &interval) {
+      if (!interval.samples) return;
+      samples += interval.samples;
+      pumpSamples += interval.pumpSamples;
+      extremes.flags |= interval.flags;
+      if (interval.temperatureMean != TELEMETRY_TEMPERATURE_UNKNOWN) {
+        temperatureSamples += interval.samples;
+        temperatureSum += (int32_t)interval.temperatureMean * interval.samples;
+        if (interval.temperatureMin < extremes.temperatureMin) extremes.temperatureMin = interval.temperatureMin;
+        if (interval.temperatureMax > extremes.temperatureMax) extremes.temperatureMax = interval.temperatureMax;
+      }
+      lightSum += (uint32_t)interval.lightMean * interval.samples;
+      if (interval.lightMin < extremes.lightMin) extremes.lightMin = interval.lightMin;
+      if (interval.lightMax > extremes.lightMax) extremes.lightMax = interval.lightMax;
+      moistureSum += (uint32_t)interval.moistureMean * interval.samples;
+      if (interval.moistureMin < extremes.moistureMin) extremes.moistureMin = interval.moistureMin;
+      if (interval.moistureMax > extremes.moistureMax) extremes.moistureMax = interval.moistureMax;
+    }
+
+    static int32_t roundedMean(int32_t sum, uint32_t count) {
+      return sum >= 0 ? (sum + (int32_t)count / 2) / (int32_t)count : (sum - (int32_t)count / 2) / (int32_t)count;
+    }
+
+    HistoryRollup rollup() const {
+      HistoryRollup result = {};
+      if (!samples) {
+        result.temperatureMin = result.temperatureMax = result.temperatureMean = TELEMETRY_TEMPERATURE_UNKNOWN;
+        return result;
+      }
+      result = extremes;
+      result.samples = samples;
+      result.pumpSamples = pumpSamples;
+      if (temperatureSamples) {
+        result.temperatureMean = roundedMean(temperatureSum, temperatureSamples);
+      } else {
+        result.temperatureMin = result.temperatureMax = result.temperatureMean = TELEMETRY_TEMPERATURE_UNKNOWN;
+      }
+      result.lightMean = (lightSum + samples / 2) / samples;
+      result.moistureMean = (moistureSum + samples / 2) / samples;
+      return result;
+    }
+  };
+
+  template <uint16_t INTERVALS>
+  struct RollupRing {
+    HistoryRollup intervals[INTERVALS];
+    Accumulator open;
+    uint32_t openStart;
+    uint16_t newest;      // Index of the newest closed interval
+    uint16_t closed;
+
+    void clear() {
+      open = Accumulator();
+      openStart = 0;
+      newest = INTERVALS - 1;
+      closed = 0;
+    }
+
+    void push(const HistoryRollup &interval) {
+      newest = (newest + 1) % INTERVALS;
+      intervals[newest] = interval;
+      if (closed < INTERVALS) closed++;
+    }
+
+    void add(const TelemetrySample &sample, uint32_t period) {
+      uint32_t start = sample.timestamp - sample.timestamp % period;
+      if (open.samples && start != openStart) {
+        push(open.rollup());
+        // Intervals nobody sampled stay in the ring as empty ones
+        uint32_t skipped = (start - openStart) / period - 1;
+        for (uint32_t i = 0; i < skipped && i < INTERVALS; i++) push(Accumulator().rollup());
+        open = Accumulator();
+      }
+      openStart = start;
+      open.add(sample);
+    }
+
+    uint32_t oldestStart(uint32_t period) const {
+      return openStart - (uint32_t)closed * period;
+    }
+
+    template <typename Visitor>
+    void visit(uint32_t period, uint32_t from, uint32_t to, Visitor &visitor) const {
+      if (!open.samples) return;
+      uint32_t start = oldestStart(period);
+      for (uint16_t i = 0; i < closed; i++, start += period) {
+        if (start >= from && start < to) visitor(start, intervals[(newest + INTERVALS - closed + 1 + i) % INTERVALS]);
+      }
+      if (openStart >= from && openStart < to) visitor(openStart, open.rollup());
+    }
+  };
+
+  Block blocks[BLOCKS];
+  Coder encoder;
+  uint8_t newestBlock = 0;
+  uint8_t usedBlocks = 0;
+  RollupRing<MINUTES> minutes;
+  RollupRing<QUARTERS> quarters;
+  RollupRing<HOURS> hours;
+  TelemetryHistoryStats statistics;
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "rtc-memory.h"
+#include "telemetry-frame.h"
+
+// ─────────────────────────────────────
+// Offline Telemetry Journal
+// ─────────────────────────────────────
+// Append-only log of fixed 12-byte records on LittleFS, kept while the
+// cloud is unreachable and replayed in batches once it is back. The log is
+// a ring of segment files, each the size of one 8 KB flash block:
+//
+//   /journal/00000007  /journal/00000008  ...  /journal/0000000a ◄── append
+//        ▲ replay cursor (segment, record) - kept in RTC memory
+//
+// Records are buffered in RAM and written a batch at a time, segments are
+// only ever appended to and deleted whole, and the oldest segment is
+// dropped when the budget is full, so writes rotate through the filesystem
+// instead of rewriting the same pages. The flash budget is fixed at
+// segments x recordsPerSegment records (32 KB, about 45 h at one record
+// per minute with the defaults).
+
+struct TelemetryRecord {
+  uint32_t timestamp;        // DutyCycle clock, seconds
+  int16_t temperatureDeci;   // Degrees C x 10, TELEMETRY_TEMPERATURE_UNKNOWN without a reading
+  uint16_t light;            // Photosensor counts, 0 when not fitted
+  uint8_t moisture;          // Soil moisture %
+  uint8_t flags;             // TELEMETRY_FLAG_*
+  uint16_t check;            // Low half of the CRC32 of the fields above
+};
+static_assert(sizeof(TelemetryRecord) == 12, "TelemetryRecord layout is stored in flash");
+
+// The sample a record retains, e.g. to replay it as a LAN telemetry frame
+inline TelemetrySample telemetryRecordSample(const TelemetryRecord &record) {
+  TelemetrySample sample;
+  sample.timestamp = record.timestamp;
+  sample.temperatureDeci = record.temperatureDeci;
+  sample.light = record.light;
+  sample.moisture = record.moisture;
+  sample.flags = record.flags;
+  return sample;
+}
+
+struct TelemetryJournalConfig {
+  uint8_t segments = 4;               // Flash budget in segment files
+  uint16_t recordsPerSegment = 682;   // 8184 bytes - one LittleFS block
+  uint8_t flushThreshold = 8;         // Records buffered in RAM per flash write
+};
+
+struct TelemetryJournalStats {
+  uint32_t appended = 0;
+  uint32_t flashWrites = 0;
+  uint32_t replayed = 0;
+  uint32_t dropped = 0;     // Lost to the flash budget before they could be replayed
+  uint32_t corrupt = 0;     // Failed the record check on replay (torn write)
+};
+
+struct TelemetryJournalCursor {
+  uint32_t segment;
+  uint16_t record;
+};
+
+class TelemetryJournal {
+public:
+  static const uint8_t MAX_BUFFERED = 16;
+
+  bool begin(const TelemetryJournalConfig &journalConfig = TelemetryJournalConfig()) {
+    config = journalConfig;
+    if (config.flushThreshold > MAX_BUFFERED) config.flushThreshold = MAX_BUFFERED;
+    buffered = 0;
+    mounted = LittleFS.begin();
+    if (!mounted) return false;
+    LittleFS.mkdir(DIRECTORY);
+
+    oldestSegment = 0;
+    writeSegment = 0;
+    Dir dir = LittleFS.openDir(DIRECTORY);
+    while (dir.next()) {
+      uint32_t segment = strtoul(dir.fileName().c_str(), nullptr, 16);
+      if (segment == 0) continue;
+      if (oldestSegment == 0 || segment < oldestSegment) oldestSegment = segment;
+      if (segment > writeSegment) writeSegment = segment;
+    }
+
+    if (writeSegment == 0) {
+      oldestSegment = writeSegment = 1;
+      writeCount = 0;
+    } else {
+      size_t bytes = segmentSize(writeSegment);
+      writeCount = bytes / sizeof(TelemetryRecord);
+      if (bytes % sizeof(TelemetryRecord) != 0) {
+        rotate();  // Torn tail from a reset mid-write - never append after it
+      }
+    }
+
+    if (!cursorRecord.load(cursor) || cursor.segment < oldestSegment || cursor.segment > writeSegment) {
+      cursor.segment = oldestSegment;
+      cursor.record = 0;
+    }
+    pendingCursor = cursor;
+    return true;
+  }
+
+  void append(TelemetryRecord record) {
+    if (!mounted) return;
+    record.check = recordCheck(record);
+    buffer[buffered++] = record;
+    statistics.appended++;
+    if (buffered >= config.flushThreshold) flush();
+  }
+
+  // Write buffered records; call before deep sleep so none are lost.
+  void flush() {
+    uint8_t written = 0;
+    while (written < buffered) {
+      if (writeCount >= config.recordsPerSegment) rotate();
+      uint16_t room = config.recordsPerSegment - writeCount;
+      uint8_t chunk = buffered - written < room ? buffered - written : room;
+      File file = LittleFS.open(segmentPath(writeSegment).text, "a");
+      if (!file) break;
+      file.write((const uint8_t *)&buffer[written], chunk * sizeof(TelemetryRecord));
+      file.close();
+      statistics.flashWrites++;
+      writeCount += chunk;
+      written += chunk;
+    }
+    buffered = 0;
+  }
+
+  // Records not yet acknowledged by commit(), including those still in RAM.
+  uint32_t backlog() const {
+    if (!mounted) return 0;
+    return (writeSegment - cursor.segment) * config.recordsPerSegment + writeCount - cursor.record + buffered;
+  }
+
+  // Read up to `maxRecords` from the replay cursor without consuming them.
+  // A following commit() acknowledges them; reading again instead re-sends
+  // the same batch, so delivery is at-least-once.
+  size_t readBatch(TelemetryRecord *records, size_t maxRecords) {
+    if (!mounted) return 0;
+    flush();
+    pendingCursor = cursor;
+    size_t count = 0;
+    while (count < maxRecords) {
+      File file = LittleFS.open(segmentPath(pendingCursor.segment).text, "r");
+      if (file && file.seek(pendingCursor.record * sizeof(TelemetryRecord))) {
+        while (count < maxRecords && file.read((uint8_t *)&records[count], sizeof(TelemetryRecord)) == sizeof(TelemetryRecord)) {
+          pendingCursor.record++;
+          if (records[count].check == recordCheck(records[count])) {
+            count++;
+          } else {
+            statistics.corrupt++;
+          }
+        }
+      }
+      if (count >= maxRecords || pendingCursor.segment >= writeSegment) break;
+      pendingCursor.segment++;  // Segment exhausted (or missing) - continue with the next one
+      pendingCursor.record = 0;
+    }
+    pendingCount = count;
+    if (count == 0) {
+      cursor = pendingCursor;  // Only skipped torn records or short segments - nothing to acknowledge
+    }
+    return count;
+  }
+
+  // Acknowledge the last readBatch() and delete fully replayed segments.
+  void commit() {
+    if (!mounted) return;
+    statistics.replayed += pendingCount;
+    pendingCount = 0;
+    cursor = pendingCursor;
+    while (oldestSegment < cursor.segment) {
+      LittleFS.remove(segmentPath(oldestSegment).text);
+      oldestSegment++;
+    }
+    cursorRecord.save(cursor);
+  }
+
+  const TelemetryJournalStats &stats() const { return statistics; }
+
+private:
+  static constexpr const char *DIRECTORY = "/journal";
+
+  TelemetryJournalConfig config;
+  TelemetryJournalStats statistics;
+  RtcRecord<TelemetryJournalCursor, RTC_BLOCK_TELEMETRY_JOURNAL> cursorRecord;
+  TelemetryJournalCursor cursor = { 1, 0 };
+  TelemetryJournalCursor pendingCursor = { 1, 0 };
+  size_t pendingCount = 0;
+  TelemetryRecord buffer[MAX_BUFFERED];
+  uint8_t buffered = 0;
+  uint32_t oldestSegment = 1;
+  uint32_t writeSegment = 1;
+  uint16_t writeCount = 0;
+  bool mounted = false;
+
+  static uint16_t recordCheck(const TelemetryRecord &record) {
+    return (uint16_t)crc32(&record, offsetof(TelemetryRecord, check));
+  }
+
+  struct SegmentPath {
+    char text[24];
+  };
+
+  // Returned by value on the stack - a String here would allocate on every open
+  static SegmentPath segmentPath(uint32_t segment) {
+    SegmentPath path;
+    snprintf(path.text, sizeof(path.text), "%s/%08lx", DIRECTORY, (unsigned long)segment);
+    return path;
+  }
+
+  static size_t segmentSize(uint32_t segment) {
+    File file = LittleFS.open(segmentPath(segment).text, "r");
+    return file ? file.size() : 0;
+  }
+
+  void rotate() {
+    writeSegment++;
+    writeCount = 0;
+    // Budget full: drop the oldest segment, replayed or not
+    while (writeSegment - oldestSegment >= config.segments) {
+      if (cursor.segment == oldestSegment) {
+        statistics.dropped += config.recordsPerSegment - cursor.record;
+        cursor.segment++;
+        cursor.record = 0;
+        pendingCursor = cursor;
+        cursorRecord.save(cursor);
+      }
+      LittleFS.remove(segmentPath(oldestSegment).text);
+      oldestSegment++;
+    }
+  }
+};
+
+// Longest rendered record ("a4294967295,100,65535,255,-32768;"); size
+// batch buffers as records x TELEMETRY_BATCH_FIELD_MAX + 1.
+const size_t TELEMETRY_BATCH_FIELD_MAX = 34;
+
+// Render a batch for a cloud String property, oldest first:
+//   "a<age s>,<moisture>,<light>,<flags>,<temp x10>;+<delta s>,<moisture>,...;"
+// The first record carries its age at send time, later ones the seconds
+// since the previous record; an unknown temperature leaves its field empty.
+// Returns the number of records that fit in `size`.
+inline size_t formatTelemetryBatch(char *text, size_t size, const TelemetryRecord *records, size_t count,
+                                   uint32_t nowSeconds) {
+  size_t length = 0;
+  size_t rendered = 0;
+  text[0] = '\0';
+  for (; rendered < count; rendered++) {
+    const TelemetryRecord &record = records[rendered];
+    char temperature[8] = "";
+    if (record.temperatureDeci != TELEMETRY_TEMPERATURE_UNKNOWN) {
+      snprintf(temperature, sizeof(temperature), "%d", record.temperatureDeci);
+    }
+    char field[48];
+    int fieldLength = rendered == 0
+      ? snprintf(field, sizeof(field), "a%lu,%u,%u,%u,%s;", (unsigned long)(nowSeconds - record.timestamp),
+                 record.moisture, record.light, record.flags, temperature)
+      : snprintf(field, sizeof(field), "+%lu,%u,%u,%u,%s;", (unsigned long)(record.timestamp - records[rendered - 1].timestamp),
+                 record.moisture, record.light, record.flags, temperature);
+    if (length + fieldLength >= size) break;
+    memcpy(text + length, field, fieldLength + 1);
+    length += fieldLength;
+  }
+  return rendered;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ─────────────────────────────────────
+// Telemetry Publish Coalescer
+// ─────────────────────────────────────
+// Sits between the sketches and their cloud backend. Sketches offer every
+// fresh reading with set(); once per coalescing window poll() decides per
+// property whether the value is worth transmitting and hands all winners
+// to the sink together, so one window costs at most one cloud message
+// (ArduinoCloud) or one burst of virtual writes (Blynk).
+//
+// A pending value is sent when
+//   - it differs from the last sent value by at least the deadband, and
+//     the property's minimum interval has elapsed (otherwise it waits), or
+//   - the maximum interval has elapsed (heartbeat, even if unchanged).
+// Exact repeats and sub-deadband jitter are dropped and counted.
+
+struct PublishPolicy {
+  float deadband = 0.0f;            // Smallest change worth sending (0 = any change)
+  unsigned long minIntervalMs = 0;  // Rate limit between sends of this property
+  unsigned long maxIntervalMs = 0;  // Heartbeat resend of an unchanged value (0 = never)
+};
+
+struct PublisherStats {
+  uint32_t offered = 0;             // set() calls
+  uint32_t sent = 0;                // Values handed to the sink
+  uint32_t transmissions = 0;       // Windows that sent at least one value
+  uint32_t suppressedDuplicate = 0; // Identical to the last sent value
+  uint32_t suppressedDeadband = 0;  // Changed by less than the deadband
+  uint32_t coalesced = 0;           // Superseded by a newer value before sending
+
+  uint32_t suppressed() const { return suppressedDuplicate + suppressedDeadband + coalesced; }
+};
+
+typedef void (*PublishSink)(uint8_t property, float value);
+
+template <uint8_t MAX_PROPERTIES = 8>
+class TelemetryPublisher {
+public:
+  void begin(PublishSink publishSink, unsigned long windowMs = 1000) {
+    sink = publishSink;
+    window = windowMs;
+    lastWindow = millis() - windowMs;  // First poll() goes out at once - short wake cycles may not see a second
+  }
+
+  // Register a property; returns its handle or -1 when full.
+  int8_t add(const PublishPolicy &policy) {
+    if (count >= MAX_PROPERTIES) return -1;
+    Property &property = properties[count];
+    property.policy = policy;
+    property.published = false;
+    property.pending = false;
+    return count++;
+  }
+
+  void set(uint8_t handle, float value) {
+    if (handle >= count) return;
+    Property &property = properties[handle];
+    statistics.offered++;
+    if (property.pending) statistics.coalesced++;
+    property.value = value;
+    property.pending = true;
+  }
+
+  // Record a value that reached the backend by another path (e.g. a remote
+  // write), so it is not echoed back.
+  void resync(uint8_t handle, float value) {
+    if (handle >= count) return;
+    Property &property = properties[handle];
+    property.lastSent = value;
+    property.lastSentAt = millis();
+    property.published = true;
+    property.pending = false;
+  }
+
+  // Send everything due in one go; returns true when a transmission happened.
+  bool poll() {
+    unsigned long now = millis();
+    if (now - lastWindow < window) return false;
+    lastWindow = now;
+
+    uint8_t sentNow = 0;
+    for (uint8_t handle = 0; handle < count; handle++) {
+      Property &property = properties[handle];
+      if (!due(property, now)) continue;
+      sink(handle, property.value);
+      property.lastSent = property.value;
+      property.lastSentAt = now;
+      property.published = true;
+      property.pending = false;
+      sentNow++;
+    }
+    statistics.sent += sentNow;
+    if (sentNow) statistics.transmissions++;
+    return sentNow > 0;
+  }
+
+  const PublisherStats &stats() const { return statistics; }
+
+private:
+  struct Property {
+    PublishPolicy policy;
+    float value;
+    float lastSent;
+    unsigned long lastSentAt;
+    bool published;
+    bool pending;
+  };
+
+  Property properties[MAX_PROPERTIES];
+  uint8_t count = 0;
+  PublishSink sink = nullptr;
+  unsigned long window = 1000;
+  unsigned long lastWindow = 0;
+  PublisherStats statistics;
+
+  bool due(Property &property, unsigned long now) {
+    if (!property.published) return property.pending;
+
+    unsigned long sinceSent = now - property.lastSentAt;
+    if (property.policy.maxIntervalMs && sinceSent >= property.policy.maxIntervalMs) {
+      if (!property.pending) property.value = property.lastSent;  // Heartbeat repeats the last value
+      return true;
+    }
+    if (!property.pending) return false;
+
+    float change = fabsf(property.value - property.lastSent);
+    if (change == 0.0f || (isnan(property.value) && isnan(property.lastSent))) {
+      statistics.suppressedDuplicate++;
+      property.pending = false;
+      return false;
+    }
+    if (change < property.policy.deadband) {
+      statistics.suppressedDeadband++;
+      property.pending = false;
+      return false;
+    }
+    return sinceSent >= property.policy.minIntervalMs;  // Otherwise held until the rate limit allows it
+  }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "telemetry-frame.h"
+
+// ─────────────────────────────────────
+// LAN Telemetry Streaming
+// ─────────────────────────────────────
+// Sends samples as 20-byte binary frames (telemetry-frame.h) in UDP
+// datagrams to a collector on the local network, alongside the cloud or
+// instead of it:
+//
+//   lanTelemetry.begin(ESP.getChipId());        // broadcast on port 47800
+//   lanTelemetry.send(sample);                  // whenever the sketch's rate is due
+//
+// A frame is one datagram of 48 bytes on the air with its UDP/IP headers,
+// encoded into a buffer on the stack - no allocation, no TLS, no broker
+// round trip. Delivery is best effort: nothing is retried, and the
+// collector counts gaps in the sequence numbers. Frames are only attempted
+// while the link is up; a failed send still consumes its sequence number.
+//
+// The sequence number can be carried across resets by the caller (e.g. in
+// RTC memory) with nextSequence() and the `firstSequence` of begin(), so a
+// deep-sleeping board does not restart its count on every wake.
+
+struct TelemetryStreamConfig {
+  uint16_t port = TELEMETRY_FRAME_PORT;
+  IPAddress destination = IPAddress(255, 255, 255, 255);  // Broadcast; a collector's address for unicast
+};
+
+struct TelemetryStreamStats {
+  uint32_t sent = 0;
+  uint32_t failed = 0;     // No buffer for the datagram, or the link dropped
+  uint32_t bytes = 0;      // UDP payload sent
+};
+
+class TelemetryStreamer {
+public:
+  void begin(uint32_t deviceId, uint16_t firstSequence = 0,
+             const TelemetryStreamConfig &streamConfig = TelemetryStreamConfig()) {
+    config = streamConfig;
+    device = deviceId;
+    sequence = firstSequence;
+  }
+
+  bool send(const TelemetrySample &sample) {
+    if (WiFi.status() != WL_CONNECTED) return false;
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    size_t length = encodeTelemetryFrame(frame, sequence++, device, sample);
+    if (!udp.beginPacket(config.destination, config.port) || udp.write(frame, length) != length || !udp.endPacket()) {
+      statistics.failed++;
+      return false;
+    }
+    statistics.sent++;
+    statistics.bytes += length;
+    return true;
+  }
+
+  uint16_t nextSequence() const { return sequence; }
+  const TelemetryStreamStats &stats() const { return statistics; }
+
+private:
+  WiFiUDP udp;
+  TelemetryStreamConfig config;
+  TelemetryStreamStats statistics;
+  uint32_t device = 0;
+  uint16_t sequence = 0;
+};
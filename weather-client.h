@@ -0,0 +1,242 @@
+#pragma once
+
+#include <Arduino.h>
+#include "weather-connection.h"
+
+// ─────────────────────────────────────
+// Shared WeatherAPI Client
+// ─────────────────────────────────────
+// Reads current.json through a streaming key scanner that is fed the body
+// byte by byte as it arrives and keeps only the handful of values the
+// sketches use. Peak RAM is the scanner's fixed state regardless of
+// payload size, and a body split across any number of reads parses the
+// same as one read whole, so the response is never buffered. Requests go
+// over the shared keep-alive WeatherServiceConnection.
+//
+// AsyncWeatherClient queues the requests, advances the one in flight by
+// whatever has arrived on each loop() pass, and delivers the parsed result
+// to a callback.
+
+struct WeatherConditions {
+  float temperatureC = NAN;   // current.temp_c
+  float humidity = NAN;       // current.humidity (%)
+  float precipitationMm = NAN; // current.precip_mm
+};
+
+struct WeatherFetchResult {
+  int httpCode;      // HTTP status, or negative HTTPClient error
+  bool parseError;   // A 200 body without current conditions, or cut short
+
+  bool ok() const { return httpCode == HTTP_CODE_OK && !parseError; }
+};
+
+// Streaming scanner over a current.json body, built like the forecast
+// table's: it tracks the latest object key and the nesting depth, and
+// takes the numeric (or numeric string) values of temp_c, humidity and
+// precip_mm that are direct members of "current". Nested objects such as
+// condition and air_quality, and everything outside "current", pass
+// through untouched.
+class WeatherConditionsScanner : public Print {
+public:
+  WeatherConditions conditions;
+
+  void reset() {
+    conditions = WeatherConditions();
+    depth = 0;
+    currentDepth = 0;
+    inString = false;
+    escaped = false;
+    afterColon = false;
+    tokenLength = 0;
+    numberLength = 0;
+    key[0] = '\0';
+    sawTemperature = false;
+    closed = false;
+  }
+
+  // The body held current.temp_c and its top-level object was closed
+  bool complete() const { return sawTemperature && closed; }
+
+  size_t write(uint8_t c) override {
+    if (inString) {
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        inString = false;
+        token[tokenLength] = '\0';
+        if (afterColon) {
+          value(token);
+          afterColon = false;
+        } else {
+          strcpy(key, token);
+        }
+      } else if (tokenLength < sizeof(token) - 1) {
+        token[tokenLength++] = c;
+      }
+      return 1;
+    }
+
+    if (c == '"') {
+      inString = true;
+      tokenLength = 0;
+    } else if (c == ':') {
+      afterColon = true;
+      numberLength = 0;
+    } else if (afterColon && ((c >= '0' && c <= '9') || c == '-' || c == '.' ||
+                              (numberLength && (c == 'e' || c == 'E' || c == '+')))) {
+      if (numberLength < sizeof(number) - 1) number[numberLength++] = c;
+    } else if (c == ',' || c == '}' || c == ']' || c == '{' || c == '[') {
+      if (afterColon && numberLength) {
+        number[numberLength] = '\0';
+        value(number);
+      }
+      if (c == '{' || c == '[') {
+        if (depth < UINT8_MAX) depth++;
+        if (c == '{' && afterColon && depth == 2 && !strcmp(key, "current")) currentDepth = depth;
+      } else if (c == '}' || c == ']') {
+        if (depth == currentDepth) currentDepth = 0;
+        if (depth && --depth == 0) closed = true;
+      }
+      afterColon = false;
+      numberLength = 0;
+    }
+    return 1;
+  }
+  using Print::write;
+
+private:
+  char key[20];
+  char token[20];
+  char number[20];
+  uint8_t tokenLength = 0;
+  uint8_t numberLength = 0;
+  uint8_t depth = 0;
+  uint8_t currentDepth = 0;   // Depth inside "current", 0 = elsewhere
+  bool inString = false;
+  bool escaped = false;
+  bool afterColon = false;
+  bool sawTemperature = false;
+  bool closed = false;
+
+  // Only the three kept members are converted; atof() on every epoch and
+  // coordinate in the body would cost more than the scan itself.
+  void value(const char *text) {
+    if (!currentDepth || depth != currentDepth) return;
+    if (!strcmp(key, "temp_c")) {
+      conditions.temperatureC = atof(text);
+      sawTemperature = true;
+    } else if (!strcmp(key, "humidity")) {
+      conditions.humidity = atof(text);
+    } else if (!strcmp(key, "precip_mm")) {
+      conditions.precipitationMm = atof(text);
+    }
+  }
+};
+
+// Parse a complete current.json body from a Stream (read until it ends)
+// or a buffer. Returns false when the body lacked current.temp_c or was
+// cut short; the other fields are NAN when absent.
+inline bool parseWeatherConditions(WeatherConditions &conditions, Stream &input) {
+  WeatherConditionsScanner scanner;
+  scanner.reset();
+  for (int c = input.read(); c >= 0; c = input.read()) scanner.write((uint8_t)c);
+  conditions = scanner.conditions;
+  return scanner.complete();
+}
+
+inline bool parseWeatherConditions(WeatherConditions &conditions, const char *body, size_t length) {
+  WeatherConditionsScanner scanner;
+  scanner.reset();
+  scanner.write((const uint8_t *)body, length);
+  conditions = scanner.conditions;
+  return scanner.complete();
+}
+
+// Called from AsyncWeatherClient::poll() when a request completes. For a
+// probe only result.httpCode is meaningful.
+typedef void (*WeatherResponseHandler)(const WeatherFetchResult &result, const WeatherConditions &conditions);
+
+class AsyncWeatherClient {
+public:
+  static const uint8_t QUEUE_DEPTH = 2;   // Probe and data request may fall due together
+  static const uint8_t MAX_URI = 160;
+
+  explicit AsyncWeatherClient(WeatherServiceConnection &connection) : service(connection) {}
+
+  // Queue a current.json request; the body is parsed slice by slice as it
+  // arrives and the handler receives the conditions. Returns false when
+  // the queue is full or the URI too long.
+  bool fetch(const char *uri, WeatherResponseHandler handler) { return enqueue(uri, handler, true); }
+
+  // Queue a request whose body is discarded; the handler gets the status only.
+  bool probe(const char *uri, WeatherResponseHandler handler) { return enqueue(uri, handler, false); }
+
+  // Queue a request whose body is streamed into `sink` as it arrives (e.g.
+  // forecast.json into a WeatherForecast); the handler gets the status only.
+  bool stream(const char *uri, Print &sink, WeatherResponseHandler handler) {
+    if (!enqueue(uri, handler, false)) return false;
+    queue[(head + queued - 1) % QUEUE_DEPTH].sink = &sink;
+    return true;
+  }
+
+  // Advance the request in flight; call every loop pass. Reading the
+  // response never blocks, but the pass that starts a request on a closed
+  // socket waits for the connection to open: DNS and TCP connect, plus over
+  // TLS the max fragment length probe (once) and the handshake, 1-2 s when
+  // the session cannot be resumed.
+  void poll() {
+    if (!queued) return;
+    Request &request = queue[head];
+    if (!started) {
+      if (request.parse) {
+        scanner.reset();
+        request.sink = &scanner;
+      }
+      started = request.sink ? service.startGet(request.uri, *request.sink) : service.startGet(request.uri);
+      if (!started) return;  // The connection still has a request pending
+    }
+    if (!service.pollResponse()) return;
+
+    WeatherFetchResult result = { service.responseStatus(), false };
+    WeatherConditions conditions;
+    if (request.parse && result.httpCode == HTTP_CODE_OK) {
+      result.parseError = !scanner.complete();
+      conditions = scanner.conditions;
+    }
+    WeatherResponseHandler handler = request.handler;
+    head = (head + 1) % QUEUE_DEPTH;
+    queued--;
+    started = false;
+    if (handler) handler(result, conditions);  // May queue the next request
+  }
+
+  bool idle() const { return queued == 0; }
+
+private:
+  struct Request {
+    char uri[MAX_URI];
+    WeatherResponseHandler handler;
+    Print *sink;
+    bool parse;
+  };
+
+  WeatherServiceConnection &service;
+  WeatherConditionsScanner scanner;   // Parses the fetch() in flight
+  Request queue[QUEUE_DEPTH];
+  uint8_t head = 0;
+  uint8_t queued = 0;
+  bool started = false;
+
+  bool enqueue(const char *uri, WeatherResponseHandler handler, bool parse) {
+    if (queued >= QUEUE_DEPTH || strlen(uri) >= MAX_URI) return false;
+    Request &request = queue[(head + queued) % QUEUE_DEPTH];
+    strcpy(request.uri, uri);
+    request.handler = handler;
+    request.sink = nullptr;
+    request.parse = parse;
+    queued++;
+    return true;
+  }
+};
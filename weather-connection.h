@@ -0,0 +1,472 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266HTTPClient.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#include "rtc-memory.h"
+#include "input-trace.h"
+
+// ─────────────────────────────────────
+// Persistent WeatherAPI Connection
+// ─────────────────────────────────────
+// One keep-alive HTTP/1.1 socket to the weather service, shared by the
+// data requests and the connectivity probe. The host address is resolved
+// once and cached for a TTL, and the socket is only re-opened when the
+// server has closed it, so a steady-state request costs no DNS lookup and
+// no TCP handshake. Requests are written directly to the WiFiClient
+// because ESP8266HTTPClient neither connects to a pre-resolved address
+// nor decodes chunked bodies on its raw stream.
+//
+// Requests never wait on the response: startGet() writes the request and
+// each pollResponse() consumes only the bytes that have already arrived, a
+// POLL_SLICE at a time for as long as more are ready and POLL_BUDGET_MS
+// has not run out. A slow uplink therefore costs the loop a few
+// microseconds per pass instead of the full round trip, while a 35 KB
+// forecast.json that is already in the socket does not take one loop pass
+// per TCP segment. The body of a 200 response is written into the caller's
+// Print slice by slice as it arrives, so no response is ever held whole,
+// or it is read and discarded (probes).
+//
+// Opening a connection still blocks the caller of startGet(), or of the
+// pollResponse() that retries on a fresh socket: the DNS lookup and TCP
+// connect (lwIP offers no asynchronous connect through WiFiClient) and,
+// over TLS, the max fragment length probe and the BearSSL handshake - a
+// 1-2 s stall for a full handshake. Only a request on the open keep-alive
+// socket avoids all of them.
+//
+// useTls() moves the connection to HTTPS over BearSSL, so the API key in
+// the query string no longer crosses the network in clear. A full BearSSL
+// handshake costs the ESP8266 1-2 s of CPU and, with the default 16 KB
+// receive buffer, ~20 KB of heap. Both are cut back:
+//
+//   - The session (ID and master secret) is kept across connections and,
+//     in RTC memory, across deep sleep, so a reconnect within the server's
+//     session lifetime (often an hour or less at CDN front ends) resumes it
+//     with an abbreviated handshake: one round trip, no certificate or key
+//     exchange. Past that lifetime the server has forgotten the session:
+//     a sketch that only talks to the API for the 6-hourly forecast refresh
+//     finds both the socket and the session gone and pays a full handshake
+//     on every refresh.
+//   - Max fragment length is probed once; if the server accepts it the
+//     receive buffer shrinks to the negotiated record size (~1.3 KB at 1024
+//     instead of 16.7 KB). Requests are small, so the transmit buffer is
+//     always the 512-byte minimum.
+//   - The keep-alive socket means requests closer together than the
+//     server's idle timeout (about two minutes) need no handshake at all,
+//     as with iot-winter's once-a-minute probe.
+//
+// TLS connects by host name rather than the cached address: the name is
+// sent as SNI, which CDN front ends need to pick the certificate.
+
+struct ConnectionStats {
+  uint32_t requests = 0;
+  uint32_t failures = 0;
+  uint32_t handshakes = 0;        // TCP connects performed
+  uint32_t handshakesSaved = 0;   // Requests served on an already-open socket
+  uint32_t dnsLookups = 0;
+  uint32_t dnsCacheHits = 0;
+  unsigned long lastLatencyMs = 0;
+  unsigned long maxLatencyMs = 0;
+  unsigned long totalLatencyMs = 0;
+
+  unsigned long lastHandshakeMs = 0;    // Connect time of the latest new socket, TCP + TLS
+  unsigned long maxHandshakeMs = 0;
+  uint32_t tlsFullHandshakes = 0;
+  uint32_t tlsResumedHandshakes = 0;    // Abbreviated handshakes on a kept session
+  unsigned long tlsHandshakeMs = 0;     // Time spent in TLS connects, summed
+  uint16_t tlsFragmentLength = 0;       // Negotiated record size, 0 = full 16 KB records
+  uint32_t connectionHeap = 0;          // Heap held by the open connection (TLS buffers and context)
+  uint32_t peakConnectionHeap = 0;
+  uint32_t lowestFreeHeap = 0;          // Lowest free heap seen with a connection open, 0 = none yet
+
+  unsigned long averageLatencyMs() const { return requests ? totalLatencyMs / requests : 0; }
+  unsigned long averageTlsHandshakeMs() const {
+    uint32_t handshakes = tlsFullHandshakes + tlsResumedHandshakes;
+    return handshakes ? tlsHandshakeMs / handshakes : 0;
+  }
+};
+
+struct WeatherTlsConfig {
+  const char *fingerprint = nullptr;                 // SHA-1 of the server certificate, hex
+  const BearSSL::X509List *trustAnchors = nullptr;   // ...or CA certificates; neither = unauthenticated encryption
+  uint16_t maxFragmentLength = 1024;                 // Record size to negotiate (512-4096), 0 = don't
+  bool retainSession = true;                         // Keep the session in RTC memory across deep sleep
+};
+
+// Status line and the headers that frame the body
+struct HttpResponseHead {
+  int status = 0;
+  long contentLength = -1;
+  bool chunked = false;
+  bool keepAlive = true;
+
+  bool parseStatusLine(const char *line) {
+    if (strncmp(line, "HTTP/1.", 7) != 0) return false;
+    status = atoi(line + 9);
+    contentLength = -1;
+    chunked = false;
+    keepAlive = line[7] == '1';  // HTTP/1.1 defaults to persistent
+    return true;
+  }
+
+  void parseHeader(const char *line) {
+    if (!strncasecmp(line, "Content-Length:", 15)) {
+      contentLength = atol(line + 15);
+    } else if (!strncasecmp(line, "Transfer-Encoding:", 18)) {
+      chunked = strstr(line + 18, "chunked") != nullptr;
+    } else if (!strncasecmp(line, "Connection:", 11)) {
+      keepAlive = strstr(line + 11, "close") == nullptr;
+    }
+  }
+};
+
+class WeatherServiceConnection {
+public:
+  static const unsigned long DEFAULT_DNS_TTL = 10UL * 60UL * 1000UL;
+  static const uint16_t RESPONSE_TIMEOUT = 5000;
+  static const uint16_t POLL_SLICE = 1460;      // Bytes consumed between budget checks - one TCP segment
+  static const uint8_t POLL_BUDGET_MS = 10;     // Time one pollResponse() may spend draining ready bytes
+
+  explicit WeatherServiceConnection(const char *hostName, uint16_t portNumber = 80)
+    : host(hostName), port(portNumber) {}
+
+  // Switch to HTTPS; call before the first request.
+  void useTls(const WeatherTlsConfig &config = WeatherTlsConfig(), uint16_t tlsPort = 443) {
+    close();
+    tlsConfig = config;
+    port = tlsPort;
+    if (tlsConfig.fingerprint) {
+      secureClient.setFingerprint(tlsConfig.fingerprint);
+    } else if (tlsConfig.trustAnchors) {
+      secureClient.setTrustAnchors(tlsConfig.trustAnchors);
+    } else {
+      secureClient.setInsecure();
+    }
+    TlsSession retained;
+    if (tlsConfig.retainSession && sessionRecord.load(retained)) {
+      session = retained.session;
+      statistics.tlsFragmentLength = retained.fragmentLength;
+      fragmentLengthKnown = true;  // Probed on an earlier wake
+    }
+    secureClient.setSession(&session);
+    client = &secureClient;
+  }
+
+  void setDnsTtl(unsigned long ttlMs) { dnsTtl = ttlMs; }
+  const ConnectionStats &stats() const { return statistics; }
+  bool isOpen() { return client->connected(); }
+  bool secure() const { return client == &secureClient; }
+
+  void close() {
+    client->stop();
+    statistics.connectionHeap = 0;
+  }
+
+  // Start a non-blocking GET whose body is read and discarded (probes);
+  // `uri` must stay valid until the response is complete. Returns false
+  // while another request is still in flight.
+  bool startGet(const char *uri) {
+    return startRequest(uri, nullptr);
+  }
+
+  // As startGet(), but the body of a 200 response is written to `sink` as
+  // it arrives, e.g. into a streaming parser.
+  bool startGet(const char *uri, Print &sink) {
+    return startRequest(uri, &sink);
+  }
+
+  // Advance the request in flight by the bytes already received, for at
+  // most POLL_BUDGET_MS. Returns true once it has finished;
+  // responseStatus() then holds the outcome until the next startGet().
+  bool pollResponse() {
+    if (asyncState == ASYNC_IDLE || asyncState == ASYNC_DONE) return true;
+
+    unsigned long sliceStarted = millis();
+    if (client->available() > 0) asyncProgressAt = sliceStarted;
+    do {
+      for (uint16_t budget = POLL_SLICE; budget && asyncState != ASYNC_DONE && client->available() > 0; budget--) {
+        consume((char)client->read());
+      }
+    } while (asyncState != ASYNC_DONE && client->available() > 0 && millis() - sliceStarted < POLL_BUDGET_MS);
+    if (asyncState == ASYNC_DONE) return true;
+
+    if (!client->connected() && client->available() <= 0) {
+      if (asyncState == ASYNC_BODY && remaining < 0) {
+        completeAsync();  // Body delimited by connection close
+      } else if (asyncState == ASYNC_STATUS && lineLength == 0 && reusedSocket && !asyncRetried) {
+        asyncRetried = true;  // Server had silently closed the idle socket - once more on a fresh one
+        close();
+        sendAsync();
+      } else {
+        finishAsync(HTTPC_ERROR_CONNECTION_LOST);
+      }
+    } else if (millis() - asyncProgressAt >= RESPONSE_TIMEOUT) {  // Silent server, as the blocking reads time out
+      finishAsync(HTTPC_ERROR_READ_TIMEOUT);
+    }
+    return asyncState == ASYNC_DONE;
+  }
+
+  bool pending() const { return asyncState != ASYNC_IDLE && asyncState != ASYNC_DONE; }
+  int responseStatus() const { return asyncStatus; }
+
+  // Record every request started, the body bytes handed to the caller's
+  // sink and the outcome.
+  void traceInputs(InputTrace &inputTrace) { trace = &inputTrace; }
+
+private:
+  struct TlsSession {
+    BearSSL::Session session;   // br_ssl_session_parameters, 86 bytes
+    uint16_t fragmentLength;    // MFLN probe result, so a wake does not repeat it
+  };
+
+  const char *host;
+  uint16_t port;
+  WiFiClient plainClient;
+  BearSSL::WiFiClientSecure secureClient;
+  WiFiClient *client = &plainClient;
+  WeatherTlsConfig tlsConfig;
+  BearSSL::Session session;
+  RtcRecord<TlsSession, RTC_BLOCK_TLS_SESSION> sessionRecord;
+  bool fragmentLengthKnown = false;
+  IPAddress address;
+  unsigned long resolvedAt = 0;
+  unsigned long dnsTtl = DEFAULT_DNS_TTL;
+  bool reusedSocket = false;
+  ConnectionStats statistics;
+
+  enum AsyncState : uint8_t {
+    ASYNC_IDLE,
+    ASYNC_STATUS,       // Reading the status line
+    ASYNC_HEADERS,
+    ASYNC_BODY,         // Content-Length body, or until close when remaining < 0
+    ASYNC_CHUNK_SIZE,
+    ASYNC_CHUNK_DATA,
+    ASYNC_CHUNK_END,    // CRLF closing a chunk
+    ASYNC_TRAILER,
+    ASYNC_DONE
+  };
+
+  AsyncState asyncState = ASYNC_IDLE;
+  const char *asyncUri = nullptr;
+  Print *asyncSink = nullptr;
+  bool asyncRetried = false;
+  int asyncStatus = 0;
+  unsigned long asyncStartedAt = 0;
+  unsigned long asyncProgressAt = 0;    // Last poll that found bytes waiting
+  HttpResponseHead head;
+  long remaining = 0;
+  char line[128];
+  uint8_t lineLength = 0;
+  InputTrace *trace = nullptr;
+
+  bool startRequest(const char *uri, Print *sink) {
+    if (pending()) return false;
+    statistics.requests++;
+    asyncUri = uri;
+    asyncSink = sink;
+    asyncStartedAt = millis();
+    asyncProgressAt = asyncStartedAt;
+    asyncRetried = false;
+    if (trace) trace->httpRequest(uri);
+    sendAsync();
+    return true;
+  }
+
+  void recordCompletion(int status, unsigned long started) {
+    if (status < 0) statistics.failures++;
+    statistics.lastLatencyMs = millis() - started;
+    statistics.totalLatencyMs += statistics.lastLatencyMs;
+    if (statistics.lastLatencyMs > statistics.maxLatencyMs) statistics.maxLatencyMs = statistics.lastLatencyMs;
+  }
+
+  void sendAsync() {
+    lineLength = 0;
+    asyncState = ASYNC_STATUS;
+    if (!ensureConnected()) {
+      finishAsync(HTTPC_ERROR_CONNECTION_REFUSED);
+      return;
+    }
+    int status = writeRequest(asyncUri);
+    if (status < 0) finishAsync(status);
+  }
+
+  void finishAsync(int status) {
+    if (status < 0) close();
+    asyncStatus = status;
+    asyncState = ASYNC_DONE;
+    recordCompletion(status, asyncStartedAt);
+    if (trace) trace->httpResponse(status, statistics.lastLatencyMs);
+  }
+
+  void completeAsync() {
+    if (!head.keepAlive || remaining < 0) close();
+    finishAsync(head.status);
+  }
+
+  void beginBody() {
+    if (head.chunked) {
+      asyncState = ASYNC_CHUNK_SIZE;
+    } else if (head.contentLength == 0) {
+      completeAsync();
+    } else {
+      remaining = head.contentLength;  // -1: until the server closes
+      asyncState = ASYNC_BODY;
+    }
+  }
+
+  void storeBody(char c) {
+    if (head.status != HTTP_CODE_OK || !asyncSink) return;
+    if (trace) trace->httpBody(c);
+    asyncSink->write((uint8_t)c);
+  }
+
+  // One received byte through the response state machine
+  void consume(char c) {
+    if (asyncState == ASYNC_BODY || asyncState == ASYNC_CHUNK_DATA) {
+      storeBody(c);
+      if (remaining > 0 && --remaining == 0) {
+        if (asyncState == ASYNC_BODY) {
+          completeAsync();
+        } else {
+          asyncState = ASYNC_CHUNK_END;
+        }
+      }
+      return;
+    }
+
+    // Everything else is line oriented
+    if (c != '\n') {
+      if (lineLength < sizeof(line) - 1) line[lineLength++] = c;
+      return;
+    }
+    if (lineLength > 0 && line[lineLength - 1] == '\r') lineLength--;
+    line[lineLength] = '\0';
+    uint8_t length = lineLength;
+    lineLength = 0;
+
+    switch (asyncState) {
+      case ASYNC_STATUS:
+        if (!head.parseStatusLine(line)) {
+          finishAsync(HTTPC_ERROR_CONNECTION_LOST);
+        } else {
+          asyncState = ASYNC_HEADERS;
+        }
+        break;
+      case ASYNC_HEADERS:
+        if (length == 0) {
+          beginBody();
+        } else {
+          head.parseHeader(line);
+        }
+        break;
+      case ASYNC_CHUNK_SIZE:
+        remaining = strtol(line, nullptr, 16);
+        asyncState = remaining > 0 ? ASYNC_CHUNK_DATA : ASYNC_TRAILER;
+        break;
+      case ASYNC_CHUNK_END:
+        asyncState = ASYNC_CHUNK_SIZE;
+        break;
+      case ASYNC_TRAILER:
+        if (length == 0) completeAsync();
+        break;
+      default:
+        break;
+    }
+  }
+
+  bool resolve() {
+    if (address.isSet() && millis() - resolvedAt < dnsTtl) {
+      statistics.dnsCacheHits++;
+      return true;
+    }
+    statistics.dnsLookups++;
+    if (!WiFi.hostByName(host, address)) {
+      address = IPAddress();
+      return false;
+    }
+    resolvedAt = millis();
+    return true;
+  }
+
+  bool ensureConnected() {
+    if (client->connected()) {
+      reusedSocket = true;
+      statistics.handshakesSaved++;
+      return true;
+    }
+    reusedSocket = false;
+    uint32_t freeBefore = ESP.getFreeHeap();
+    unsigned long started = millis();
+    client->setTimeout(RESPONSE_TIMEOUT);
+    if (secure() ? !connectSecure() : !connectPlain()) return false;
+    client->setNoDelay(true);
+    statistics.handshakes++;
+    statistics.lastHandshakeMs = millis() - started;
+    if (statistics.lastHandshakeMs > statistics.maxHandshakeMs) statistics.maxHandshakeMs = statistics.lastHandshakeMs;
+
+    uint32_t freeAfter = ESP.getFreeHeap();
+    statistics.connectionHeap = freeBefore > freeAfter ? freeBefore - freeAfter : 0;
+    if (statistics.connectionHeap > statistics.peakConnectionHeap) statistics.peakConnectionHeap = statistics.connectionHeap;
+    if (!statistics.lowestFreeHeap || freeAfter < statistics.lowestFreeHeap) statistics.lowestFreeHeap = freeAfter;
+    return true;
+  }
+
+  bool connectPlain() {
+    if (!resolve()) return false;
+    if (!client->connect(address, port)) {
+      address = IPAddress();  // Cached address may be stale - resolve again next time
+      return false;
+    }
+    return true;
+  }
+
+  bool connectSecure() {
+    if (!fragmentLengthKnown) {
+      // One extra ClientHello per boot (or per power cycle with a retained session)
+      uint16_t requested = tlsConfig.maxFragmentLength;
+      statistics.tlsFragmentLength =
+          requested && BearSSL::WiFiClientSecure::probeMaxFragmentLength(host, port, requested) ? requested : 0;
+      fragmentLengthKnown = true;
+    }
+    secureClient.setBufferSizes(statistics.tlsFragmentLength ? statistics.tlsFragmentLength : 16384, 512);
+
+    BearSSL::Session offered = session;
+    unsigned long started = millis();
+    if (!secureClient.connect(host, port)) {
+      fragmentLengthKnown = false;  // The server may have changed - probe again next time
+      return false;
+    }
+    statistics.tlsHandshakeMs += millis() - started;
+
+    // BearSSL keeps the session parameters when the server resumed them and
+    // writes a fresh ID and master secret after a full handshake
+    BearSSL::Session none;
+    bool resumed = memcmp(&offered, &none, sizeof(none)) != 0 && memcmp(&offered, &session, sizeof(session)) == 0;
+    if (resumed) {
+      statistics.tlsResumedHandshakes++;
+    } else {
+      statistics.tlsFullHandshakes++;
+      if (tlsConfig.retainSession) {
+        TlsSession retained = { session, statistics.tlsFragmentLength };
+        sessionRecord.save(retained);
+      }
+    }
+    return true;
+  }
+
+  int writeRequest(const char *uri) {
+    char request[320];
+    int length = snprintf_P(request, sizeof(request),
+                            PSTR("GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: EcoPulse\r\n"
+                                 "Accept: application/json\r\nConnection: keep-alive\r\n\r\n"),
+                            uri, host);
+    if (length <= 0 || length >= (int)sizeof(request)) return HTTPC_ERROR_SEND_HEADER_FAILED;
+    if (client->write((const uint8_t *)request, length) != (size_t)length) {
+      close();
+      return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    return 0;
+  }
+};
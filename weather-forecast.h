@@ -0,0 +1,360 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "rtc-memory.h"
+
+// ─────────────────────────────────────
+// Hourly Weather Forecast Cache
+// ─────────────────────────────────────
+// Polling current.json every few minutes costs over a thousand API calls a
+// day per device. Instead, forecast.json (today and tomorrow) is fetched a
+// few times a day and reduced to a compact hourly table:
+//
+//   hour   0      1      2     ...   47
+//        ┌──────┬──────┬──────┬─────┬──────┐
+//        │ 12.4 │ 11.9 │ 11.5 │ ... │ 16.0 │  °C x10, rain %, humidity %
+//        └──────┴──────┴──────┴─────┴──────┘
+//          ▲ firstHourEpoch
+//
+// "Temperature now" is interpolated between the neighbouring hours and
+// "rain in the next N hours" is answered from the table - both locally,
+// with no network traffic. The response (~35 KB) is never stored: it is
+// streamed through a small key scanner that keeps only the hourly fields.
+//
+// The device needs no NTP for this. The response carries the server's
+// epoch (location.localtime_epoch), which is anchored to a monotonic clock
+// supplied by the sketch (millis() by default, or a DutyCycle clock that
+// keeps counting through deep sleep). With flash caching enabled the
+// table and anchor survive resets; after a power cycle the clock restarts,
+// the anchor no longer fits and the table is refetched.
+//
+// snapshot() and adopt() hand the table between boards (weather-share.h):
+// a table fetched by one board is anchored on another to the sender's
+// epoch, keeping the age it had when it was fetched.
+
+struct ForecastHour {
+  int16_t temperatureDeci;   // °C x 10
+  uint8_t rainChance;        // %
+  uint8_t humidity;          // %
+};
+
+struct WeatherForecastConfig {
+  unsigned long refreshIntervalMs = 6UL * 60UL * 60UL * 1000UL;  // 4 requests a day
+  unsigned long retryIntervalMs = 15UL * 60UL * 1000UL;          // After a failed refresh
+  bool flashCache = false;                                        // Keep the table on LittleFS
+};
+
+struct WeatherForecastStats {
+  uint32_t refreshes = 0;
+  uint32_t failures = 0;
+  uint32_t lookups = 0;       // Answers served from the table
+  uint32_t misses = 0;        // Queries the table did not cover
+  uint32_t adopted = 0;       // Tables taken over from another board
+  uint8_t hours = 0;          // Hours held by the current table
+};
+
+typedef unsigned long (*ForecastClock)();
+
+class WeatherForecast {
+public:
+  static const uint8_t MAX_HOURS = 48;
+
+  struct Snapshot {
+    uint32_t fetchedEpoch;      // Server time of the fetch
+    uint32_t firstHourEpoch;
+    uint8_t count;
+    ForecastHour hours[MAX_HOURS];
+  };
+
+  void begin(const WeatherForecastConfig &forecastConfig = WeatherForecastConfig(), ForecastClock monotonicClock = millis) {
+    config = forecastConfig;
+    clock = monotonicClock;
+    if (config.flashCache) loadFlashCache();
+    statistics.hours = table.count;
+  }
+
+  // A refresh is due when nothing usable is cached, the table is older
+  // than the refresh interval, or (after a failure) the retry interval has
+  // passed. Sketches then stream forecast.json into receiver().
+  bool refreshDue() const {
+    unsigned long now = clock();
+    if (attempted && now - lastAttemptAt < config.retryIntervalMs) return false;
+    return !anchored() || now - table.anchorClock >= config.refreshIntervalMs;
+  }
+
+  // Start collecting a fresh table; feed the response body to the
+  // returned Print. The live table keeps answering until commit().
+  Print &receiver() {
+    scanner.reset();
+    attempted = true;
+    lastAttemptAt = clock();
+    return scanner;
+  }
+
+  // Adopt the scanned table if the request succeeded and the body held a
+  // usable forecast. Returns true when the table was replaced.
+  bool commit(int httpCode) {
+    if (httpCode != 200 || !scanner.complete()) {
+      statistics.failures++;
+      return false;
+    }
+    table = scanner.table;
+    table.anchorClock = clock();  // Within a few seconds of localtime_epoch - ample for hourly data
+    attempted = false;
+    statistics.refreshes++;
+    statistics.hours = table.count;
+    if (config.flashCache) saveFlashCache();
+    return true;
+  }
+
+  // The held table, false when there is none
+  bool snapshot(Snapshot &out) const {
+    if (!anchored()) return false;
+    out.fetchedEpoch = table.anchorEpoch;
+    out.firstHourEpoch = table.firstHourEpoch;
+    out.count = table.count;
+    memcpy(out.hours, table.hours, table.count * sizeof(ForecastHour));
+    return true;
+  }
+
+  // Replace the table with one fetched elsewhere; `nowEpoch` is the
+  // sender's clock when it sent the table. The table keeps its age, so it
+  // is due for refresh when the original is - unless this clock started
+  // after the fetch, in which case the age is cut to the clock's.
+  bool adopt(const Snapshot &shared, uint32_t nowEpoch) {
+    if (shared.count == 0 || shared.count > MAX_HOURS || nowEpoch < shared.fetchedEpoch) return false;
+    unsigned long now = clock();
+    uint32_t age = nowEpoch - shared.fetchedEpoch;
+    if (age > now / 1000) age = now / 1000;
+    table.firstHourEpoch = shared.firstHourEpoch;
+    table.anchorEpoch = nowEpoch - age;
+    table.anchorClock = now - age * 1000UL;
+    table.count = shared.count;
+    memcpy(table.hours, shared.hours, shared.count * sizeof(ForecastHour));
+    attempted = false;
+    statistics.adopted++;
+    statistics.hours = table.count;
+    if (config.flashCache) saveFlashCache();
+    return true;
+  }
+
+  // Seconds since the epoch by the anchored clock, 0 when unknown.
+  uint32_t epochNow() const {
+    if (!anchored()) return 0;
+    return table.anchorEpoch + (clock() - table.anchorClock) / 1000;
+  }
+
+  // Interpolated temperature at `epoch`; NAN when the table does not cover it.
+  float temperatureAt(uint32_t epoch) {
+    float position;
+    if (!locate(epoch, position)) return NAN;
+    uint8_t hour = (uint8_t)position;
+    float fraction = position - hour;
+    float from = table.hours[hour].temperatureDeci / 10.0f;
+    if (hour + 1 >= table.count) return from;
+    float to = table.hours[hour + 1].temperatureDeci / 10.0f;
+    return from + (to - from) * fraction;
+  }
+
+  float temperatureNow() { return temperatureAt(epochNow()); }
+
+  // Interpolated relative humidity (%) now; NAN when not covered.
+  float humidityNow() {
+    float position;
+    if (!locate(epochNow(), position)) return NAN;
+    uint8_t hour = (uint8_t)position;
+    if (hour + 1 >= table.count) return table.hours[hour].humidity;
+    return table.hours[hour].humidity + (table.hours[hour + 1].humidity - table.hours[hour].humidity) * (position - hour);
+  }
+
+  // Highest chance of rain (%) over the next `hours`, starting with the
+  // current hour; -1 when the table does not cover now.
+  int rainChanceWithin(uint8_t hours) {
+    float position;
+    if (!locate(epochNow(), position)) return -1;
+    uint8_t first = (uint8_t)position;
+    uint8_t last = first + hours < table.count ? first + hours : table.count - 1;
+    uint8_t highest = 0;
+    for (uint8_t hour = first; hour <= last; hour++) {
+      if (table.hours[hour].rainChance > highest) highest = table.hours[hour].rainChance;
+    }
+    return highest;
+  }
+
+  bool rainExpectedWithin(uint8_t hours, uint8_t minimumChance = 60) {
+    return rainChanceWithin(hours) >= minimumChance;
+  }
+
+  // Table covers the current time
+  bool available() {
+    float position;
+    return locate(epochNow(), position);
+  }
+
+  const WeatherForecastStats &stats() const { return statistics; }
+
+private:
+  struct Table {
+    uint32_t firstHourEpoch;
+    uint32_t anchorEpoch;       // Server time when the response arrived...
+    uint32_t anchorClock;       // ...and the monotonic clock at that moment
+    uint8_t count;
+    uint8_t reserved[3];
+    ForecastHour hours[MAX_HOURS];
+  };
+
+  // Streaming scanner over the forecast.json body. Tracks the most recent
+  // object key and picks out the numeric (or numeric string) values of the
+  // handful of keys it needs; everything else passes through untouched.
+  // Hour fields are only taken after an hour's time_epoch, so the
+  // "current" block and the daily summaries are ignored.
+  class Scanner : public Print {
+  public:
+    Table table;
+
+    void reset() {
+      memset(&table, 0, sizeof(table));
+      hour = -1;
+      inString = false;
+      escaped = false;
+      afterColon = false;
+      tokenLength = 0;
+      numberLength = 0;
+      key[0] = '\0';
+      sawAnchor = false;
+    }
+
+    bool complete() const { return sawAnchor && table.count > 0; }
+
+    size_t write(uint8_t c) override {
+      if (inString) {
+        if (escaped) {
+          escaped = false;
+        } else if (c == '\\') {
+          escaped = true;
+        } else if (c == '"') {
+          inString = false;
+          token[tokenLength] = '\0';
+          if (afterColon) {
+            value(atof(token));  // e.g. "chance_of_rain":"86" in older API versions
+            afterColon = false;
+          } else {
+            strcpy(key, token);
+          }
+        } else if (tokenLength < sizeof(token) - 1) {
+          token[tokenLength++] = c;
+        }
+        return 1;
+      }
+
+      if (c == '"') {
+        inString = true;
+        tokenLength = 0;
+      } else if (c == ':') {
+        afterColon = true;
+        numberLength = 0;
+      } else if (afterColon && ((c >= '0' && c <= '9') || c == '-' || c == '.' || c == 'e' || c == 'E' || c == '+')) {
+        if (numberLength < sizeof(number) - 1) number[numberLength++] = c;
+      } else if (c == ',' || c == '}' || c == ']' || c == '{' || c == '[') {
+        if (afterColon && numberLength) {
+          number[numberLength] = '\0';
+          value(atof(number));
+        }
+        afterColon = false;
+        numberLength = 0;
+      }
+      return 1;
+    }
+    using Print::write;
+
+  private:
+    char key[20];
+    char token[20];
+    char number[20];
+    uint8_t tokenLength = 0;
+    uint8_t numberLength = 0;
+    int8_t hour = -1;
+    bool inString = false;
+    bool escaped = false;
+    bool afterColon = false;
+    bool sawAnchor = false;
+
+    void value(double number) {
+      if (!strcmp(key, "localtime_epoch")) {
+        table.anchorEpoch = (uint32_t)number;
+        sawAnchor = true;
+      } else if (!strcmp(key, "time_epoch")) {
+        uint32_t epoch = (uint32_t)number;
+        if (table.count == 0) table.firstHourEpoch = epoch;
+        uint32_t index = epoch >= table.firstHourEpoch ? (epoch - table.firstHourEpoch) / 3600 : MAX_HOURS;
+        hour = index < MAX_HOURS ? (int8_t)index : -1;
+        if (hour >= 0 && hour >= table.count) table.count = hour + 1;
+      } else if (hour >= 0) {
+        ForecastHour &slot = table.hours[hour];
+        if (!strcmp(key, "temp_c")) {
+          slot.temperatureDeci = (int16_t)lround(number * 10.0);
+        } else if (!strcmp(key, "chance_of_rain")) {
+          slot.rainChance = (uint8_t)constrain(number, 0.0, 100.0);
+        } else if (!strcmp(key, "humidity")) {
+          slot.humidity = (uint8_t)constrain(number, 0.0, 100.0);
+        }
+      }
+    }
+
+    friend class WeatherForecast;
+  };
+
+  static constexpr const char *CACHE_PATH = "/forecast.bin";
+
+  WeatherForecastConfig config;
+  WeatherForecastStats statistics;
+  ForecastClock clock = millis;
+  Table table = {};
+  Scanner scanner;
+  unsigned long lastAttemptAt = 0;
+  bool attempted = false;
+
+  // The anchor is only meaningful while the clock has not restarted since
+  bool anchored() const {
+    return table.count > 0 && table.anchorEpoch != 0 && clock() >= table.anchorClock;
+  }
+
+  // Fractional table position of `epoch`
+  bool locate(uint32_t epoch, float &position) {
+    if (!anchored() || epoch < table.firstHourEpoch) {
+      statistics.misses++;
+      return false;
+    }
+    position = (epoch - table.firstHourEpoch) / 3600.0f;
+    if (position > table.count - 1) {
+      statistics.misses++;
+      return false;
+    }
+    statistics.lookups++;
+    return true;
+  }
+
+  bool loadFlashCache() {
+    if (!LittleFS.begin()) return false;
+    File file = LittleFS.open(CACHE_PATH, "r");
+    if (!file) return false;
+    uint32_t storedCrc;
+    Table stored;
+    bool valid = file.read((uint8_t *)&storedCrc, sizeof(storedCrc)) == sizeof(storedCrc) &&
+                 file.read((uint8_t *)&stored, sizeof(stored)) == sizeof(stored) &&
+                 storedCrc == crc32(&stored, sizeof(stored)) && stored.count <= MAX_HOURS;
+    if (valid) table = stored;
+    return valid;
+  }
+
+  void saveFlashCache() {
+    if (!LittleFS.begin()) return;
+    File file = LittleFS.open(CACHE_PATH, "w");
+    if (!file) return;
+    uint32_t storedCrc = crc32(&table, sizeof(table));
+    file.write((const uint8_t *)&storedCrc, sizeof(storedCrc));
+    file.write((const uint8_t *)&table, sizeof(table));
+    file.close();
+  }
+};
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "telemetry-frame.h"
+#include "weather-forecast.h"
+
+// ─────────────────────────────────────
+// LAN Weather Sharing
+// ─────────────────────────────────────
+// Boards at one site ask the weather API the same question. With sharing,
+// one board - the fetcher - downloads forecast.json and multicasts the
+// reduced hourly table to the others, so the site spends one API call,
+// one TLS handshake and one radio-on period per refresh instead of one
+// per board:
+//
+//   weatherShare.begin(forecast, ESP.getChipId(), location);
+//   if (weatherShare.poll()) ...;              // every pass: a peer's table was adopted
+//   if (weatherShare.fetchDue()) fetch();      // every pass, in place of forecast.refreshDue()
+//   weatherShare.publish();                    // after forecast.commit() succeeded
+//
+// Election needs no extra traffic: the board that fetched the newest
+// table is the fetcher. It refreshes when the table ages out, as it would
+// alone. Peers adopt every newer table they hear and keep it until it is
+// staleAfterMs old; past that, the fetcher is taken to be gone and a peer
+// fetches itself, becoming the new fetcher. Takeovers are spread by
+// device ID so one peer normally wins and the rest adopt its table. When
+// two boards fetch anyway, the one with the older table adopts the newer
+// and steps down.
+//
+// A board without a table (after boot, or when its refresh is due) sends
+// a request; the fetcher answers with its table if it is newer. Booting
+// boards wait answerWindowMs plus bootSpreadMs per rank for an answer
+// before fetching on their own; the spread outlasts a fetch, so the first
+// board's table reaches the others before their turn. fetchDue() is cheap
+// and meant to be called every pass - checked once a minute, boards of
+// neighbouring ranks would reach their turn together.
+//
+// Messages are multicast to 239.255.236.1:47810, little-endian with a
+// CRC-16 like the telemetry frame, and carry a hash of the API location
+// so boards at different locations on one LAN ignore each other:
+//
+//    0  magic 0xED       4  device ID          16 sender's epoch
+//    1  version          8  location hash      20 first hour epoch
+//    2  type             12 fetched epoch      24 hours x 4, CRC-16
+//    3  hour count
+//
+// A full record with 48 hours is 218 bytes. The receiver anchors the table
+// to the sender's epoch, so the boards need no NTP and no common clock.
+
+const uint8_t WEATHER_SHARE_MAGIC = 0xED;
+const uint8_t WEATHER_SHARE_VERSION = 1;
+const uint16_t WEATHER_SHARE_PORT = 47810;
+const size_t WEATHER_SHARE_HEADER_SIZE = 24;
+const size_t WEATHER_SHARE_MAX_MESSAGE = WEATHER_SHARE_HEADER_SIZE + WeatherForecast::MAX_HOURS * 4 + 2;
+
+enum WeatherShareMessage : uint8_t {
+  WEATHER_SHARE_REQUEST = 1,
+  WEATHER_SHARE_RECORD = 2,
+};
+
+struct WeatherShareConfig {
+  IPAddress group = IPAddress(239, 255, 236, 1);                 // Organization-local scope
+  uint16_t port = WEATHER_SHARE_PORT;
+  unsigned long staleAfterMs = 7UL * 60UL * 60UL * 1000UL;       // An hour past the fetcher's 6 h refresh
+  unsigned long takeoverSpreadMs = 2UL * 60UL * 1000UL;          // Per rank (device ID % 8)
+  unsigned long answerWindowMs = 3000;                           // Wait for the fetcher before fetching
+  unsigned long bootSpreadMs = 20000;                            // Per rank, for a board without a table
+  unsigned long requestIntervalMs = 60UL * 1000UL;               // Repeat requests while a refresh is due
+};
+
+struct WeatherShareStats {
+  uint32_t recordsSent = 0;
+  uint32_t recordsAdopted = 0;
+  uint32_t requestsSent = 0;
+  uint32_t requestsAnswered = 0;
+  uint32_t takeovers = 0;      // Fetches by a peer whose fetcher went quiet
+  uint32_t stepDowns = 0;      // Fetcher role left to a board with a newer table
+  uint32_t rejected = 0;       // Malformed or corrupted messages
+};
+
+class WeatherShare {
+public:
+  enum Role : uint8_t { LISTENING, FETCHER, PEER };
+
+  void begin(WeatherForecast &weatherForecast, uint32_t deviceId, const char *location,
+             const WeatherShareConfig &shareConfig = WeatherShareConfig(), ForecastClock monotonicClock = millis) {
+    forecast = &weatherForecast;
+    device = deviceId;
+    config = shareConfig;
+    clock = monotonicClock;
+    locationHash = 2166136261u;   // FNV-1a
+    for (const char *c = location; *c; c++) locationHash = (locationHash ^ (uint8_t)*c) * 16777619u;
+    // A table restored from flash may be anyone's: listen as a peer until it ages out
+    WeatherForecast::Snapshot held;
+    if (forecast->snapshot(held)) {
+      fetchedEpoch = held.fetchedEpoch;
+      role = PEER;
+    }
+  }
+
+  // Joins the group once the link is up and handles what has arrived.
+  // True when a shared table was adopted.
+  bool poll() {
+    if (WiFi.status() != WL_CONNECTED) {
+      joined = false;
+      return false;
+    }
+    if (!joined && !(joined = udp.beginMulticast(WiFi.localIP(), config.group, config.port))) return false;
+    bool adopted = false;
+    uint8_t message[WEATHER_SHARE_MAX_MESSAGE];
+    while (udp.parsePacket() > 0) {
+      int length = udp.read(message, sizeof(message));
+      if (length > 0) adopted |= receive(message, length);
+    }
+    return adopted;
+  }
+
+  // Whether this board should fetch forecast.json now
+  bool fetchDue() {
+    if (!forecast->refreshDue()) return false;   // Fresh, or a failed fetch is waiting out its retry
+    unsigned long now = clock();
+    if (role == FETCHER) return true;
+    if (role == LISTENING) {
+      if (!requested) {
+        sendRequest();
+        return false;
+      }
+      return now - requestedAt >= config.answerWindowMs + rank() * config.bootSpreadMs;
+    }
+    uint32_t age = forecast->epochNow() - fetchedEpoch;
+    if (age >= (config.staleAfterMs + rank() * config.takeoverSpreadMs) / 1000) return true;
+    if (!requested || now - requestedAt >= config.requestIntervalMs) sendRequest();
+    return false;
+  }
+
+  // Call after forecast.commit() accepted a table this board fetched
+  void publish() {
+    WeatherForecast::Snapshot held;
+    if (!forecast->snapshot(held)) return;
+    fetchedEpoch = held.fetchedEpoch;
+    if (role == PEER) statistics.takeovers++;
+    role = FETCHER;
+    requested = false;
+    sendRecord();
+  }
+
+  // A request is out and the fetcher may still answer it; a duty-cycled
+  // board keeps its radio up until then
+  bool awaitingAnswer() const {
+    return requested && clock() - requestedAt < config.answerWindowMs + (role == LISTENING ? rank() * config.bootSpreadMs : 0);
+  }
+
+  Role currentRole() const { return role; }
+  const WeatherShareStats &stats() const { return statistics; }
+
+private:
+  WiFiUDP udp;
+  WeatherForecast *forecast = nullptr;
+  WeatherShareConfig config;
+  WeatherShareStats statistics;
+  ForecastClock clock = millis;
+  uint32_t device = 0;
+  uint32_t locationHash = 0;
+  uint32_t fetchedEpoch = 0;      // Of the held table
+  unsigned long requestedAt = 0;
+  unsigned long recordSentAt = 0;
+  Role role = LISTENING;
+  bool requested = false;
+  bool recordSent = false;
+  bool joined = false;
+
+  uint8_t rank() const { return device % 8; }
+
+  static void put32(uint8_t *out, uint32_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+  }
+  static uint32_t get32(const uint8_t *in) {
+    return in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+  }
+
+  size_t encodeHeader(uint8_t *out, WeatherShareMessage type, uint8_t hours, uint32_t firstHourEpoch) {
+    out[0] = WEATHER_SHARE_MAGIC;
+    out[1] = WEATHER_SHARE_VERSION;
+    out[2] = type;
+    out[3] = hours;
+    put32(out + 4, device);
+    put32(out + 8, locationHash);
+    put32(out + 12, fetchedEpoch);
+    put32(out + 16, forecast->epochNow());
+    put32(out + 20, firstHourEpoch);
+    return WEATHER_SHARE_HEADER_SIZE;
+  }
+
+  bool send(uint8_t *message, size_t length) {
+    uint16_t crc = telemetryFrameCrc(message, length);
+    message[length] = crc;
+    message[length + 1] = crc >> 8;
+    length += 2;
+    return joined && udp.beginPacketMulticast(config.group, config.port, WiFi.localIP()) &&
+           udp.write(message, length) == length && udp.endPacket();
+  }
+
+  void sendRequest() {
+    uint8_t message[WEATHER_SHARE_HEADER_SIZE + 2];
+    requested = true;
+    requestedAt = clock();
+    if (send(message, encodeHeader(message, WEATHER_SHARE_REQUEST, 0, 0))) statistics.requestsSent++;
+  }
+
+  void sendRecord() {
+    WeatherForecast::Snapshot held;
+    if (!forecast->snapshot(held)) return;
+    uint8_t message[WEATHER_SHARE_MAX_MESSAGE];
+    size_t length = encodeHeader(message, WEATHER_SHARE_RECORD, held.count, held.firstHourEpoch);
+    for (uint8_t hour = 0; hour < held.count; hour++) {
+      const ForecastHour &slot = held.hours[hour];
+      message[length++] = (uint16_t)slot.temperatureDeci;
+      message[length++] = (uint16_t)slot.temperatureDeci >> 8;
+      message[length++] = slot.rainChance;
+      message[length++] = slot.humidity;
+    }
+    if (send(message, length)) {
+      statistics.recordsSent++;
+      recordSent = true;
+      recordSentAt = clock();
+    }
+  }
+
+  // At most one unsolicited answer per second however many boards ask
+  void answer() {
+    if (recordSent && clock() - recordSentAt < 1000) return;
+    statistics.requestsAnswered++;
+    sendRecord();
+  }
+
+  bool receive(const uint8_t *message, size_t length) {
+    if (length < WEATHER_SHARE_HEADER_SIZE + 2 || message[0] != WEATHER_SHARE_MAGIC || message[1] != WEATHER_SHARE_VERSION) {
+      statistics.rejected++;
+      return false;
+    }
+    const uint8_t type = message[2];
+    const uint8_t hours = message[3];
+    const size_t expected = WEATHER_SHARE_HEADER_SIZE + (type == WEATHER_SHARE_RECORD ? hours * 4 : 0);
+    if (hours > WeatherForecast::MAX_HOURS || length < expected + 2 ||
+        telemetryFrameCrc(message, expected) != (message[expected] | (uint16_t)message[expected + 1] << 8)) {
+      statistics.rejected++;
+      return false;
+    }
+    if (get32(message + 4) == device || get32(message + 8) != locationHash) return false;   // Own loopback, other location
+
+    const uint32_t theirFetched = get32(message + 12);
+    if (type == WEATHER_SHARE_REQUEST) {
+      if (role == FETCHER && theirFetched < fetchedEpoch) answer();
+      return false;
+    }
+    if (type != WEATHER_SHARE_RECORD) return false;
+
+    if (theirFetched <= fetchedEpoch) {
+      // A fetcher that missed the newer table is still announcing its own
+      if (theirFetched < fetchedEpoch && role == FETCHER) answer();
+      return false;
+    }
+    const uint32_t theirNow = get32(message + 16);
+    if (theirNow < theirFetched || theirNow - theirFetched >= config.staleAfterMs / 1000) return false;
+
+    WeatherForecast::Snapshot shared;
+    shared.fetchedEpoch = theirFetched;
+    shared.firstHourEpoch = get32(message + 20);
+    shared.count = hours;
+    for (uint8_t hour = 0; hour < hours; hour++) {
+      const uint8_t *slot = message + WEATHER_SHARE_HEADER_SIZE + hour * 4;
+      shared.hours[hour].temperatureDeci = (int16_t)(slot[0] | (uint16_t)slot[1] << 8);
+      shared.hours[hour].rainChance = slot[2];
+      shared.hours[hour].humidity = slot[3];
+    }
+    if (!forecast->adopt(shared, theirNow)) return false;
+    if (role == FETCHER) statistics.stepDowns++;
+    fetchedEpoch = theirFetched;
+    role = PEER;
+    requested = false;
+    statistics.recordsAdopted++;
+    return true;
+  }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include "rtc-memory.h"
+#include "input-trace.h"
+
+// ─────────────────────────────────────
+// Non-Blocking WiFi Link Manager
+// ─────────────────────────────────────
+// Polled state machine that brings the station up and keeps it up without
+// ever waiting inside the loop:
+//
+//   IDLE ─begin()─► FAST_CONNECT ──fail/timeout──► CONNECTING ──fail──► BACKOFF
+//                        │  (cached channel,             │ (scan + DHCP)     │
+//                        │   BSSID and address)          │                   │
+//                        └──────────► CONNECTED ◄────────┘   ◄───retry───────┘
+//                                         │ link lost: fast reconnect at once
+//
+// A full association scans every channel and waits for DHCP, ~2-3 s. The
+// AP's BSSID and channel and the DHCP lease of the last good association
+// are cached in RTC memory (and optionally on LittleFS), so a reconnect
+// joins the known AP directly with the old address configured statically
+// and is up in a few hundred ms. If the AP moved, the fast attempt fails
+// quickly and a full scan follows. Failed full attempts back off
+// exponentially with jitter.
+
+enum WiFiLinkState : uint8_t {
+  WIFI_LINK_IDLE,
+  WIFI_LINK_FAST_CONNECT,
+  WIFI_LINK_CONNECTING,
+  WIFI_LINK_CONNECTED,
+  WIFI_LINK_BACKOFF
+};
+
+struct WiFiLinkConfig {
+  unsigned long fastConnectTimeoutMs = 1500;  // Cached-AP attempt before falling back to a scan
+  unsigned long connectTimeoutMs = 15000;     // Full scan + DHCP attempt
+  unsigned long backoffMinMs = 2000;
+  unsigned long backoffMaxMs = 5UL * 60UL * 1000UL;
+  bool reuseLease = true;                     // Rejoin with the last DHCP address set statically
+  bool flashCache = false;                    // Also keep the cache on LittleFS (survives power loss)
+  IPAddress staticIp;                         // Fixed address instead of DHCP when set
+  IPAddress gateway;
+  IPAddress subnet;
+  IPAddress dns;
+};
+
+struct WiFiLinkStats {
+  uint32_t attempts = 0;
+  uint32_t fastAttempts = 0;       // Attempts from the cached channel/BSSID
+  uint32_t fastConnects = 0;       // ...that succeeded
+  uint32_t failures = 0;           // Full attempts that ended in backoff
+  uint32_t drops = 0;              // Established links lost
+  unsigned long lastConnectMs = 0; // Link down (or begin()) to link up
+  unsigned long maxConnectMs = 0;
+  bool lastConnectFast = false;    // Last link came up from the cache, without a scan
+};
+
+typedef void (*WiFiLinkHandler)();
+
+class WiFiLink {
+public:
+  void begin(const char *networkSsid, const char *networkPass, const WiFiLinkConfig &linkConfig = WiFiLinkConfig()) {
+    if (state != WIFI_LINK_IDLE) return;
+    ssid = networkSsid;
+    pass = networkPass;
+    config = linkConfig;
+    consecutiveFailures = 0;
+
+    WiFi.persistent(false);         // The SDK would otherwise rewrite its flash config on every begin()
+    WiFi.setAutoReconnect(false);   // Reconnects are driven from poll()
+    WiFi.mode(WIFI_STA);
+
+    cacheValid = cacheRecord.load(cache) || (config.flashCache && loadFlashCache());
+    outageStartedAt = millis();
+    startAttempt(cacheValid);
+  }
+
+  // Advance the state machine; call every loop pass. Never blocks.
+  void poll() {
+    unsigned long now = millis();
+    switch (state) {
+      case WIFI_LINK_IDLE:
+        return;
+
+      case WIFI_LINK_FAST_CONNECT:
+      case WIFI_LINK_CONNECTING: {
+        wl_status_t status = WiFi.status();
+        if (trace) trace->link(status);
+        if (status == WL_CONNECTED) {
+          linkEstablished(now);
+        } else if (state == WIFI_LINK_FAST_CONNECT) {
+          if (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED || now - attemptStartedAt >= config.fastConnectTimeoutMs) {
+            startAttempt(false);  // AP moved or lease refused - scan straight away
+          }
+        } else if (status == WL_CONNECT_FAILED || status == WL_WRONG_PASSWORD || now - attemptStartedAt >= config.connectTimeoutMs) {
+          WiFi.disconnect();
+          statistics.failures++;
+          consecutiveFailures++;
+          backoffMs = backoffDelay();
+          attemptStartedAt = now;
+          state = WIFI_LINK_BACKOFF;
+        }
+        return;
+      }
+
+      case WIFI_LINK_CONNECTED: {
+        wl_status_t status = WiFi.status();
+        if (trace) trace->link(status);
+        if (status != WL_CONNECTED) {
+          statistics.drops++;
+          outageStartedAt = now;
+          startAttempt(cacheValid);
+          if (disconnectedHandler) disconnectedHandler();
+        }
+        return;
+      }
+
+      case WIFI_LINK_BACKOFF:
+        if (now - attemptStartedAt >= backoffMs) startAttempt(cacheValid);
+        return;
+    }
+  }
+
+  // Drop the link and stop reconnecting until begin() is called again.
+  void end() {
+    WiFi.disconnect();
+    state = WIFI_LINK_IDLE;
+  }
+
+  void onConnected(WiFiLinkHandler handler) { connectedHandler = handler; }
+  void onDisconnected(WiFiLinkHandler handler) { disconnectedHandler = handler; }
+
+  bool connected() const { return state == WIFI_LINK_CONNECTED; }
+  bool connecting() const { return state == WIFI_LINK_FAST_CONNECT || state == WIFI_LINK_CONNECTING; }
+  WiFiLinkState linkState() const { return state; }
+  const WiFiLinkStats &stats() const { return statistics; }
+
+  // Record the WiFi status each time poll() reads a changed one
+  void traceInputs(InputTrace &inputTrace) { trace = &inputTrace; }
+
+  // Forget the cached AP, e.g. after changing networks.
+  void forget() {
+    cacheValid = false;
+    cacheRecord.invalidate();
+    if (config.flashCache) LittleFS.remove(CACHE_PATH);
+  }
+
+private:
+  struct Cache {
+    uint8_t bssid[6];
+    uint8_t reserved[2];
+    int32_t channel;
+    uint32_t address;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+  };
+
+  static constexpr const char *CACHE_PATH = "/wifi-link.bin";
+
+  const char *ssid = nullptr;
+  const char *pass = nullptr;
+  WiFiLinkConfig config;
+  WiFiLinkStats statistics;
+  RtcRecord<Cache, RTC_BLOCK_WIFI_LINK> cacheRecord;
+  Cache cache = {};
+  bool cacheValid = false;
+  WiFiLinkState state = WIFI_LINK_IDLE;
+  unsigned long attemptStartedAt = 0;
+  unsigned long outageStartedAt = 0;
+  unsigned long backoffMs = 0;
+  uint8_t consecutiveFailures = 0;
+  WiFiLinkHandler connectedHandler = nullptr;
+  WiFiLinkHandler disconnectedHandler = nullptr;
+  InputTrace *trace = nullptr;
+
+  void startAttempt(bool fast) {
+    WiFi.disconnect();
+    statistics.attempts++;
+    attemptStartedAt = millis();
+    if (config.staticIp.isSet()) {
+      WiFi.config(config.staticIp, config.gateway, config.subnet, config.dns);
+    } else if (fast && config.reuseLease) {
+      WiFi.config(IPAddress(cache.address), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+    } else {
+      WiFi.config(IPAddress(), IPAddress(), IPAddress());  // Back to DHCP
+    }
+    if (fast) {
+      statistics.fastAttempts++;
+      WiFi.begin(ssid, pass, cache.channel, cache.bssid);
+      state = WIFI_LINK_FAST_CONNECT;
+    } else {
+      WiFi.begin(ssid, pass);
+      state = WIFI_LINK_CONNECTING;
+    }
+  }
+
+  void linkEstablished(unsigned long now) {
+    statistics.lastConnectFast = state == WIFI_LINK_FAST_CONNECT;
+    if (statistics.lastConnectFast) statistics.fastConnects++;
+    statistics.lastConnectMs = now - outageStartedAt;
+    if (statistics.lastConnectMs > statistics.maxConnectMs) statistics.maxConnectMs = statistics.lastConnectMs;
+    consecutiveFailures = 0;
+    state = WIFI_LINK_CONNECTED;
+
+    Cache current = {};
+    const uint8_t *bssid = WiFi.BSSID();
+    if (bssid) memcpy(current.bssid, bssid, sizeof(current.bssid));
+    current.channel = WiFi.channel();
+    current.address = WiFi.localIP();
+    current.gateway = WiFi.gatewayIP();
+    current.subnet = WiFi.subnetMask();
+    current.dns = WiFi.dnsIP();
+    if (!cacheValid || memcmp(&current, &cache, sizeof(cache)) != 0) {
+      cache = current;
+      cacheValid = true;
+      cacheRecord.save(cache);
+      if (config.flashCache) saveFlashCache();  // Only when the AP or lease changed - no routine flash wear
+    }
+    if (connectedHandler) connectedHandler();
+  }
+
+  unsigned long backoffDelay() {
+    uint8_t doublings = consecutiveFailures > 8 ? 8 : consecutiveFailures - 1;
+    unsigned long delayMs = config.backoffMinMs << doublings;
+    if (delayMs > config.backoffMaxMs) delayMs = config.backoffMaxMs;
+    return delayMs + random(delayMs / 4 + 1);  // Jitter keeps a fleet from retrying in lockstep
+  }
+
+  bool loadFlashCache() {
+    if (!LittleFS.begin()) return false;
+    File file = LittleFS.open(CACHE_PATH, "r");
+    if (!file) return false;
+    uint32_t storedCrc;
+    Cache stored;
+    bool valid = file.read((uint8_t *)&storedCrc, sizeof(storedCrc)) == sizeof(storedCrc) &&
+                 file.read((uint8_t *)&stored, sizeof(stored)) == sizeof(stored) &&
+                 storedCrc == crc32(&stored, sizeof(stored));
+    if (valid) cache = stored;
+    return valid;
+  }
+
+  void saveFlashCache() {
+    if (!LittleFS.begin()) return;
+    File file = LittleFS.open(CACHE_PATH, "w");
+    if (!file) return;
+    uint32_t storedCrc = crc32(&cache, sizeof(cache));
+    file.write((const uint8_t *)&storedCrc, sizeof(storedCrc));
+    file.write((const uint8_t *)&cache, sizeof(cache));
+    file.close();
+  }
+};